@@ -14,6 +14,7 @@
 #include "Metrics/LogSink.h"
 #include "Metrics/Registrar.h"
 #include "Metrics/Reporter.h"
+#include "NeXusDataset/ChunkCompression.h"
 #include "RunState.h"
 #include "Status/StatusInfo.h"
 #include "Status/StatusReporter.h"
@@ -238,6 +239,33 @@ int main(int argc, char **argv) {
           "not enforced, only used as guideline to throttle Kafka "
           "consumption. Note that total memory usage will also depend on "
           "the size of the actual messages consumed from Kafka."));
+  app.add_flag(
+      "--load-shedding", options->StreamerConfiguration.LoadShedding,
+      wrap_lines("When \"--max-queued-writes\" is exceeded, drop messages "
+                 "according to the \"drop_policy\" of each stream before "
+                 "pausing the consumers. Consumers are then only paused if the "
+                 "number of queued writes exceeds twice the maximum."));
+  app.add_option(
+      "--flush-after-bytes", options->StreamerConfiguration.FlushAfterBytes,
+      wrap_lines("Flush the data to file when (approximately) this many bytes "
+                 "have been written since the last flush, in addition to "
+                 "flushing every \"--data-flush-interval\". Set to 0 to only "
+                 "flush on the interval (and the staleness bounds of the "
+                 "writer modules)."));
+  app.add_option(
+      "--write-preparation-threads",
+      options->StreamerConfiguration.WritePreparationThreads,
+      wrap_lines("Number of threads per file used for the CPU bound part of "
+                 "writing messages (e.g. transforming event data). All HDF5 "
+                 "calls are still done by a single writer thread. Set to 0 to "
+                 "do all of the work on the writer thread."));
+  app.add_option(
+      "--chunk-compression-threads", options->ChunkCompressionThreads,
+      wrap_lines("Number of threads (shared by all files) used for "
+                 "compressing whole chunks of event (ev44) and area detector "
+                 "(ad00) data with deflate, which are then written without "
+                 "the HDF5 filter pipeline. Set to 0 to compress the data on "
+                 "the writer thread of each file."));
   app.add_option(
          "--service-name",
          [&options](std::vector<std::string> service_names) -> bool {
@@ -303,6 +331,8 @@ int main(int argc, char **argv) {
 
   CLI11_PARSE(app, argc, argv);
   setupLoggerFromOptions(*options);
+  NeXusDataset::ChunkCompressionPool::setNrOfThreads(
+      options->ChunkCompressionThreads);
   if (!versionOfHDF5IsOk()) {
     Logger::Critical("Failed HDF5 version check. Exiting.");
     return EXIT_FAILURE;
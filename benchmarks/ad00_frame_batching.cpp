@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+/// \file
+/// \brief Compares writing area detector frames one by one and in batches,
+/// see NeXusDataset::MultiDimDataset::setFramesPerWrite().
+
+#include "NeXusDataset/ExtensibleDataset.h"
+#include <CLI/CLI.hpp>
+#include <chrono>
+#include <cstdint>
+#include <h5cpp/hdf5.hpp>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+int main(int argc, char **argv) {
+  CLI::App App{"Benchmark of the batching of area detector frames"};
+  std::string FileName{"ad00-frame-batching.nxs"};
+  App.add_option("-f,--file", FileName, "The file to write to (truncated)");
+  size_t NrOfFrames{200};
+  App.add_option("-n,--frames", NrOfFrames, "The nr of frames per run");
+  hsize_t Width{1024};
+  App.add_option("--width", Width, "The nr of pixels in a frame row");
+  hsize_t Height{1024};
+  App.add_option("--height", Height, "The nr of rows in a frame");
+  hsize_t FramesPerChunk{16};
+  App.add_option("-c,--chunk-frames", FramesPerChunk,
+                 "The nr of frames per chunk");
+  std::vector<size_t> BatchSizes{1, 4, 16};
+  App.add_option("-b,--frames-per-write", BatchSizes,
+                 "The nr of frames per write, one run for each");
+  CLI11_PARSE(App, argc, argv);
+
+  hdf5::Dimensions FrameShape{Height, Width};
+  std::vector<std::uint16_t> Frame(Height * Width);
+  std::iota(Frame.begin(), Frame.end(), 0);
+  auto File = hdf5::file::create(FileName, hdf5::file::AccessFlags::Truncate);
+  for (auto FramesPerWrite : BatchSizes) {
+    auto Name = "value_" + std::to_string(FramesPerWrite);
+    auto Start = std::chrono::steady_clock::now();
+    {
+      NeXusDataset::MultiDimDataset<std::uint16_t> Dataset(
+          File.root(), Name, NeXusDataset::Mode::Create, FrameShape,
+          {FramesPerChunk, Height, Width});
+      Dataset.setFramesPerWrite(FramesPerWrite);
+      for (size_t i = 0; i < NrOfFrames; ++i) {
+        Dataset.appendArray(Frame, FrameShape);
+      }
+    }
+    File.flush(hdf5::file::Scope::Global);
+    std::chrono::duration<double> Elapsed =
+        std::chrono::steady_clock::now() - Start;
+    std::cout << FramesPerWrite << " frame(s) per write: "
+              << static_cast<double>(NrOfFrames) / Elapsed.count()
+              << " frames/s, "
+              << static_cast<double>(NrOfFrames * Frame.size() *
+                                     sizeof(std::uint16_t)) /
+                     Elapsed.count() / 1e6
+              << " MB/s\n";
+  }
+  return 0;
+}
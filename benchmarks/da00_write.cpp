@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+/// \file
+/// \brief Measures the time per message of the da00 writer module for
+/// messages with many variables, see WriterModule::da00::WritePlan.
+
+#include "WriterModule/da00/da00_Writer.h"
+#include <CLI/CLI.hpp>
+#include <chrono>
+#include <da00_dataarray_generated.h>
+#include <h5cpp/hdf5.hpp>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+namespace {
+std::string variableName(size_t Index) {
+  return "variable_" + std::to_string(Index);
+}
+
+std::string configuration(size_t NrOfVariables, int64_t Length) {
+  auto Config = nlohmann::json::parse(R"""({
+    "topic": "benchmark.topic",
+    "source": "benchmark_source",
+    "variables": []
+  })""");
+  for (size_t i = 0; i < NrOfVariables; ++i) {
+    Config["variables"].push_back({{"name", variableName(i)},
+                                   {"data_type", "float64"},
+                                   {"axes", {"x"}},
+                                   {"shape", {Length}}});
+  }
+  return Config.dump();
+}
+
+flatbuffers::DetachedBuffer message(size_t NrOfVariables, int64_t Length) {
+  flatbuffers::FlatBufferBuilder Builder;
+  std::vector<flatbuffers::Offset<da00_Variable>> Variables;
+  std::vector<std::string> Axes{"x"};
+  std::vector<int64_t> Shape{Length};
+  for (size_t i = 0; i < NrOfVariables; ++i) {
+    std::vector<double> Values(Length, static_cast<double>(i));
+    auto Data = Builder.CreateVector(
+        reinterpret_cast<std::uint8_t const *>(Values.data()),
+        Values.size() * sizeof(double));
+    Variables.push_back(Createda00_Variable(
+        Builder, Builder.CreateString(variableName(i)),
+        Builder.CreateString(""), Builder.CreateString(""),
+        Builder.CreateString(""), da00_dtype::float64,
+        Builder.CreateVectorOfStrings(Axes), Builder.CreateVector(Shape),
+        Data));
+  }
+  auto DataArray =
+      Createda00_DataArray(Builder, Builder.CreateString("benchmark_source"),
+                           19820909, Builder.CreateVector(Variables));
+  Builder.Finish(DataArray, da00_DataArrayIdentifier());
+  return Builder.Release();
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  CLI::App App{"Benchmark of the da00 writer module"};
+  std::string FileName{"da00-write.nxs"};
+  App.add_option("-f,--file", FileName, "The file to write to (truncated)");
+  size_t NrOfMessages{1'000};
+  App.add_option("-n,--messages", NrOfMessages, "The nr of messages per run");
+  int64_t Length{16};
+  App.add_option("-l,--length", Length, "The nr of values per variable");
+  std::vector<size_t> VariableCounts{10, 100};
+  App.add_option("-v,--variables", VariableCounts,
+                 "The nr of variables per message, one run for each");
+  CLI11_PARSE(App, argc, argv);
+
+  auto File = hdf5::file::create(FileName, hdf5::file::AccessFlags::Truncate);
+  for (auto NrOfVariables : VariableCounts) {
+    auto Buffer = message(NrOfVariables, Length);
+    FileWriter::FlatbufferMessage Message(Buffer.data(), Buffer.size());
+    auto Group =
+        File.root().create_group("variables_" + std::to_string(NrOfVariables));
+    WriterModule::da00::da00_Writer Writer;
+    Writer.parse_config(configuration(NrOfVariables, Length));
+    Writer.init_hdf(Group);
+    Writer.reopen(Group);
+    auto Start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < NrOfMessages; ++i) {
+      Writer.write(Message, false);
+    }
+    Writer.flushBuffers();
+    File.flush(hdf5::file::Scope::Global);
+    std::chrono::duration<double, std::micro> Elapsed =
+        std::chrono::steady_clock::now() - Start;
+    std::cout << NrOfVariables << " variables per message: "
+              << Elapsed.count() / static_cast<double>(NrOfMessages)
+              << " us/message\n";
+  }
+  return 0;
+}
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+/// \file
+/// \brief Measures the rate at which the ev44 writer module histograms
+/// events, see WriterModule::ev44::EventHistogram.
+
+#include "WriterModule/ev44/ev44_Histogram.h"
+#include <CLI/CLI.hpp>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+int main(int argc, char **argv) {
+  CLI::App App{"Benchmark of the histogramming of ev44 events"};
+  size_t EventsPerMessage{100'000};
+  App.add_option("-e,--events", EventsPerMessage,
+                 "The nr of events per message");
+  size_t NrOfMessages{1'000};
+  App.add_option("-n,--messages", NrOfMessages, "The nr of messages");
+  size_t NrOfTofBins{1'000};
+  App.add_option("-t,--tof-bins", NrOfTofBins, "The nr of time of flight bins");
+  std::int32_t NrOfPixels{100'000};
+  App.add_option("-p,--pixels", NrOfPixels, "The nr of pixels");
+  bool UnevenBins{false};
+  App.add_flag("-u,--uneven", UnevenBins,
+               "Use bin edges that are not evenly spaced");
+  CLI11_PARSE(App, argc, argv);
+
+  std::int32_t const BinWidth{100};
+  std::vector<std::int32_t> TofEdges(NrOfTofBins + 1);
+  for (size_t i = 0; i < TofEdges.size(); ++i) {
+    TofEdges[i] = static_cast<std::int32_t>(i) * BinWidth +
+                  (UnevenBins && i % 2 == 1 ? BinWidth / 2 : 0);
+  }
+  WriterModule::ev44::EventHistogram Histogram(TofEdges, 0, NrOfPixels - 1,
+                                               1);
+
+  // Some of the events are outside of the histogram.
+  std::mt19937 Generator(0);
+  std::uniform_int_distribution<std::int32_t> TofDistribution(
+      0, TofEdges.back() + TofEdges.back() / 10);
+  std::uniform_int_distribution<std::int32_t> PixelDistribution(
+      0, NrOfPixels + NrOfPixels / 10);
+  std::vector<std::int32_t> TimeOfFlight(EventsPerMessage);
+  std::vector<std::int32_t> PixelId(EventsPerMessage);
+  for (size_t i = 0; i < EventsPerMessage; ++i) {
+    TimeOfFlight[i] = TofDistribution(Generator);
+    PixelId[i] = PixelDistribution(Generator);
+  }
+
+  std::vector<std::uint32_t> Bins;
+  std::chrono::steady_clock::duration Binning{0};
+  std::chrono::steady_clock::duration Counting{0};
+  for (size_t i = 0; i < NrOfMessages; ++i) {
+    auto Start = std::chrono::steady_clock::now();
+    Histogram.binIndices(TimeOfFlight.data(), PixelId.data(),
+                         EventsPerMessage, Bins);
+    auto Binned = std::chrono::steady_clock::now();
+    Histogram.count(Bins);
+    Counting += std::chrono::steady_clock::now() - Binned;
+    Binning += Binned - Start;
+  }
+
+  auto EventsPerSecond = [&](auto Duration) {
+    return static_cast<double>(EventsPerMessage * NrOfMessages) /
+           std::chrono::duration<double>(Duration).count();
+  };
+  std::cout << "Binning: " << EventsPerSecond(Binning)
+            << " events/s, counting: " << EventsPerSecond(Counting)
+            << " events/s, total: " << EventsPerSecond(Binning + Counting)
+            << " events/s\n";
+  return 0;
+}
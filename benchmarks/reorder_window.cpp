@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+/// \file
+/// \brief Measures the overhead of passing messages through the reorder
+/// window of their source, see Stream::ReorderStage.
+
+#include "FlatBufferGenerators.h"
+#include "Metrics/Registrar.h"
+#include "Stream/SourceFilter.h"
+#include "WriterModule/f144/f144_Writer.h"
+#include <CLI/CLI.hpp>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+/// Counts the messages instead of writing them.
+class CountingMessageWriter : public Stream::MessageWriter {
+public:
+  CountingMessageWriter()
+      : MessageWriter([](duration) { return true; }, 1s,
+                      std::make_unique<Metrics::Registrar>("")) {}
+  void addMessage(Stream::Message const &, bool) override {
+    ++NrOfMessages;
+  }
+  size_t NrOfMessages{0};
+};
+
+/// The time per message, in ns, to pass the messages through a source
+/// filter with the given reorder window (or none).
+double
+nsPerMessage(std::vector<FileWriter::FlatbufferMessage> const &Messages,
+             std::shared_ptr<Stream::ReorderStage> const &Stage) {
+  CountingMessageWriter Writer;
+  WriterModule::f144::f144_Writer Module;
+  auto Start = std::chrono::steady_clock::now();
+  {
+    Stream::SourceFilter Filter(time_point::min(), time_point::max(), true,
+                                &Writer,
+                                std::make_unique<Metrics::Registrar>(""));
+    Filter.set_source_hash(FileWriter::calcSourceHash("f144", "source"));
+    Filter.add_writer_module_for_message(&Module);
+    Filter.set_reorder_stage(Stage);
+    for (auto const &Message : Messages) {
+      Filter.filter_message(Message);
+    }
+  }
+  std::chrono::duration<double, std::nano> Elapsed =
+      std::chrono::steady_clock::now() - Start;
+  if (Writer.NrOfMessages != Messages.size()) {
+    std::cerr << "Passed on " << Writer.NrOfMessages << " of "
+              << Messages.size() << " messages\n";
+  }
+  return Elapsed.count() / static_cast<double>(Messages.size());
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  CLI::App App{"Benchmark of the reorder window of a source"};
+  size_t NrOfMessages{1'000'000};
+  App.add_option("-n,--messages", NrOfMessages, "The nr of messages");
+  size_t WindowMessages{16};
+  App.add_option("-m,--window-messages", WindowMessages,
+                 "The max nr of messages in the window");
+  int WindowMs{50};
+  App.add_option("-t,--window-ms", WindowMs,
+                 "The max time difference in the window, in ms");
+  CLI11_PARSE(App, argc, argv);
+
+  // Mostly in order, with every tenth message up to 20 ms early.
+  std::vector<FileWriter::FlatbufferMessage> Messages;
+  Messages.reserve(NrOfMessages);
+  std::mt19937 Generator(0);
+  std::uniform_int_distribution<int64_t> Jitter(1, 20);
+  for (size_t i = 0; i < NrOfMessages; ++i) {
+    auto TimestampMs = static_cast<int64_t>(i) * 10 + 1000 -
+                       (i % 10 == 0 ? Jitter(Generator) : 0);
+    auto const [Buffer, Size] = FlatBuffers::create_f144_message_double(
+        "source", static_cast<double>(i), TimestampMs);
+    Messages.emplace_back(Buffer.get(), Size);
+  }
+
+  auto Without = nsPerMessage(Messages, nullptr);
+  auto With = nsPerMessage(
+      Messages, std::make_shared<Stream::ReorderStage>(
+                    WindowMessages, std::chrono::milliseconds(WindowMs)));
+  std::cout << "Without reorder window: " << Without
+            << " ns/message, with reorder window: " << With
+            << " ns/message, overhead: " << With - Without
+            << " ns/message\n";
+  return 0;
+}
@@ -95,10 +95,11 @@ void FileWriterTask::writeLinks(
 
 void FileWriterTask::writeMetaData() { File->addMetaData(); }
 
-void FileWriterTask::flushDataToFile() {
+bool FileWriterTask::flushDataToFile(duration MaxTime) {
   if (File != nullptr) {
-    File->flush();
+    return File->flushIncrementally(MaxTime);
   }
+  return true;
 }
 
 void FileWriterTask::updateApproximateFileSize() {
@@ -13,6 +13,7 @@
 #include "Metrics/Registrar.h"
 #include "ModuleSettings.h"
 #include "Source.h"
+#include "TimeUtility.h"
 #include "json.h"
 #include <map>
 #include <memory>
@@ -97,7 +98,11 @@ public:
 
   void writeMetaData();
 
-  void flushDataToFile();
+  /// \brief Flush (part of) the data to file.
+  ///
+  /// See FileWriter::HDFFileBase::flushIncrementally().
+  /// \return True if a complete flush of the file has been done.
+  bool flushDataToFile(duration MaxTime);
 
   /// \brief Updates the "arpproximate file size" meta data status field.
   /// \note Due to uncertainties in the file size, this function will round up
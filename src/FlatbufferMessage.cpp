@@ -20,7 +20,10 @@ FlatbufferMessage::FlatbufferMessage(uint8_t const *BufferPtr, size_t Size)
 
 FlatbufferMessage::FlatbufferMessage(FileWriter::Msg const &KafkaMessage)
     : DataPtr(std::make_unique<uint8_t[]>(KafkaMessage.size())),
-      DataSize(KafkaMessage.size()) {
+      DataSize(KafkaMessage.size()),
+      Origin{KafkaMessage.getMetaData().Offset,
+             KafkaMessage.getMetaData().Partition,
+             KafkaMessage.getMetaData().Timestamp.count()} {
   std::memcpy(DataPtr.get(), KafkaMessage.data(), DataSize);
   extractPacketInfo();
 }
@@ -29,10 +32,30 @@ FlatbufferMessage::FlatbufferMessage(FlatbufferMessage const &Other)
     : DataPtr(std::make_unique<uint8_t[]>(Other.size())),
       DataSize(Other.size()), SourceNameIDHash(Other.SourceNameIDHash),
       Sourcename(Other.Sourcename), ID(Other.ID), Timestamp(Other.Timestamp),
-      Valid(Other.Valid) {
+      Origin(Other.Origin), Valid(Other.Valid) {
   std::memcpy(DataPtr.get(), Other.data(), DataSize);
 }
 
+FlatbufferMessage
+FlatbufferMessage::unparsed(FileWriter::Msg const &KafkaMessage) {
+  FlatbufferMessage Result;
+  Result.DataSize = KafkaMessage.size();
+  Result.DataPtr = std::make_unique<uint8_t[]>(Result.DataSize);
+  if (Result.DataSize > 0) {
+    std::memcpy(Result.DataPtr.get(), KafkaMessage.data(), Result.DataSize);
+  }
+  auto const &MetaData = KafkaMessage.getMetaData();
+  Result.Origin = {MetaData.Offset, MetaData.Partition,
+                   MetaData.Timestamp.count()};
+  Result.Timestamp =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(MetaData.Timestamp)
+          .count();
+  if (Result.DataSize >= 8) {
+    Result.ID.assign(reinterpret_cast<char const *>(Result.data()) + 4, 4);
+  }
+  return Result;
+}
+
 FlatbufferMessage::SrcHash calcSourceHash(std::string const &ID,
                                           std::string const &Name) {
   return std::hash<std::string>{}(ID + Name);
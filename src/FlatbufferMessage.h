@@ -11,6 +11,7 @@
 
 #include "Msg.h"
 #include "logger.h"
+#include <utility>
 
 namespace FileWriter {
 class FlatbufferError : public std::runtime_error {
@@ -43,6 +44,15 @@ public:
       : FlatbufferError(what){};
 };
 
+/// \brief Where a message was consumed from, only known for messages
+/// consumed from Kafka.
+struct KafkaOrigin {
+  std::int64_t Offset{-1};
+  std::int32_t Partition{-1};
+  /// The Kafka timestamp of the message, in ms since the epoch.
+  std::int64_t TimestampMs{-1};
+};
+
 /// \brief A wrapper around a databuffer which holds a flatbuffer.
 ///
 /// Used to simplify passing around flatbuffers and the most important pieces of
@@ -81,6 +91,17 @@ public:
   /// \note Will make a copy of the data in the Kafka message.
   FlatbufferMessage(FlatbufferMessage const &Other);
 
+  /// \brief Creates a message of which the flatbuffer is neither verified nor
+  /// read, e.g. as it has an unknown flatbuffer id or is broken.
+  ///
+  /// The message is not valid and has no source name. Its timestamp is the
+  /// Kafka timestamp of the message and its flatbuffer id is read from the
+  /// buffer if it is long enough.
+  ///
+  /// \param KafkaMessage The Kafka message used to create the message.
+  /// \note Will make a copy of the data in the Kafka message.
+  static FlatbufferMessage unparsed(FileWriter::Msg const &KafkaMessage);
+
   /// \\bried Default destructor.
   ~FlatbufferMessage() = default;
 
@@ -92,10 +113,28 @@ public:
     Sourcename = Other.Sourcename;
     ID = Other.ID;
     Timestamp = Other.Timestamp;
+    Origin = Other.Origin;
     Valid = Other.Valid;
     return *this;
   }
 
+  /// \brief Takes over the data of \p Other, which is left invalid.
+  FlatbufferMessage(FlatbufferMessage &&Other) noexcept {
+    *this = std::move(Other);
+  }
+
+  FlatbufferMessage &operator=(FlatbufferMessage &&Other) noexcept {
+    DataPtr = std::move(Other.DataPtr);
+    DataSize = std::exchange(Other.DataSize, 0);
+    SourceNameIDHash = std::exchange(Other.SourceNameIDHash, 0);
+    Sourcename = std::move(Other.Sourcename);
+    ID = std::move(Other.ID);
+    Timestamp = std::exchange(Other.Timestamp, 0);
+    Origin = std::exchange(Other.Origin, {});
+    Valid = std::exchange(Other.Valid, false);
+    return *this;
+  }
+
   /// \brief Returns the state of the FlatbufferMessage.
   ///
   /// \return `true` if valid, `false` if not.
@@ -129,6 +168,11 @@ public:
   /// invalid.
   std::string getFlatbufferID() const { return ID; };
 
+  /// \brief Get the Kafka offset, partition and timestamp of the message.
+  ///
+  /// \return Negative values if the message was not consumed from Kafka.
+  KafkaOrigin const &getKafkaOrigin() const { return Origin; };
+
   /// \brief Get pointer to flatbuffer.
   ///
   /// \return Pointer to flatbuffer data if flatbuffer is valid, `nullptr` if it
@@ -149,6 +193,7 @@ private:
   std::string Sourcename;
   std::string ID;
   std::int64_t Timestamp{0};
+  KafkaOrigin Origin;
   bool Valid{false};
 };
 
@@ -13,6 +13,7 @@
 #include "HDFVersionCheck.h"
 #include "Version.h"
 #include "json.h"
+#include <algorithm>
 
 namespace FileWriter {
 using HDFOperations::createHDFStructures;
@@ -165,6 +166,7 @@ std::string HDFFileBase::read_template_version_if_present(
 }
 
 void HDFFile::closeFile() {
+  abortIncrementalFlush();
   try {
     if (hdfFile().is_valid()) {
       Logger::Debug(R"(Closing file "{}".)",
@@ -206,6 +208,81 @@ void HDFFileBase::flush() {
   }
 }
 
+bool HDFFileBase::flushIncrementally(duration MaxTime) {
+  if (!H5File.is_valid()) {
+    Logger::Critical("Unable to flush file due to it being invalid.");
+    return true;
+  }
+  auto StopTime = std::chrono::system_clock::now() + MaxTime;
+  if (!FlushCycleInProgress) {
+    auto FileId = static_cast<hid_t>(H5File.id());
+    unsigned int const ObjectTypes = H5F_OBJ_DATASET;
+    auto NrOfDatasets = H5Fget_obj_count(FileId, ObjectTypes);
+    if (NrOfDatasets < 0) {
+      throw std::runtime_error(
+          "HDFFile failed to flush, unable to get the open datasets.");
+    }
+    DatasetsToFlush.resize(NrOfDatasets);
+    auto NrOfIds = H5Fget_obj_ids(FileId, ObjectTypes, DatasetsToFlush.size(),
+                                  DatasetsToFlush.data());
+    DatasetsToFlush.resize(std::max(NrOfIds, ssize_t(0)));
+    // Hold on to the datasets until flushed, in case they are closed by the
+    // owner in the meantime.
+    for (auto const &DatasetId : DatasetsToFlush) {
+      H5Iinc_ref(DatasetId);
+    }
+    FlushCycleInProgress = true;
+  }
+  while (!DatasetsToFlush.empty()) {
+    auto DatasetId = DatasetsToFlush.back();
+    DatasetsToFlush.pop_back();
+    auto FlushResult = H5Dflush(DatasetId);
+    H5Idec_ref(DatasetId);
+    if (FlushResult < 0) {
+      Logger::Warn("Failed to flush dataset, will be flushed in the next "
+                   "flush cycle.");
+    }
+    if (std::chrono::system_clock::now() >= StopTime) {
+      break;
+    }
+  }
+  if (!DatasetsToFlush.empty()) {
+    return false;
+  }
+  // The datasets have been flushed, only the attributes of the groups
+  // remain.
+  flushGroups();
+  FlushCycleInProgress = false;
+  return true;
+}
+
+void HDFFileBase::flushGroups() {
+  auto FileId = static_cast<hid_t>(H5File.id());
+  unsigned int const ObjectTypes = H5F_OBJ_GROUP;
+  auto NrOfGroups = H5Fget_obj_count(FileId, ObjectTypes);
+  if (NrOfGroups <= 0) {
+    return;
+  }
+  std::vector<hid_t> Groups(NrOfGroups);
+  auto NrOfIds =
+      H5Fget_obj_ids(FileId, ObjectTypes, Groups.size(), Groups.data());
+  Groups.resize(std::max(NrOfIds, ssize_t(0)));
+  for (auto const &GroupId : Groups) {
+    if (H5Gflush(GroupId) < 0) {
+      Logger::Warn("Failed to flush group, will be flushed in the next "
+                   "flush cycle.");
+    }
+  }
+}
+
+void HDFFileBase::abortIncrementalFlush() {
+  for (auto const &DatasetId : DatasetsToFlush) {
+    H5Idec_ref(DatasetId);
+  }
+  DatasetsToFlush.clear();
+  FlushCycleInProgress = false;
+}
+
 void HDFFile::openFileInRegularMode() {
   Logger::Debug(R"(Opening file "{}" in regular (non SWMR) mode.)",
                 H5FileName.string());
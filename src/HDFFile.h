@@ -12,6 +12,7 @@
 #include "MetaData/Tracker.h"
 #include "ModuleHDFInfo.h"
 #include "ModuleSettings.h"
+#include "TimeUtility.h"
 #include "json.h"
 #include "logger.h"
 #include <H5Ipublic.h>
@@ -26,13 +27,35 @@ namespace FileWriter {
 
 class HDFFileBase {
 public:
-  virtual ~HDFFileBase() = default;
+  virtual ~HDFFileBase() { abortIncrementalFlush(); }
   virtual void flush();
 
+  /// \brief Flush (part of) the data of the file.
+  ///
+  /// Flushes the open datasets of the file one at a time (H5Dflush) until at
+  /// least \p MaxTime has passed or all datasets of the current flush cycle
+  /// have been flushed. In the latter case the open groups are flushed
+  /// (H5Gflush), for their attributes, and the flush cycle is completed. A
+  /// new flush cycle is started on the first call after a completed one.
+  ///
+  /// The file is not flushed as a whole (H5Fflush), which would write all
+  /// of the data again. While writing in SWMR mode no objects are created,
+  /// so the metadata that changes is that of the datasets (e.g. extents and
+  /// chunk indices) and the attributes of the open objects. The remaining
+  /// (file level) metadata is written when the file is closed.
+  /// \return True if the flush cycle was completed.
+  virtual bool flushIncrementally(duration MaxTime);
+
   auto hdfGroup() const { return H5File.root(); }
 
 protected:
   auto &hdfFile() { return H5File; }
+
+  /// \brief Release the datasets of an unfinished flush cycle.
+  ///
+  /// Must be called before closing the file.
+  void abortIncrementalFlush();
+
   void init(const std::string &NexusStructure,
             std::vector<ModuleHDFInfo> &ModuleHDFInfo,
             std::filesystem::path const &template_path,
@@ -55,8 +78,15 @@ private:
                                          nlohmann::json const &NexusStructure);
   std::string
   read_template_version_if_present(hdf5::node::Group const &RootGroup);
+  /// \brief Flush the metadata of the open groups of the file.
+  void flushGroups();
   std::string ExistingTemplateVersion;
   hdf5::file::File H5File;
+
+  /// Datasets (with an incremented reference count) not yet flushed in the
+  /// current flush cycle.
+  std::vector<hid_t> DatasetsToFlush;
+  bool FlushCycleInProgress{false};
 };
 
 class HDFFile : public HDFFileBase {
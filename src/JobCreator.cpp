@@ -177,6 +177,8 @@ std::unique_ptr<StreamController> createFileWritingJob(
     }
     try {
       Item.WriterModule->register_meta_data(StreamGroup, Tracker);
+      Item.WriterModule->register_load_shedding_meta_data(StreamGroup,
+                                                          Tracker);
     } catch (std::exception const &E) {
       throw std::runtime_error(fmt::format(
           R"(Exception encountered in WriterModule::Base::register_meta_data(). Module: "{}" Source: "{}"  Error message: {})",
@@ -233,10 +235,19 @@ void addStreamSourceToWriterModule(vector<ModuleSettings> &StreamSettingsList,
 
       // Create a Source instance for the stream and add to the task.
       auto FoundModule = WriterModule::Registry::find(StreamSettings.Module);
-      Source ThisSource(StreamSettings.Source, FoundModule.second.Id,
+      auto FlatbufferID = StreamSettings.WriterModule->messageFlatbufferID()
+                              .value_or(FoundModule.second.Id);
+      Source ThisSource(StreamSettings.Source, FlatbufferID,
                         FoundModule.second.Name, StreamSettings.Topic,
                         std::move(StreamSettings.WriterModule));
+      auto *Writer = ThisSource.getWriterPtr();
       Task.addSource(std::move(ThisSource));
+
+      // Sources of which the messages are also written by this module.
+      for (auto const &Name : Writer->additionalSources()) {
+        Task.addSource(Source(Name, FlatbufferID, FoundModule.second.Name,
+                              StreamSettings.Topic, Writer));
+      }
     } catch (std::runtime_error const &E) {
       Logger::Info(
           "Exception while initializing writer module {} for source {}: {}",
@@ -72,6 +72,10 @@ struct MainOpt {
   /// (e.g. list of current file writings).
   duration StatusMasterInterval{2000ms};
 
+  /// \brief Nr of threads (shared by all files) compressing whole chunks of
+  /// event and area detector data, zero to compress in the HDF5 library.
+  size_t ChunkCompressionThreads{2};
+
   std::vector<std::string> brokers;
 
 private:
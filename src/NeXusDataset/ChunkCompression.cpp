@@ -0,0 +1,263 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#include "ChunkCompression.h"
+#include "../SetThreadName.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <zlib.h>
+
+namespace NeXusDataset {
+
+bool canCompressChunks(Compression const &Applied) {
+  return Applied.Filter == CompressionFilter::DEFLATE;
+}
+
+std::vector<char> compressChunk(std::vector<char> const &RawChunk,
+                                Compression const &Applied,
+                                size_t ElementSize) {
+  if (!canCompressChunks(Applied)) {
+    throw std::runtime_error("Unsupported compression of chunk.");
+  }
+  auto const *Input = &RawChunk;
+  std::vector<char> Shuffled;
+  auto NrOfElements = ElementSize == 0 ? 0 : RawChunk.size() / ElementSize;
+  if (Applied.Shuffle && ElementSize > 1 && NrOfElements > 1) {
+    // Same byte order as the HDF5 shuffle filter: the first byte of all
+    // elements, then the second byte of all elements and so on.
+    Shuffled.resize(RawChunk.size());
+    for (size_t i = 0; i < NrOfElements; ++i) {
+      for (size_t j = 0; j < ElementSize; ++j) {
+        Shuffled[j * NrOfElements + i] = RawChunk[i * ElementSize + j];
+      }
+    }
+    auto WholeElementsSize = NrOfElements * ElementSize;
+    std::copy(RawChunk.begin() + WholeElementsSize, RawChunk.end(),
+              Shuffled.begin() + WholeElementsSize);
+    Input = &Shuffled;
+  }
+  uLongf CompressedSize = compressBound(Input->size());
+  std::vector<char> Compressed(CompressedSize);
+  if (compress2(reinterpret_cast<Bytef *>(Compressed.data()), &CompressedSize,
+                reinterpret_cast<Bytef const *>(Input->data()),
+                Input->size(), Applied.Level) != Z_OK) {
+    throw std::runtime_error("Failed to compress chunk.");
+  }
+  Compressed.resize(CompressedSize);
+  return Compressed;
+}
+
+std::atomic<size_t> ChunkCompressionPool::ConfiguredThreads{0};
+
+ChunkCompressionPool::ChunkCompressionPool(size_t NrOfThreads) {
+  for (size_t i = 0; i < NrOfThreads; ++i) {
+    Workers.emplace_back(&ChunkCompressionPool::threadFunction, this);
+  }
+}
+
+ChunkCompressionPool::~ChunkCompressionPool() {
+  {
+    std::lock_guard Lock(PoolMutex);
+    RunThreads = false;
+  }
+  TaskAvailable.notify_all();
+  for (auto &Worker : Workers) {
+    if (Worker.joinable()) {
+      Worker.join();
+    }
+  }
+}
+
+std::future<std::vector<char>>
+ChunkCompressionPool::compress(std::vector<char> RawChunk,
+                               Compression const &Applied,
+                               size_t ElementSize) {
+  std::packaged_task<std::vector<char>()> Task(
+      [Raw = std::move(RawChunk), Applied, ElementSize]() {
+        return compressChunk(Raw, Applied, ElementSize);
+      });
+  auto Result = Task.get_future();
+  {
+    std::lock_guard Lock(PoolMutex);
+    Tasks.emplace_back(std::move(Task));
+  }
+  TaskAvailable.notify_one();
+  return Result;
+}
+
+void ChunkCompressionPool::setNrOfThreads(size_t NrOfThreads) {
+  ConfiguredThreads = NrOfThreads;
+}
+
+ChunkCompressionPool *ChunkCompressionPool::instance() {
+  static std::unique_ptr<ChunkCompressionPool> Pool =
+      ConfiguredThreads > 0
+          ? std::make_unique<ChunkCompressionPool>(ConfiguredThreads.load())
+          : nullptr;
+  return Pool.get();
+}
+
+void ChunkCompressionPool::threadFunction() {
+  setThreadName("chunk_compress");
+  std::unique_lock Lock(PoolMutex);
+  while (true) {
+    TaskAvailable.wait(Lock,
+                       [this]() { return !Tasks.empty() || !RunThreads; });
+    if (Tasks.empty()) {
+      // Only reached when stopping with no tasks left.
+      return;
+    }
+    auto CurrentTask = std::move(Tasks.front());
+    Tasks.pop_front();
+    Lock.unlock();
+    // Exceptions are passed on to the caller by the future.
+    CurrentTask();
+    Lock.lock();
+  }
+}
+
+std::unique_ptr<ChunkAssembler>
+ChunkAssembler::create(hdf5::node::Dataset const &Dataset,
+                       ChunkCompressionPool *Pool, hsize_t NextRow) {
+  if (Pool == nullptr) {
+    return nullptr;
+  }
+  auto Applied = readCompressionAttributes(Dataset);
+  if (!canCompressChunks(Applied)) {
+    return nullptr;
+  }
+  auto CreationList = Dataset.creation_list();
+  if (CreationList.layout() != hdf5::property::DatasetLayout::Chunked) {
+    return nullptr;
+  }
+  // Only the filters set by applyCompression() are known.
+  auto ExpectedNrOfFilters = Applied.Shuffle ? 2 : 1;
+  if (H5Pget_nfilters(static_cast<hid_t>(CreationList)) !=
+      ExpectedNrOfFilters) {
+    return nullptr;
+  }
+  auto Chunk = CreationList.chunk();
+  auto Extent =
+      hdf5::dataspace::Simple(Dataset.dataspace()).current_dimensions();
+  if (Chunk.size() != Extent.size() ||
+      !std::equal(std::next(Chunk.begin()), Chunk.end(),
+                  std::next(Extent.begin()))) {
+    return nullptr;
+  }
+  return std::make_unique<ChunkAssembler>(Dataset, Applied, *Pool, NextRow);
+}
+
+ChunkAssembler::ChunkAssembler(hdf5::node::Dataset DatasetToWrite,
+                               Compression const &AppliedCompression,
+                               ChunkCompressionPool &CompressionPool,
+                               hsize_t FirstRow)
+    : Dataset(std::move(DatasetToWrite)), Type(Dataset.datatype()),
+      Applied(AppliedCompression), Pool(CompressionPool),
+      ElementSize(Type.size()), NextRow(FirstRow),
+      MaxPendingChunks(std::max<size_t>(2 * Pool.nrOfThreads(), 1)) {
+  auto Chunk = Dataset.creation_list().chunk();
+  RowsPerChunk = std::max<hsize_t>(Chunk.at(0), 1);
+  RowShape.assign(std::next(Chunk.begin()), Chunk.end());
+  RowSize = std::accumulate(RowShape.begin(), RowShape.end(), ElementSize,
+                            std::multiplies<>());
+}
+
+bool ChunkAssembler::accepts(hdf5::datatype::Datatype const &DataType,
+                             hdf5::Dimensions const &DataRowShape) const {
+  return DataRowShape == RowShape && DataType == Type;
+}
+
+void ChunkAssembler::append(char const *Data, size_t NrOfRows) {
+  while (NrOfRows > 0) {
+    auto RowInChunk = NextRow % RowsPerChunk;
+    auto Rows = std::min<hsize_t>(NrOfRows, RowsPerChunk - RowInChunk);
+    if (CurrentChunk.empty() && RowInChunk != 0) {
+      // The start of this chunk was not appended here, so the chunk can not
+      // be written as a whole.
+      writeRows(NextRow, Data, Rows);
+    } else {
+      CurrentChunk.insert(CurrentChunk.end(), Data, Data + Rows * RowSize);
+    }
+    NextRow += Rows;
+    Data += Rows * RowSize;
+    NrOfRows -= Rows;
+    if (NextRow % RowsPerChunk == 0 && !CurrentChunk.empty()) {
+      submitCurrentChunk();
+    }
+  }
+}
+
+void ChunkAssembler::writeCompressedChunks() {
+  using std::chrono_literals::operator""s;
+  while (!Pending.empty() &&
+         Pending.front().Data.wait_for(0s) == std::future_status::ready) {
+    writeOldestChunk();
+  }
+}
+
+void ChunkAssembler::flush() {
+  while (!Pending.empty()) {
+    writeOldestChunk();
+  }
+  auto RowsInChunk = CurrentChunk.size() / RowSize;
+  if (RowsInChunk > RowsWritten) {
+    writeRows(NextRow - RowsInChunk + RowsWritten,
+              CurrentChunk.data() + RowsWritten * RowSize,
+              RowsInChunk - RowsWritten);
+    RowsWritten = RowsInChunk;
+  }
+}
+
+void ChunkAssembler::submitCurrentChunk() {
+  // Limit the memory used by chunks waiting to be compressed or written.
+  while (Pending.size() >= MaxPendingChunks) {
+    writeOldestChunk();
+  }
+  auto ChunkData = std::move(CurrentChunk);
+  CurrentChunk.clear();
+  CurrentChunk.reserve(RowsPerChunk * RowSize);
+  RowsWritten = 0;
+  Pending.push_back({NextRow - RowsPerChunk,
+                     Pool.compress(std::move(ChunkData), Applied,
+                                   ElementSize)});
+}
+
+void ChunkAssembler::writeOldestChunk() {
+  auto Chunk = std::move(Pending.front());
+  Pending.pop_front();
+  auto Data = Chunk.Data.get();
+  hdf5::Dimensions Offset(RowShape.size() + 1, 0);
+  Offset[0] = Chunk.FirstRow;
+  if (H5Dwrite_chunk(static_cast<hid_t>(Dataset), H5P_DEFAULT, 0,
+                     Offset.data(), Data.size(), Data.data()) < 0) {
+    throw std::runtime_error("Failed to write compressed chunk.");
+  }
+}
+
+void ChunkAssembler::writeRows(hsize_t FirstRow, char const *Data,
+                               hsize_t NrOfRows) {
+  hdf5::Dimensions Block(RowShape);
+  Block.insert(Block.begin(), NrOfRows);
+  hdf5::Dimensions Offset(Block.size(), 0);
+  Offset[0] = FirstRow;
+  hdf5::dataspace::Simple MemorySpace(Block);
+  hdf5::dataspace::Dataspace FileSpace = Dataset.dataspace();
+  FileSpace.selection(hdf5::dataspace::SelectionOperation::Set,
+                      hdf5::dataspace::Hyperslab(Offset, Block));
+  if (H5Dwrite(static_cast<hid_t>(Dataset), static_cast<hid_t>(Type),
+               static_cast<hid_t>(MemorySpace), static_cast<hid_t>(FileSpace),
+               H5P_DEFAULT, Data) < 0) {
+    throw std::runtime_error("Failed to write rows of partial chunk.");
+  }
+}
+
+} // namespace NeXusDataset
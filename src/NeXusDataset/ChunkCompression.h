@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+/// \file
+/// \brief Compression of whole chunks on worker threads, for writing the
+/// chunks with direct chunk writes.
+
+#pragma once
+
+#include "Compression.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <h5cpp/hdf5.hpp>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NeXusDataset {
+
+/// \brief Check if compressChunk() can produce chunks for a dataset with the
+/// given (applied) compression.
+///
+/// Only deflate, with or without the shuffle filter, is supported.
+bool canCompressChunks(Compression const &Applied);
+
+/// \brief Compress a chunk the same way as the filter pipeline set up by
+/// applyCompression().
+///
+/// \param RawChunk The uncompressed data of a whole chunk.
+/// \param Applied The (applied) compression of the dataset, see
+/// canCompressChunks().
+/// \param ElementSize The size (in bytes) of the elements of the dataset,
+/// used by the shuffle filter.
+/// \return The compressed chunk, as expected by H5Dwrite_chunk().
+std::vector<char> compressChunk(std::vector<char> const &RawChunk,
+                                Compression const &Applied,
+                                size_t ElementSize);
+
+/// \brief Worker threads that compress chunks.
+class ChunkCompressionPool {
+public:
+  explicit ChunkCompressionPool(size_t NrOfThreads);
+  ~ChunkCompressionPool();
+
+  /// \brief Queue a chunk for compression with compressChunk().
+  std::future<std::vector<char>> compress(std::vector<char> RawChunk,
+                                          Compression const &Applied,
+                                          size_t ElementSize);
+
+  [[nodiscard]] size_t nrOfThreads() const { return Workers.size(); }
+
+  /// \brief Set the number of threads of the pool returned by instance().
+  ///
+  /// Has no effect after the first call of instance().
+  static void setNrOfThreads(size_t NrOfThreads);
+
+  /// \brief The pool shared by all files being written.
+  ///
+  /// \return nullptr if the number of threads is zero (the default).
+  static ChunkCompressionPool *instance();
+
+private:
+  void threadFunction();
+  std::mutex PoolMutex;
+  std::condition_variable TaskAvailable;
+  std::deque<std::packaged_task<void()>> Tasks;
+  bool RunThreads{true};
+  std::vector<std::thread> Workers;
+  static std::atomic<size_t> ConfiguredThreads;
+};
+
+/// \brief Writes rows of a chunked dataset as whole, compressed chunks.
+///
+/// A row is an element of the first (extensible) dimension of the dataset.
+/// Appended rows are collected in a chunk sized buffer. Full chunks are
+/// compressed by a ChunkCompressionPool and written with H5Dwrite_chunk(),
+/// bypassing the filter pipeline of the dataset. The rows of a partially
+/// filled chunk are written with a regular write (i.e. through the filter
+/// pipeline) by flush() and are written again as part of the whole chunk
+/// once it is full.
+///
+/// The extent of the dataset must include the appended rows and must not be
+/// reduced to less than the number of appended rows.
+class ChunkAssembler {
+public:
+  /// \brief Create an assembler if the chunks of a dataset can be written
+  /// with it.
+  ///
+  /// The compression of the dataset is read from the attributes written by
+  /// writeCompressionAttributes(). The chunks must contain whole rows.
+  /// \param Dataset The dataset.
+  /// \param Pool The threads compressing the chunks, can be nullptr.
+  /// \param NextRow The index of the first row to be appended.
+  /// \return The assembler, nullptr if direct chunk writes can not be used.
+  static std::unique_ptr<ChunkAssembler>
+  create(hdf5::node::Dataset const &Dataset, ChunkCompressionPool *Pool,
+         hsize_t NextRow);
+
+  ChunkAssembler(hdf5::node::Dataset Dataset, Compression const &Applied,
+                 ChunkCompressionPool &Pool, hsize_t NextRow);
+
+  /// \brief Check if data of a given type and row shape can be appended.
+  [[nodiscard]] bool accepts(hdf5::datatype::Datatype const &Type,
+                             hdf5::Dimensions const &RowShape) const;
+
+  /// \brief Append rows.
+  ///
+  /// \param Data The data of the rows, in the datatype of the dataset.
+  /// \param NrOfRows The number of rows.
+  void append(char const *Data, size_t NrOfRows);
+
+  /// \brief Write the chunks that have been compressed, without waiting for
+  /// the others.
+  void writeCompressedChunks();
+
+  /// \brief Write all chunks and the rows of the partially filled chunk.
+  void flush();
+
+  [[nodiscard]] hdf5::Dimensions const &rowShape() const { return RowShape; }
+
+private:
+  void submitCurrentChunk();
+  void writeOldestChunk();
+  void writeRows(hsize_t FirstRow, char const *Data, hsize_t NrOfRows);
+
+  struct PendingChunk {
+    hsize_t FirstRow{0};
+    std::future<std::vector<char>> Data;
+  };
+
+  hdf5::node::Dataset Dataset;
+  hdf5::datatype::Datatype Type;
+  Compression Applied;
+  ChunkCompressionPool &Pool;
+  size_t ElementSize{0};
+  hdf5::Dimensions RowShape;
+  hsize_t RowsPerChunk{1};
+  size_t RowSize{0};
+  hsize_t NextRow{0};
+  /// The rows appended to the chunk that NextRow is in.
+  std::vector<char> CurrentChunk;
+  /// Rows of the current chunk that have been written by flush().
+  hsize_t RowsWritten{0};
+  std::deque<PendingChunk> Pending;
+  size_t MaxPendingChunks{1};
+};
+
+} // namespace NeXusDataset
@@ -0,0 +1,159 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#include "Compression.h"
+#include "../logger.h"
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <vector>
+
+namespace NeXusDataset {
+
+namespace {
+/// Filter ids registered with The HDF Group.
+const H5Z_filter_t LZ4FilterId{32004};
+const H5Z_filter_t ZstdFilterId{32015};
+
+const int DefaultDeflateLevel{6};
+const int DefaultZstdLevel{3};
+
+bool setPluginFilter(hdf5::property::DatasetCreationList &CreationList,
+                     H5Z_filter_t FilterId,
+                     std::vector<unsigned int> const &Parameters) {
+  if (H5Zfilter_avail(FilterId) <= 0) {
+    return false;
+  }
+  return H5Pset_filter(static_cast<hid_t>(CreationList), FilterId,
+                       H5Z_FLAG_MANDATORY, Parameters.size(),
+                       Parameters.data()) >= 0;
+}
+} // namespace
+
+std::optional<CompressionFilter> compressionFilterFromString(std::string Name) {
+  std::transform(Name.begin(), Name.end(), Name.begin(),
+                 [](auto C) { return std::tolower(C); });
+  std::map<std::string, CompressionFilter> FilterMap{
+      {"none", CompressionFilter::NONE},
+      {"deflate", CompressionFilter::DEFLATE},
+      {"lz4", CompressionFilter::LZ4},
+      {"zstd", CompressionFilter::ZSTD}};
+  if (auto Found = FilterMap.find(Name); Found != FilterMap.end()) {
+    return Found->second;
+  }
+  return std::nullopt;
+}
+
+std::string toString(CompressionFilter Filter) {
+  switch (Filter) {
+  case CompressionFilter::DEFLATE:
+    return "deflate";
+  case CompressionFilter::LZ4:
+    return "lz4";
+  case CompressionFilter::ZSTD:
+    return "zstd";
+  case CompressionFilter::NONE:
+    break;
+  }
+  return "none";
+}
+
+Compression
+applyCompression(Compression const &Settings,
+                 hdf5::property::DatasetCreationList &CreationList) {
+  Compression Applied{Settings};
+  bool FilterSet{false};
+  switch (Settings.Filter) {
+  case CompressionFilter::NONE:
+    return {};
+  case CompressionFilter::DEFLATE:
+    Applied.Level = std::clamp(
+        Settings.Level < 0 ? DefaultDeflateLevel : Settings.Level, 0, 9);
+    if (Applied.Shuffle) {
+      H5Pset_shuffle(static_cast<hid_t>(CreationList));
+    }
+    FilterSet = H5Pset_deflate(static_cast<hid_t>(CreationList),
+                               static_cast<unsigned>(Applied.Level)) >= 0;
+    break;
+  case CompressionFilter::LZ4:
+    // The LZ4 filter has no compression level.
+    Applied.Level = 0;
+    if (Applied.Shuffle && H5Zfilter_avail(LZ4FilterId) > 0) {
+      H5Pset_shuffle(static_cast<hid_t>(CreationList));
+    }
+    FilterSet = setPluginFilter(CreationList, LZ4FilterId, {});
+    break;
+  case CompressionFilter::ZSTD:
+    Applied.Level = Settings.Level < 0 ? DefaultZstdLevel : Settings.Level;
+    if (Applied.Shuffle && H5Zfilter_avail(ZstdFilterId) > 0) {
+      H5Pset_shuffle(static_cast<hid_t>(CreationList));
+    }
+    FilterSet = setPluginFilter(CreationList, ZstdFilterId,
+                                {static_cast<unsigned>(Applied.Level)});
+    break;
+  }
+  if (!FilterSet) {
+    Logger::Error(R"(Compression filter "{}" is not available, the data will )"
+                  R"(not be compressed.)",
+                  toString(Settings.Filter));
+    return {};
+  }
+  return Applied;
+}
+
+void writeCompressionAttributes(hdf5::node::Dataset &Dataset,
+                                Compression const &Applied) {
+  if (Applied.Filter == CompressionFilter::NONE) {
+    return;
+  }
+  Dataset.attributes.create<std::string>("compression")
+      .write(toString(Applied.Filter));
+  Dataset.attributes.create<std::int32_t>("compression_level")
+      .write(std::int32_t(Applied.Level));
+  Dataset.attributes.create<std::int32_t>("compression_shuffle")
+      .write(std::int32_t(Applied.Shuffle));
+}
+
+Compression readCompressionAttributes(hdf5::node::Dataset const &Dataset) {
+  if (!Dataset.attributes.exists("compression")) {
+    return {};
+  }
+  std::string FilterName;
+  Dataset.attributes["compression"].read(FilterName);
+  auto Filter = compressionFilterFromString(FilterName);
+  if (!Filter) {
+    return {};
+  }
+  std::int32_t Level{-1};
+  if (Dataset.attributes.exists("compression_level")) {
+    Dataset.attributes["compression_level"].read(Level);
+  }
+  std::int32_t Shuffle{0};
+  if (Dataset.attributes.exists("compression_shuffle")) {
+    Dataset.attributes["compression_shuffle"].read(Shuffle);
+  }
+  return {*Filter, Level, Shuffle != 0};
+}
+
+hdf5::node::Dataset createCompressedDataset(
+    hdf5::node::Group const &Parent, std::string const &Name,
+    hdf5::datatype::Datatype const &Type, hdf5::Dimensions const &Shape,
+    hdf5::Dimensions const &MaxShape, hdf5::Dimensions const &ChunkShape,
+    Compression const &Settings) {
+  hdf5::property::DatasetCreationList CreationList;
+  CreationList.layout(hdf5::property::DatasetLayout::Chunked);
+  CreationList.chunk(ChunkShape);
+  auto Applied = applyCompression(Settings, CreationList);
+  auto Dataset = Parent.create_dataset(
+      Name, Type, hdf5::dataspace::Simple(Shape, MaxShape), CreationList);
+  writeCompressionAttributes(Dataset, Applied);
+  return Dataset;
+}
+
+} // namespace NeXusDataset
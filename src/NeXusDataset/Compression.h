@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+/// \file
+/// \brief Compression (filter pipeline) settings of datasets.
+
+#pragma once
+
+#include <h5cpp/hdf5.hpp>
+#include <optional>
+#include <string>
+
+namespace NeXusDataset {
+
+/// \brief The compression filters that can be used.
+///
+/// LZ4 and ZSTD require the corresponding (registered) HDF5 filter plugins.
+enum class CompressionFilter { NONE, DEFLATE, LZ4, ZSTD };
+
+/// \brief Get the filter from its (case insensitive) name.
+///
+/// \param Name One of "none", "deflate", "lz4" or "zstd".
+/// \return The filter or std::nullopt if the name is not known.
+std::optional<CompressionFilter> compressionFilterFromString(std::string Name);
+
+std::string toString(CompressionFilter Filter);
+
+/// \brief The compression of a dataset.
+struct Compression {
+  CompressionFilter Filter{CompressionFilter::NONE};
+  /// Compression level, negative for the default level of the filter.
+  int Level{-1};
+  /// Apply the byte shuffle filter before compressing.
+  bool Shuffle{false};
+};
+
+/// \brief Add the filters of \p Settings to a dataset creation property list.
+///
+/// If a filter plugin is not available, the data is written uncompressed and
+/// an error is logged.
+/// \param Settings The requested compression.
+/// \param CreationList The property list of a (chunked) dataset.
+/// \return The compression that was actually applied.
+Compression applyCompression(Compression const &Settings,
+                             hdf5::property::DatasetCreationList &CreationList);
+
+/// \brief Record the applied compression as attributes of a dataset.
+///
+/// Writes the "compression", "compression_level" and "compression_shuffle"
+/// attributes. Nothing is written for uncompressed datasets.
+void writeCompressionAttributes(hdf5::node::Dataset &Dataset,
+                                Compression const &Applied);
+
+/// \brief Get the compression recorded by writeCompressionAttributes().
+///
+/// \return The compression, Filter is NONE if there are no (known)
+/// compression attributes.
+Compression readCompressionAttributes(hdf5::node::Dataset const &Dataset);
+
+/// \brief Create a chunked dataset with the given compression.
+///
+/// The applied compression is recorded with writeCompressionAttributes().
+hdf5::node::Dataset createCompressedDataset(
+    hdf5::node::Group const &Parent, std::string const &Name,
+    hdf5::datatype::Datatype const &Type, hdf5::Dimensions const &Shape,
+    hdf5::Dimensions const &MaxShape, hdf5::Dimensions const &ChunkShape,
+    Compression const &Settings);
+
+} // namespace NeXusDataset
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "NeXusDataset.h"
+#include "StringDataset.h"
 
 namespace NeXusDataset {
 
@@ -24,13 +25,16 @@ public:
 };
 
 /// \brief Represents a dataset with the name "alarm_message".
-class AlarmMsg : public FixedSizeString {
+///
+/// See StringDataset for the datasets used by the different encodings.
+class AlarmMsg : public StringDataset {
 public:
   AlarmMsg() = default;
-  AlarmMsg(hdf5::node::Group const &Parent, Mode CMode, size_t StringSize = 200,
-           size_t ChunkSize = 1024)
-      : FixedSizeString(Parent, "alarm_message", CMode, StringSize,
-                        ChunkSize){};
+  AlarmMsg(hdf5::node::Group const &Parent, Mode CMode,
+           StringEncoding Encoding = StringEncoding::FIXED,
+           size_t StringSize = 200, size_t ChunkSize = 1024)
+      : StringDataset(Parent, "alarm_message", CMode, Encoding, StringSize,
+                      ChunkSize){};
 };
 
 /// \brief Represents a dataset with the name "alarm_severity".
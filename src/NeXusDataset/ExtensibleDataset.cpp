@@ -14,22 +14,20 @@
 namespace NeXusDataset {
 FixedSizeString::FixedSizeString(const hdf5::node::Group &Parent,
                                  std::string const &Name, Mode CMode,
-                                 size_t StringSize, size_t ChunkSize)
+                                 size_t StringSize, size_t ChunkSize,
+                                 Compression const &Settings)
     : StringType(hdf5::datatype::String::fixed(StringSize)),
       MaxStringSize(StringSize) {
   StringType.encoding(hdf5::datatype::CharacterEncoding::UTF8);
   StringType.padding(hdf5::datatype::StringPad::NullTerm);
   if (Mode::Create == CMode) {
-    _dataset = hdf5::node::ChunkedDataset(
-        Parent, Name, StringType,
-        hdf5::dataspace::Simple({0}, {hdf5::dataspace::Simple::unlimited}),
-        {
-            static_cast<unsigned long long>(ChunkSize),
-        });
+    _dataset = createCompressedDataset(
+        Parent, Name, StringType, {0}, {hdf5::dataspace::Simple::unlimited},
+        {static_cast<unsigned long long>(ChunkSize)}, Settings);
   } else if (Mode::Open == CMode) {
     _dataset = Parent.get_dataset(Name);
-    hdf5::datatype::String Type(_dataset.datatype());
-    MaxStringSize = Type.size();
+    StringType = hdf5::datatype::String(_dataset.datatype());
+    MaxStringSize = StringType.size();
     NrOfStrings = static_cast<size_t>(_dataset.dataspace().size());
   } else {
     throw std::runtime_error(
@@ -37,14 +35,61 @@ FixedSizeString::FixedSizeString(const hdf5::node::Group &Parent,
   }
 }
 
+FixedSizeString &FixedSizeString::operator=(FixedSizeString &&Other) {
+  flushBuffer();
+  _dataset = std::move(Other._dataset);
+  StringType = std::move(Other.StringType);
+  MaxStringSize = Other.MaxStringSize;
+  NrOfStrings = Other.NrOfStrings;
+  BufferedStrings = std::move(Other.BufferedStrings);
+  // Leave nothing for the moved from object to write.
+  Other.BufferedStrings.clear();
+  return *this;
+}
+
+FixedSizeString::~FixedSizeString() {
+  try {
+    flushBuffer();
+  } catch (std::exception &E) {
+    Logger::Error("Failed to write buffered strings to dataset: {}", E.what());
+  }
+}
+
 void FixedSizeString::appendStringElement(std::string const &InString) {
-  _dataset.extent(0, 1);
-  hdf5::dataspace::Hyperslab Selection{{NrOfStrings}, {1}};
-  hdf5::dataspace::Scalar ScalarSpace;
-  hdf5::dataspace::Dataspace FileSpace = _dataset.dataspace();
-  FileSpace.selection(hdf5::dataspace::SelectionOperation::Set, Selection);
-  _dataset.write(InString, StringType, ScalarSpace, FileSpace);
+  auto Offset = BufferedStrings.size();
+  BufferedStrings.resize(Offset + MaxStringSize, '\0');
+  std::copy_n(InString.begin(), std::min(InString.size(), MaxStringSize),
+              BufferedStrings.begin() + Offset);
   NrOfStrings += 1;
+  if (BufferedStrings.size() >= MaxBufferedStrings * MaxStringSize) {
+    flushBuffer();
+  }
+}
+
+void FixedSizeString::flushBuffer() {
+  if (BufferedStrings.empty()) {
+    return;
+  }
+  hsize_t NrOfBuffered = BufferedStrings.size() / MaxStringSize;
+  try {
+    _dataset.extent({NrOfStrings});
+    hdf5::dataspace::Simple MemorySpace({NrOfBuffered});
+    hdf5::dataspace::Dataspace FileSpace = _dataset.dataspace();
+    FileSpace.selection(
+        hdf5::dataspace::SelectionOperation::Set,
+        hdf5::dataspace::Hyperslab{{NrOfStrings - NrOfBuffered},
+                                   {NrOfBuffered}});
+    if (H5Dwrite(static_cast<hid_t>(_dataset), static_cast<hid_t>(StringType),
+                 static_cast<hid_t>(MemorySpace), static_cast<hid_t>(FileSpace),
+                 H5P_DEFAULT, BufferedStrings.data()) < 0) {
+      throw std::runtime_error("Failed to write strings to dataset.");
+    }
+  } catch (...) {
+    // Do not try to write the same strings again.
+    BufferedStrings.clear();
+    throw;
+  }
+  BufferedStrings.clear();
 }
 
 } // namespace NeXusDataset
\ No newline at end of file
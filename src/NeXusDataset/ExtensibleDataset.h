@@ -15,9 +15,19 @@
 #pragma once
 
 #include "../logger.h"
+#include "ChunkCompression.h"
+#include "Compression.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
 #include <h5cpp/dataspace/simple.hpp>
 #include <h5cpp/hdf5.hpp>
 #include <h5cpp/utilities/array_adapter.hpp>
+#include <memory>
+#include <numeric>
+#include <type_traits>
+#include <typeindex>
+#include <vector>
 
 namespace hdf5::datatype {
 
@@ -141,11 +151,71 @@ enum class Mode { Create, Open };
 ///
 /// This base class is used in order to have templated child classes that can
 /// override/inherit the member functions of this class.
+///
+/// Elements appended with appendElement() are buffered in memory and written
+/// to the dataset (with one write) when a chunk's worth of elements has been
+/// buffered, when flushBuffer() is called, before any other write or read of
+/// the dataset and on destruction.
+///
+/// The extent of the dataset is tracked in memory and set to exactly the
+/// number of elements written by each write, so that (SWMR) readers never
+/// see elements that have not been written. Capacity is only reserved in
+/// memory, for the buffered elements. Writer modules must call flushBuffer()
+/// from WriterModule::Base::flushBuffers() so that the buffered elements are
+/// written before the file is flushed.
+///
+/// If enabled with useDirectChunkWrites(), the data is instead compressed in
+/// whole chunks by a ChunkCompressionPool, see ChunkAssembler.
 class ExtensibleDatasetBase {
 public:
   /// \brief Constructor.
   ExtensibleDatasetBase() = default;
 
+  ExtensibleDatasetBase(ExtensibleDatasetBase const &) = delete;
+  ExtensibleDatasetBase(ExtensibleDatasetBase &&Other) {
+    *this = std::move(Other);
+  }
+  ExtensibleDatasetBase &operator=(ExtensibleDatasetBase const &) = delete;
+
+  /// \brief Calls flushBuffer() before taking over the dataset of \p Other.
+  ExtensibleDatasetBase &operator=(ExtensibleDatasetBase &&Other) {
+    flushBuffer();
+    _dataset = std::move(Other._dataset);
+    MemorySpace = std::move(Other.MemorySpace);
+    MemorySpaceSize = Other.MemorySpaceSize;
+    FileSpace = std::move(Other.FileSpace);
+    MaxDimensions = std::move(Other.MaxDimensions);
+    FileSpaceIsCached = Other.FileSpaceIsCached;
+    Other.FileSpaceIsCached = false;
+    ArrayType = Other.ArrayType;
+    ArrayMemoryType = std::move(Other.ArrayMemoryType);
+    NewDimensions = std::move(Other.NewDimensions);
+    ArraySelection = std::move(Other.ArraySelection);
+    Dtpl = std::move(Other.Dtpl);
+    NrOfElements = Other.NrOfElements;
+    Extent = Other.Extent;
+    ChunkSize = Other.ChunkSize;
+    BufferedData = std::move(Other.BufferedData);
+    // Leave nothing for the moved from object to write.
+    Other.BufferedData.clear();
+    BufferedType = Other.BufferedType;
+    BufferedMemoryType = std::move(Other.BufferedMemoryType);
+    BufferedElementSize = Other.BufferedElementSize;
+    BufferCapacity = Other.BufferCapacity;
+    DirectChunks = std::move(Other.DirectChunks);
+    return *this;
+  }
+
+  /// \brief Calls flushBuffer().
+  ~ExtensibleDatasetBase() {
+    try {
+      flushBuffer();
+    } catch (std::exception &E) {
+      Logger::Error("Failed to write buffered elements to dataset: {}",
+                    E.what());
+    }
+  }
+
   /// \brief Open a dataset.
   ///
   /// \param parent The group/node where the dataset to be opened is located.
@@ -161,15 +231,46 @@ public:
           "Can only open datasets, not create.");
     } else if (Mode::Open == mode) {
       _dataset = parent.get_dataset(name);
+      NrOfElements = static_cast<size_t>(_dataset.dataspace().size());
+      Extent = NrOfElements;
+    } else {
+      throw std::runtime_error(
+          "ExtensibleDatasetBase::ExtensibleDatasetBase(): Unknown mode.");
+    }
+  }
+
+  /// \brief Create or open a dataset with elements of a given datatype.
+  ///
+  /// \param Parent The group/node of the dataset.
+  /// \param Name The name of the dataset.
+  /// \param CMode Should the dataset be opened or created.
+  /// \param Type The datatype of the elements, ignored if the dataset is
+  /// opened.
+  /// \param ChunkSize The chunk size (as number of elements) of the dataset,
+  /// ignored if the dataset is opened.
+  /// \param Settings The compression of the dataset, ignored if the dataset
+  /// is opened.
+  ExtensibleDatasetBase(hdf5::node::Group const &Parent,
+                        std::string const &Name, Mode CMode,
+                        hdf5::datatype::Datatype const &Type, size_t ChunkSize,
+                        Compression const &Settings) {
+    if (Mode::Create == CMode) {
+      _dataset = createCompressedDataset(
+          Parent, Name, Type, {0}, {hdf5::dataspace::Simple::unlimited},
+          {static_cast<unsigned long long>(ChunkSize)}, Settings);
+    } else if (Mode::Open == CMode) {
+      _dataset = Parent.get_dataset(Name);
+      NrOfElements = static_cast<size_t>(_dataset.dataspace().size());
+      Extent = NrOfElements;
     } else {
       throw std::runtime_error(
           "ExtensibleDatasetBase::ExtensibleDatasetBase(): Unknown mode.");
     }
   }
 
-  /// Gets the current size of the dataset.
+  /// Gets the current size of the dataset, including buffered elements.
   [[nodiscard]] hssize_t current_size() const {
-    return _dataset.dataspace().size();
+    return static_cast<hssize_t>(NrOfElements);
   }
 
   /// Read the current data in the dataset.
@@ -177,6 +278,7 @@ public:
   ///
   /// \param buffer
   template <typename T> void read_data(std::vector<T> &buffer) {
+    flushBuffer();
     _dataset.read(buffer);
   }
 
@@ -184,48 +286,71 @@ public:
   /// Only for use in tests.
   ///
   /// \param buffer
-  template <typename T> void read_data(T &buffer) { _dataset.read(buffer); }
+  template <typename T> void read_data(T &buffer) {
+    flushBuffer();
+    _dataset.read(buffer);
+  }
 
   /// Access the underlying dataset.
   /// Only for use in tests.
   [[nodiscard]] hdf5::node::Dataset const &dataset() const { return _dataset; }
 
-  /// Append data to dataset that is contained in some sort of container.
+  /// Append data to dataset that is contained in some sort of container
+  /// (e.g. std::vector or hdf5::ArrayAdapter).
   template <typename T> void appendArray(T const &data) {
-    _dataset.extent(0, data.size());
-    hdf5::dataspace::Hyperslab selection{
-        {NrOfElements}, {static_cast<unsigned long long>(data.size())}};
-    _dataset.write(data, selection);
-    NrOfElements += data.size();
+    appendValues(data.data(), data.size());
   }
 
   /// Append single scalar values to dataset.
+  ///
+  /// The value is buffered, see flushBuffer().
   template <typename T> void appendElement(T const &element) {
-    _dataset.extent(0, 1);
-    hdf5::dataspace::Hyperslab selection{{NrOfElements}, {1}};
-    _dataset.write(element, selection);
+    using ElementType = std::remove_cv_t<T>;
+    static_assert(std::is_trivially_copyable_v<ElementType>,
+                  "Only scalar values can be appended as elements.");
+    if (BufferedType != typeid(ElementType)) {
+      writeBufferedElements();
+      BufferedType = typeid(ElementType);
+      BufferedMemoryType = hdf5::datatype::create<ElementType>();
+      BufferedElementSize = sizeof(ElementType);
+    }
+    if (BufferCapacity == 0) {
+      BufferCapacity = std::min<size_t>(chunkSize(), MaxBufferedElements);
+      BufferedData.reserve(BufferCapacity * sizeof(ElementType));
+    }
+    auto Offset = BufferedData.size();
+    BufferedData.resize(Offset + sizeof(ElementType));
+    std::memcpy(BufferedData.data() + Offset, &element, sizeof(ElementType));
     NrOfElements += 1;
+    if (nrOfBufferedElements() >= BufferCapacity) {
+      writeBufferedElements();
+    }
   }
 
-  template <class DataType>
-  void appendArray(hdf5::ArrayAdapter<const DataType> const &data) {
-    if (data.size() == 0) {
-      return;
+  /// \brief Write the elements buffered by appendElement() to the dataset.
+  void flushBuffer() {
+    writeBufferedElements();
+    if (DirectChunks) {
+      DirectChunks->flush();
     }
-    NewDimensions[0] = NrOfElements + data.size();
-    _dataset.resize(NewDimensions);
-    ArraySelection.offset({NrOfElements});
-    ArraySelection.block({static_cast<unsigned long long>(data.size())});
+  }
 
-    ArrayDataSpace.dimensions({data.size()}, {data.size()});
-    hdf5::dataspace::Dataspace file_space = _dataset.dataspace();
-    file_space.selection(hdf5::dataspace::SelectionOperation::Set,
-                         ArraySelection);
-    hdf5::datatype::Datatype array_value_type{
-        hdf5::datatype::create(DataType())};
-    _dataset.write(data, array_value_type, ArrayDataSpace, file_space, Dtpl);
+  /// \brief Write whole chunks compressed by \p Pool with direct chunk writes.
+  ///
+  /// Only has an effect if \p Pool is not nullptr and the (recorded)
+  /// compression of the dataset is supported by compressChunk().
+  void useDirectChunkWrites(ChunkCompressionPool *Pool) {
+    writeBufferedElements();
+    DirectChunks = ChunkAssembler::create(_dataset, Pool, NrOfElements);
+  }
 
-    NrOfElements += data.size();
+  /// \brief The number of elements appended but not yet written to the
+  /// dataset.
+  [[nodiscard]] size_t nrOfBufferedElements() const {
+    if (BufferedElementSize == 0) {
+      return 0;
+    }
+    return BufferedData.size() / BufferedElementSize;
   }
 
   [[nodiscard]] size_t size() const { return NrOfElements; }
@@ -248,15 +373,186 @@ public:
   /// \brief Read data from the dataset.
   ///
   /// Note: only for use in tests!
-  template <typename T> void read(T &result) { _dataset.read(result); }
+  template <typename T> void read(T &result) {
+    flushBuffer();
+    _dataset.read(result);
+  }
 
 protected:
+  /// \brief Append values to the dataset.
+  template <typename T> void appendValues(T const *Data, size_t Size) {
+    if (Size == 0 || appendDirect(Data, Size)) {
+      return;
+    }
+    writeBufferedElements();
+    extendTo(NrOfElements + Size);
+    writeValues(reinterpret_cast<char const *>(Data), arrayMemoryType<T>(),
+                NrOfElements, Size);
+    NrOfElements += Size;
+  }
+
+  /// \brief Append data with direct chunk writes, if enabled.
+  ///
+  /// \return False if the data was not appended.
+  template <typename T> bool appendDirect(T const *Data, size_t Size) {
+    if (!DirectChunks) {
+      return false;
+    }
+    writeBufferedElements();
+    if (DirectChunks && !DirectChunks->accepts(arrayMemoryType<T>(), {})) {
+      stopDirectChunkWrites();
+    }
+    if (!DirectChunks) {
+      return false;
+    }
+    extendTo(NrOfElements + Size);
+    DirectChunks->append(reinterpret_cast<char const *>(Data), Size);
+    NrOfElements += Size;
+    DirectChunks->writeCompressedChunks();
+    return true;
+  }
+
+  /// \brief Write all data of the direct chunk writes and go back to writing
+  /// through the filter pipeline.
+  void stopDirectChunkWrites() {
+    Logger::Info("Data type does not match the dataset, not using direct "
+                 "chunk writes for it anymore.");
+    auto Assembler = std::move(DirectChunks);
+    Assembler->flush();
+  }
+
+  /// \brief Write the elements buffered by appendElement() to the dataset.
+  void writeBufferedElements() {
+    auto NrOfBuffered = nrOfBufferedElements();
+    if (NrOfBuffered == 0) {
+      return;
+    }
+    if (DirectChunks && !DirectChunks->accepts(BufferedMemoryType, {})) {
+      stopDirectChunkWrites();
+    }
+    try {
+      extendTo(NrOfElements);
+      if (DirectChunks) {
+        DirectChunks->append(BufferedData.data(), NrOfBuffered);
+        DirectChunks->writeCompressedChunks();
+        BufferedData.clear();
+        return;
+      }
+      writeValues(BufferedData.data(), BufferedMemoryType,
+                  NrOfElements - NrOfBuffered, NrOfBuffered);
+    } catch (...) {
+      // Do not try to write the same elements again.
+      BufferedData.clear();
+      throw;
+    }
+    BufferedData.clear();
+  }
+
+  /// \brief Set the extent of the dataset to \p Size elements, if it is
+  /// smaller.
+  void extendTo(hsize_t Size) {
+    if (Size > Extent) {
+      setExtent(Size);
+    }
+  }
+
+  /// \brief Set the extent of the dataset and of the cached file dataspace.
+  void setExtent(hsize_t NewSize) {
+    NewDimensions[0] = NewSize;
+    _dataset.resize(NewDimensions);
+    Extent = NewSize;
+    if (FileSpaceIsCached) {
+      FileSpace.dimensions(NewDimensions, MaxDimensions);
+    }
+  }
+
+  /// \brief The file dataspace of the dataset.
+  ///
+  /// Getting the dataspace from the dataset creates a new dataspace (and
+  /// handle) every time. It is instead got once and its extent is updated by
+  /// setExtent().
+  hdf5::dataspace::Simple &fileSpace() {
+    if (!FileSpaceIsCached) {
+      FileSpace = hdf5::dataspace::Simple(_dataset.dataspace());
+      MaxDimensions = FileSpace.maximum_dimensions();
+      FileSpaceIsCached = true;
+    }
+    return FileSpace;
+  }
+
+  /// \brief The memory datatype of arrays of \p T, created once per type.
+  template <typename T> hdf5::datatype::Datatype const &arrayMemoryType() {
+    if (ArrayType != typeid(T)) {
+      ArrayMemoryType = hdf5::datatype::create<T>();
+      ArrayType = typeid(T);
+    }
+    return ArrayMemoryType;
+  }
+
+  /// \brief Write values to the dataset (which must be large enough).
+  ///
+  /// Only the selection and the write itself are done per call, the memory
+  /// dataspace is re-used while the number of values is unchanged.
+  /// \param Data The values.
+  /// \param MemoryType The datatype of the values.
+  /// \param Offset The index of the first value in the dataset.
+  /// \param NrOfValues The number of values.
+  void writeValues(char const *Data, hdf5::datatype::Datatype const &MemoryType,
+                   hsize_t Offset, hsize_t NrOfValues) {
+    if (MemorySpaceSize != NrOfValues) {
+      MemorySpace.dimensions({NrOfValues}, {NrOfValues});
+      MemorySpaceSize = NrOfValues;
+    }
+    ArraySelection.offset({Offset});
+    ArraySelection.block({NrOfValues});
+    auto &Space = fileSpace();
+    Space.selection(hdf5::dataspace::SelectionOperation::Set, ArraySelection);
+    if (H5Dwrite(static_cast<hid_t>(_dataset), static_cast<hid_t>(MemoryType),
+                 static_cast<hid_t>(MemorySpace), static_cast<hid_t>(Space),
+                 static_cast<hid_t>(Dtpl), Data) < 0) {
+      throw std::runtime_error("Failed to write values to dataset.");
+    }
+  }
+
+  /// \brief The size (in elements) of the first dimension of the chunks, 1
+  /// if the dataset is not chunked.
+  hsize_t chunkSize() {
+    if (ChunkSize == 0) {
+      auto CreationList = _dataset.creation_list();
+      ChunkSize = 1;
+      if (CreationList.layout() == hdf5::property::DatasetLayout::Chunked) {
+        ChunkSize = std::max<hsize_t>(CreationList.chunk().at(0), 1);
+      }
+    }
+    return ChunkSize;
+  }
+
   hdf5::node::Dataset _dataset;
-  hdf5::dataspace::Simple ArrayDataSpace;
+  hdf5::dataspace::Simple MemorySpace;
+  hsize_t MemorySpaceSize{0};
+  /// Has the extent of the dataset, see fileSpace().
+  hdf5::dataspace::Simple FileSpace;
+  hdf5::Dimensions MaxDimensions;
+  bool FileSpaceIsCached{false};
+  std::type_index ArrayType{typeid(void)};
+  hdf5::datatype::Datatype ArrayMemoryType;
   hdf5::Dimensions NewDimensions{0};
   hdf5::dataspace::Hyperslab ArraySelection{{0}, {1}};
   hdf5::property::DatasetTransferList Dtpl;
+  /// Includes the buffered elements.
   size_t NrOfElements{0};
+  /// The extent of the dataset, the number of elements written.
+  hsize_t Extent{0};
+  hsize_t ChunkSize{0};
+
+  static constexpr size_t MaxBufferedElements{16384};
+  std::vector<char> BufferedData;
+  std::type_index BufferedType{typeid(void)};
+  hdf5::datatype::Datatype BufferedMemoryType;
+  size_t BufferedElementSize{0};
+  size_t BufferCapacity{0};
+
+  std::unique_ptr<ChunkAssembler> DirectChunks;
 };
 
 /// h5cpp dataset class that implements methods for appending data.
@@ -270,19 +566,21 @@ public:
   /// \param CMode Should the dataset be opened or created.
   /// \param ChunkSize The hunk size (as number of elements) of the dataset,
   /// ignored if the dataset is opened.
+  /// \param Settings The compression of the dataset, ignored if the dataset
+  /// is opened.
   ExtensibleDataset(hdf5::node::Group const &Parent, std::string Name,
-                    Mode CMode, size_t ChunkSize = 1024)
+                    Mode CMode, size_t ChunkSize = 1024,
+                    Compression const &Settings = {})
       : ExtensibleDatasetBase() {
     if (Mode::Create == CMode) {
-      _dataset = hdf5::node::ChunkedDataset(
-          Parent, Name, hdf5::datatype::create<DataType>(),
-          hdf5::dataspace::Simple({0}, {hdf5::dataspace::Simple::unlimited}),
-          {
-              static_cast<unsigned long long>(ChunkSize),
-          });
+      _dataset = createCompressedDataset(
+          Parent, Name, hdf5::datatype::create<DataType>(), {0},
+          {hdf5::dataspace::Simple::unlimited},
+          {static_cast<unsigned long long>(ChunkSize)}, Settings);
     } else if (Mode::Open == CMode) {
       _dataset = Parent.get_dataset(Name);
       NrOfElements = static_cast<size_t>(_dataset.dataspace().size());
+      Extent = NrOfElements;
     } else {
       throw std::runtime_error(
           "ExtensibleDataset::ExtensibleDataset(): Unknown mode.");
@@ -290,10 +588,25 @@ public:
   }
 };
 
-/// \brief
+/// \brief A dataset of fixed length strings.
+///
+/// Appended strings are buffered in memory and written to the dataset (with
+/// one write) when MaxBufferedStrings strings have been buffered, when
+/// flushBuffer() is called and on destruction.
 class FixedSizeString {
 public:
   FixedSizeString() = default;
+
+  FixedSizeString(FixedSizeString const &) = delete;
+  FixedSizeString(FixedSizeString &&Other) { *this = std::move(Other); }
+  FixedSizeString &operator=(FixedSizeString const &) = delete;
+
+  /// \brief Calls flushBuffer() before taking over the dataset of \p Other.
+  FixedSizeString &operator=(FixedSizeString &&Other);
+
+  /// \brief Calls flushBuffer().
+  ~FixedSizeString();
+
   /// \brief Create/open a fixed string length datatset.
   ///
   /// \param Parent The group/node where the dataset is to be located.
@@ -301,8 +614,10 @@ public:
   /// \param CMode Should the dataset be opened or created.
   /// \param StringSize What is the maximum number of characters in the string.
   /// \param ChunkSize The number of strings in one chunk.
+  /// \param Settings The compression of the dataset (if/when creating it).
   FixedSizeString(hdf5::node::Group const &Parent, std::string const &Name,
-                  Mode CMode, size_t StringSize = 300, size_t ChunkSize = 1024);
+                  Mode CMode, size_t StringSize = 300, size_t ChunkSize = 1024,
+                  Compression const &Settings = {});
 
   /// \brief Get max string size.
   ///
@@ -313,12 +628,17 @@ public:
 
   /// \brief Append a new string to the dataset array
   ///
+  /// The string is truncated to the max string size and buffered, see
+  /// flushBuffer().
   /// \param InString The string that is to be appended to the dataset.
   void appendStringElement(std::string const &InString);
 
-  /// Gets the current size of the dataset.
+  /// \brief Write the buffered strings to the dataset.
+  void flushBuffer();
+
+  /// Gets the current size of the dataset, including buffered strings.
   [[nodiscard]] hssize_t current_size() const {
-    return _dataset.dataspace().size();
+    return static_cast<hssize_t>(NrOfStrings);
   }
 
   /// \brief Read a string element from the dataset array.
@@ -328,7 +648,8 @@ public:
   ///
   /// \param offset The index of the element to read.
   /// \return The string value.
-  [[nodiscard]] std::string read_element(uint64_t offset) const {
+  [[nodiscard]] std::string read_element(uint64_t offset) {
+    flushBuffer();
     std::string result;
     _dataset.read(result, _dataset.datatype(), hdf5::dataspace::Scalar(),
                   hdf5::dataspace::Hyperslab{{offset}, {1}});
@@ -336,16 +657,65 @@ public:
   }
 
 private:
+  static constexpr size_t MaxBufferedStrings{1024};
   hdf5::node::Dataset _dataset;
   hdf5::datatype::String StringType;
   size_t MaxStringSize{300};
+  /// Includes the buffered strings.
   size_t NrOfStrings{0};
+  /// The buffered strings, MaxStringSize characters each.
+  std::vector<char> BufferedStrings;
 };
 
+/// \brief The base class for datasets with an extensible first dimension.
+///
+/// If enabled with setFramesPerWrite(), appended arrays (frames) are
+/// collected in memory and appended with one write. If enabled with
+/// useDirectChunkWrites(), the data is compressed in whole chunks by a
+/// ChunkCompressionPool, see ChunkAssembler. Writer modules must in both
+/// cases call flushBuffer() from WriterModule::Base::flushBuffers().
 class MultiDimDatasetBase {
 public:
   MultiDimDatasetBase() = default;
 
+  MultiDimDatasetBase(MultiDimDatasetBase const &) = delete;
+  MultiDimDatasetBase(MultiDimDatasetBase &&Other) {
+    *this = std::move(Other);
+  }
+  MultiDimDatasetBase &operator=(MultiDimDatasetBase const &) = delete;
+
+  /// \brief Calls flushBuffer() before taking over the dataset of \p Other.
+  MultiDimDatasetBase &operator=(MultiDimDatasetBase &&Other) {
+    flushBuffer();
+    _dataset = std::move(Other._dataset);
+    DirectChunks = std::move(Other.DirectChunks);
+    Extent = std::move(Other.Extent);
+    MaxExtent = std::move(Other.MaxExtent);
+    FileSpace = std::move(Other.FileSpace);
+    ExtentIsCached = Other.ExtentIsCached;
+    Other.ExtentIsCached = false;
+    MemorySpace = std::move(Other.MemorySpace);
+    MemoryShape = std::move(Other.MemoryShape);
+    MemoryTypeIndex = Other.MemoryTypeIndex;
+    MemoryType = std::move(Other.MemoryType);
+    FramesPerWrite = Other.FramesPerWrite;
+    StagedData = std::move(Other.StagedData);
+    StagedFrames = Other.StagedFrames;
+    // Leave nothing for the moved from object to write.
+    Other.StagedData.clear();
+    Other.StagedFrames = 0;
+    return *this;
+  }
+
+  /// \brief Calls flushBuffer().
+  ~MultiDimDatasetBase() {
+    try {
+      flushBuffer();
+    } catch (std::exception &E) {
+      Logger::Error("Failed to write chunks to dataset: {}", E.what());
+    }
+  }
+
   /// \brief Open a dataset.
   ///
   /// \param Parent The group/node where the dataset to be opened is located.
@@ -386,8 +756,14 @@ public:
     return _dataset.attributes.exists(name);
   }
 
-  /// \brief Get the dimensions of the dataset.
+  /// \brief Get the dimensions of the dataset, including frames that have
+  /// not been written yet.
   [[nodiscard]] std::vector<hsize_t> dimensions() const {
+    if (ExtentIsCached) {
+      auto CurrentExtent = Extent;
+      CurrentExtent[0] += StagedFrames;
+      return CurrentExtent;
+    }
     return hdf5::dataspace::Simple(_dataset.dataspace()).current_dimensions();
   }
 
@@ -399,7 +775,43 @@ public:
   /// \brief Read data from the dataset.
   ///
   /// Note: only for use in tests!
-  template <typename T> void read(T &result) { _dataset.read(result); }
+  template <typename T> void read(T &result) {
+    flushBuffer();
+    _dataset.read(result);
+  }
+
+  /// \brief Write whole chunks compressed by \p Pool with direct chunk writes.
+  ///
+  /// Only has an effect if \p Pool is not nullptr, the (recorded)
+  /// compression of the dataset is supported by compressChunk() and the
+  /// chunks contain whole rows (i.e. arrays appended with appendArray()).
+  void useDirectChunkWrites(ChunkCompressionPool *Pool) {
+    flushBuffer();
+    DirectChunks = ChunkAssembler::create(_dataset, Pool, dimensions().at(0));
+  }
+
+  /// \brief Collect appended arrays in memory and append them to the dataset
+  /// with one write per \p Frames arrays.
+  ///
+  /// Only arrays with the shape of the rows of the dataset are collected,
+  /// others are written directly. The collected arrays are written by
+  /// flushBuffer().
+  void setFramesPerWrite(size_t Frames) {
+    writeStagedFrames();
+    FramesPerWrite = std::max<size_t>(Frames, 1);
+  }
+
+  /// \brief The number of arrays appended but not yet written to the dataset.
+  [[nodiscard]] size_t nrOfStagedFrames() const { return StagedFrames; }
+
+  /// \brief Write the collected arrays and all chunks and (partial) rows of
+  /// the direct chunk writes.
+  void flushBuffer() {
+    writeStagedFrames();
+    if (DirectChunks) {
+      DirectChunks->flush();
+    }
+  }
 
   /// \brief Append data to dataset that is contained in some sort of container.
   ///
@@ -411,18 +823,26 @@ public:
   /// correct for the current dataset.
   template <typename T>
   void appendArray(T const &NewData, hdf5::Dimensions Shape) {
-    auto CurrentExtent = dimensions();
-    hdf5::Dimensions Origin(CurrentExtent.size(), 0);
-    Origin[0] = CurrentExtent[0];
-    ++CurrentExtent[0];
+    using ValueType =
+        std::remove_cv_t<std::remove_pointer_t<decltype(NewData.data())>>;
+    cacheExtent();
     Shape.insert(Shape.begin(), 1);
-    if (Shape.size() != CurrentExtent.size()) {
+    if (Shape.size() != Extent.size()) {
       Logger::Error(
           "Data has {} dimension(s) and dataset has {} (+1) dimensions.",
-          Shape.size() - 1, CurrentExtent.size() - 1);
+          Shape.size() - 1, Extent.size() - 1);
       throw std::runtime_error(
           "Rank (dimensions) of data to be written is wrong.");
     }
+    if (FramesPerWrite > 1 &&
+        stageFrame(NewData.data(), NewData.size(), Shape)) {
+      return;
+    }
+    writeStagedFrames();
+    auto CurrentExtent = Extent;
+    hdf5::Dimensions Origin(CurrentExtent.size(), 0);
+    Origin[0] = CurrentExtent[0];
+    ++CurrentExtent[0];
     for (size_t i = 1; i < Shape.size(); i++) {
       if (Shape[i] > CurrentExtent[i]) {
         Logger::Info("Dimension {} of new data is larger than that of the "
@@ -435,13 +855,158 @@ public:
                      i - 1);
       }
     }
-    _dataset.extent(CurrentExtent);
-    hdf5::dataspace::Hyperslab Selection{{Origin}, {Shape}};
-    _dataset.write(NewData, Selection);
+    hdf5::Dimensions RowShape(std::next(Shape.begin()), Shape.end());
+    auto NrOfValues = std::accumulate(RowShape.begin(), RowShape.end(),
+                                      size_t(1), std::multiplies<>());
+    if (NewData.size() != NrOfValues) {
+      throw std::runtime_error(
+          "Number of values does not match the shape of the data.");
+    }
+    bool Direct = appendsDirectly(memoryType<ValueType>(), RowShape);
+    setExtent(CurrentExtent);
+    if (Direct) {
+      DirectChunks->append(reinterpret_cast<char const *>(NewData.data()), 1);
+      DirectChunks->writeCompressedChunks();
+      return;
+    }
+    writeRows(NewData.data(), Origin, Shape);
   }
 
 protected:
+  /// \brief Get the extent and the file dataspace of the dataset once, they
+  /// are then kept up to date by setExtent().
+  void cacheExtent() {
+    if (!ExtentIsCached) {
+      FileSpace = hdf5::dataspace::Simple(_dataset.dataspace());
+      Extent = FileSpace.current_dimensions();
+      MaxExtent = FileSpace.maximum_dimensions();
+      ExtentIsCached = true;
+    }
+  }
+
+  /// \brief Set the extent of the dataset and of the cached file dataspace.
+  void setExtent(hdf5::Dimensions const &NewExtent) {
+    _dataset.extent(NewExtent);
+    Extent = NewExtent;
+    FileSpace.dimensions(Extent, MaxExtent);
+  }
+
+  /// \brief Copy an array with the shape of the rows of the dataset to the
+  /// staging buffer, see setFramesPerWrite().
+  ///
+  /// \param Data The values of the array.
+  /// \param Size The number of values.
+  /// \param Shape The shape of the array, with the (extensible) first
+  /// dimension prepended.
+  /// \return False if the array was not copied.
+  template <typename T>
+  bool stageFrame(T const *Data, size_t Size, hdf5::Dimensions const &Shape) {
+    auto RowSize = std::accumulate(std::next(Extent.begin()), Extent.end(),
+                                   size_t(1), std::multiplies<>());
+    if (Size != RowSize ||
+        !std::equal(std::next(Shape.begin()), Shape.end(),
+                    std::next(Extent.begin())) ||
+        (StagedFrames > 0 && MemoryTypeIndex != typeid(T))) {
+      return false;
+    }
+    memoryType<T>();
+    auto const *Bytes = reinterpret_cast<char const *>(Data);
+    StagedData.insert(StagedData.end(), Bytes, Bytes + Size * sizeof(T));
+    if (++StagedFrames >= FramesPerWrite) {
+      writeStagedFrames();
+    }
+    return true;
+  }
+
+  /// \brief Append the collected arrays to the dataset with one write.
+  void writeStagedFrames() {
+    if (StagedFrames == 0) {
+      return;
+    }
+    auto NrOfFrames = StagedFrames;
+    StagedFrames = 0;
+    try {
+      auto NewExtent = Extent;
+      hdf5::Dimensions Origin(Extent.size(), 0);
+      Origin[0] = Extent[0];
+      NewExtent[0] += NrOfFrames;
+      hdf5::Dimensions RowShape(std::next(Extent.begin()), Extent.end());
+      bool Direct = appendsDirectly(MemoryType, RowShape);
+      setExtent(NewExtent);
+      if (Direct) {
+        DirectChunks->append(StagedData.data(), NrOfFrames);
+        DirectChunks->writeCompressedChunks();
+      } else {
+        auto Block = NewExtent;
+        Block[0] = NrOfFrames;
+        writeRows(StagedData.data(), Origin, Block);
+      }
+    } catch (...) {
+      // Do not try to write the same frames again.
+      StagedData.clear();
+      throw;
+    }
+    StagedData.clear();
+  }
+
+  /// \brief Check if rows of a given datatype and shape can be appended with
+  /// direct chunk writes, stop using direct chunk writes if not.
+  bool appendsDirectly(hdf5::datatype::Datatype const &Type,
+                       hdf5::Dimensions const &RowShape) {
+    if (!DirectChunks) {
+      return false;
+    }
+    if (!DirectChunks->accepts(Type, RowShape)) {
+      Logger::Info("Data does not match the chunks of the dataset, not "
+                   "using direct chunk writes for it anymore.");
+      auto Assembler = std::move(DirectChunks);
+      Assembler->flush();
+      return false;
+    }
+    return true;
+  }
+
+  /// \brief Write a block of values of the current memory datatype (see
+  /// memoryType()) to the dataset.
+  void writeRows(void const *Data, hdf5::Dimensions const &Origin,
+                 hdf5::Dimensions const &Block) {
+    if (MemoryShape != Block) {
+      MemorySpace.dimensions(Block, Block);
+      MemoryShape = Block;
+    }
+    FileSpace.selection(hdf5::dataspace::SelectionOperation::Set,
+                        hdf5::dataspace::Hyperslab{Origin, Block});
+    if (H5Dwrite(static_cast<hid_t>(_dataset), static_cast<hid_t>(MemoryType),
+                 static_cast<hid_t>(MemorySpace), static_cast<hid_t>(FileSpace),
+                 H5P_DEFAULT, Data) < 0) {
+      throw std::runtime_error("Failed to write array to dataset.");
+    }
+  }
+
+  /// \brief The memory datatype of values of \p T, created once per type.
+  template <typename T> hdf5::datatype::Datatype const &memoryType() {
+    if (MemoryTypeIndex != typeid(T)) {
+      MemoryType = hdf5::datatype::create<T>();
+      MemoryTypeIndex = typeid(T);
+    }
+    return MemoryType;
+  }
+
   hdf5::node::Dataset _dataset;
+  std::unique_ptr<ChunkAssembler> DirectChunks;
+  /// The extent of the dataset, see cacheExtent().
+  hdf5::Dimensions Extent;
+  hdf5::Dimensions MaxExtent;
+  hdf5::dataspace::Simple FileSpace;
+  bool ExtentIsCached{false};
+  hdf5::dataspace::Simple MemorySpace;
+  hdf5::Dimensions MemoryShape;
+  std::type_index MemoryTypeIndex{typeid(void)};
+  hdf5::datatype::Datatype MemoryType;
+  size_t FramesPerWrite{1};
+  /// The values of the arrays collected by stageFrame().
+  std::vector<char> StagedData;
+  hsize_t StagedFrames{0};
 };
 
 /// \brief h5cpp dataset class that implements methods for appending data.
@@ -461,9 +1026,11 @@ public:
   /// will be prepended with one dimension to allow for adding of data.
   /// \param ChunkSize The chunk size (as number of elements) of the dataset,
   /// ignored if the dataset is opened.
+  /// \param Settings The compression of the dataset, ignored if the dataset
+  /// is opened.
   MultiDimDataset(hdf5::node::Group const &parent, std::string const &name,
                   Mode CMode, hdf5::Dimensions shape,
-                  hdf5::Dimensions chunksize)
+                  hdf5::Dimensions chunksize, Compression const &Settings = {})
       : MultiDimDatasetBase() {
     if (Mode::Create == CMode) {
       shape.insert(shape.begin(), 0);
@@ -494,9 +1061,10 @@ public:
         VectorChunkSize = shape;
         VectorChunkSize[0] = 1024;
       }
-      _dataset = hdf5::node::ChunkedDataset(
-          parent, name, hdf5::datatype::create<DataType>(),
-          hdf5::dataspace::Simple(shape, MaxSize), VectorChunkSize);
+      _dataset = createCompressedDataset(parent, name,
+                                         hdf5::datatype::create<DataType>(),
+                                         shape, MaxSize, VectorChunkSize,
+                                         Settings);
     } else if (Mode::Open == CMode) {
       _dataset = parent.get_dataset(name);
     } else {
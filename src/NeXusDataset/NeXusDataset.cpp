@@ -13,11 +13,14 @@
 
 namespace NeXusDataset {
 UInt16Value::UInt16Value(hdf5::node::Group const &Parent, Mode CMode,
-                         size_t ChunkSize)
-    : ExtensibleDataset<std::uint16_t>(Parent, "value", CMode, ChunkSize) {}
+                         size_t ChunkSize, Compression const &Settings)
+    : ExtensibleDataset<std::uint16_t>(Parent, "value", CMode, ChunkSize,
+                                       Settings) {}
 
-Time::Time(hdf5::node::Group const &Parent, Mode CMode, size_t ChunkSize)
-    : ExtensibleDataset<std::uint64_t>(Parent, "time", CMode, ChunkSize) {
+Time::Time(hdf5::node::Group const &Parent, Mode CMode, size_t ChunkSize,
+           Compression const &Settings)
+    : ExtensibleDataset<std::uint64_t>(Parent, "time", CMode, ChunkSize,
+                                       Settings) {
   if (Mode::Create == CMode) {
     auto StartAttr = _dataset.attributes.create<std::string>("start");
     StartAttr.write("1970-01-01T00:00:00Z");
@@ -27,18 +30,21 @@ Time::Time(hdf5::node::Group const &Parent, Mode CMode, size_t ChunkSize)
 }
 
 DoubleValue::DoubleValue(hdf5::node::Group const &Parent,
-                         NeXusDataset::Mode CMode, size_t ChunkSize)
-    : NeXusDataset::ExtensibleDataset<double>(Parent, "value", CMode,
-                                              ChunkSize) {}
+                         NeXusDataset::Mode CMode, size_t ChunkSize,
+                         Compression const &Settings)
+    : NeXusDataset::ExtensibleDataset<double>(Parent, "value", CMode, ChunkSize,
+                                              Settings) {}
 
 CueIndex::CueIndex(hdf5::node::Group const &Parent, Mode CMode,
-                   size_t ChunkSize)
-    : ExtensibleDataset<std::uint32_t>(Parent, "cue_index", CMode, ChunkSize) {}
+                   size_t ChunkSize, Compression const &Settings)
+    : ExtensibleDataset<std::uint32_t>(Parent, "cue_index", CMode, ChunkSize,
+                                       Settings) {}
 
 CueTimestampZero::CueTimestampZero(hdf5::node::Group const &Parent, Mode CMode,
-                                   size_t ChunkSize)
+                                   size_t ChunkSize,
+                                   Compression const &Settings)
     : ExtensibleDataset<std::uint64_t>(Parent, "cue_timestamp_zero", CMode,
-                                       ChunkSize) {
+                                       ChunkSize, Settings) {
   if (Mode::Create == CMode) {
     auto StartAttr = _dataset.attributes.create<std::string>("start");
     StartAttr.write("1970-01-01T00:00:00Z");
@@ -47,13 +53,30 @@ CueTimestampZero::CueTimestampZero(hdf5::node::Group const &Parent, Mode CMode,
   }
 }
 
-EventId::EventId(hdf5::node::Group const &Parent, Mode CMode, size_t ChunkSize)
-    : ExtensibleDataset<std::uint32_t>(Parent, "event_id", CMode, ChunkSize) {}
+namespace {
+template <typename WireType, typename LegacyType>
+hdf5::datatype::Datatype eventDataType(EventDataTypes Types) {
+  if (Types == EventDataTypes::LEGACY) {
+    return hdf5::datatype::create<LegacyType>();
+  }
+  return hdf5::datatype::create<WireType>();
+}
+} // namespace
+
+EventId::EventId(hdf5::node::Group const &Parent, Mode CMode, size_t ChunkSize,
+                 Compression const &Settings, EventDataTypes Types)
+    : ExtensibleDatasetBase(
+          Parent, "event_id", CMode,
+          eventDataType<std::int32_t, std::uint32_t>(Types), ChunkSize,
+          Settings) {}
 
 EventTimeOffset::EventTimeOffset(hdf5::node::Group const &Parent, Mode CMode,
-                                 size_t ChunkSize)
-    : ExtensibleDataset<std::uint32_t>(Parent, "event_time_offset", CMode,
-                                       ChunkSize) {
+                                 size_t ChunkSize, Compression const &Settings,
+                                 EventDataTypes Types)
+    : ExtensibleDatasetBase(
+          Parent, "event_time_offset", CMode,
+          eventDataType<std::int32_t, std::uint32_t>(Types), ChunkSize,
+          Settings) {
   if (Mode::Create == CMode) {
     auto UnitAttr = _dataset.attributes.create<std::string>("units");
     UnitAttr.write("ns");
@@ -61,14 +84,20 @@ EventTimeOffset::EventTimeOffset(hdf5::node::Group const &Parent, Mode CMode,
 }
 
 EventIndex::EventIndex(hdf5::node::Group const &Parent, Mode CMode,
-                       size_t ChunkSize)
-    : ExtensibleDataset<std::uint32_t>(Parent, "event_index", CMode,
-                                       ChunkSize) {}
+                       size_t ChunkSize, Compression const &Settings,
+                       EventDataTypes Types)
+    : ExtensibleDatasetBase(
+          Parent, "event_index", CMode,
+          eventDataType<std::int64_t, std::uint32_t>(Types), ChunkSize,
+          Settings) {}
 
 EventTimeZero::EventTimeZero(hdf5::node::Group const &Parent, Mode CMode,
-                             size_t ChunkSize)
-    : ExtensibleDataset<std::uint64_t>(Parent, "event_time_zero", CMode,
-                                       ChunkSize) {
+                             size_t ChunkSize, Compression const &Settings,
+                             EventDataTypes Types)
+    : ExtensibleDatasetBase(
+          Parent, "event_time_zero", CMode,
+          eventDataType<std::int64_t, std::uint64_t>(Types), ChunkSize,
+          Settings) {
   if (Mode::Create == CMode) {
     auto StartAttr = _dataset.attributes.create<std::string>("start");
     StartAttr.write("1970-01-01T00:00:00Z");
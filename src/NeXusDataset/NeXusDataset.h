@@ -26,10 +26,11 @@ public:
   ///
   /// \param Parent The group/node where the dataset exists or should be
   /// created. \param CMode Create or open dataset. \param ChunkSize The chunk
-  /// size in number of elements for this dataset (if/when creating it). \throws
-  /// std::runtime_error if dataset already exists.
+  /// size in number of elements for this dataset (if/when creating it).
+  /// \param Settings The compression of the dataset (if/when creating it).
+  /// \throws std::runtime_error if dataset already exists.
   UInt16Value(hdf5::node::Group const &Parent, Mode CMode,
-              size_t ChunkSize = 1024);
+              size_t ChunkSize = 1024, Compression const &Settings = {});
 };
 
 /// \brief Class for representing a double precision floating point NeXus
@@ -41,10 +42,11 @@ public:
   ///
   /// \param Parent The group/node where the dataset exists or should be
   /// created. \param CMode Create or open dataset. \param ChunkSize The chunk
-  /// size in number of elements for this dataset (if/when creating it). \throws
-  /// std::runtime_error if dataset already exists.
+  /// size in number of elements for this dataset (if/when creating it).
+  /// \param Settings The compression of the dataset (if/when creating it).
+  /// \throws std::runtime_error if dataset already exists.
   DoubleValue(hdf5::node::Group const &Parent, NeXusDataset::Mode CMode,
-              size_t ChunkSize = 1024);
+              size_t ChunkSize = 1024, Compression const &Settings = {});
 };
 
 /// \brief Class for representing a timestamp (NeXus) dataset where the
@@ -56,9 +58,11 @@ public:
   ///
   /// \param Parent The group/node where the dataset exists or should be
   /// created. \param CMode Create or open dataset. \param ChunkSize The chunk
-  /// size in number of elements for this dataset (if/when creating it). \throws
-  /// std::runtime_error if dataset already exists.
-  Time(hdf5::node::Group const &Parent, Mode CMode, size_t ChunkSize = 1024);
+  /// size in number of elements for this dataset (if/when creating it).
+  /// \param Settings The compression of the dataset (if/when creating it).
+  /// \throws std::runtime_error if dataset already exists.
+  Time(hdf5::node::Group const &Parent, Mode CMode, size_t ChunkSize = 1024,
+       Compression const &Settings = {});
 };
 
 /// \brief Represents the index register for searching a large NXlog
@@ -70,10 +74,11 @@ public:
   ///
   /// \param Parent The group/node where the dataset exists or should be
   /// created. \param CMode Create or open dataset. \param ChunkSize The chunk
-  /// size in number of elements for this dataset (if/when creating it). \throws
-  /// std::runtime_error if dataset already exists.
-  CueIndex(hdf5::node::Group const &Parent, Mode CMode,
-           size_t ChunkSize = 1024);
+  /// size in number of elements for this dataset (if/when creating it).
+  /// \param Settings The compression of the dataset (if/when creating it).
+  /// \throws std::runtime_error if dataset already exists.
+  CueIndex(hdf5::node::Group const &Parent, Mode CMode, size_t ChunkSize = 1024,
+           Compression const &Settings = {});
 };
 
 /// \brief Represents the timestamp register for searching a large NXlog
@@ -85,69 +90,92 @@ public:
   ///
   /// \param Parent The group/node where the dataset exists or should be
   /// created. \param CMode Create or open dataset. \param ChunkSize The chunk
-  /// size in number of elements for this dataset (if/when creating it). \throws
-  /// std::runtime_error if dataset already exists.
+  /// size in number of elements for this dataset (if/when creating it).
+  /// \param Settings The compression of the dataset (if/when creating it).
+  /// \throws std::runtime_error if dataset already exists.
   CueTimestampZero(hdf5::node::Group const &Parent, Mode CMode,
-                   size_t ChunkSize = 1024);
+                   size_t ChunkSize = 1024, Compression const &Settings = {});
 };
 
+/// \brief The (on-disk) element types of the NXevent_data datasets.
+///
+/// - WIRE: The types of the ev44 flatbuffer arrays, int32 for event_id and
+///   event_time_offset and int64 for event_time_zero and event_index. The
+///   data is written without type conversion.
+/// - LEGACY: uint32 for event_id, event_time_offset and event_index and
+///   uint64 for event_time_zero, as written by earlier versions.
+enum class EventDataTypes { WIRE, LEGACY };
+
 /// \brief Represents the (radiation) detector event id dataset in a
 /// NXevent_data.
-class EventId : public ExtensibleDataset<std::uint32_t> {
+class EventId : public ExtensibleDatasetBase {
 public:
   EventId() = default;
   /// \brief Create the event_id dataset of NXevent_data.
   ///
   /// \param Parent The group/node where the dataset exists or should be
   /// created. \param CMode Create or open dataset. \param ChunkSize The chunk
-  /// size in number of elements for this dataset (if/when creating it). \throws
-  /// std::runtime_error if dataset already exists.
-  EventId(hdf5::node::Group const &Parent, Mode CMode, size_t ChunkSize = 1024);
+  /// size in number of elements for this dataset (if/when creating it).
+  /// \param Settings The compression of the dataset (if/when creating it).
+  /// \param Types The element types (if/when creating it).
+  /// \throws std::runtime_error if dataset already exists.
+  EventId(hdf5::node::Group const &Parent, Mode CMode, size_t ChunkSize = 1024,
+          Compression const &Settings = {},
+          EventDataTypes Types = EventDataTypes::WIRE);
 };
 
 /// \brief Represents the (radiation) detector event timestamp offset from zero
 /// time in a NXevent_data.
-class EventTimeOffset : public ExtensibleDataset<std::uint32_t> {
+class EventTimeOffset : public ExtensibleDatasetBase {
 public:
   EventTimeOffset() = default;
   /// \brief Create the event_time_offset dataset of NXevent_data.
   ///
   /// \param Parent The group/node where the dataset exists or should be
   /// created. \param CMode Create or open dataset. \param ChunkSize The chunk
-  /// size in number of elements for this dataset (if/when creating it). \throws
-  /// std::runtime_error if dataset already exists.
+  /// size in number of elements for this dataset (if/when creating it).
+  /// \param Settings The compression of the dataset (if/when creating it).
+  /// \param Types The element types (if/when creating it).
+  /// \throws std::runtime_error if dataset already exists.
   EventTimeOffset(hdf5::node::Group const &Parent, Mode CMode,
-                  size_t ChunkSize = 1024);
+                  size_t ChunkSize = 1024, Compression const &Settings = {},
+                  EventDataTypes Types = EventDataTypes::WIRE);
 };
 
 /// \brief Represents the (radiation) detector event index that ties
 /// EventTimeZero to event id and offset in a NXevent_data.
-class EventIndex : public ExtensibleDataset<std::uint32_t> {
+class EventIndex : public ExtensibleDatasetBase {
 public:
   EventIndex() = default;
   /// \brief Create the event_index dataset of NXevent_data.
   ////
   /// \param Parent The group/node where the dataset exists or should be
   /// created. \param CMode Create or open dataset. \param ChunkSize The chunk
-  /// size in number of elements for this dataset (if/when creating it). \throws
-  /// std::runtime_error if dataset already exists.
+  /// size in number of elements for this dataset (if/when creating it).
+  /// \param Settings The compression of the dataset (if/when creating it).
+  /// \param Types The element types (if/when creating it).
+  /// \throws std::runtime_error if dataset already exists.
   EventIndex(hdf5::node::Group const &Parent, Mode CMode,
-             size_t ChunkSize = 1024);
+             size_t ChunkSize = 1024, Compression const &Settings = {},
+             EventDataTypes Types = EventDataTypes::WIRE);
 };
 
 /// \brief Represents the (radiation) detector event reference timestamp dataset
 /// in a NXevent_data.
-class EventTimeZero : public ExtensibleDataset<std::uint64_t> {
+class EventTimeZero : public ExtensibleDatasetBase {
 public:
   EventTimeZero() = default;
   /// \brief Create the event_time_zero dataset of NXevent_data.
   ///
   /// \param Parent The group/node where the dataset exists or should be
   /// created. \param CMode Create or open dataset. \param ChunkSize The chunk
-  /// size in number of elements for this dataset (if/when creating it). \throws
-  /// std::runtime_error if dataset already exists.
+  /// size in number of elements for this dataset (if/when creating it).
+  /// \param Settings The compression of the dataset (if/when creating it).
+  /// \param Types The element types (if/when creating it).
+  /// \throws std::runtime_error if dataset already exists.
   EventTimeZero(hdf5::node::Group const &Parent, Mode CMode,
-                size_t ChunkSize = 1024);
+                size_t ChunkSize = 1024, Compression const &Settings = {},
+                EventDataTypes Types = EventDataTypes::WIRE);
 };
 
 } // namespace NeXusDataset
@@ -0,0 +1,227 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#include "StringDataset.h"
+#include <algorithm>
+#include <cctype>
+#include <map>
+
+namespace NeXusDataset {
+
+std::optional<StringEncoding> stringEncodingFromString(std::string Name) {
+  std::transform(Name.begin(), Name.end(), Name.begin(),
+                 [](auto C) { return std::tolower(C); });
+  std::map<std::string, StringEncoding> EncodingMap{
+      {"fixed", StringEncoding::FIXED},
+      {"variable", StringEncoding::VARIABLE},
+      {"dictionary", StringEncoding::DICTIONARY}};
+  if (auto Found = EncodingMap.find(Name); Found != EncodingMap.end()) {
+    return Found->second;
+  }
+  return std::nullopt;
+}
+
+namespace {
+std::string offsetsName(std::string const &Name) { return Name + "_offsets"; }
+} // namespace
+
+PackedStrings::PackedStrings(hdf5::node::Group const &Parent,
+                             std::string const &Name, Mode CMode,
+                             size_t ChunkSize, Compression const &Settings)
+    : Characters(Parent, Name, CMode, ChunkSize * CharactersPerString,
+                 Settings),
+      Offsets(Parent, offsetsName(Name), CMode, ChunkSize, Settings) {
+  if (Mode::Create == CMode) {
+    auto OffsetDataset = Offsets.dataset();
+    OffsetDataset.attributes.create_from<std::string>("string_characters",
+                                                      Name);
+  }
+  NrOfStrings = Offsets.size();
+  NrOfCharacters = Characters.size();
+}
+
+bool PackedStrings::exists(hdf5::node::Group const &Parent,
+                           std::string const &Name) {
+  return Parent.has_dataset(Name) && Parent.has_dataset(offsetsName(Name));
+}
+
+PackedStrings &PackedStrings::operator=(PackedStrings &&Other) {
+  flushBuffer();
+  Characters = std::move(Other.Characters);
+  Offsets = std::move(Other.Offsets);
+  NrOfStrings = Other.NrOfStrings;
+  NrOfCharacters = Other.NrOfCharacters;
+  BufferedCharacters = std::move(Other.BufferedCharacters);
+  BufferedOffsets = std::move(Other.BufferedOffsets);
+  // Leave nothing for the moved from object to write.
+  Other.BufferedCharacters.clear();
+  Other.BufferedOffsets.clear();
+  return *this;
+}
+
+PackedStrings::~PackedStrings() {
+  try {
+    flushBuffer();
+  } catch (std::exception &E) {
+    Logger::Error("Failed to write buffered strings to dataset: {}", E.what());
+  }
+}
+
+void PackedStrings::appendStringElement(std::string const &InString) {
+  BufferedCharacters.insert(BufferedCharacters.end(), InString.begin(),
+                            InString.end());
+  NrOfCharacters += InString.size();
+  BufferedOffsets.push_back(NrOfCharacters);
+  NrOfStrings += 1;
+  if (BufferedOffsets.size() >= MaxBufferedStrings) {
+    flushBuffer();
+  }
+}
+
+void PackedStrings::flushBuffer() {
+  if (BufferedOffsets.empty()) {
+    return;
+  }
+  try {
+    // Readers only see the strings whose characters have been written.
+    Characters.appendArray(BufferedCharacters);
+    Characters.flushBuffer();
+    Offsets.appendArray(BufferedOffsets);
+    Offsets.flushBuffer();
+  } catch (...) {
+    // Do not try to write the same strings again.
+    BufferedCharacters.clear();
+    BufferedOffsets.clear();
+    throw;
+  }
+  BufferedCharacters.clear();
+  BufferedOffsets.clear();
+}
+
+std::vector<std::string> PackedStrings::readAll() {
+  flushBuffer();
+  std::vector<std::uint8_t> AllCharacters(Characters.size());
+  std::vector<std::uint64_t> Ends(Offsets.size());
+  if (!AllCharacters.empty()) {
+    Characters.read_data(AllCharacters);
+  }
+  if (!Ends.empty()) {
+    Offsets.read_data(Ends);
+  }
+  std::vector<std::string> Result;
+  Result.reserve(Ends.size());
+  std::uint64_t Begin{0};
+  for (auto End : Ends) {
+    Result.emplace_back(AllCharacters.begin() + Begin,
+                        AllCharacters.begin() + End);
+    Begin = End;
+  }
+  return Result;
+}
+
+StringDataset::StringDataset(hdf5::node::Group const &Parent,
+                             std::string const &Name, Mode CMode,
+                             StringEncoding Requested, size_t StringSize,
+                             size_t ChunkSize)
+    : Encoding(Requested) {
+  auto TableName = Name + "_table";
+  auto IndexName = Name + "_index";
+  if (Mode::Open == CMode) {
+    if (Parent.has_dataset(TableName) && Parent.has_dataset(IndexName)) {
+      Encoding = StringEncoding::DICTIONARY;
+    } else {
+      Encoding = PackedStrings::exists(Parent, Name) ? StringEncoding::VARIABLE
+                                                     : StringEncoding::FIXED;
+    }
+  }
+  switch (Encoding) {
+  case StringEncoding::FIXED:
+    FixedStrings = FixedSizeString(Parent, Name, CMode, StringSize, ChunkSize);
+    break;
+  case StringEncoding::VARIABLE:
+    Strings = PackedStrings(Parent, Name, CMode, ChunkSize);
+    break;
+  case StringEncoding::DICTIONARY:
+    Strings = PackedStrings(Parent, TableName, CMode, ChunkSize);
+    Indices = ExtensibleDataset<std::uint32_t>(Parent, IndexName, CMode,
+                                               ChunkSize);
+    if (Mode::Create == CMode) {
+      auto IndexDataset = Indices.dataset();
+      IndexDataset.attributes.create_from<std::string>("string_table",
+                                                       TableName);
+    } else {
+      auto Table = Strings.readAll();
+      for (size_t i = 0; i < Table.size(); ++i) {
+        TableIndex.emplace(Table[i], static_cast<std::uint32_t>(i));
+      }
+    }
+    break;
+  }
+}
+
+StringDataset::~StringDataset() {
+  try {
+    flushBuffer();
+  } catch (std::exception &E) {
+    Logger::Error("Failed to write buffered strings to dataset: {}", E.what());
+  }
+}
+
+void StringDataset::appendStringElement(std::string const &InString) {
+  switch (Encoding) {
+  case StringEncoding::FIXED:
+    FixedStrings.appendStringElement(InString);
+    break;
+  case StringEncoding::VARIABLE:
+    Strings.appendStringElement(InString);
+    break;
+  case StringEncoding::DICTIONARY: {
+    auto [Entry, IsNew] = TableIndex.try_emplace(
+        InString, static_cast<std::uint32_t>(TableIndex.size()));
+    if (IsNew) {
+      Strings.appendStringElement(InString);
+    }
+    Indices.appendElement(Entry->second);
+  } break;
+  }
+}
+
+void StringDataset::flushBuffer() {
+  FixedStrings.flushBuffer();
+  // Write the table before the indices into it.
+  Strings.flushBuffer();
+  Indices.flushBuffer();
+}
+
+std::vector<std::string> StringDataset::readAll() {
+  flushBuffer();
+  std::vector<std::string> Result;
+  switch (Encoding) {
+  case StringEncoding::FIXED:
+    for (hssize_t i = 0; i < FixedStrings.current_size(); ++i) {
+      auto String = FixedStrings.read_element(static_cast<uint64_t>(i));
+      Result.emplace_back(String.c_str());
+    }
+    break;
+  case StringEncoding::VARIABLE:
+    Result = Strings.readAll();
+    break;
+  case StringEncoding::DICTIONARY: {
+    auto Table = Strings.readAll();
+    std::vector<std::uint32_t> TableIndices(Indices.size());
+    Indices.read_data(TableIndices);
+    for (auto Index : TableIndices) {
+      Result.push_back(Table.at(Index));
+    }
+  } break;
+  }
+  return Result;
+}
+
+} // namespace NeXusDataset
@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+/// \file
+/// \brief Datasets of strings with buffered writes.
+
+#pragma once
+
+#include "ExtensibleDataset.h"
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace NeXusDataset {
+
+/// \brief How the strings of a StringDataset are stored.
+///
+/// FIXED: Fixed length strings, truncated to a maximum length.
+/// VARIABLE: Strings of any length, stored as PackedStrings.
+/// DICTIONARY: Every distinct string is stored once, in the PackedStrings
+/// "<name>_table". The dataset "<name>_index" holds the index (into the
+/// table) of every appended string.
+///
+/// HDF5 variable length strings are not used, as they are stored on the
+/// global heap which can not be written in SWMR mode.
+enum class StringEncoding { FIXED, VARIABLE, DICTIONARY };
+
+/// \brief Get the encoding from its (case insensitive) name.
+///
+/// \param Name One of "fixed", "variable" or "dictionary".
+/// \return The encoding or std::nullopt if the name is not known.
+std::optional<StringEncoding> stringEncodingFromString(std::string Name);
+
+/// \brief Strings of any length, packed into a byte dataset.
+///
+/// The (UTF-8) characters of the strings are appended to the uint8 dataset
+/// "<name>" and the end of every string (i.e. the offset in "<name>" after
+/// its last character) to the uint64 dataset "<name>_offsets". Unlike
+/// variable length strings, both can be written in SWMR mode.
+///
+/// Appended strings are buffered in memory and written to the datasets (with
+/// one write each) when MaxBufferedStrings strings have been buffered, when
+/// flushBuffer() is called and on destruction.
+class PackedStrings {
+public:
+  PackedStrings() = default;
+
+  PackedStrings(PackedStrings const &) = delete;
+  PackedStrings(PackedStrings &&Other) { *this = std::move(Other); }
+  PackedStrings &operator=(PackedStrings const &) = delete;
+
+  /// \brief Calls flushBuffer() before taking over the datasets of \p Other.
+  PackedStrings &operator=(PackedStrings &&Other);
+
+  /// \brief Calls flushBuffer().
+  ~PackedStrings();
+
+  /// \brief Create/open the datasets of packed strings.
+  ///
+  /// \param Parent The group/node of the datasets.
+  /// \param Name The name of the dataset of the characters.
+  /// \param CMode Should the datasets be opened or created.
+  /// \param ChunkSize The number of offsets in one chunk, the chunks of the
+  /// characters are CharactersPerString times larger.
+  /// \param Settings The compression of the datasets (if/when creating them).
+  PackedStrings(hdf5::node::Group const &Parent, std::string const &Name,
+                Mode CMode, size_t ChunkSize = 1024,
+                Compression const &Settings = {});
+
+  /// \brief Check if a group has the datasets of packed strings.
+  static bool exists(hdf5::node::Group const &Parent, std::string const &Name);
+
+  /// \brief Append a string, see flushBuffer().
+  void appendStringElement(std::string const &InString);
+
+  /// \brief Write the buffered strings to the datasets, the characters
+  /// before the offsets.
+  void flushBuffer();
+
+  /// \brief The number of strings, including buffered strings.
+  [[nodiscard]] size_t size() const { return NrOfStrings; }
+
+  /// \brief Read all strings of the datasets.
+  std::vector<std::string> readAll();
+
+private:
+  static constexpr size_t MaxBufferedStrings{1024};
+  static constexpr size_t CharactersPerString{32};
+  ExtensibleDataset<std::uint8_t> Characters;
+  ExtensibleDataset<std::uint64_t> Offsets;
+  /// Includes the buffered strings.
+  size_t NrOfStrings{0};
+  /// Includes the buffered characters.
+  std::uint64_t NrOfCharacters{0};
+  std::vector<std::uint8_t> BufferedCharacters;
+  std::vector<std::uint64_t> BufferedOffsets;
+};
+
+/// \brief A dataset of strings, stored with one of the StringEncoding
+/// encodings.
+///
+/// The strings are written with buffered writes, see FixedSizeString and
+/// PackedStrings. With the dictionary encoding, appending a string
+/// that has been appended before only appends its index.
+class StringDataset {
+public:
+  StringDataset() = default;
+  StringDataset(StringDataset &&) = default;
+  StringDataset &operator=(StringDataset &&) = default;
+
+  /// \brief Calls flushBuffer().
+  ~StringDataset();
+
+  /// \brief Create/open a string dataset.
+  ///
+  /// \param Parent The group/node of the dataset.
+  /// \param Name The name of the dataset.
+  /// \param CMode Should the dataset be opened or created.
+  /// \param Encoding How the strings are stored, ignored if the dataset is
+  /// opened (the encoding is then determined from the file).
+  /// \param StringSize The maximum number of characters of fixed length
+  /// strings.
+  /// \param ChunkSize The number of strings (or indices) in one chunk.
+  StringDataset(hdf5::node::Group const &Parent, std::string const &Name,
+                Mode CMode, StringEncoding Encoding = StringEncoding::FIXED,
+                size_t StringSize = 300, size_t ChunkSize = 1024);
+
+  /// \brief Append a string (buffered).
+  void appendStringElement(std::string const &InString);
+
+  /// \brief Write the buffered strings (and indices) to the file.
+  void flushBuffer();
+
+  [[nodiscard]] StringEncoding encoding() const { return Encoding; }
+
+  /// \brief Read all strings, decoding the dictionary encoding.
+  ///
+  /// Note: only for use in tests!
+  std::vector<std::string> readAll();
+
+private:
+  StringEncoding Encoding{StringEncoding::FIXED};
+  FixedSizeString FixedStrings;
+  /// The strings or, with the dictionary encoding, the table of strings.
+  PackedStrings Strings;
+  ExtensibleDataset<std::uint32_t> Indices;
+  std::unordered_map<std::string, std::uint32_t> TableIndex;
+};
+
+} // namespace NeXusDataset
@@ -17,7 +17,15 @@ Source::Source(std::string Name, std::string FlatbufferID, std::string ModuleID,
       WriterModuleID(std::move(ModuleID)), TopicName(std::move(Topic)),
       SrcHash(calcSourceHash(SchemaID, SourceName)),
       ModuleHash(calcSourceHash(WriterModuleID, SourceName)),
-      WriterModule(std::move(Writer)) {}
+      WriterModule(std::move(Writer)), WriterPtr(WriterModule.get()) {}
+
+Source::Source(std::string Name, std::string FlatbufferID, std::string ModuleID,
+               std::string Topic, WriterModule::Base *SharedWriter)
+    : SourceName(std::move(Name)), SchemaID(std::move(FlatbufferID)),
+      WriterModuleID(std::move(ModuleID)), TopicName(std::move(Topic)),
+      SrcHash(calcSourceHash(SchemaID, SourceName)),
+      ModuleHash(calcSourceHash(WriterModuleID, SourceName)),
+      WriterPtr(SharedWriter) {}
 
 std::string const &Source::topic() const { return TopicName; }
 
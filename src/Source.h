@@ -22,6 +22,10 @@ class Source {
 public:
   Source(std::string Name, std::string FlatbufferID, std::string ModuleID,
          std::string Topic, WriterModule::ptr Writer);
+  /// \brief A source of which the messages are written by the writer module
+  /// of another source, which owns (and outlives) the writer module.
+  Source(std::string Name, std::string FlatbufferID, std::string ModuleID,
+         std::string Topic, WriterModule::Base *SharedWriter);
   Source(Source &&) = default;
   ~Source() = default;
   std::string const &topic() const;
@@ -30,7 +34,7 @@ public:
   std::string const &writerModuleID() const { return WriterModuleID; };
   FlatbufferMessage::SrcHash getSrcHash() const { return SrcHash; };
   FlatbufferMessage::SrcHash getModuleHash() const { return ModuleHash; };
-  WriterModule::Base *getWriterPtr() { return WriterModule.get(); }
+  WriterModule::Base *getWriterPtr() { return WriterPtr; }
 
 private:
   std::string SourceName;
@@ -40,6 +44,7 @@ private:
   FlatbufferMessage::SrcHash SrcHash;
   FlatbufferMessage::SrcHash ModuleHash;
   std::unique_ptr<WriterModule::Base> WriterModule;
+  WriterModule::Base *WriterPtr;
 };
 
 } // namespace FileWriter
@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#include "DuplicateFilter.h"
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+
+namespace Stream {
+
+DuplicateFilter::DuplicateFilter(size_t NrOfMessages)
+    : MaxMessages(NrOfMessages) {
+  if (NrOfMessages == 0) {
+    throw std::invalid_argument(
+        "The duplicate filter must remember at least one message.");
+  }
+  Recent.reserve(NrOfMessages);
+  size_t TableSize{1};
+  while (TableSize < 2 * NrOfMessages) {
+    TableSize *= 2;
+  }
+  Table.assign(TableSize, EmptySlot);
+  TableMask = TableSize - 1;
+}
+
+DuplicateFilter::MessageKey
+DuplicateFilter::messageKey(FileWriter::FlatbufferMessage const &Message) {
+  auto ContentHash = std::hash<std::string_view>{}(std::string_view(
+      reinterpret_cast<char const *>(Message.data()), Message.size()));
+  return {Message.getTimestamp(), Message.size(), ContentHash};
+}
+
+size_t DuplicateFilter::homeSlot(MessageKey const &Key) const {
+  // Combine as in boost::hash_combine
+  auto Hash = static_cast<std::uint64_t>(Key.Timestamp);
+  Hash ^= Key.Hash + 0x9e3779b97f4a7c15ULL + (Hash << 6) + (Hash >> 2);
+  return Hash & TableMask;
+}
+
+bool DuplicateFilter::contains(MessageKey const &Key) const {
+  for (auto Slot = homeSlot(Key); Table[Slot] != EmptySlot;
+       Slot = (Slot + 1) & TableMask) {
+    if (Recent[Table[Slot]] == Key) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void DuplicateFilter::insert(size_t RecentIndex) {
+  auto Slot = homeSlot(Recent[RecentIndex]);
+  while (Table[Slot] != EmptySlot) {
+    Slot = (Slot + 1) & TableMask;
+  }
+  Table[Slot] = RecentIndex;
+}
+
+void DuplicateFilter::erase(size_t RecentIndex) {
+  auto Hole = homeSlot(Recent[RecentIndex]);
+  while (Table[Hole] != RecentIndex) {
+    Hole = (Hole + 1) & TableMask;
+  }
+  // Move the following keys of the probe sequence back into the hole, so
+  // that no key is behind an empty slot.
+  for (auto Slot = (Hole + 1) & TableMask; Table[Slot] != EmptySlot;
+       Slot = (Slot + 1) & TableMask) {
+    auto Home = homeSlot(Recent[Table[Slot]]);
+    if (((Slot - Home) & TableMask) >= ((Slot - Hole) & TableMask)) {
+      Table[Hole] = Table[Slot];
+      Hole = Slot;
+    }
+  }
+  Table[Hole] = EmptySlot;
+}
+
+bool DuplicateFilter::isDuplicate(
+    FileWriter::FlatbufferMessage const &Message) {
+  auto Key = messageKey(Message);
+  if (contains(Key)) {
+    return true;
+  }
+  if (Recent.size() < MaxMessages) {
+    Recent.push_back(Key);
+    insert(Recent.size() - 1);
+  } else {
+    erase(NextRecent);
+    Recent[NextRecent] = Key;
+    insert(NextRecent);
+    NextRecent = (NextRecent + 1) % Recent.size();
+  }
+  return false;
+}
+
+} // namespace Stream
@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#pragma once
+
+#include "FlatbufferMessage.h"
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Stream {
+
+/// \brief Detects duplicates of the recent messages of a source, e.g. when a
+/// producer retries sending a message or a topic is mirrored.
+///
+/// A message is identified by its timestamp, its size and a hash of its
+/// content, the filter is used per source. The keys of the last NrOfMessages
+/// messages are kept in a ring buffer (to forget the oldest key) and indexed by
+/// an open addressing hash table, both of which are allocated up front such
+/// that the memory used is fixed.
+class DuplicateFilter {
+public:
+  /// \param NrOfMessages The nr of recent messages to remember, must be > 0.
+  explicit DuplicateFilter(size_t NrOfMessages);
+
+  /// \brief Check if the message is a duplicate of a recent message and, if
+  /// it is not, remember it.
+  bool isDuplicate(FileWriter::FlatbufferMessage const &Message);
+
+  [[nodiscard]] size_t size() const { return Recent.size(); }
+
+private:
+  struct MessageKey {
+    std::int64_t Timestamp{0};
+    size_t Size{0};
+    std::uint64_t Hash{0};
+    bool operator==(MessageKey const &Other) const {
+      return Timestamp == Other.Timestamp && Size == Other.Size &&
+             Hash == Other.Hash;
+    }
+  };
+  static MessageKey messageKey(FileWriter::FlatbufferMessage const &Message);
+  /// \brief The slot of the table at which the search for a key starts.
+  [[nodiscard]] size_t homeSlot(MessageKey const &Key) const;
+  [[nodiscard]] bool contains(MessageKey const &Key) const;
+  void insert(size_t RecentIndex);
+  void erase(size_t RecentIndex);
+  static constexpr size_t EmptySlot{std::numeric_limits<size_t>::max()};
+  size_t MaxMessages;
+  /// The keys of the recent messages, a ring buffer once full.
+  std::vector<MessageKey> Recent;
+  size_t NextRecent{0};
+  /// The indices in Recent, linear probing with at most half of the slots
+  /// used.
+  std::vector<size_t> Table;
+  size_t TableMask{0};
+};
+
+} // namespace Stream
@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+/// \brief Decides when the writer thread should flush the file.
+///
+
+#include "FlushPolicy.h"
+#include <algorithm>
+
+namespace Stream {
+
+FlushPolicy::FlushPolicy(duration MaxInterval, size_t MaxBytes, time_point Now)
+    : MaxInterval(MaxInterval), MaxBytes(MaxBytes), LastFlushTime(Now) {}
+
+void FlushPolicy::registerWrite(size_t Bytes,
+                                std::optional<duration> MaxStaleness,
+                                time_point Now) {
+  BytesSinceFlush += Bytes;
+  if (MaxStaleness) {
+    StalenessDeadline = std::min(StalenessDeadline, Now + *MaxStaleness);
+  }
+}
+
+FlushPolicy::Reason FlushPolicy::shouldFlush(time_point Now) const {
+  if (Now >= StalenessDeadline) {
+    return Reason::STALENESS;
+  }
+  if (MaxBytes > 0 && BytesSinceFlush >= MaxBytes) {
+    return Reason::BYTES;
+  }
+  if (Now >= LastFlushTime + MaxInterval) {
+    return Reason::INTERVAL;
+  }
+  return Reason::NONE;
+}
+
+void FlushPolicy::flushStarted(time_point Now) {
+  LastFlushTime = Now;
+  BytesSinceFlush = 0;
+  StalenessDeadline = time_point::max();
+}
+
+} // namespace Stream
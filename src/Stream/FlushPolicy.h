@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+/// \brief Decides when the writer thread should flush the file.
+///
+
+#pragma once
+
+#include "TimeUtility.h"
+#include <optional>
+
+namespace Stream {
+
+/// \brief Decides when to start a flush of the file.
+///
+/// A flush is started when (whichever comes first):
+/// - the max interval has passed since the start of the last flush,
+/// - the amount of data written since the start of the last flush exceeds a
+///   limit (if set), or
+/// - data has been written by a writer module with a staleness bound and
+///   that bound is about to be exceeded.
+///
+/// Not thread safe, only to be used by the writer thread.
+class FlushPolicy {
+public:
+  enum class Reason { NONE, INTERVAL, BYTES, STALENESS };
+
+  /// \param MaxInterval Max amount of time between flushes.
+  /// \param MaxBytes Start a flush when this many bytes have been written
+  /// since the last flush. Zero to disable.
+  /// \param Now The current time.
+  FlushPolicy(duration MaxInterval, size_t MaxBytes, time_point Now);
+
+  /// \brief Register that data has been written.
+  ///
+  /// \param Bytes The (approximate) size of the data written.
+  /// \param MaxStaleness Max amount of time until the data must have been
+  /// flushed, if any.
+  /// \param Now The current time.
+  void registerWrite(size_t Bytes, std::optional<duration> MaxStaleness,
+                     time_point Now);
+
+  /// \brief Determine if a flush should be started.
+  ///
+  /// \return The reason for flushing, Reason::NONE if no flush is required.
+  Reason shouldFlush(time_point Now) const;
+
+  /// \brief Register that a flush was started, resets the state.
+  void flushStarted(time_point Now);
+
+  size_t bytesSinceFlush() const { return BytesSinceFlush; }
+
+private:
+  duration const MaxInterval;
+  size_t const MaxBytes;
+  time_point LastFlushTime;
+  size_t BytesSinceFlush{0};
+  time_point StalenessDeadline{time_point::max()};
+};
+
+} // namespace Stream
@@ -11,6 +11,7 @@
 
 #include "FlatbufferMessage.h"
 #include <memory>
+#include <utility>
 
 namespace WriterModule {
 class Base;
@@ -29,6 +30,10 @@ public:
           FileWriter::FlatbufferMessage const &Msg)
       : FbMsg(Msg), DestPtr(DestinationModule) {}
 
+  Message(WriterModule::Base *DestinationModule,
+          FileWriter::FlatbufferMessage &&Msg)
+      : FbMsg(std::move(Msg)), DestPtr(DestinationModule) {}
+
   FileWriter::FlatbufferMessage const FbMsg{};
   DestPtrType const DestPtr{nullptr};
 };
@@ -28,16 +28,30 @@ ModuleHash generateSrcHash(std::string const &Source,
 static const ModuleHash UnknownModuleHash{
     generateSrcHash("Unknown source", "Unknown fb-id")};
 
-MessageWriter::MessageWriter(std::function<void()> FlushFunction,
+MessageWriter::MessageWriter(FlushFunctionType FlushFunction,
                              duration FlushIntervalTime,
-                             std::unique_ptr<Metrics::IRegistrar> registrar)
+                             std::unique_ptr<Metrics::IRegistrar> registrar,
+                             size_t PreparationThreads, size_t FlushAfterBytes)
     : FlushDataFunction(std::move(FlushFunction)),
-      _registrar(std::move(registrar)), FlushInterval(FlushIntervalTime),
+      _registrar(std::move(registrar)),
+      FlushDecider(FlushIntervalTime, FlushAfterBytes, system_clock::now()),
+      PreparationPool(PreparationThreads > 0
+                          ? std::make_unique<WritePreparationPool>(
+                                PreparationThreads)
+                          : nullptr),
       WriterThread(&MessageWriter::threadFunction, this) {
   _registrar->registerMetric(WritesDone, {Metrics::LogTo::CARBON});
   _registrar->registerMetric(WriteErrors,
                              {Metrics::LogTo::CARBON, Metrics::LogTo::LOG_MSG});
   _registrar->registerMetric(ApproxQueuedWrites, {Metrics::LogTo::CARBON});
+  _registrar->registerMetric(MessagesDropped,
+                             {Metrics::LogTo::CARBON, Metrics::LogTo::LOG_MSG});
+  _registrar->registerMetric(FlushDuration, {Metrics::LogTo::CARBON});
+  _registrar->registerMetric(FlushTime, {Metrics::LogTo::CARBON});
+  _registrar->registerMetric(FlushesOnInterval, {Metrics::LogTo::CARBON});
+  _registrar->registerMetric(FlushesOnBytes, {Metrics::LogTo::CARBON});
+  _registrar->registerMetric(FlushesOnStaleness, {Metrics::LogTo::CARBON});
+  _registrar->registerMetric(BytesPerFlush, {Metrics::LogTo::CARBON});
   ModuleErrorCounters[UnknownModuleHash] = std::make_unique<Metrics::Metric>(
       "error_unknown", "Unknown flatbuffer message.", Metrics::Severity::ERROR);
   _registrar->registerMetric(*ModuleErrorCounters[UnknownModuleHash],
@@ -52,8 +66,98 @@ MessageWriter::~MessageWriter() {
 }
 
 void MessageWriter::addMessage(Message const &Msg, bool is_buffered_message) {
-  WriteJobs.enqueue(
-      [=]() { writeMsgImpl(Msg.DestPtr, Msg.FbMsg, is_buffered_message); });
+  auto Priority = WriterModule::WritePriority::NORMAL;
+  if (Msg.DestPtr == nullptr) {
+    runJob(
+        [=]() { writeMsgImpl(Msg.DestPtr, Msg.FbMsg, is_buffered_message); },
+        Priority);
+    return;
+  }
+  Priority = Msg.DestPtr->writePriority();
+  if (dropOnQueueing(Msg)) {
+    return;
+  }
+  // Lets the writer modules keep track of their part of the queue.
+  auto QueueSequenceNr = Msg.DestPtr->nextQueueSequenceNumber();
+  auto QueuedAt = system_clock::now();
+  auto Dequeued = [DestPtr = Msg.DestPtr, QueuedAt]() {
+    DestPtr->countDequeuedMessage(system_clock::now() - QueuedAt);
+  };
+  if (Msg.DestPtr->dropPolicy() == WriterModule::DropPolicy::DROP_OLDEST) {
+    runJob(
+        [=]() {
+          Dequeued();
+          if (!dropOnDequeueing(Msg.DestPtr, Msg.FbMsg, QueueSequenceNr)) {
+            writeMsgImpl(Msg.DestPtr, Msg.FbMsg, is_buffered_message);
+          }
+        },
+        Priority);
+    return;
+  }
+  if (PreparationPool == nullptr || !Msg.DestPtr->hasPreparationStage()) {
+    runJob(
+        [=]() {
+          Dequeued();
+          writeMsgImpl(Msg.DestPtr, Msg.FbMsg, is_buffered_message);
+        },
+        Priority);
+    return;
+  }
+  // The message is shared by the preparation and the write stage as the
+  // latter may reference the flatbuffer data.
+  auto SharedMsg = std::make_shared<Message const>(Msg);
+  auto PreparedWrite =
+      std::make_shared<std::promise<WriterModule::WriteStage>>();
+  std::shared_future<WriterModule::WriteStage> PreparedWriteFuture =
+      PreparedWrite->get_future().share();
+  PreparationPool->submit(
+      Msg.DestPtr, [SharedMsg, PreparedWrite, is_buffered_message]() {
+        try {
+          PreparedWrite->set_value(SharedMsg->DestPtr->prepareWrite(
+              SharedMsg->FbMsg, is_buffered_message));
+        } catch (...) {
+          PreparedWrite->set_exception(std::current_exception());
+        }
+      });
+  runJob(
+      [this, SharedMsg, PreparedWriteFuture, Dequeued]() {
+        Dequeued();
+        writePreparedMsgImpl(SharedMsg->DestPtr, SharedMsg->FbMsg,
+                             PreparedWriteFuture);
+      },
+      Priority);
+}
+
+bool MessageWriter::dropOnQueueing(Message const &Msg) {
+  if (!LoadSheddingActive ||
+      Msg.DestPtr->dropPolicy() != WriterModule::DropPolicy::KEEP_EVERY_NTH ||
+      Msg.DestPtr->keepWhileSheddingLoad()) {
+    return false;
+  }
+  Msg.DestPtr->countDroppedMessage(Msg.FbMsg.size());
+  MessagesDropped++;
+  return true;
+}
+
+bool MessageWriter::dropOnDequeueing(WriterModule::Base *ModulePtr,
+                                     FileWriter::FlatbufferMessage const &Msg,
+                                     uint64_t QueueSequenceNr) {
+  // Nr of messages queued for the module since (and including) this one.
+  auto QueuedSince = ModulePtr->nrOfMessagesQueued() - QueueSequenceNr;
+  if (!LoadSheddingActive || QueuedSince <= ModulePtr->dropKeepNewest()) {
+    return false;
+  }
+  ModulePtr->countDroppedMessage(Msg.size());
+  MessagesDropped++;
+  return true;
+}
+
+size_t MessageWriter::nrOfWritesQueued() const {
+  size_t QueuedWrites{0};
+  for (auto const &Lane : WriteJobs) {
+    QueuedWrites += Lane.size_approx();
+  }
+  return QueuedWrites;
 }
 
 void MessageWriter::stop() { RunThread.store(false); }
@@ -64,52 +168,135 @@ void MessageWriter::writeMsgImpl(WriterModule::Base *ModulePtr,
   try {
     ModulePtr->write(Msg, is_buffered_message);
     WritesDone++;
+    registerWrite(ModulePtr, Msg);
   } catch (WriterModule::WriterException &E) {
+    countWriteError(Msg);
+  } catch (std::exception &E) {
     WriteErrors++;
-    auto UsedHash = UnknownModuleHash;
-    if (Msg.isValid()) {
-      UsedHash = generateSrcHash(Msg.getSourceName(), Msg.getFlatbufferID());
-      if (ModuleErrorCounters.find(UsedHash) == ModuleErrorCounters.end()) {
-        auto Description = fmt::format(
-            R"(Error writing fb.-msg with source name "{}" and flatbuffer id: {})",
-            Msg.getSourceName(), Msg.getFlatbufferID());
-        auto Name =
-            "error_" + Msg.getSourceName() + "_" + Msg.getFlatbufferID();
-        ModuleErrorCounters[UsedHash] = std::make_unique<Metrics::Metric>(
-            Name, Description, Metrics::Severity::ERROR);
-        _registrar->registerMetric(*ModuleErrorCounters[UsedHash],
-                                   {Metrics::LogTo::LOG_MSG});
-      }
-    }
-    (*ModuleErrorCounters[UsedHash])++;
+    Logger::Error("Unknown file writing error: {}", E.what());
+  }
+}
+
+void MessageWriter::writePreparedMsgImpl(
+    WriterModule::Base *ModulePtr, FileWriter::FlatbufferMessage const &Msg,
+    std::shared_future<WriterModule::WriteStage> const &PreparedWrite) {
+  try {
+    // Blocks if the preparation has not finished yet, keeping the writes in
+    // queue order.
+    ModulePtr->commitWrite(PreparedWrite.get());
+    WritesDone++;
+    registerWrite(ModulePtr, Msg);
+  } catch (WriterModule::WriterException &E) {
+    countWriteError(Msg);
   } catch (std::exception &E) {
     WriteErrors++;
     Logger::Error("Unknown file writing error: {}", E.what());
   }
 }
 
+void MessageWriter::registerWrite(WriterModule::Base *ModulePtr,
+                                  FileWriter::FlatbufferMessage const &Msg) {
+  FlushDecider.registerWrite(Msg.size(), ModulePtr->maxStaleness(),
+                             system_clock::now());
+  ModulesWritten.insert(ModulePtr);
+}
+
+void MessageWriter::flushModuleBuffers() {
+  for (auto ModulePtr : ModulesWritten) {
+    try {
+      ModulePtr->flushBuffers();
+    } catch (std::exception &E) {
+      WriteErrors++;
+      Logger::Error("Failed to write buffered data to file: {}", E.what());
+    }
+  }
+  ModulesWritten.clear();
+}
+
+void MessageWriter::startFlush(FlushPolicy::Reason Reason) {
+  switch (Reason) {
+  case FlushPolicy::Reason::INTERVAL:
+    FlushesOnInterval++;
+    break;
+  case FlushPolicy::Reason::BYTES:
+    FlushesOnBytes++;
+    break;
+  case FlushPolicy::Reason::STALENESS:
+    FlushesOnStaleness++;
+    break;
+  case FlushPolicy::Reason::NONE:
+    break;
+  }
+  BytesPerFlush = FlushDecider.bytesSinceFlush();
+  ApproxQueuedWrites = nrOfWritesQueued();
+}
+
+void MessageWriter::countWriteError(FileWriter::FlatbufferMessage const &Msg) {
+  WriteErrors++;
+  auto UsedHash = UnknownModuleHash;
+  if (Msg.isValid()) {
+    UsedHash = generateSrcHash(Msg.getSourceName(), Msg.getFlatbufferID());
+    if (ModuleErrorCounters.find(UsedHash) == ModuleErrorCounters.end()) {
+      auto Description = fmt::format(
+          R"(Error writing fb.-msg with source name "{}" and flatbuffer id: {})",
+          Msg.getSourceName(), Msg.getFlatbufferID());
+      auto Name = "error_" + Msg.getSourceName() + "_" + Msg.getFlatbufferID();
+      ModuleErrorCounters[UsedHash] = std::make_unique<Metrics::Metric>(
+          Name, Description, Metrics::Severity::ERROR);
+      _registrar->registerMetric(*ModuleErrorCounters[UsedHash],
+                                 {Metrics::LogTo::LOG_MSG});
+    }
+  }
+  (*ModuleErrorCounters[UsedHash])++;
+}
+
 void MessageWriter::threadFunction() {
   setThreadName("writer");
   int CheckTimeCounter{0};
   JobType CurrentJob;
-  time_point NextFlushTime{system_clock::now() + FlushInterval};
+  bool FlushInProgress{false};
+  time_point FlushStartTime;
+  duration TimeSpentFlushing{0};
   auto FlushOperation = [&]() {
     auto Now = system_clock::now();
-    if (Now >= NextFlushTime) {
-      ApproxQueuedWrites = WriteJobs.size_approx();
-      flushData();
-      auto FlushPeriods = int((Now - NextFlushTime) / FlushInterval) + 1;
-      NextFlushTime += FlushPeriods * FlushInterval;
+    if (!FlushInProgress) {
+      auto Reason = FlushDecider.shouldFlush(Now);
+      if (Reason == FlushPolicy::Reason::NONE) {
+        return;
+      }
+      startFlush(Reason);
+      flushModuleBuffers();
+      FlushDecider.flushStarted(Now);
+      FlushInProgress = true;
+      FlushStartTime = Now;
+      TimeSpentFlushing = 0s;
+    }
+    auto FlushDone = flushData(FlushStepTime);
+    auto FlushStepEnd = system_clock::now();
+    TimeSpentFlushing += FlushStepEnd - Now;
+    if (FlushDone) {
+      FlushInProgress = false;
+      FlushDuration = toMilliSeconds(FlushStepEnd - FlushStartTime);
+      FlushTime = toMilliSeconds(TimeSpentFlushing);
     }
   };
   auto WriteOperation = [&]() {
     CheckTimeCounter = 0;
-    while (WriteJobs.try_dequeue(CurrentJob)) {
-      CurrentJob();
-      ++CheckTimeCounter;
-      if (CheckTimeCounter > MaxTimeCheckCounter) {
-        FlushOperation();
-        CheckTimeCounter = 0;
+    bool JobsExecuted{true};
+    while (JobsExecuted) {
+      JobsExecuted = false;
+      for (size_t Lane = 0; Lane < NrOfLanes; ++Lane) {
+        for (int i = 0;
+             i < LaneWeights[Lane] && WriteJobs[Lane].try_dequeue(CurrentJob);
+             ++i) {
+          CurrentJob();
+          JobsExecuted = true;
+          ++CheckTimeCounter;
+          if (CheckTimeCounter > MaxTimeCheckCounter) {
+            FlushOperation();
+            CheckTimeCounter = 0;
+          }
+        }
       }
     }
   };
@@ -122,6 +309,7 @@ void MessageWriter::threadFunction() {
     std::this_thread::sleep_for(SleepTime);
   }
   WriteOperation();
+  flushModuleBuffers();
 }
 
 } // namespace Stream
@@ -12,29 +12,65 @@
 
 #pragma once
 
+#include "FlushPolicy.h"
 #include "Message.h"
 #include "Metrics/Metric.h"
 #include "Metrics/Registrar.h"
 #include "TimeUtility.h"
+#include "WritePreparationPool.h"
+#include "WriterModuleBase.h"
 #include "logger.h"
+#include <array>
+#include <future>
 #include <map>
 #include <moodycamel/concurrentqueue.h>
+#include <set>
 #include <thread>
 
-namespace WriterModule {
-class Base;
-}
-
 namespace Stream {
 
 /// \brief Implements the writing of flatbuffer messages to disk.
 ///
-/// We can only have one writer per (HDF5) file.
+/// We can only have one writer per (HDF5) file. Writes are queued in one lane
+/// per WriterModule::WritePriority. The lanes are serviced in weighted
+/// round-robin order (see LaneWeights) so that a backlog of low priority
+/// writes only adds a bounded delay to the high priority ones.
+///
+/// If preparation threads are used, the CPU bound part of a write (see
+/// WriterModule::Base::prepareWrite()) is done by a WritePreparationPool
+/// while the writer thread only does the HDF5 calls, in queue order. Only
+/// the writes of writer modules with a preparation stage (see
+/// WriterModule::Base::hasPreparationStage()) go through the pool.
+///
+/// If load shedding is active, messages are dropped according to the drop
+/// policy of the destination writer module (see WriterModule::DropPolicy).
+/// Writes of modules with the DROP_OLDEST policy are not prepared by the
+/// WritePreparationPool as they can only be dropped when dequeued.
+///
+/// When to flush the file is decided by a FlushPolicy. Before the file is
+/// flushed, the writer modules are told to write their buffered data (see
+/// WriterModule::Base::flushBuffers()). The flush is done in steps of at most
+/// (approximately) FlushStepTime, interleaved with the writes, so that writing
+/// does not stall for the duration of a (possibly very slow) flush of the
+/// whole file.
 class MessageWriter {
 public:
-  explicit MessageWriter(std::function<void()> FlushFunction,
+  /// \brief Flush (part of) the data, see FileWriterTask::flushDataToFile().
+  ///
+  /// Is given the (approximate) max amount of time to spend flushing and
+  /// returns true when the flush is complete.
+  using FlushFunctionType = std::function<bool(duration)>;
+
+  /// \param FlushIntervalTime Max amount of time between flushes.
+  /// \param PreparationThreads Nr of threads used for preparing writes. If
+  /// zero, all of the work is done by the writer thread.
+  /// \param FlushAfterBytes Flush when (approximately) this many bytes have
+  /// been written since the last flush. Zero to disable.
+  explicit MessageWriter(FlushFunctionType FlushFunction,
                          duration FlushIntervalTime,
-                         std::unique_ptr<Metrics::IRegistrar> registrar);
+                         std::unique_ptr<Metrics::IRegistrar> registrar,
+                         size_t PreparationThreads = 0,
+                         size_t FlushAfterBytes = 0);
 
   virtual ~MessageWriter();
 
@@ -47,8 +83,22 @@ public:
 
   using ModuleHash = size_t;
 
-  /// \brief Return the approximate number of writes queued.
-  auto nrOfWritesQueued() const { return WriteJobs.size_approx(); };
+  /// \brief Activate or deactivate load shedding.
+  ///
+  /// Called by the StreamController when the write queue is (no longer)
+  /// full.
+  void setLoadShedding(bool Active) { LoadSheddingActive = Active; }
+  bool loadSheddingActive() const { return LoadSheddingActive; }
+
+  auto nrOfMessagesDropped() const { return int64_t(MessagesDropped); }
+
+  /// \brief Return the approximate number of writes queued (all lanes).
+  size_t nrOfWritesQueued() const;
+
+  /// \brief Return the approximate number of writes queued in one lane.
+  size_t nrOfWritesQueued(WriterModule::WritePriority Priority) const {
+    return WriteJobs[static_cast<size_t>(Priority)].size_approx();
+  }
 
   auto nrOfWritesDone() const { return int64_t(WritesDone); };
   auto nrOfWriteErrors() const { return int64_t(WriteErrors); };
@@ -56,16 +106,41 @@ public:
     return ModuleErrorCounters.size();
   }
 
-  void runJob(std::function<void()> Job) { WriteJobs.enqueue(Job); }
+  /// \brief Run a job on the writer thread.
+  ///
+  /// Jobs are executed in order with respect to other jobs and writes queued
+  /// with the same priority.
+  void runJob(std::function<void()> Job,
+              WriterModule::WritePriority Priority =
+                  WriterModule::WritePriority::NORMAL) {
+    WriteJobs[static_cast<size_t>(Priority)].enqueue(std::move(Job));
+  }
 
 protected:
   virtual void writeMsgImpl(WriterModule::Base *ModulePtr,
                             FileWriter::FlatbufferMessage const &Msg,
                             bool is_buffered_message);
+  bool dropOnQueueing(Message const &Msg);
+  bool dropOnDequeueing(WriterModule::Base *ModulePtr,
+                        FileWriter::FlatbufferMessage const &Msg,
+                        uint64_t QueueSequenceNr);
+  void writePreparedMsgImpl(
+      WriterModule::Base *ModulePtr, FileWriter::FlatbufferMessage const &Msg,
+      std::shared_future<WriterModule::WriteStage> const &PreparedWrite);
+  void countWriteError(FileWriter::FlatbufferMessage const &Msg);
+  void registerWrite(WriterModule::Base *ModulePtr,
+                     FileWriter::FlatbufferMessage const &Msg);
+  void startFlush(FlushPolicy::Reason Reason);
+
+  /// \brief Have the writer modules written to since the last flush write
+  /// their buffered data to file, see WriterModule::Base::flushBuffers().
+  void flushModuleBuffers();
   virtual void threadFunction();
 
-  virtual void flushData() { FlushDataFunction(); };
-  std::function<void()> FlushDataFunction;
+  virtual bool flushData(duration MaxTime) {
+    return FlushDataFunction(MaxTime);
+  };
+  FlushFunctionType FlushDataFunction;
 
   Metrics::Metric WritesDone{"writes_done",
                              "Number of completed writes to HDF file."};
@@ -74,15 +149,51 @@ protected:
                               Metrics::Severity::ERROR};
   Metrics::Metric ApproxQueuedWrites{"approx_queued_writes",
                                      "Approximate number of writes queued up."};
+  Metrics::Metric MessagesDropped{
+      "messages_dropped",
+      "Number of messages dropped due to load shedding.",
+      Metrics::Severity::WARNING};
+  Metrics::Metric FlushDuration{
+      "flush_duration",
+      "Time (ms) from start to end of the last file flush, includes the "
+      "writes done in between flush steps."};
+  Metrics::Metric FlushTime{
+      "flush_time", "Time (ms) spent flushing during the last file flush."};
+  Metrics::Metric FlushesOnInterval{
+      "flushes_on_interval",
+      "Number of file flushes started due to the max flush interval."};
+  Metrics::Metric FlushesOnBytes{
+      "flushes_on_bytes",
+      "Number of file flushes started due to the amount of data written."};
+  Metrics::Metric FlushesOnStaleness{
+      "flushes_on_staleness",
+      "Number of file flushes started due to the staleness bound of a writer "
+      "module."};
+  Metrics::Metric BytesPerFlush{
+      "bytes_per_flush",
+      "Approximate number of bytes written between the last two flushes."};
   std::map<ModuleHash, std::unique_ptr<Metrics::Metric>> ModuleErrorCounters;
   std::unique_ptr<Metrics::IRegistrar> _registrar;
 
   using JobType = std::function<void()>;
-  moodycamel::ConcurrentQueue<JobType> WriteJobs;
+  static constexpr size_t NrOfLanes{3};
+  std::array<moodycamel::ConcurrentQueue<JobType>, NrOfLanes> WriteJobs;
+
+  /// \brief Max nr of jobs taken from each lane (in priority order) per
+  /// round-robin cycle.
+  const std::array<int, NrOfLanes> LaneWeights{16, 4, 1};
   std::atomic_bool RunThread{true};
+  std::atomic_bool LoadSheddingActive{false};
   const duration SleepTime{10ms};
-  duration FlushInterval{5s};
+  const duration FlushStepTime{20ms};
+  FlushPolicy FlushDecider;
+  /// Only accessed by the writer thread.
+  std::set<WriterModule::Base *> ModulesWritten;
   const int MaxTimeCheckCounter{200};
+
+  /// Must be destroyed after the writer thread has been stopped as queued
+  /// writes wait for their preparation to finish.
+  std::unique_ptr<WritePreparationPool> PreparationPool;
   std::thread WriterThread; // Must be last
 };
 
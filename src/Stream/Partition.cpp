@@ -9,11 +9,31 @@
 
 #include "Partition.h"
 #include "Msg.h"
+#include <optional>
 
 namespace Stream {
 
+ReorderStages create_reorder_stages(SrcToDst const &map) {
+  ReorderStages stages;
+  for (auto const &src_dest_info : map) {
+    if (src_dest_info.ReorderWindowMessages == 0 &&
+        src_dest_info.ReorderWindowTime <= duration::zero()) {
+      continue;
+    }
+    // The window of the first writer module of a source that has one is used.
+    if (stages.find(src_dest_info.WriteHash) == stages.end()) {
+      stages.emplace(src_dest_info.WriteHash,
+                     std::make_shared<ReorderStage>(
+                         src_dest_info.ReorderWindowMessages,
+                         src_dest_info.ReorderWindowTime));
+    }
+  }
+  return stages;
+}
+
 std::vector<std::unique_ptr<ISourceFilter>>
-create_filters(SrcToDst const &map, time_point start_time, time_point stop_time,
+create_filters(SrcToDst const &map, ReorderStages const &reorder_stages,
+               time_point start_time, time_point stop_time,
                MessageWriter *writer, Metrics::IRegistrar *registrar) {
   std::map<FileWriter::FlatbufferMessage::SrcHash,
            std::unique_ptr<SourceFilter>>
@@ -34,8 +54,14 @@ create_filters(SrcToDst const &map, time_point start_time, time_point stop_time,
                                  registrar->getNewRegistrar(
                                      src_dest_info.getMetricsNameString())));
     }
-    hash_to_filter[src_dest_info.WriteHash]->add_writer_module_for_message(
-        src_dest_info.Destination);
+    auto &filter = hash_to_filter[src_dest_info.WriteHash];
+    filter->add_writer_module_for_message(src_dest_info.Destination);
+    if (auto stage = reorder_stages.find(src_dest_info.WriteHash);
+        stage != reorder_stages.end()) {
+      filter->set_reorder_stage(stage->second);
+    }
+    filter->set_dedup_window(src_dest_info.DedupWindow);
+    filter->set_accepts_all_messages(src_dest_info.AcceptsAllMessages);
     write_hash_to_source_hash[src_dest_info.WriteHash] = src_dest_info.SrcHash;
   }
   std::vector<std::unique_ptr<ISourceFilter>> filters;
@@ -49,11 +75,13 @@ create_filters(SrcToDst const &map, time_point start_time, time_point stop_time,
 
 std::unique_ptr<Partition> Partition::create(
     std::shared_ptr<Kafka::ConsumerInterface> consumer, int partition,
-    const std::string &topic_name, const SrcToDst &map, MessageWriter *writer,
+    const std::string &topic_name, const SrcToDst &map,
+    ReorderStages const &reorder_stages, MessageWriter *writer,
     Metrics::IRegistrar *registrar, time_point start_time, time_point stop_time,
     duration stop_leeway, duration kafka_error_timeout,
     const std::function<bool()> &streamers_paused_function) {
-  auto filters = create_filters(map, start_time, stop_time, writer, registrar);
+  auto filters = create_filters(map, reorder_stages, start_time, stop_time,
+                                writer, registrar);
   auto partition_filter = std::make_unique<PartitionFilter>(
       stop_time, stop_leeway, kafka_error_timeout);
   return std::make_unique<Partition>(
@@ -107,7 +135,8 @@ Partition::Partition(std::shared_ptr<Kafka::ConsumerInterface> consumer,
                      duration kafka_error_timeout,
                      std::function<bool()> const &streamers_paused_function)
     : Partition(std::move(consumer), partition, topic_name,
-                create_filters(map, start_time, stop_time, writer, registrar),
+                create_filters(map, create_reorder_stages(map), start_time,
+                               stop_time, writer, registrar),
                 std::make_unique<PartitionFilter>(stop_time, stop_leeway,
                                                   kafka_error_timeout),
                 registrar, stop_time, stop_leeway, streamers_paused_function) {}
@@ -215,6 +244,12 @@ void Partition::pollForMessage() {
       _has_finished = true;
       return;
     }
+    // Messages waiting in a reorder window are passed on after a while, also
+    // if no later messages arrive.
+    auto Now = system_clock::now();
+    for (auto const &filter : _source_filters) {
+      filter->forward_waiting_messages(Now);
+    }
 
     if (Msg.first == Kafka::PollStatus::Message) {
       processMessage(Msg.second);
@@ -248,21 +283,20 @@ void Partition::processMessage(FileWriter::Msg const &Message) {
   } catch (FileWriter::BufferTooSmallError &) {
     BufferTooSmallErrors++;
     FlatbufferErrors++;
-    return;
   } catch (FileWriter::InvalidFlatbufferTimestamp &) {
     BadFlatbufferTimestampErrors++;
     FlatbufferErrors++;
-    return;
   } catch (FileWriter::UnknownFlatbufferID &) {
     UnknownFlatbufferIdErrors++;
     FlatbufferErrors++;
-    return;
   } catch (FileWriter::NotValidFlatbuffer &) {
     NotValidFlatbufferErrors++;
     FlatbufferErrors++;
-    return;
   } catch (std::exception &) {
     FlatbufferErrors++;
+  }
+  if (!FbMsg.isValid()) {
+    forwardUnparsedMessage(Message);
     return;
   }
 
@@ -283,4 +317,18 @@ void Partition::processMessage(FileWriter::Msg const &Message) {
       _source_filters.end());
 }
 
+void Partition::forwardUnparsedMessage(FileWriter::Msg const &Message) {
+  std::optional<FileWriter::FlatbufferMessage> FbMsg;
+  for (auto const &filter : _source_filters) {
+    if (!filter->accepts_all_messages()) {
+      continue;
+    }
+    if (!FbMsg) {
+      FbMsg = FileWriter::FlatbufferMessage::unparsed(Message);
+    }
+    // Not counted as processed, the message is counted as an error.
+    [[maybe_unused]] auto Forwarded = filter->filter_message(*FbMsg);
+  }
+}
+
 } // namespace Stream
@@ -16,6 +16,7 @@
 #include "Message.h"
 #include "MessageWriter.h"
 #include "PartitionFilter.h"
+#include "ReorderStage.h"
 #include "SourceFilter.h"
 #include "Stream/MessageWriter.h"
 #include "ThreadedExecutor.h"
@@ -32,12 +33,34 @@ struct SrcDstKey {
   std::string FlatbufferId;
   std::string WriterModuleId;
   bool AcceptsRepeatedTimestamps;
+  /// The bounds of the reorder window of the source, see ReorderBuffer.
+  size_t ReorderWindowMessages;
+  duration ReorderWindowTime;
+  /// The nr of recent messages checked for duplicates, see DuplicateFilter.
+  size_t DedupWindow;
+  /// If all messages of the topic are passed on, see
+  /// WriterModule::Base::writesAllMessagesOfTopic().
+  bool AcceptsAllMessages;
   [[nodiscard]] std::string getMetricsNameString() const {
     return SourceName + "_" + WriterModuleId;
   }
 };
 using SrcToDst = std::vector<SrcDstKey>;
 
+/// \brief Create the reorder windows of the sources of a topic, one for each
+/// source (by write hash) that has a window configured.
+///
+/// The windows are shared by the source filters of all partitions of the
+/// topic, so that the messages of a source are put in order across
+/// partitions.
+ReorderStages create_reorder_stages(SrcToDst const &map);
+
+/// \brief Create the source filters of a partition.
+std::vector<std::unique_ptr<ISourceFilter>>
+create_filters(SrcToDst const &map, ReorderStages const &reorder_stages,
+               time_point start_time, time_point stop_time,
+               MessageWriter *writer, Metrics::IRegistrar *registrar);
+
 /// \brief Implements consumption of Kafka messages from partitions and (time
 /// based) filtering of those messages.
 class Partition {
@@ -45,7 +68,8 @@ public:
   static std::unique_ptr<Partition>
   create(std::shared_ptr<Kafka::ConsumerInterface> consumer, int partition,
          std::string const &topic_name, SrcToDst const &map,
-         MessageWriter *writer, Metrics::IRegistrar *registrar,
+         ReorderStages const &reorder_stages, MessageWriter *writer,
+         Metrics::IRegistrar *registrar,
          time_point start_time, time_point stop_time, duration stop_leeway,
          duration kafka_error_timeout,
          std::function<bool()> const &streamers_paused_function);
@@ -133,6 +157,9 @@ protected:
   /// \note This function exist in order to make unit testing possible.
   virtual void sleep(duration Duration) const;
   virtual void processMessage(FileWriter::Msg const &Message);
+  /// \brief Pass a message that can not be read on to the source filters that
+  /// accept all messages of the topic.
+  void forwardUnparsedMessage(FileWriter::Msg const &Message);
 
   std::shared_ptr<Kafka::ConsumerInterface> _consumer;
   int _partition_id{-1};
@@ -153,14 +180,15 @@ class PartitionThreaded {
 public:
   static std::unique_ptr<PartitionThreaded> create(
       std::shared_ptr<Kafka::ConsumerInterface> consumer, int partition_index,
-      std::string const &topic_name, SrcToDst const &map, MessageWriter *writer,
+      std::string const &topic_name, SrcToDst const &map,
+      ReorderStages const &reorder_stages, MessageWriter *writer,
       Metrics::IRegistrar *registrar, time_point start_time,
       time_point stop_time, duration stop_leeway, duration kafka_error_timeout,
       std::function<bool()> const &streamers_paused_function) {
-    auto partition =
-        Partition::create(std::move(consumer), partition_index, topic_name, map,
-                          writer, registrar, start_time, stop_time, stop_leeway,
-                          kafka_error_timeout, streamers_paused_function);
+    auto partition = Partition::create(
+        std::move(consumer), partition_index, topic_name, map, reorder_stages,
+        writer, registrar, start_time, stop_time, stop_leeway,
+        kafka_error_timeout, streamers_paused_function);
     return std::make_unique<PartitionThreaded>(std::move(partition));
   }
 
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#include "ReorderBuffer.h"
+#include <algorithm>
+
+namespace Stream {
+
+ReorderBuffer::ReorderBuffer(size_t MaxNrOfMessages, duration MaxDelay)
+    : MaxMessages(MaxNrOfMessages),
+      MaxDelayNs(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(MaxDelay)
+              .count()),
+      MaxDelay(MaxDelay) {}
+
+bool ReorderBuffer::add(FileWriter::FlatbufferMessage &&Message,
+                        time_point Now) {
+  auto Timestamp = Message.getTimestamp();
+  if (LastReleased && Timestamp < *LastReleased) {
+    return false;
+  }
+  auto Position = std::upper_bound(
+      Messages.rbegin(), Messages.rend(), Timestamp,
+      [](std::int64_t Time, WaitingMessage const &Other) {
+        return Time >= Other.Message.getTimestamp();
+      });
+  Messages.insert(Position.base(), {std::move(Message), Now});
+  LatestTimestamp = std::max(LatestTimestamp, Timestamp);
+  return true;
+}
+
+bool ReorderBuffer::canRelease() const {
+  if (Messages.empty()) {
+    return false;
+  }
+  return (MaxMessages > 0 && Messages.size() > MaxMessages) ||
+         (MaxDelayNs > 0 &&
+          LatestTimestamp - Messages.front().Message.getTimestamp() >=
+              MaxDelayNs);
+}
+
+bool ReorderBuffer::canRelease(time_point Now) const {
+  if (canRelease()) {
+    return true;
+  }
+  return !Messages.empty() && MaxDelayNs > 0 &&
+         Now - Messages.front().AddedAt >= MaxDelay;
+}
+
+FileWriter::FlatbufferMessage ReorderBuffer::release() {
+  auto Released = std::move(Messages.front().Message);
+  Messages.pop_front();
+  LastReleased = Released.getTimestamp();
+  return Released;
+}
+
+} // namespace Stream
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#pragma once
+
+#include "FlatbufferMessage.h"
+#include "TimeUtility.h"
+#include <deque>
+#include <optional>
+
+namespace Stream {
+
+/// \brief A bounded window in which the messages of a source are put in
+/// timestamp order.
+///
+/// A message is released (in timestamp order) when the window holds more than
+/// MaxMessages messages or when its timestamp is at least MaxDelay earlier
+/// than the latest timestamp added. The window is bounded by either or both.
+/// So that the messages of a source that has stopped sending are not kept
+/// indefinitely, a message is also released when it has been in the window
+/// for MaxDelay. As messages mostly arrive in order, they are kept in a deque
+/// that is searched from the back.
+class ReorderBuffer {
+public:
+  /// \param MaxMessages Max nr of messages in the window, 0 for no limit.
+  /// \param MaxDelay Max difference between the timestamps of the messages in
+  /// the window, zero for no limit.
+  ReorderBuffer(size_t MaxMessages, duration MaxDelay);
+
+  /// \brief Add a message to the window.
+  ///
+  /// \param Message The message, moved into the window unless it is late.
+  /// \param Now The time at which the message is added.
+  /// \return False if the message is late, i.e. earlier than a message that
+  /// has already been released. A late message is not added.
+  bool add(FileWriter::FlatbufferMessage &&Message,
+           time_point Now = system_clock::now());
+
+  /// \brief True if the earliest message in the window should be released,
+  /// based on the messages in the window only.
+  [[nodiscard]] bool canRelease() const;
+
+  /// \brief As canRelease(), but the earliest message is also released if
+  /// it was added at least MaxDelay before \p Now.
+  [[nodiscard]] bool canRelease(time_point Now) const;
+
+  /// \brief Take the earliest message from the window.
+  FileWriter::FlatbufferMessage release();
+
+  [[nodiscard]] bool empty() const { return Messages.empty(); }
+  [[nodiscard]] size_t size() const { return Messages.size(); }
+
+private:
+  size_t MaxMessages;
+  std::int64_t MaxDelayNs;
+  duration MaxDelay;
+  struct WaitingMessage {
+    FileWriter::FlatbufferMessage Message;
+    time_point AddedAt;
+  };
+  std::deque<WaitingMessage> Messages;
+  std::int64_t LatestTimestamp{0};
+  std::optional<std::int64_t> LastReleased;
+};
+
+} // namespace Stream
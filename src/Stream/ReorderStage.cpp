@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#include "ReorderStage.h"
+
+namespace Stream {
+
+bool ReorderStage::add(FileWriter::FlatbufferMessage &&Message,
+                       time_point Now, ForwardFunction const &Forward) {
+  std::lock_guard Lock(Mutex);
+  if (!Window.add(std::move(Message), Now)) {
+    // Not moved from, as late messages are not added.
+    Forward(std::move(Message));
+    return false;
+  }
+  while (Window.canRelease(Now)) {
+    Forward(Window.release());
+  }
+  return true;
+}
+
+void ReorderStage::forwardWaiting(time_point Now,
+                                  ForwardFunction const &Forward) {
+  std::lock_guard Lock(Mutex);
+  while (Window.canRelease(Now)) {
+    Forward(Window.release());
+  }
+}
+
+void ReorderStage::forwardAll(ForwardFunction const &Forward) {
+  std::lock_guard Lock(Mutex);
+  while (!Window.empty()) {
+    Forward(Window.release());
+  }
+}
+
+} // namespace Stream
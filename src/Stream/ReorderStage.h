@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#pragma once
+
+#include "FlatbufferMessage.h"
+#include "Stream/ReorderBuffer.h"
+#include "TimeUtility.h"
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace Stream {
+
+/// \brief The reorder window of a source, shared by the source filters of
+/// all partitions of its topic.
+///
+/// The messages of a source can arrive on several partitions, each consumed
+/// by its own thread. They are put in timestamp order in one ReorderBuffer,
+/// see SourceFilter. Messages are passed on while holding the lock of the
+/// window, so that they reach the writer modules in the order in which they
+/// are released, whichever partition releases them.
+class ReorderStage {
+public:
+  /// \brief Passes a released message on to the writer modules.
+  using ForwardFunction = std::function<void(FileWriter::FlatbufferMessage)>;
+
+  /// \param MaxMessages Max nr of messages in the window, 0 for no limit.
+  /// \param MaxDelay Max difference between the timestamps of the messages in
+  /// the window, zero for no limit.
+  ReorderStage(size_t MaxMessages, duration MaxDelay)
+      : Window(MaxMessages, MaxDelay) {}
+
+  /// \brief Add a message to the window and pass on the messages that can be
+  /// released.
+  ///
+  /// \return False if the message is late, it is then passed on immediately.
+  bool add(FileWriter::FlatbufferMessage &&Message, time_point Now,
+           ForwardFunction const &Forward);
+
+  /// \brief Pass on the messages that have waited long enough.
+  void forwardWaiting(time_point Now, ForwardFunction const &Forward);
+
+  /// \brief Pass on all messages in the window.
+  void forwardAll(ForwardFunction const &Forward);
+
+private:
+  std::mutex Mutex;
+  ReorderBuffer Window;
+};
+
+/// \brief The reorder stage of every written source (by write hash) that
+/// has a reorder window.
+using ReorderStages =
+    std::map<FileWriter::FlatbufferMessage::SrcHash,
+             std::shared_ptr<ReorderStage>>;
+
+} // namespace Stream
@@ -8,6 +8,7 @@
 // Screaming Udder!                              https://esss.se
 
 #include "SourceFilter.h"
+#include <iterator>
 
 namespace Stream {
 
@@ -24,9 +25,22 @@ SourceFilter::SourceFilter(time_point start_time, time_point stop_time,
   _registrar->registerMetric(MessagesTransmitted, {Metrics::LogTo::CARBON});
   _registrar->registerMetric(MessagesDiscarded, {Metrics::LogTo::CARBON});
   _registrar->registerMetric(RepeatedTimestamp, {Metrics::LogTo::CARBON});
+  _registrar->registerMetric(LateMessages, {Metrics::LogTo::CARBON});
+  _registrar->registerMetric(Duplicates, {Metrics::LogTo::CARBON});
 }
 
-SourceFilter::~SourceFilter() { forward_buffered_message(); }
+SourceFilter::~SourceFilter() {
+  forward_buffered_message();
+  forward_reordered_messages();
+}
+
+void SourceFilter::set_dedup_window(size_t nr_of_messages) {
+  if (nr_of_messages == 0) {
+    _duplicate_filter.reset();
+    return;
+  }
+  _duplicate_filter = std::make_unique<DuplicateFilter>(nr_of_messages);
+}
 
 void SourceFilter::set_stop_time(time_point stop_time) {
   _stop_time = stop_time;
@@ -35,9 +49,10 @@ void SourceFilter::set_stop_time(time_point stop_time) {
 bool SourceFilter::has_finished() const { return _is_finished; }
 
 void SourceFilter::forward_buffered_message() {
-  if (_buffered_message.isValid()) {
-    forward_message(_buffered_message, true);
+  if (_has_buffered_message) {
+    forward_message(std::move(_buffered_message), true);
     _buffered_message = FileWriter::FlatbufferMessage();
+    _has_buffered_message = false;
   }
 }
 
@@ -48,7 +63,7 @@ time_point to_timepoint(int64_t timestamp) {
 
 bool SourceFilter::filter_message(
     FileWriter::FlatbufferMessage const &message) {
-  if (message.getSourceHash() != _source_hash) {
+  if (!_accepts_all_messages && message.getSourceHash() != _source_hash) {
     // Not intended for this filter
     return false;
   }
@@ -57,11 +72,15 @@ bool SourceFilter::filter_message(
     MessagesDiscarded++;
     return false;
   }
-  if (!message.isValid()) {
+  if (!message.isValid() && !_accepts_all_messages) {
     MessagesDiscarded++;
     FlatbufferInvalid++;
     return false;
   }
+  if (is_duplicate(message)) {
+    MessagesDiscarded++;
+    return false;
+  }
 
   if (message.getTimestamp() == _last_seen_timestamp) {
     RepeatedTimestamp++;
@@ -76,30 +95,87 @@ bool SourceFilter::filter_message(
 
   auto message_time = to_timepoint(message.getTimestamp());
   if (message_time < _start_time) {
-    if (_buffered_message.isValid() &&
+    if (_has_buffered_message &&
         message_time < to_timepoint(_buffered_message.getTimestamp())) {
       MessagesDiscarded++;
       return false;
     }
     _buffered_message = message;
+    _has_buffered_message = true;
     return false;
   }
   if (message_time > _stop_time) {
     _is_finished = true;
     forward_buffered_message();
+    forward_reordered_messages();
     return false;
   }
   forward_buffered_message();
-  forward_message(message);
+  forward_in_order(message);
+  return true;
+}
+
+bool SourceFilter::is_duplicate(
+    FileWriter::FlatbufferMessage const &message) {
+  if (!_duplicate_filter || !_duplicate_filter->isDuplicate(message)) {
+    return false;
+  }
+  Duplicates++;
+  for (auto const &writer_module : _destination_writer_modules) {
+    if (writer_module != nullptr) {
+      writer_module->countDuplicateMessage();
+    }
+  }
   return true;
 }
 
-void SourceFilter::forward_message(FileWriter::FlatbufferMessage const &message,
+void SourceFilter::forward_in_order(
+    FileWriter::FlatbufferMessage const &message) {
+  if (!_reorder_stage) {
+    forward_message(message);
+    return;
+  }
+  auto forward = [this](FileWriter::FlatbufferMessage released) {
+    forward_message(std::move(released));
+  };
+  if (!_reorder_stage->add(FileWriter::FlatbufferMessage(message),
+                           system_clock::now(), forward)) {
+    LateMessages++;
+  }
+}
+
+void SourceFilter::forward_waiting_messages(time_point now) {
+  if (!_reorder_stage) {
+    return;
+  }
+  _reorder_stage->forwardWaiting(
+      now, [this](FileWriter::FlatbufferMessage released) {
+        forward_message(std::move(released));
+      });
+}
+
+void SourceFilter::forward_reordered_messages() {
+  if (!_reorder_stage) {
+    return;
+  }
+  _reorder_stage->forwardAll([this](FileWriter::FlatbufferMessage released) {
+    forward_message(std::move(released));
+  });
+}
+
+void SourceFilter::forward_message(FileWriter::FlatbufferMessage message,
                                    bool is_buffered_message) {
   ++MessagesTransmitted;
-  for (auto const &writer_module : _destination_writer_modules) {
-    _writer->addMessage({writer_module, message}, is_buffered_message);
+  if (_destination_writer_modules.empty()) {
+    return;
+  }
+  // Only the messages for all but the last module are copied.
+  auto last_module = std::prev(_destination_writer_modules.end());
+  for (auto it = _destination_writer_modules.begin(); it != last_module;
+       ++it) {
+    _writer->addMessage({*it, message}, is_buffered_message);
   }
+  _writer->addMessage({*last_module, std::move(message)}, is_buffered_message);
 }
 
 } // namespace Stream
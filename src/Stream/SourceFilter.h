@@ -12,7 +12,9 @@
 #include "FlatbufferMessage.h"
 #include "Metrics/Metric.h"
 #include "Metrics/Registrar.h"
+#include "Stream/DuplicateFilter.h"
 #include "Stream/MessageWriter.h"
+#include "Stream/ReorderStage.h"
 #include "TimeUtility.h"
 #include <iostream>
 
@@ -27,6 +29,12 @@ public:
   [[nodiscard]] virtual bool has_finished() const = 0;
   virtual void
   set_source_hash(FileWriter::FlatbufferMessage::SrcHash source_hash) = 0;
+  /// \brief Pass on the messages that have waited long enough, called
+  /// periodically, also when no messages arrive.
+  virtual void forward_waiting_messages(time_point now) = 0;
+  /// \brief True if all messages of the topic are accepted, whatever their
+  /// source and including messages that are not valid.
+  [[nodiscard]] virtual bool accepts_all_messages() const = 0;
 };
 
 /// \brief Pass messages to the _writer thread based on timestamp of message
@@ -34,6 +42,20 @@ public:
 /// SourceFilter buffers a message such that, when used in conjunction with the
 /// periodic-update feature of the Forwarder, the _writer module should always
 /// be able to record at least the data from a single message.
+///
+/// If a reorder stage is set, the messages (between start and stop time)
+/// are passed on in timestamp order, see ReorderBuffer. The stage is shared
+/// with the filters of the same source on the other partitions of the topic,
+/// see ReorderStage. Messages that arrive after a later message has been
+/// passed on are counted as late and passed on immediately. The messages are
+/// moved through the window rather than copied.
+///
+/// If a dedup window is set, (valid) messages that are duplicates of a recent
+/// message are dropped, see DuplicateFilter.
+///
+/// A filter that accepts all messages passes on the messages of all sources
+/// of the topic, including messages that are not valid (e.g. of an unknown
+/// schema), see WriterModule::Base::writesAllMessagesOfTopic().
 class SourceFilter : public ISourceFilter {
 public:
   SourceFilter() = default;
@@ -45,9 +67,31 @@ public:
     _destination_writer_modules.push_back(writer_module);
   };
 
+  /// \brief Pass messages on in timestamp order, through the reorder window
+  /// of the source.
+  ///
+  /// \param stage The window, shared by the filters of the source on all
+  /// partitions, nullptr to pass messages on as they arrive.
+  void set_reorder_stage(std::shared_ptr<ReorderStage> stage) {
+    _reorder_stage = std::move(stage);
+  }
+
+  /// \brief Drop duplicates of the last nr_of_messages messages.
+  ///
+  /// \param nr_of_messages Zero to not check for duplicates.
+  void set_dedup_window(size_t nr_of_messages);
+
+  /// \brief Accept the messages of all sources of the topic, including
+  /// messages that are not valid, instead of those of the source hash only.
+  void set_accepts_all_messages(bool accepts_all) {
+    _accepts_all_messages = accepts_all;
+  }
+  bool accepts_all_messages() const override { return _accepts_all_messages; }
+
   bool filter_message(FileWriter::FlatbufferMessage const &message) override;
   void set_stop_time(time_point stop_time) override;
   bool has_finished() const override;
+  void forward_waiting_messages(time_point now) override;
   time_point get_stop_time() const { return _stop_time; }
   void
   set_source_hash(FileWriter::FlatbufferMessage::SrcHash source_hash) override {
@@ -58,16 +102,25 @@ public:
   }
 
 private:
-  void forward_message(FileWriter::FlatbufferMessage const &message,
+  void forward_message(FileWriter::FlatbufferMessage message,
                        bool is_buffered_message = false);
   void forward_buffered_message();
+  void forward_in_order(FileWriter::FlatbufferMessage const &message);
+  void forward_reordered_messages();
+  bool is_duplicate(FileWriter::FlatbufferMessage const &message);
   time_point _start_time;
   time_point _stop_time;
   bool _allow_repeated_timestamps{false};
+  bool _accepts_all_messages{false};
   int64_t _last_seen_timestamp{0};
   MessageWriter *_writer{nullptr};
   bool _is_finished{false};
   FileWriter::FlatbufferMessage _buffered_message;
+  /// If a message is buffered, which need not be valid if all messages are
+  /// accepted.
+  bool _has_buffered_message{false};
+  std::shared_ptr<ReorderStage> _reorder_stage;
+  std::unique_ptr<DuplicateFilter> _duplicate_filter;
   std::vector<Message::DestPtrType> _destination_writer_modules;
   std::unique_ptr<Metrics::IRegistrar> _registrar;
   FileWriter::FlatbufferMessage::SrcHash _source_hash{0};
@@ -80,6 +133,12 @@ private:
   Metrics::Metric RepeatedTimestamp{"repeated_timestamp",
                                     "Got message with repeated timestamp.",
                                     Metrics::Severity::DEBUG};
+  Metrics::Metric LateMessages{
+      "late", "Number of messages that arrived after the reorder window.",
+      Metrics::Severity::WARNING};
+  Metrics::Metric Duplicates{"duplicates",
+                             "Number of duplicate messages dropped.",
+                             Metrics::Severity::DEBUG};
   Metrics::Metric MessagesReceived{"received",
                                    "Number of messages received/processed.",
                                    Metrics::Severity::DEBUG};
@@ -28,9 +28,9 @@ Topic::Topic(Kafka::BrokerSettings const &Settings, std::string const &Topic,
              std::shared_ptr<Kafka::MetadataEnquirer> metadata_enquirer,
              std::shared_ptr<Kafka::ConsumerFactoryInterface> consumer_factory)
     : KafkaSettings(Settings), TopicName(Topic), DataMap(std::move(Map)),
-      WriterPtr(Writer), StartConsumeTime(StartTime),
-      StartLeeway(StartTimeLeeway), StopConsumeTime(StopTime),
-      StopLeeway(StopTimeLeeway),
+      ReorderWindows(create_reorder_stages(DataMap)), WriterPtr(Writer),
+      StartConsumeTime(StartTime), StartLeeway(StartTimeLeeway),
+      StopConsumeTime(StopTime), StopLeeway(StopTimeLeeway),
       CurrentMetadataTimeOut(Settings.MinMetadataTimeout),
       Registrar(RegisterMetric->getNewRegistrar(Topic)),
       AreStreamersPausedFunction(std::move(AreStreamersPausedFunction)),
@@ -167,9 +167,9 @@ void Topic::createStreams(
     auto Consumer = _consumer_factory->createConsumerAtOffset(
         Settings, Topic, partition, offset);
     auto TempPartition = PartitionThreaded::create(
-        std::move(Consumer), partition, Topic, DataMap, WriterPtr,
-        CRegistrar.get(), StartConsumeTime, StopConsumeTime, StopLeeway,
-        Settings.KafkaErrorTimeout, AreStreamersPausedFunction);
+        std::move(Consumer), partition, Topic, DataMap, ReorderWindows,
+        WriterPtr, CRegistrar.get(), StartConsumeTime, StopConsumeTime,
+        StopLeeway, Settings.KafkaErrorTimeout, AreStreamersPausedFunction);
     ConsumerThreads.emplace_back(std::move(TempPartition));
   }
   checkIfDoneTask();
@@ -66,6 +66,8 @@ protected:
   Kafka::BrokerSettings KafkaSettings;
   std::string TopicName;
   SrcToDst DataMap;
+  /// The reorder windows of the sources, shared by all partitions.
+  ReorderStages ReorderWindows;
   MessageWriter *WriterPtr;
   time_point StartConsumeTime;
   duration StartLeeway;
@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+/// \brief Worker threads for the CPU bound part of writing messages.
+///
+
+#include "WritePreparationPool.h"
+#include "SetThreadName.h"
+#include "logger.h"
+
+namespace Stream {
+
+WritePreparationPool::WritePreparationPool(size_t NrOfThreads) {
+  for (size_t i = 0; i < NrOfThreads; ++i) {
+    Workers.emplace_back(&WritePreparationPool::threadFunction, this);
+  }
+}
+
+WritePreparationPool::~WritePreparationPool() {
+  {
+    std::lock_guard Lock(PoolMutex);
+    RunThreads = false;
+  }
+  TaskAvailable.notify_all();
+  for (auto &Worker : Workers) {
+    if (Worker.joinable()) {
+      Worker.join();
+    }
+  }
+}
+
+void WritePreparationPool::submit(KeyType Key, TaskType Task) {
+  {
+    std::lock_guard Lock(PoolMutex);
+    auto &CurrentStrand = Strands[Key];
+    CurrentStrand.Tasks.push_back(std::move(Task));
+    if (CurrentStrand.Scheduled) {
+      // A worker will pick up the task when done with the earlier ones.
+      return;
+    }
+    CurrentStrand.Scheduled = true;
+    ScheduledStrands.push_back(Key);
+  }
+  TaskAvailable.notify_one();
+}
+
+void WritePreparationPool::threadFunction() {
+  setThreadName("write_prep");
+  std::unique_lock Lock(PoolMutex);
+  while (true) {
+    TaskAvailable.wait(
+        Lock, [this]() { return !ScheduledStrands.empty() || !RunThreads; });
+    if (ScheduledStrands.empty()) {
+      // Only reached when stopping with no tasks left.
+      return;
+    }
+    auto Key = ScheduledStrands.front();
+    ScheduledStrands.pop_front();
+    auto &CurrentStrand = Strands[Key];
+    auto CurrentTask = std::move(CurrentStrand.Tasks.front());
+    CurrentStrand.Tasks.pop_front();
+    Lock.unlock();
+    try {
+      CurrentTask();
+    } catch (std::exception &E) {
+      Logger::Error("Write preparation task failed: {}", E.what());
+    }
+    Lock.lock();
+    if (CurrentStrand.Tasks.empty()) {
+      CurrentStrand.Scheduled = false;
+    } else {
+      // Go to the back of the line to let other strands have a go.
+      ScheduledStrands.push_back(Key);
+      TaskAvailable.notify_one();
+    }
+  }
+}
+
+} // namespace Stream
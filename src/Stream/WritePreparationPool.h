@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+/// \brief Worker threads for the CPU bound part of writing messages.
+///
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Stream {
+
+/// \brief A thread pool that executes tasks in order per key.
+///
+/// Tasks submitted with the same key are executed one at a time and in the
+/// order in which they were submitted. Tasks with different keys may be
+/// executed concurrently. Used by the MessageWriter to run the (CPU bound)
+/// preparation of writes for different writer modules in parallel while the
+/// actual HDF5 calls are done by the writer thread only.
+class WritePreparationPool {
+public:
+  using KeyType = void const *;
+  using TaskType = std::function<void()>;
+
+  explicit WritePreparationPool(size_t NrOfThreads);
+
+  /// \brief Executes all queued tasks before returning.
+  ~WritePreparationPool();
+
+  /// \brief Queue a task for execution.
+  ///
+  /// \note Tasks should not throw, exceptions are logged and ignored.
+  void submit(KeyType Key, TaskType Task);
+
+  size_t nrOfThreads() const { return Workers.size(); }
+
+private:
+  void threadFunction();
+
+  struct Strand {
+    std::deque<TaskType> Tasks;
+    bool Scheduled{false};
+  };
+  std::mutex PoolMutex;
+  std::condition_variable TaskAvailable;
+  std::map<KeyType, Strand> Strands;
+  std::deque<KeyType> ScheduledStrands;
+  bool RunThreads{true};
+  std::vector<std::thread> Workers; // Must be last
+};
+
+} // namespace Stream
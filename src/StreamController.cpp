@@ -20,9 +20,13 @@ StreamController::StreamController(
     std::shared_ptr<Kafka::ConsumerFactoryInterface> consumer_factory)
     : WriterTask(std::move(FileWriterTask)), MdatWriter(std::move(mdatWriter)),
       StreamMetricRegistrar(Registrar->getNewRegistrar("")),
-      WriterThread([this]() { WriterTask->flushDataToFile(); },
-                   Settings.DataFlushInterval,
-                   Registrar->getNewRegistrar("stream.writer")),
+      WriterThread(
+          [this](duration MaxTime) {
+            return WriterTask->flushDataToFile(MaxTime);
+          },
+          Settings.DataFlushInterval,
+          Registrar->getNewRegistrar("stream.writer"),
+          Settings.WritePreparationThreads, Settings.FlushAfterBytes),
       StreamerOptions(Settings), MetaDataTracker(std::move(Tracker)),
       _metadata_enquirer(std::move(metadata_enquirer)),
       _consumer_factory(std::move(consumer_factory)) {}
@@ -111,10 +115,13 @@ void StreamController::initStreams(std::set<std::string> known_topic_names) {
   std::string errors_collector;
   for (auto &src : WriterTask->sources()) {
     if (known_topic_names.find(src.topic()) != known_topic_names.end()) {
+      auto *Writer = src.getWriterPtr();
       topic_src_map[src.topic()].push_back(
-          {src.getSrcHash(), src.getModuleHash(), src.getWriterPtr(),
-           src.sourcename(), src.flatbufferID(), src.writerModuleID(),
-           src.getWriterPtr()->acceptsRepeatedTimestamps()});
+          {src.getSrcHash(), src.getModuleHash(), Writer, src.sourcename(),
+           src.flatbufferID(), src.writerModuleID(),
+           Writer->acceptsRepeatedTimestamps(),
+           Writer->reorderWindowMessages(), Writer->reorderWindowTime(),
+           Writer->dedupWindow(), Writer->writesAllMessagesOfTopic()});
     } else {
       errors_collector += fmt::format(
           "Unable to set up consumer for source {} on topic {} as this "
@@ -185,14 +192,30 @@ void StreamController::checkIfStreamsAreDone() {
 
 void StreamController::throttleIfWriteQueueIsFull() {
   auto QueuedWrites = WriterThread.nrOfWritesQueued();
-  if (QueuedWrites > StreamerOptions.MaxQueuedWrites &&
-      !StreamersPaused.load()) {
+  auto MaxQueuedWrites = StreamerOptions.MaxQueuedWrites;
+  if (StreamerOptions.LoadShedding) {
+    if (QueuedWrites > MaxQueuedWrites && !WriterThread.loadSheddingActive()) {
+      Logger::Info(
+          "Maximum queued writes exceeded (count={}). Starting load shedding.",
+          QueuedWrites);
+      WriterThread.setLoadShedding(true);
+    } else if (QueuedWrites < QueuedWritesResumeThreshold * MaxQueuedWrites &&
+               WriterThread.loadSheddingActive()) {
+      Logger::Info("Write queue below maximum (count={}). Stopping load "
+                   "shedding.",
+                   QueuedWrites);
+      WriterThread.setLoadShedding(false);
+    }
+    // Only pause the consumers if load shedding is not enough, e.g. due to
+    // the streams being configured to never drop messages.
+    MaxQueuedWrites *= LoadSheddingPauseFactor;
+  }
+  if (QueuedWrites > MaxQueuedWrites && !StreamersPaused.load()) {
     Logger::Debug(
         "Maximum queued writes exceeded (count={}). Pausing consumers...",
         QueuedWrites);
     pauseStreamers();
-  } else if (QueuedWrites < QueuedWritesResumeThreshold *
-                                StreamerOptions.MaxQueuedWrites &&
+  } else if (QueuedWrites < QueuedWritesResumeThreshold * MaxQueuedWrites &&
              StreamersPaused.load()) {
     Logger::Debug("Write queue below maximum (count={}). Resuming consumers...",
                   QueuedWrites);
@@ -123,6 +123,11 @@ private:
   /// which the consumers will be resumed.
   float const QueuedWritesResumeThreshold{0.8F};
 
+  /// \brief Factor by which the write queue may exceed
+  /// StreamerOptions.MaxQueuedWrites before the consumers are paused, if load
+  /// shedding is enabled.
+  size_t const LoadSheddingPauseFactor{2};
+
   /// \brief The file-writing task object
   /// \note Must be located before the streamers and the writer thread to
   /// guarantee that its destructor is not called before the writer modules have
@@ -16,14 +16,23 @@ namespace FileWriter {
 
 /// Contains configuration parameters for the Streamer
 struct StreamerOptions {
-  // Amount of time between flushing of data to file.
+  // Max amount of time between flushing of data to file.
   duration DataFlushInterval{10s};
+  // Flush when (approximately) this many bytes have been written since the
+  // last flush, zero to disable.
+  size_t FlushAfterBytes{0};
   Kafka::BrokerSettings BrokerSettings;
   time_point StartTimestamp{0ms};
   time_point StopTimestamp{time_point::max()};
   duration BeforeStartTime{10s};
   duration AfterStopTime{10s};
   size_t MaxQueuedWrites{1000};
+  // Drop messages according to the drop policy of the streams when
+  // MaxQueuedWrites is exceeded, before pausing the consumers.
+  bool LoadShedding{false};
+  // Nr of threads used for preparing writes, zero to do all of the work on
+  // the writer thread.
+  size_t WritePreparationThreads{2};
 };
 
 } // namespace FileWriter
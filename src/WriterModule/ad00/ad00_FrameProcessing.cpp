@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#include "ad00_FrameProcessing.h"
+#include <fmt/core.h>
+#include <stdexcept>
+#include <vector>
+
+namespace WriterModule::ad00 {
+
+FrameRegion parseFrameRegion(nlohmann::json const &Config,
+                             std::string const &DefaultName) {
+  if (!Config.is_object() || !Config.contains("offset") ||
+      !Config.contains("size")) {
+    throw std::runtime_error(
+        fmt::format(R"(A region must have an "offset" and a "size": {})",
+                    Config.dump()));
+  }
+  auto Offset = Config["offset"].get<std::vector<size_t>>();
+  auto Size = Config["size"].get<std::vector<size_t>>();
+  if (Offset.size() != 2 || Size.size() != 2) {
+    throw std::runtime_error(fmt::format(
+        "The offset and the size of a region must be (rows, columns): {}",
+        Config.dump()));
+  }
+  if (Size[0] == 0 || Size[1] == 0) {
+    throw std::runtime_error(
+        fmt::format("A region can not be empty: {}", Config.dump()));
+  }
+  return {Config.value("name", DefaultName), Offset[0], Offset[1], Size[0],
+          Size[1]};
+}
+
+} // namespace WriterModule::ad00
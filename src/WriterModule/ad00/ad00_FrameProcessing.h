@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+/// \file
+/// \brief Regions of interest, pixel binning and sum projections of ad00
+/// frames.
+///
+/// Frames are two-dimensional arrays of pixels in row-major order, i.e. the
+/// dimensions of a frame are (rows, columns). The loops walk the pixels of a
+/// frame row by row and have no branches, so that they can be vectorised.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <nlohmann/json.hpp>
+#include <numeric>
+#include <string>
+#include <type_traits>
+
+namespace WriterModule::ad00 {
+
+/// \brief A rectangular region of a frame.
+struct FrameRegion {
+  /// The name of the dataset of the region.
+  std::string Name;
+  size_t Row{0};
+  size_t Column{0};
+  size_t Rows{0};
+  size_t Columns{0};
+
+  /// \brief Check if the region is inside a frame of the given shape.
+  [[nodiscard]] bool fits(size_t FrameRows, size_t FrameColumns) const {
+    return Row + Rows <= FrameRows && Column + Columns <= FrameColumns;
+  }
+};
+
+/// \brief Parse a region from its configuration, e.g.
+/// `{"name": "spot", "offset": [10, 20], "size": [64, 32]}` for the 64 rows
+/// and 32 columns starting at row 10 and column 20.
+///
+/// \param Config The configuration of the region.
+/// \param DefaultName The name used if the configuration has none.
+/// \throws std::runtime_error If the configuration is invalid.
+FrameRegion parseFrameRegion(nlohmann::json const &Config,
+                             std::string const &DefaultName);
+
+/// \brief The type that pixels of type \p T are summed in.
+template <typename T>
+using PixelSum = std::conditional_t<
+    std::is_floating_point_v<T>, double,
+    std::conditional_t<std::is_signed_v<T>, std::int64_t, std::uint64_t>>;
+
+/// \brief Convert a sum of pixels to \p T, clamped to the range of \p T.
+template <typename T> T saturate(PixelSum<T> Sum) {
+  if constexpr (std::is_floating_point_v<T> ||
+                sizeof(T) == sizeof(PixelSum<T>)) {
+    return static_cast<T>(Sum);
+  } else {
+    return static_cast<T>(std::clamp<PixelSum<T>>(
+        Sum, std::numeric_limits<T>::lowest(), std::numeric_limits<T>::max()));
+  }
+}
+
+/// \brief Copy a region of a frame, summing the pixels of every bin of
+/// \p BinRows x \p BinColumns pixels into one pixel.
+///
+/// Rows and columns at the end of the region that do not fill a whole bin
+/// are dropped. The sums are clamped to the range of \p T.
+///
+/// \param Frame The pixels of the frame.
+/// \param FrameColumns The number of columns of the frame.
+/// \param Region The region, must be inside the frame.
+/// \param BinRows The number of rows of a bin.
+/// \param BinColumns The number of columns of a bin.
+/// \param RowSums Space for the sums of one row of bins, i.e.
+/// `Region.Columns / BinColumns` values.
+/// \param Result The binned pixels, `(Region.Rows / BinRows) x
+/// (Region.Columns / BinColumns)` values.
+template <typename T>
+void binRegion(T const *Frame, size_t FrameColumns, FrameRegion const &Region,
+               size_t BinRows, size_t BinColumns, PixelSum<T> *RowSums,
+               T *Result) {
+  auto const ResultRows = Region.Rows / BinRows;
+  auto const ResultColumns = Region.Columns / BinColumns;
+  auto const *First = Frame + Region.Row * FrameColumns + Region.Column;
+  if (BinRows == 1 && BinColumns == 1) {
+    for (size_t Row = 0; Row < ResultRows; ++Row) {
+      std::copy_n(First + Row * FrameColumns, ResultColumns,
+                  Result + Row * ResultColumns);
+    }
+    return;
+  }
+  for (size_t Row = 0; Row < ResultRows; ++Row) {
+    std::fill_n(RowSums, ResultColumns, PixelSum<T>{0});
+    for (size_t BinRow = 0; BinRow < BinRows; ++BinRow) {
+      auto const *Pixels = First + (Row * BinRows + BinRow) * FrameColumns;
+      // One (strided) pass per column of the bins, the row stays in the
+      // cache.
+      for (size_t BinColumn = 0; BinColumn < BinColumns; ++BinColumn) {
+        for (size_t Column = 0; Column < ResultColumns; ++Column) {
+          RowSums[Column] += Pixels[Column * BinColumns + BinColumn];
+        }
+      }
+    }
+    auto *ResultRow = Result + Row * ResultColumns;
+    for (size_t Column = 0; Column < ResultColumns; ++Column) {
+      ResultRow[Column] = saturate<T>(RowSums[Column]);
+    }
+  }
+}
+
+/// \brief Sum the pixels of a frame along its columns and along its rows.
+///
+/// \param Frame The pixels of the frame.
+/// \param Rows The number of rows of the frame.
+/// \param Columns The number of columns of the frame.
+/// \param ColumnSums The sum of every column (i.e. the projection on the
+/// columns), \p Columns values.
+/// \param RowSums The sum of every row, \p Rows values.
+template <typename T>
+void sumProjections(T const *Frame, size_t Rows, size_t Columns,
+                    PixelSum<T> *ColumnSums, PixelSum<T> *RowSums) {
+  std::fill_n(ColumnSums, Columns, PixelSum<T>{0});
+  for (size_t Row = 0; Row < Rows; ++Row) {
+    auto const *Pixels = Frame + Row * Columns;
+    for (size_t Column = 0; Column < Columns; ++Column) {
+      ColumnSums[Column] += Pixels[Column];
+    }
+    RowSums[Row] = std::accumulate(Pixels, Pixels + Columns, PixelSum<T>{0});
+  }
+}
+
+/// \brief Sum every \p BinSize values into one, in place.
+///
+/// Values at the end that do not fill a whole bin are dropped.
+///
+/// \return The number of binned values.
+template <typename T>
+size_t binInPlace(T *Values, size_t Size, size_t BinSize) {
+  auto const NrOfBins = Size / BinSize;
+  for (size_t Bin = 0; Bin < NrOfBins; ++Bin) {
+    Values[Bin] = std::accumulate(Values + Bin * BinSize,
+                                  Values + (Bin + 1) * BinSize, T{0});
+  }
+  return NrOfBins;
+}
+
+} // namespace WriterModule::ad00
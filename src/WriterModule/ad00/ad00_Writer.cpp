@@ -14,10 +14,12 @@
 
 #include "helper.h"
 
+#include "HDFAttributes.h"
 #include "HDFOperations.h"
 #include "WriterRegistrar.h"
 #include "ad00_Writer.h"
 #include <ad00_area_detector_array_generated.h>
+#include <set>
 
 namespace WriterModule::ad00 {
 
@@ -43,25 +45,90 @@ void ad00_Writer::config_post_processing() {
     Logger::Error("Unknown type ({}), using the default (double).",
                   DataType.get_value());
   }
+
+  BinRows = 1;
+  BinColumns = 1;
+  if (auto Bins = Binning.get_value();
+      Bins.size() == 2 && Bins[0] > 0 && Bins[1] > 0) {
+    BinRows = Bins[0];
+    BinColumns = Bins[1];
+  } else {
+    Logger::Error("The binning must be the (non-zero) number of rows and "
+                  "columns of a bin, not binning the frames.");
+  }
+  SumProjections = SumProjectionsField;
+  Regions.clear();
+  std::set<std::string> DatasetNames{"value",        "time",
+                                     "cue_index",    "cue_timestamp_zero",
+                                     "projection_x", "projection_y"};
+  auto const &RegionConfigs = RegionsField.get_value();
+  for (size_t i = 0; i < RegionConfigs.size(); ++i) {
+    try {
+      auto Region =
+          parseFrameRegion(RegionConfigs[i], fmt::format("roi_{}", i));
+      if (Region.Rows < BinRows || Region.Columns < BinColumns) {
+        throw std::runtime_error("The region is smaller than a bin.");
+      }
+      if (!DatasetNames.insert(Region.Name).second) {
+        throw std::runtime_error(
+            fmt::format(R"(The name "{}" is already used.)", Region.Name));
+      }
+      Regions.push_back(std::move(Region));
+    } catch (std::exception const &E) {
+      Logger::Error("Invalid region of interest, not using it: {}", E.what());
+    }
+  }
+  if (processesFrames() && ArrayShape.get_value().size() != 2) {
+    Logger::Error("Regions, binning and projections require frames with two "
+                  "dimensions, writing the whole frames.");
+    Regions.clear();
+    BinRows = 1;
+    BinColumns = 1;
+    SumProjections = false;
+  }
 }
 
 InitResult ad00_Writer::init_hdf(hdf5::node::Group &HDFGroup) {
   auto DefaultChunkSize = ChunkSize.operator hdf5::Dimensions().at(0);
   try {
-    initValueDataset(HDFGroup);
+    hdf5::Dimensions FrameShape = ArrayShape;
+    if (processesFrames()) {
+      FrameShape = {FrameShape[0] / BinRows, FrameShape[1] / BinColumns};
+    }
+    if (Regions.empty()) {
+      initValueDataset(HDFGroup, "value", FrameShape);
+      HDFGroup["value"].attributes.create_from<std::string>("units", "");
+    }
+    for (auto const &Region : Regions) {
+      initValueDataset(HDFGroup, Region.Name,
+                       {Region.Rows / BinRows, Region.Columns / BinColumns});
+      auto RegionDataset = HDFGroup.get_dataset(Region.Name);
+      HDFAttributes::writeAttribute(
+          RegionDataset, "offset",
+          std::vector<std::uint64_t>{Region.Row, Region.Column});
+      HDFAttributes::writeAttribute(
+          RegionDataset, "binning",
+          std::vector<std::uint64_t>{BinRows, BinColumns});
+    }
+    if (SumProjections) {
+      initProjectionDataset(HDFGroup, "projection_x", FrameShape[1]);
+      initProjectionDataset(HDFGroup, "projection_y", FrameShape[0]);
+    }
     NeXusDataset::Time(             // NOLINT(bugprone-unused-raii)
         HDFGroup,                   // NOLINT(bugprone-unused-raii)
         NeXusDataset::Mode::Create, // NOLINT(bugprone-unused-raii)
-        DefaultChunkSize);          // NOLINT(bugprone-unused-raii)
+        DefaultChunkSize,           // NOLINT(bugprone-unused-raii)
+        compression("time"));       // NOLINT(bugprone-unused-raii)
     NeXusDataset::CueIndex(         // NOLINT(bugprone-unused-raii)
         HDFGroup,                   // NOLINT(bugprone-unused-raii)
         NeXusDataset::Mode::Create, // NOLINT(bugprone-unused-raii)
-        DefaultChunkSize);          // NOLINT(bugprone-unused-raii)
-    NeXusDataset::CueTimestampZero( // NOLINT(bugprone-unused-raii)
-        HDFGroup,                   // NOLINT(bugprone-unused-raii)
-        NeXusDataset::Mode::Create, // NOLINT(bugprone-unused-raii)
-        DefaultChunkSize);          // NOLINT(bugprone-unused-raii)
-    HDFGroup["value"].attributes.create_from<std::string>("units", "");
+        DefaultChunkSize,           // NOLINT(bugprone-unused-raii)
+        compression("cue_index"));  // NOLINT(bugprone-unused-raii)
+    NeXusDataset::CueTimestampZero(         // NOLINT(bugprone-unused-raii)
+        HDFGroup,                           // NOLINT(bugprone-unused-raii)
+        NeXusDataset::Mode::Create,         // NOLINT(bugprone-unused-raii)
+        DefaultChunkSize,                   // NOLINT(bugprone-unused-raii)
+        compression("cue_timestamp_zero")); // NOLINT(bugprone-unused-raii)
   } catch (std::exception &E) {
     Logger::Error(
         R"(Unable to initialise areaDetector data tree in HDF file with error message: "{}")",
@@ -73,8 +140,26 @@ InitResult ad00_Writer::init_hdf(hdf5::node::Group &HDFGroup) {
 
 WriterModule::InitResult ad00_Writer::reopen(hdf5::node::Group &HDFGroup) {
   try {
-    Values = std::make_unique<NeXusDataset::MultiDimDatasetBase>(
-        HDFGroup, "value", NeXusDataset::Mode::Open);
+    auto OpenFrames = [&](std::string const &Name) {
+      auto Dataset = std::make_unique<NeXusDataset::MultiDimDatasetBase>(
+          HDFGroup, Name, NeXusDataset::Mode::Open);
+      Dataset->useDirectChunkWrites(
+          NeXusDataset::ChunkCompressionPool::instance());
+      Dataset->setFramesPerWrite(FramesPerWrite);
+      return Dataset;
+    };
+    Values.reset();
+    if (Regions.empty()) {
+      Values = OpenFrames("value");
+    }
+    RegionValues.clear();
+    for (auto const &Region : Regions) {
+      RegionValues.push_back(OpenFrames(Region.Name));
+    }
+    if (SumProjections) {
+      ProjectionX = OpenFrames("projection_x");
+      ProjectionY = OpenFrames("projection_y");
+    }
     Timestamp = NeXusDataset::Time(HDFGroup, NeXusDataset::Mode::Open);
     CueTimestampIndex =
         NeXusDataset::CueIndex(HDFGroup, NeXusDataset::Mode::Open);
@@ -96,6 +181,102 @@ void appendData(DatasetType &Dataset, const std::uint8_t *Pointer, size_t Size,
       Shape);
 }
 
+template <typename T>
+std::function<void()>
+ad00_Writer::prepareFrame(std::uint8_t const *Data, size_t DataSize,
+                          size_t NrOfElements, hdf5::Dimensions const &Shape) {
+  if (DataSize != NrOfElements * sizeof(T)) {
+    throw WriterModule::WriterException(fmt::format(
+        "The ad00 message has {} bytes of data but its dimensions require {}.",
+        DataSize, NrOfElements * sizeof(T)));
+  }
+  if (!processesFrames()) {
+    return [this, Data, NrOfElements, Shape]() {
+      appendData<T const>(Values, Data, NrOfElements, Shape);
+    };
+  }
+  if (Shape.size() != 2) {
+    throw WriterModule::WriterException(fmt::format(
+        "Frames with {} dimensions can not be processed, two are required.",
+        Shape.size()));
+  }
+  auto const *Frame = reinterpret_cast<T const *>(Data);
+  auto const Rows = static_cast<size_t>(Shape[0]);
+  auto const Columns = static_cast<size_t>(Shape[1]);
+  for (auto const &Region : Regions) {
+    if (!Region.fits(Rows, Columns)) {
+      throw WriterModule::WriterException(fmt::format(
+          R"(The region "{}" is outside of the frame ({} x {} pixels).)",
+          Region.Name, Rows, Columns));
+    }
+  }
+  auto const WritesWholeFrame = Values && BinRows == 1 && BinColumns == 1;
+  BinnedRegion<T> BinnedFrame;
+  if (Values && !WritesWholeFrame) {
+    BinnedFrame =
+        binnedRegion(Frame, Columns, FrameRegion{"value", 0, 0, Rows, Columns});
+  }
+  std::vector<BinnedRegion<T>> BinnedRegions;
+  BinnedRegions.reserve(Regions.size());
+  for (auto const &Region : Regions) {
+    BinnedRegions.push_back(binnedRegion(Frame, Columns, Region));
+  }
+  // The column sums followed by the row sums.
+  std::vector<PixelSum<T>> Projections;
+  size_t NrOfColumnBins{0};
+  size_t NrOfRowBins{0};
+  if (SumProjections) {
+    Projections.resize(Columns + Rows);
+    auto *ColumnSums = Projections.data();
+    auto *RowSums = ColumnSums + Columns;
+    sumProjections(Frame, Rows, Columns, ColumnSums, RowSums);
+    NrOfColumnBins = binInPlace(ColumnSums, Columns, BinColumns);
+    NrOfRowBins = binInPlace(RowSums, Rows, BinRows);
+  }
+  return [this, Data, NrOfElements, Shape, WritesWholeFrame,
+          BinnedFrame = std::move(BinnedFrame),
+          BinnedRegions = std::move(BinnedRegions),
+          Projections = std::move(Projections), Columns, NrOfColumnBins,
+          NrOfRowBins]() {
+    if (WritesWholeFrame) {
+      appendData<T const>(Values, Data, NrOfElements, Shape);
+    } else if (Values) {
+      Values->appendArray(
+          hdf5::ArrayAdapter<T const>(BinnedFrame.Pixels.data(),
+                                      BinnedFrame.Pixels.size()),
+          BinnedFrame.Shape);
+    }
+    for (size_t i = 0; i < BinnedRegions.size(); ++i) {
+      auto const &Region = BinnedRegions[i];
+      RegionValues[i]->appendArray(
+          hdf5::ArrayAdapter<T const>(Region.Pixels.data(),
+                                      Region.Pixels.size()),
+          Region.Shape);
+    }
+    if (SumProjections) {
+      ProjectionX->appendArray(hdf5::ArrayAdapter<PixelSum<T> const>(
+                                   Projections.data(), NrOfColumnBins),
+                               {NrOfColumnBins});
+      ProjectionY->appendArray(hdf5::ArrayAdapter<PixelSum<T> const>(
+                                   Projections.data() + Columns, NrOfRowBins),
+                               {NrOfRowBins});
+    }
+  };
+}
+
+template <typename T>
+BinnedRegion<T> ad00_Writer::binnedRegion(T const *Frame, size_t FrameColumns,
+                                          FrameRegion const &Region) {
+  BinnedRegion<T> Result;
+  Result.Shape = {Region.Rows / BinRows, Region.Columns / BinColumns};
+  Result.Pixels.resize(Result.Shape[0] * Result.Shape[1]);
+  PixelSums.resize(Result.Shape[1] * sizeof(PixelSum<T>));
+  binRegion(Frame, FrameColumns, Region, BinRows, BinColumns,
+            reinterpret_cast<PixelSum<T> *>(PixelSums.data()),
+            Result.Pixels.data());
+  return Result;
+}
+
 void msgTypeIsConfigType(ad00_Writer::Type ConfigType, DType MsgType) {
   std::unordered_map<DType, ad00_Writer::Type> TypeComparison{
       {DType::int8, ad00_Writer::Type::int8},
@@ -140,7 +321,13 @@ void msgTypeIsConfigType(ad00_Writer::Type ConfigType, DType MsgType) {
 }
 
 bool ad00_Writer::writeImpl(const FileWriter::FlatbufferMessage &Message,
-                            [[maybe_unused]] bool is_buffered_message) {
+                            bool is_buffered_message) {
+  return prepareImpl(Message, is_buffered_message)();
+}
+
+WriterModule::WriteStage
+ad00_Writer::prepareImpl(const FileWriter::FlatbufferMessage &Message,
+                         [[maybe_unused]] bool is_buffered_message) {
   auto ad00 = Getad00_ADArray(Message.data());
   auto DataShape =
       hdf5::Dimensions(ad00->dimensions()->begin(), ad00->dimensions()->end());
@@ -152,92 +339,205 @@ bool ad00_Writer::writeImpl(const FileWriter::FlatbufferMessage &Message,
     HasCheckedMessageType = true;
   }
 
-  auto DataPtr = ad00->data()->Data();
+  std::uint8_t const *DataPtr{nullptr};
+  size_t DataSize{0};
+  if (ad00->data() != nullptr) {
+    DataPtr = ad00->data()->Data();
+    DataSize = ad00->data()->size();
+  }
   auto NrOfElements =
       std::accumulate(std::cbegin(DataShape), std::cend(DataShape), size_t(1),
                       std::multiplies<>());
 
+  std::function<void()> AppendFrame;
   switch (Type) {
   case DType::int8:
-    appendData<const std::int8_t>(Values, DataPtr, NrOfElements, DataShape);
+    AppendFrame = prepareFrame<std::int8_t>(DataPtr, DataSize, NrOfElements,
+                                            DataShape);
     break;
   case DType::uint8:
-    appendData<const std::uint8_t>(Values, DataPtr, NrOfElements, DataShape);
+    AppendFrame = prepareFrame<std::uint8_t>(DataPtr, DataSize, NrOfElements,
+                                             DataShape);
     break;
   case DType::int16:
-    appendData<const std::int16_t>(Values, DataPtr, NrOfElements, DataShape);
+    AppendFrame = prepareFrame<std::int16_t>(DataPtr, DataSize, NrOfElements,
+                                             DataShape);
     break;
   case DType::uint16:
-    appendData<const std::uint16_t>(Values, DataPtr, NrOfElements, DataShape);
+    AppendFrame = prepareFrame<std::uint16_t>(DataPtr, DataSize, NrOfElements,
+                                              DataShape);
     break;
   case DType::int32:
-    appendData<const std::int32_t>(Values, DataPtr, NrOfElements, DataShape);
+    AppendFrame = prepareFrame<std::int32_t>(DataPtr, DataSize, NrOfElements,
+                                             DataShape);
     break;
   case DType::uint32:
-    appendData<const std::uint32_t>(Values, DataPtr, NrOfElements, DataShape);
+    AppendFrame = prepareFrame<std::uint32_t>(DataPtr, DataSize, NrOfElements,
+                                              DataShape);
     break;
   case DType::int64:
-    appendData<const std::int64_t>(Values, DataPtr, NrOfElements, DataShape);
+    AppendFrame = prepareFrame<std::int64_t>(DataPtr, DataSize, NrOfElements,
+                                             DataShape);
     break;
   case DType::uint64:
-    appendData<const std::uint64_t>(Values, DataPtr, NrOfElements, DataShape);
+    AppendFrame = prepareFrame<std::uint64_t>(DataPtr, DataSize, NrOfElements,
+                                              DataShape);
     break;
   case DType::float32:
-    appendData<const float>(Values, DataPtr, NrOfElements, DataShape);
+    AppendFrame =
+        prepareFrame<float>(DataPtr, DataSize, NrOfElements, DataShape);
     break;
   case DType::float64:
-    appendData<const double>(Values, DataPtr, NrOfElements, DataShape);
+    AppendFrame =
+        prepareFrame<double>(DataPtr, DataSize, NrOfElements, DataShape);
     break;
   case DType::c_string:
-    appendData<const char>(Values, DataPtr, NrOfElements, DataShape);
+    AppendFrame =
+        prepareFrame<char>(DataPtr, DataSize, NrOfElements, DataShape);
     break;
   default:
     throw WriterModule::WriterException("Error in flatbuffer.");
   }
-  Timestamp.appendElement(CurrentTimestamp);
-  if (++CueCounter == CueInterval) {
-    CueTimestampIndex.appendElement(Timestamp.current_size() - 1);
-    CueTimestamp.appendElement(CurrentTimestamp);
-    CueCounter = 0;
+  return [this, AppendFrame = std::move(AppendFrame), CurrentTimestamp]() {
+    AppendFrame();
+    Timestamp.appendElement(CurrentTimestamp);
+    if (++CueCounter == CueInterval) {
+      CueTimestampIndex.appendElement(Timestamp.current_size() - 1);
+      CueTimestamp.appendElement(CurrentTimestamp);
+      CueCounter = 0;
+    }
+    return true;
+  };
+}
+
+void ad00_Writer::flushBuffers() {
+  if (Values) {
+    Values->flushBuffer();
+  }
+  for (auto &RegionDataset : RegionValues) {
+    RegionDataset->flushBuffer();
+  }
+  if (ProjectionX && ProjectionY) {
+    ProjectionX->flushBuffer();
+    ProjectionY->flushBuffer();
   }
-  return true;
+  Timestamp.flushBuffer();
+  CueTimestampIndex.flushBuffer();
+  CueTimestamp.flushBuffer();
 }
 
 template <typename Type>
 std::unique_ptr<NeXusDataset::MultiDimDatasetBase>
-makeIt(hdf5::node::Group const &Parent, hdf5::Dimensions const &Shape,
-       hdf5::Dimensions const &ChunkSize) {
+makeIt(hdf5::node::Group const &Parent, std::string const &Name,
+       hdf5::Dimensions const &Shape, hdf5::Dimensions const &ChunkSize,
+       NeXusDataset::Compression const &Settings) {
   return std::make_unique<NeXusDataset::MultiDimDataset<Type>>(
-      Parent, "value", NeXusDataset::Mode::Create, Shape, ChunkSize);
+      Parent, Name, NeXusDataset::Mode::Create, Shape, ChunkSize, Settings);
+}
+
+/// \brief The chunk size of a dataset of frames (or regions or projections)
+/// of the given shape.
+///
+/// If the number of frames per chunk is configured, the chunks contain that
+/// many whole frames. Otherwise the configured chunk size is used.
+hdf5::Dimensions
+ad00_Writer::valueChunkSize(hdf5::Dimensions const &Shape) const {
+  if (FramesPerChunk == 0) {
+    return ChunkSize;
+  }
+  hdf5::Dimensions FrameChunk = Shape;
+  FrameChunk.insert(FrameChunk.begin(), FramesPerChunk.get_value());
+  return FrameChunk;
 }
 
-void ad00_Writer::initValueDataset(hdf5::node::Group const &Parent) const {
+void ad00_Writer::initValueDataset(hdf5::node::Group const &Parent,
+                                   std::string const &Name,
+                                   hdf5::Dimensions const &Shape) const {
   using OpenFuncType =
       std::function<std::unique_ptr<NeXusDataset::MultiDimDatasetBase>()>;
+  auto Settings = compression(Name);
+  auto ValueChunkSize = valueChunkSize(Shape);
   std::map<Type, OpenFuncType> CreateValuesMap{
       {Type::c_string,
-       [&]() { return makeIt<char>(Parent, ArrayShape, ChunkSize); }},
+       [&]() {
+         return makeIt<char>(Parent, Name, Shape, ValueChunkSize,
+                             Settings);
+       }},
       {Type::int8,
-       [&]() { return makeIt<std::int8_t>(Parent, ArrayShape, ChunkSize); }},
+       [&]() {
+         return makeIt<std::int8_t>(Parent, Name, Shape, ValueChunkSize,
+                                    Settings);
+       }},
       {Type::uint8,
-       [&]() { return makeIt<std::uint8_t>(Parent, ArrayShape, ChunkSize); }},
+       [&]() {
+         return makeIt<std::uint8_t>(Parent, Name, Shape, ValueChunkSize,
+                                     Settings);
+       }},
       {Type::int16,
-       [&]() { return makeIt<std::int16_t>(Parent, ArrayShape, ChunkSize); }},
+       [&]() {
+         return makeIt<std::int16_t>(Parent, Name, Shape, ValueChunkSize,
+                                     Settings);
+       }},
       {Type::uint16,
-       [&]() { return makeIt<std::uint16_t>(Parent, ArrayShape, ChunkSize); }},
+       [&]() {
+         return makeIt<std::uint16_t>(Parent, Name, Shape, ValueChunkSize,
+                                      Settings);
+       }},
       {Type::int32,
-       [&]() { return makeIt<std::int32_t>(Parent, ArrayShape, ChunkSize); }},
+       [&]() {
+         return makeIt<std::int32_t>(Parent, Name, Shape, ValueChunkSize,
+                                     Settings);
+       }},
       {Type::uint32,
-       [&]() { return makeIt<std::uint32_t>(Parent, ArrayShape, ChunkSize); }},
+       [&]() {
+         return makeIt<std::uint32_t>(Parent, Name, Shape, ValueChunkSize,
+                                      Settings);
+       }},
       {Type::int64,
-       [&]() { return makeIt<std::int64_t>(Parent, ArrayShape, ChunkSize); }},
+       [&]() {
+         return makeIt<std::int64_t>(Parent, Name, Shape, ValueChunkSize,
+                                     Settings);
+       }},
       {Type::uint64,
-       [&]() { return makeIt<std::uint64_t>(Parent, ArrayShape, ChunkSize); }},
+       [&]() {
+         return makeIt<std::uint64_t>(Parent, Name, Shape, ValueChunkSize,
+                                      Settings);
+       }},
       {Type::float32,
-       [&]() { return makeIt<std::float_t>(Parent, ArrayShape, ChunkSize); }},
+       [&]() {
+         return makeIt<std::float_t>(Parent, Name, Shape, ValueChunkSize,
+                                     Settings);
+       }},
       {Type::float64,
-       [&]() { return makeIt<std::double_t>(Parent, ArrayShape, ChunkSize); }},
+       [&]() {
+         return makeIt<std::double_t>(Parent, Name, Shape, ValueChunkSize,
+                                      Settings);
+       }},
   };
   CreateValuesMap.at(ElementType)();
 }
+
+/// \brief Create a dataset for projections, of the type that the pixels of
+/// the configured type are summed in.
+void ad00_Writer::initProjectionDataset(hdf5::node::Group const &Parent,
+                                        std::string const &Name,
+                                        size_t Size) const {
+  auto Settings = compression(Name);
+  hdf5::Dimensions Shape{Size};
+  auto ProjectionChunkSize = valueChunkSize(Shape);
+  switch (ElementType) {
+  case Type::float32:
+  case Type::float64:
+    makeIt<double>(Parent, Name, Shape, ProjectionChunkSize, Settings);
+    break;
+  case Type::uint8:
+  case Type::uint16:
+  case Type::uint32:
+  case Type::uint64:
+    makeIt<std::uint64_t>(Parent, Name, Shape, ProjectionChunkSize, Settings);
+    break;
+  default:
+    makeIt<std::int64_t>(Parent, Name, Shape, ProjectionChunkSize, Settings);
+  }
+}
 } // namespace WriterModule::ad00
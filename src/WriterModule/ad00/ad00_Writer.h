@@ -19,8 +19,15 @@
 #include "Msg.h"
 #include "NeXusDataset/NeXusDataset.h"
 #include "WriterModuleBase.h"
+#include "ad00_FrameProcessing.h"
 
 namespace WriterModule::ad00 {
+/// \brief The binned pixels of a region of a frame.
+template <typename T> struct BinnedRegion {
+  std::vector<T> Pixels;
+  hdf5::Dimensions Shape;
+};
+
 /// See parent class for documentation.
 class ad00_Writer : public WriterModule::Base {
 public:
@@ -36,6 +43,15 @@ public:
   bool writeImpl(FileWriter::FlatbufferMessage const &Message,
                  bool is_buffered_message) override;
 
+  /// \brief Check the frame and do the regions, binning and projections, the
+  /// write stage appends the results and the time stamp.
+  WriteStage prepareImpl(FileWriter::FlatbufferMessage const &Message,
+                         bool is_buffered_message) override;
+
+  bool hasPreparationStage() const override { return true; }
+
+  void flushBuffers() override;
+
   enum class Type {
     int8,
     uint8,
@@ -51,7 +67,40 @@ public:
   };
 
 protected:
-  void initValueDataset(hdf5::node::Group const &Parent) const;
+  WritePriority defaultWritePriority() const override {
+    return WritePriority::LOW;
+  }
+
+  void initValueDataset(hdf5::node::Group const &Parent,
+                        std::string const &Name,
+                        hdf5::Dimensions const &Shape) const;
+  void initProjectionDataset(hdf5::node::Group const &Parent,
+                             std::string const &Name, size_t Size) const;
+  hdf5::Dimensions valueChunkSize(hdf5::Dimensions const &Shape) const;
+
+  /// \brief Check if regions, binning or projections are configured, i.e.
+  /// if the frames are processed before they are written.
+  [[nodiscard]] bool processesFrames() const {
+    return !Regions.empty() || BinRows > 1 || BinColumns > 1 ||
+           SumProjections;
+  }
+
+  /// \brief Check a frame and process its regions, binned pixels and
+  /// projections.
+  ///
+  /// \param DataSize The size of the data of the frame in bytes.
+  /// \return The function that writes the frame, or the results.
+  /// \throws WriterModule::WriterException If the frame can not be written.
+  template <typename T>
+  std::function<void()> prepareFrame(std::uint8_t const *Data, size_t DataSize,
+                                     size_t NrOfElements,
+                                     hdf5::Dimensions const &Shape);
+
+  /// \brief Bin the pixels of a region of a frame.
+  template <typename T>
+  BinnedRegion<T> binnedRegion(T const *Frame, size_t FrameColumns,
+                               FrameRegion const &Region);
+
   Type ElementType{Type::float64};
   std::unique_ptr<NeXusDataset::MultiDimDatasetBase> Values;
   NeXusDataset::Time Timestamp;
@@ -59,6 +108,27 @@ protected:
   JsonConfig::Field<std::string> DataType{this, {"type", "dtype"}, "float64"};
   JsonConfig::Field<hdf5::Dimensions> ArrayShape{this, "array_size", {1, 1}};
   JsonConfig::Field<hdf5::Dimensions> ChunkSize{this, "chunk_size", {1 << 20}};
+  /// Number of frames in a chunk of the value dataset, 0 to derive it from
+  /// the chunk size.
+  JsonConfig::Field<size_t> FramesPerChunk{this, "frames_per_chunk", 0};
+  /// Number of frames collected in memory and written with one write.
+  JsonConfig::Field<size_t> FramesPerWrite{this, "frames_per_write", 1};
+  /// Regions of the frames written to their own datasets instead of the
+  /// whole frames.
+  JsonConfig::Field<std::vector<nlohmann::json>> RegionsField{
+      this, "rois", std::vector<nlohmann::json>{}};
+  /// The number of (rows, columns) of pixels summed into one pixel.
+  JsonConfig::Field<hdf5::Dimensions> Binning{this, "binning", {1, 1}};
+  JsonConfig::Field<bool> SumProjectionsField{this, "sum_projection", false};
+  std::vector<FrameRegion> Regions;
+  size_t BinRows{1};
+  size_t BinColumns{1};
+  bool SumProjections{false};
+  std::vector<std::unique_ptr<NeXusDataset::MultiDimDatasetBase>> RegionValues;
+  std::unique_ptr<NeXusDataset::MultiDimDatasetBase> ProjectionX;
+  std::unique_ptr<NeXusDataset::MultiDimDatasetBase> ProjectionY;
+  /// Reused for the sums of the binning, only used by prepareImpl().
+  std::vector<char> PixelSums;
   int CueCounter{0};
   NeXusDataset::CueIndex CueTimestampIndex;
   NeXusDataset::CueTimestampZero CueTimestamp;
@@ -23,8 +23,14 @@ namespace WriterModule::al00 {
 /// `init_hdf`.
 InitResult al00_Writer::init_hdf(hdf5::node::Group &HDFGroup) {
   auto Create = NeXusDataset::Mode::Create;
+  auto Encoding = NeXusDataset::stringEncodingFromString(MessageEncoding);
+  if (!Encoding) {
+    Logger::Error(R"(Unknown message encoding "{}", using "fixed".)",
+                  MessageEncoding.get_value());
+    Encoding = NeXusDataset::StringEncoding::FIXED;
+  }
   try {
-    NeXusDataset::AlarmMsg(HDFGroup, Create);
+    NeXusDataset::AlarmMsg(HDFGroup, Create, *Encoding);
     NeXusDataset::AlarmTime(HDFGroup, Create);
     NeXusDataset::AlarmSeverity(HDFGroup, Create);
   } catch (std::exception const &E) {
@@ -69,6 +75,12 @@ bool al00_Writer::writeImpl(FlatbufferMessage const &Message,
   return true;
 }
 
+void al00_Writer::flushBuffers() {
+  AlarmTime.flushBuffer();
+  AlarmSeverity.flushBuffer();
+  AlarmMsg.flushBuffer();
+}
+
 /// Register the writer module.
 static WriterModule::Registry::Registrar<al00_Writer>
     RegisterWriter("al00", "alarm_info");
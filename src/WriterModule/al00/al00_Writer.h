@@ -36,10 +36,19 @@ public:
   bool writeImpl(FlatbufferMessage const &Message,
                  bool is_buffered_message) override;
 
+  void flushBuffers() override;
+
   al00_Writer() : WriterModule::Base("al00", false, "NXlog") {}
   ~al00_Writer() override = default;
 
 protected:
+  WritePriority defaultWritePriority() const override {
+    return WritePriority::HIGH;
+  }
+
+  /// How the alarm messages are stored, see NeXusDataset::StringEncoding.
+  JsonConfig::Field<std::string> MessageEncoding{this, "message_encoding",
+                                                 "fixed"};
   NeXusDataset::AlarmTime AlarmTime;
   NeXusDataset::AlarmSeverity AlarmSeverity;
   NeXusDataset::AlarmMsg AlarmMsg;
@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#include "da00_WritePlan.h"
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace WriterModule::da00 {
+
+VariableWritePlan::VariableWritePlan(VariableConfig const &Config,
+                                     hdf5::node::Dataset &Target)
+    : Name(Config.name()), Dataset(&Target), DataType(Config.dtype()),
+      RowShape(Config.shape()) {
+  NrOfElements = std::accumulate(RowShape.cbegin(), RowShape.cend(),
+                                 size_t{1}, std::multiplies<>());
+  switch (DataType) {
+  case da00_dtype::int8:
+    setType<std::int8_t>();
+    break;
+  case da00_dtype::uint8:
+    setType<std::uint8_t>();
+    break;
+  case da00_dtype::int16:
+    setType<std::int16_t>();
+    break;
+  case da00_dtype::uint16:
+    setType<std::uint16_t>();
+    break;
+  case da00_dtype::int32:
+    setType<std::int32_t>();
+    break;
+  case da00_dtype::uint32:
+    setType<std::uint32_t>();
+    break;
+  case da00_dtype::int64:
+    setType<std::int64_t>();
+    break;
+  case da00_dtype::uint64:
+    setType<std::uint64_t>();
+    break;
+  case da00_dtype::float32:
+    setType<std::float_t>();
+    break;
+  case da00_dtype::float64:
+    setType<std::double_t>();
+    break;
+  case da00_dtype::c_string:
+    setType<char>();
+    break;
+  default:
+    throw std::runtime_error(
+        fmt::format("Variable {} has an unsupported data type {}.", Name,
+                    DataType));
+  }
+  hdf5::Dimensions Block(RowShape);
+  Block.insert(Block.begin(), 1);
+  Selection = hdf5::dataspace::Hyperslab(hdf5::Dimensions(Block.size(), 0),
+                                         Block);
+  refresh();
+}
+
+template <class DataType> void VariableWritePlan::setType() {
+  ElementSize = sizeof(DataType);
+  AppendRow = &VariableWritePlan::appendRow<DataType>;
+  auto FillValue = std::numeric_limits<DataType>::has_quiet_NaN
+                       ? std::numeric_limits<DataType>::quiet_NaN()
+                       : (std::numeric_limits<DataType>::max)();
+  std::vector<DataType> Row(NrOfElements, FillValue);
+  auto const *RowBytes = reinterpret_cast<std::uint8_t const *>(Row.data());
+  MissingRow.assign(RowBytes, RowBytes + NrOfElements * ElementSize);
+}
+
+void VariableWritePlan::refresh() {
+  if (Dataset == nullptr) {
+    return;
+  }
+  Extent = hdf5::dataspace::Simple(Dataset->dataspace()).current_dimensions();
+  if (Extent.size() != RowShape.size() + 1) {
+    throw std::runtime_error(fmt::format(
+        "Dataset of variable {} has {} dimension(s), expected {} (+1).", Name,
+        Extent.size() - 1, RowShape.size()));
+  }
+}
+
+template <class DataType>
+void VariableWritePlan::appendRow(VariableWritePlan &Plan,
+                                  std::uint8_t const *Data) {
+  Plan.Selection.offset(0, Plan.Extent[0]);
+  ++Plan.Extent[0];
+  Plan.Dataset->extent(Plan.Extent);
+  Plan.Dataset->write(
+      hdf5::ArrayAdapter<const DataType>(
+          reinterpret_cast<const DataType *>(Data), Plan.NrOfElements),
+      Plan.Selection);
+}
+
+bool VariableWritePlan::append(da00_Variable const *Variable) {
+  if (!isPlanned() || Variable->data_type() != DataType ||
+      Variable->data() == nullptr ||
+      Variable->data()->size() != NrOfElements * ElementSize ||
+      Variable->shape() == nullptr ||
+      Variable->shape()->size() != RowShape.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < RowShape.size(); ++i) {
+    if (static_cast<hsize_t>(Variable->shape()->Get(i)) != RowShape[i] ||
+        RowShape[i] > Extent[i + 1]) {
+      return false;
+    }
+  }
+  AppendRow(*this, Variable->data()->Data());
+  return true;
+}
+
+void VariableWritePlan::appendMissing() { AppendRow(*this, MissingRow.data()); }
+
+} // namespace WriterModule::da00
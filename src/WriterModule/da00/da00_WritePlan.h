@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+/// \file
+/// \brief Per variable plan for appending da00 data to its dataset.
+
+#pragma once
+
+#include "da00_Variable.h"
+#include <cstdint>
+#include <da00_dataarray_generated.h>
+#include <h5cpp/hdf5.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace WriterModule::da00 {
+
+/// \brief How to append the data of a da00 variable to its dataset.
+///
+/// The data type, element size, row shape and dataset extent are resolved
+/// once, when the datasets are (re)opened, rather than for every message. The
+/// row of fill values written for a missing variable is also only made once.
+/// Data that does not match the plan (e.g. of another type or shape) is not
+/// appended by the plan.
+class VariableWritePlan {
+public:
+  /// \brief A plan that appends nothing, for a variable of which the type or
+  /// shape is not known (well enough) to plan its writes.
+  explicit VariableWritePlan(std::string VariableName)
+      : Name(std::move(VariableName)), Dataset(nullptr) {}
+
+  /// \param Config The configuration of the variable, must have a data type
+  /// and shape.
+  /// \param Target The (open) dataset of the variable, must outlive the plan.
+  VariableWritePlan(VariableConfig const &Config,
+                    hdf5::node::Dataset &Target);
+
+  [[nodiscard]] std::string const &name() const { return Name; }
+
+  /// \brief False if the plan appends nothing, the data of the variable must
+  /// be appended by other means.
+  [[nodiscard]] bool isPlanned() const { return AppendRow != nullptr; }
+
+  /// \brief Append the data of a variable as the next row of the dataset.
+  ///
+  /// \return False if the data does not match the type or shape of the plan,
+  /// nothing is appended in that case.
+  bool append(da00_Variable const *Variable);
+
+  /// \brief Append a row of fill values (NaN or the max value of the type),
+  /// must only be used if isPlanned().
+  void appendMissing();
+
+  /// \brief Read the extent of the dataset again, e.g. after it was appended
+  /// to or resized by other means than the plan.
+  void refresh();
+
+private:
+  using AppendFunction = void (*)(VariableWritePlan &, std::uint8_t const *);
+  template <class DataType>
+  static void appendRow(VariableWritePlan &Plan, std::uint8_t const *Data);
+  template <class DataType> void setType();
+
+  std::string Name;
+  hdf5::node::Dataset *Dataset;
+  da00_dtype DataType{da00_dtype::none};
+  size_t ElementSize{0};
+  hdf5::Dimensions RowShape;
+  size_t NrOfElements{0};
+  hdf5::Dimensions Extent;
+  hdf5::dataspace::Hyperslab Selection;
+  std::vector<std::uint8_t> MissingRow;
+  AppendFunction AppendRow{nullptr};
+};
+
+} // namespace WriterModule::da00
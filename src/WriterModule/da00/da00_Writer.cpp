@@ -317,6 +317,7 @@ InitResult da00_Writer::reopen(hdf5::node::Group &HDFGroup) {
               name);
       }
     }
+    compile_write_plan();
     CueIndex = NeXusDataset::CueIndex(HDFGroup, NeXusDataset::Mode::Open);
     CueTimestampZero =
         NeXusDataset::CueTimestampZero(HDFGroup, NeXusDataset::Mode::Open);
@@ -330,46 +331,104 @@ InitResult da00_Writer::reopen(hdf5::node::Group &HDFGroup) {
   return InitResult::OK;
 }
 
+void da00_Writer::compile_write_plan(da00_DataArray const *da00) {
+  std::vector<std::string> order;
+  order.reserve(VariablePtrs.size());
+  auto add_to_order = [&](std::string const &name) {
+    if (VariablePtrs.find(name) != VariablePtrs.end() &&
+        std::find(order.begin(), order.end(), name) == order.end()) {
+      order.push_back(name);
+    }
+  };
+  if (da00 != nullptr) {
+    for (const auto ptr : *da00->data()) {
+      add_to_order(ptr->name()->str());
+    }
+  }
+  for (const auto &[name, dataset] : VariablePtrs) {
+    add_to_order(name);
+  }
+  WritePlan.clear();
+  WritePlanIndex.clear();
+  WritePlan.reserve(order.size());
+  for (const auto &name : order) {
+    try {
+      WritePlan.emplace_back(VariableConfigMap[name], *VariablePtrs[name]);
+      WritePlanIndex.emplace(name, WritePlan.size() - 1);
+    } catch (std::exception &E) {
+      Logger::Warn("Unable to plan writes of Variable {}, its data is written "
+                   "without a plan: {}",
+                   name, E.what());
+      WritePlan.emplace_back(name);
+      WritePlanIndex.emplace(name, WritePlan.size() - 1);
+    }
+  }
+  VariableWritten.assign(WritePlan.size(), false);
+}
+
+size_t da00_Writer::find_write_plan(std::string_view name,
+                                    size_t next) const {
+  if (next < WritePlan.size() && WritePlan[next].name() == name) {
+    return next;
+  }
+  if (auto f = WritePlanIndex.find(name); f != WritePlanIndex.end()) {
+    return f->second;
+  }
+  return WritePlan.size();
+}
+
 bool da00_Writer::writeImpl(const FileWriter::FlatbufferMessage &Message,
                             [[maybe_unused]] bool is_buffered_message) {
   const auto da00_obj = Getda00_DataArray(Message.data());
   if (isFirstMessage) {
     handle_first_message(da00_obj);
+    // the first message may have changed the datasets
+    compile_write_plan(da00_obj);
     isFirstMessage = false;
   }
   // go through the buffered data and write non-constants:
-  std::vector<std::string> variable_order;
-  variable_order.reserve(VariablePtrs.size());
+  std::fill(VariableWritten.begin(), VariableWritten.end(), false);
+  size_t written_count{0};
+  size_t next{0};
   for (const auto ptr : *da00_obj->data()) {
-    auto name = ptr->name()->str();
-    if (auto f = VariablePtrs.find(name); f != VariablePtrs.end()) {
-      if (!f->second->is_valid()) {
-        Logger::Error(
-            "Variable {} dataset pointer is not valid. Buffered data is "
-            "ignored",
-            name);
-      }
-      VariableConfigMap[name].variable_append(f->second, ptr);
-      variable_order.push_back(name);
-    } else {
+    auto name = std::string_view(ptr->name()->c_str(), ptr->name()->size());
+    auto index = find_write_plan(name, next);
+    if (index == WritePlan.size()) {
       Logger::Debug(
           "Buffer Variable {} is not a configured dataset. Buffered data "
           "is ignored",
           name);
+      continue;
+    }
+    auto &plan = WritePlan[index];
+    if (!plan.append(ptr)) {
+      // not the planned type or shape, append it the generic way
+      VariableConfigMap[plan.name()].variable_append(VariablePtrs[plan.name()],
+                                                     ptr);
+      plan.refresh();
     }
+    if (!VariableWritten[index]) {
+      VariableWritten[index] = true;
+      ++written_count;
+    }
+    next = index + 1;
   }
-  if (variable_order.size() != VariablePtrs.size()) {
+  if (written_count != WritePlan.size()) {
     std::stringstream message;
-    if (VariablePtrs.size() - variable_order.size() > 1) {
+    if (WritePlan.size() - written_count > 1) {
       message << "Buffered data is missing variables ";
     } else {
       message << "Buffered data is missing variable ";
     }
-    for (auto &[name, ptr] : VariablePtrs) {
-      if (std::find(variable_order.begin(), variable_order.end(), name) ==
-          variable_order.end()) {
-        VariableConfigMap[name].variable_append_missing(ptr);
-        message << name << ", ";
+    for (size_t i = 0; i < WritePlan.size(); ++i) {
+      if (!VariableWritten[i]) {
+        if (WritePlan[i].isPlanned()) {
+          WritePlan[i].appendMissing();
+        } else {
+          VariableConfigMap[WritePlan[i].name()].variable_append_missing(
+              VariablePtrs[WritePlan[i].name()]);
+        }
+        message << WritePlan[i].name() << ", ";
       }
     }
     auto str = message.str();
@@ -386,4 +445,10 @@ bool da00_Writer::writeImpl(const FileWriter::FlatbufferMessage &Message,
   return true;
 }
 
+void da00_Writer::flushBuffers() {
+  Timestamp.flushBuffer();
+  CueIndex.flushBuffer();
+  CueTimestampZero.flushBuffer();
+}
+
 } // namespace WriterModule::da00
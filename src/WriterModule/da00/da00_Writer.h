@@ -22,6 +22,8 @@
 
 #include "da00_Type.h"
 #include "da00_Variable.h"
+#include "da00_WritePlan.h"
+#include <string_view>
 
 namespace WriterModule::da00 {
 /// See parent class for documentation.
@@ -39,6 +41,8 @@ public:
   bool writeImpl(FileWriter::FlatbufferMessage const &Message,
                  bool is_buffered_message) override;
 
+  void flushBuffers() override;
+
   NeXusDataset::Time Timestamp;
   NeXusDataset::CueIndex CueIndex;
   NeXusDataset::CueTimestampZero CueTimestampZero;
@@ -61,11 +65,24 @@ protected:
 private:
   void handle_first_message(da00_DataArray const *da00);
   void handle_group_attributes(hdf5::node::Group &HDFGroup) const;
+  /// \brief Make the write plans of the (opened) variable datasets.
+  ///
+  /// \param da00 If given, the plans are ordered as the variables of this
+  /// message, such that the plan of the next variable is usually found
+  /// without a lookup.
+  void compile_write_plan(da00_DataArray const *da00 = nullptr);
+  /// \brief The index of the write plan of a variable, WritePlan.size() if
+  /// it has none.
+  size_t find_write_plan(std::string_view name, size_t next) const;
   // specifications for variable and constant datasets
   std::map<std::string, VariableConfig> VariableConfigMap;
   std::map<std::string, VariableConfig> ConstantConfigMap;
   // unique pointers to the dataset objects
   std::map<std::string, VariableConfig::VariableDataset> VariablePtrs;
   std::map<std::string, VariableConfig::ConstantDataset> ConstantPtrs;
+  // how to write the variables, see VariableWritePlan
+  std::vector<VariableWritePlan> WritePlan;
+  std::map<std::string, size_t, std::less<>> WritePlanIndex;
+  std::vector<bool> VariableWritten;
 };
 } // namespace WriterModule::da00
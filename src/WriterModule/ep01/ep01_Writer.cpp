@@ -45,6 +45,11 @@ bool ep01_Writer::writeImpl(FileWriter::FlatbufferMessage const &Message,
   return true;
 }
 
+void ep01_Writer::flushBuffers() {
+  TimestampDataset.flushBuffer();
+  StatusDataset.flushBuffer();
+}
+
 static WriterModule::Registry::Registrar<ep01_Writer>
     RegisterWriter("ep01", "epics_con_info");
 
@@ -12,9 +12,16 @@ public:
   bool writeImpl(FileWriter::FlatbufferMessage const &Message,
                  bool is_buffered_message) override;
 
+  void flushBuffers() override;
+
   ep01_Writer() : WriterModule::Base("ep01", false, "NXlog") {}
   ~ep01_Writer() override = default;
 
+protected:
+  WritePriority defaultWritePriority() const override {
+    return WritePriority::HIGH;
+  }
+
 private:
   NeXusDataset::ConnectionStatusTime TimestampDataset;
   NeXusDataset::ConnectionStatus StatusDataset;
@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#include "ev44_EventFilter.h"
+#include <algorithm>
+#include <limits>
+
+namespace WriterModule::ev44 {
+
+EventFilter::EventFilter(
+    std::vector<std::int32_t> Table, std::int32_t Offset,
+    std::vector<std::int32_t> const &MaskedPixels,
+    std::optional<std::pair<std::int32_t, std::int32_t>> TofWindow)
+    : LookupTable(std::move(Table)), LookupOffset(Offset),
+      TofMin(std::numeric_limits<std::int32_t>::min()),
+      TofMax(std::numeric_limits<std::int32_t>::max()) {
+  if (!MaskedPixels.empty()) {
+    auto [Min, Max] =
+        std::minmax_element(MaskedPixels.begin(), MaskedPixels.end());
+    MaskOffset = *Min;
+    Mask.resize(std::int64_t(*Max) - *Min + 1, 0);
+    for (auto Pixel : MaskedPixels) {
+      Mask[Pixel - MaskOffset] = 1;
+    }
+  }
+  if (TofWindow) {
+    TofMin = TofWindow->first;
+    TofMax = TofWindow->second;
+  }
+}
+
+void EventFilter::apply(std::int32_t const *TimeOfFlight,
+                        std::int32_t const *PixelId, size_t NrOfEvents,
+                        std::int32_t const *ReferenceTimeIndex,
+                        size_t NrOfPulses, FilteredEvents &Result) const {
+  // Check and map all events.
+  std::vector<std::int32_t> Mapped(NrOfEvents, 0);
+  std::vector<std::uint8_t> Keep(NrOfEvents);
+  auto const *Table = LookupTable.data();
+  auto const TableSize = static_cast<std::int64_t>(LookupTable.size());
+  auto const *MaskData = Mask.data();
+  auto const MaskSize = static_cast<std::int64_t>(Mask.size());
+  std::uint64_t DroppedTof{0};
+  std::uint64_t DroppedUnmapped{0};
+  std::uint64_t DroppedMasked{0};
+  for (size_t i = 0; i < NrOfEvents; ++i) {
+    bool InWindow = (TimeOfFlight[i] >= TofMin) & (TimeOfFlight[i] < TofMax);
+    Keep[i] = InWindow;
+    DroppedTof += !InWindow;
+  }
+  if (PixelId != nullptr) {
+    for (size_t i = 0; i < NrOfEvents; ++i) {
+      auto Pixel = PixelId[i];
+      auto TableIndex = std::int64_t(Pixel) - LookupOffset;
+      bool InTable = (TableIndex >= 0) & (TableIndex < TableSize);
+      if (TableSize > 0) {
+        Pixel = InTable ? Table[TableIndex] : -1;
+      }
+      bool IsMapped = (TableSize == 0) | (InTable & (Pixel >= 0));
+      auto MaskIndex = std::int64_t(Pixel) - MaskOffset;
+      bool IsMasked = (MaskIndex >= 0) & (MaskIndex < MaskSize) &&
+                      MaskData[MaskIndex] != 0;
+      bool InWindow = Keep[i];
+      DroppedUnmapped += InWindow & !IsMapped;
+      DroppedMasked += InWindow & IsMapped & IsMasked;
+      Mapped[i] = Pixel;
+      Keep[i] = InWindow & IsMapped & !IsMasked;
+    }
+  }
+
+  // Compact the kept events, without branches.
+  Result.TimeOfFlight.resize(NrOfEvents);
+  Result.PixelId.resize(PixelId != nullptr ? NrOfEvents : 0);
+  size_t NrOfKept{0};
+  for (size_t i = 0; i < NrOfEvents; ++i) {
+    Result.TimeOfFlight[NrOfKept] = TimeOfFlight[i];
+    NrOfKept += Keep[i];
+  }
+  if (PixelId != nullptr) {
+    size_t NrOfKeptPixels{0};
+    for (size_t i = 0; i < NrOfEvents; ++i) {
+      Result.PixelId[NrOfKeptPixels] = Mapped[i];
+      NrOfKeptPixels += Keep[i];
+    }
+    Result.PixelId.resize(NrOfKeptPixels);
+  }
+  Result.TimeOfFlight.resize(NrOfKept);
+
+  // The pulses now start at the number of kept events before their first
+  // event.
+  Result.ReferenceTimeIndex.resize(NrOfPulses);
+  size_t KeptBefore{0};
+  size_t Event{0};
+  for (size_t j = 0; j < NrOfPulses; ++j) {
+    auto FirstEvent = std::clamp<std::int64_t>(ReferenceTimeIndex[j], 0,
+                                               std::int64_t(NrOfEvents));
+    for (; Event < size_t(FirstEvent); ++Event) {
+      KeptBefore += Keep[Event];
+    }
+    Result.ReferenceTimeIndex[j] = static_cast<std::int32_t>(KeptBefore);
+  }
+  Result.DroppedTof = DroppedTof;
+  Result.DroppedUnmapped = DroppedUnmapped;
+  Result.DroppedMasked = DroppedMasked;
+}
+
+} // namespace WriterModule::ev44
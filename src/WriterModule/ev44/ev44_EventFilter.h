@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+/// \file
+/// \brief Pixel id remapping and filtering of ev44 events.
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace WriterModule::ev44 {
+
+/// \brief The events of an ev44 message that are kept by an EventFilter.
+struct FilteredEvents {
+  std::vector<std::int32_t> TimeOfFlight;
+  /// Empty if the message has no pixel ids.
+  std::vector<std::int32_t> PixelId;
+  /// The reference_time_index of the message, pointing into the kept events.
+  std::vector<std::int32_t> ReferenceTimeIndex;
+  /// Events outside of the time of flight window.
+  std::uint64_t DroppedTof{0};
+  /// Events with pixel ids that are not in the lookup table (or are mapped
+  /// to a negative id).
+  std::uint64_t DroppedUnmapped{0};
+  /// Events with masked pixel ids.
+  std::uint64_t DroppedMasked{0};
+};
+
+/// \brief Maps the raw pixel ids of events to (logical) pixel ids and drops
+/// events outside of a time of flight window, with unmapped pixel ids and
+/// with masked pixel ids.
+class EventFilter {
+public:
+  /// \param LookupTable The pixel id of every raw id, starting with raw id
+  /// \p LookupOffset. Negative ids drop the events. Not used if empty.
+  /// \param LookupOffset The raw id of the first lookup table entry.
+  /// \param MaskedPixels The (mapped) pixel ids of which the events are
+  /// dropped.
+  /// \param TofWindow The first and (one after) the last time of flight of
+  /// the kept events, if any.
+  EventFilter(std::vector<std::int32_t> LookupTable, std::int32_t LookupOffset,
+              std::vector<std::int32_t> const &MaskedPixels,
+              std::optional<std::pair<std::int32_t, std::int32_t>> TofWindow);
+
+  /// \brief Filter the events of a message.
+  ///
+  /// The events are first checked and mapped in a loop without branches
+  /// (which the compiler can vectorise) and then compacted.
+  ///
+  /// \param TimeOfFlight The time of flight of the events.
+  /// \param PixelId The raw pixel ids, nullptr if the message has no pixel
+  /// ids (only the time of flight window is then applied).
+  /// \param NrOfEvents The number of events.
+  /// \param ReferenceTimeIndex The reference_time_index of the message.
+  /// \param NrOfPulses The number of reference time indices.
+  /// \param Result Set to the kept events.
+  void apply(std::int32_t const *TimeOfFlight, std::int32_t const *PixelId,
+             size_t NrOfEvents, std::int32_t const *ReferenceTimeIndex,
+             size_t NrOfPulses, FilteredEvents &Result) const;
+
+private:
+  std::vector<std::int32_t> LookupTable;
+  std::int32_t LookupOffset;
+  /// One entry per pixel id from MaskOffset, non-zero if masked.
+  std::vector<std::uint8_t> Mask;
+  std::int32_t MaskOffset{0};
+  std::int32_t TofMin;
+  std::int32_t TofMax;
+};
+
+} // namespace WriterModule::ev44
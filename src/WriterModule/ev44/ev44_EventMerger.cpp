@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#include "ev44_EventMerger.h"
+#include <algorithm>
+
+namespace WriterModule::ev44 {
+
+EventMerger::EventMerger(size_t NrOfSources, size_t MaxPulses)
+    : WindowSize(std::max<size_t>(MaxPulses, 1)), Windows(NrOfSources) {}
+
+void EventMerger::add(size_t Source,
+                      std::shared_ptr<MessageEvents const> Events,
+                      std::int64_t const *ReferenceTime,
+                      std::int32_t const *ReferenceTimeIndex,
+                      size_t NrOfPulses) {
+  auto &Window = Windows.at(Source);
+  auto NrOfEvents = static_cast<std::int64_t>(Events->TimeOfFlight.size());
+  for (size_t j = 0; j < NrOfPulses; ++j) {
+    // Events before the first index are part of the first pulse.
+    auto First = j == 0 ? 0
+                        : std::clamp<std::int64_t>(ReferenceTimeIndex[j], 0,
+                                                   NrOfEvents);
+    auto End = j + 1 == NrOfPulses
+                   ? NrOfEvents
+                   : std::clamp<std::int64_t>(ReferenceTimeIndex[j + 1],
+                                              First, NrOfEvents);
+    Pulse NewPulse{ReferenceTime[j], Events, size_t(First),
+                   size_t(End - First)};
+    // Pulses mostly arrive in order, search from the back.
+    auto Position = std::upper_bound(
+        Window.rbegin(), Window.rend(), NewPulse.ReferenceTime,
+        [](std::int64_t Time, Pulse const &Other) {
+          return Time >= Other.ReferenceTime;
+        });
+    Window.insert(Position.base(), std::move(NewPulse));
+  }
+}
+
+void EventMerger::merge(MergedEvents &Result, bool Drain) {
+  // The number of sources is small, a linear search for the earliest pulse
+  // is faster than keeping a heap up to date.
+  while (true) {
+    std::deque<Pulse> *Earliest{nullptr};
+    bool AllWaiting{true};
+    bool WindowFull{false};
+    for (auto &Window : Windows) {
+      if (Window.empty()) {
+        AllWaiting = false;
+        continue;
+      }
+      WindowFull = WindowFull || Window.size() > WindowSize;
+      if (Earliest == nullptr ||
+          Window.front().ReferenceTime < Earliest->front().ReferenceTime) {
+        Earliest = &Window;
+      }
+    }
+    if (Earliest == nullptr || !(Drain || AllWaiting || WindowFull)) {
+      return;
+    }
+    append(Earliest->front(), Result);
+    Earliest->pop_front();
+  }
+}
+
+void EventMerger::append(Pulse const &Next, MergedEvents &Result) {
+  // Events of a pulse with the same reference time as the previous one are
+  // added to the previous pulse.
+  if (!LastReferenceTime || Next.ReferenceTime != *LastReferenceTime) {
+    if (LastReferenceTime && Next.ReferenceTime < *LastReferenceTime) {
+      ++LatePulses;
+    }
+    Result.ReferenceTime.push_back(Next.ReferenceTime);
+    Result.ReferenceTimeIndex.push_back(
+        static_cast<std::int64_t>(Result.TimeOfFlight.size()));
+    LastReferenceTime = Next.ReferenceTime;
+  }
+  auto const &Events = *Next.Events;
+  auto First = Events.TimeOfFlight.begin() + Next.FirstEvent;
+  Result.TimeOfFlight.insert(Result.TimeOfFlight.end(), First,
+                             First + Next.NrOfEvents);
+  if (!Events.PixelId.empty()) {
+    auto FirstPixel = Events.PixelId.begin() + Next.FirstEvent;
+    Result.PixelId.insert(Result.PixelId.end(), FirstPixel,
+                          FirstPixel + Next.NrOfEvents);
+  }
+}
+
+size_t EventMerger::nrOfWaitingPulses() const {
+  size_t Waiting{0};
+  for (auto const &Window : Windows) {
+    Waiting += Window.size();
+  }
+  return Waiting;
+}
+
+} // namespace WriterModule::ev44
@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+/// \file
+/// \brief Merging of the events of several ev44 sources by reference time.
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace WriterModule::ev44 {
+
+/// \brief The events of one ev44 message.
+struct MessageEvents {
+  std::vector<std::int32_t> TimeOfFlight;
+  /// Empty if the message has no pixel ids.
+  std::vector<std::int32_t> PixelId;
+};
+
+/// \brief Events merged by an EventMerger, in the layout of NXevent_data.
+struct MergedEvents {
+  std::vector<std::int32_t> TimeOfFlight;
+  std::vector<std::int32_t> PixelId;
+  std::vector<std::int64_t> ReferenceTime;
+  /// The first event of every pulse, relative to the first event in
+  /// TimeOfFlight.
+  std::vector<std::int64_t> ReferenceTimeIndex;
+
+  void clear() {
+    TimeOfFlight.clear();
+    PixelId.clear();
+    ReferenceTime.clear();
+    ReferenceTimeIndex.clear();
+  }
+};
+
+/// \brief Merges the pulses of several sources into one stream of pulses
+/// ordered by reference time.
+///
+/// Every source has a reorder window of (at most) WindowSize pulses ordered
+/// by reference time. A pulse is taken from the windows (the one with the
+/// lowest reference time, i.e. a k-way merge) when every source has a pulse
+/// waiting, as no source can then deliver an earlier pulse (assuming that
+/// a source is ordered within its window), or when a window is full. Pulses
+/// of different sources with the same reference time are merged into one
+/// pulse.
+class EventMerger {
+public:
+  /// \param NrOfSources The number of merged sources.
+  /// \param MaxPulses The size of the reorder windows, the max number of
+  /// pulses waiting per source.
+  EventMerger(size_t NrOfSources, size_t MaxPulses);
+
+  /// \brief Add the pulses of a message to the window of a source.
+  ///
+  /// \param Source The index of the source.
+  /// \param Events The events of the message.
+  /// \param ReferenceTime The reference time of every pulse.
+  /// \param ReferenceTimeIndex The first event of every pulse.
+  /// \param NrOfPulses The number of pulses.
+  void add(size_t Source, std::shared_ptr<MessageEvents const> Events,
+           std::int64_t const *ReferenceTime,
+           std::int32_t const *ReferenceTimeIndex, size_t NrOfPulses);
+
+  /// \brief Take the pulses that can be merged from the windows.
+  ///
+  /// \param Result The merged pulses are appended to it.
+  /// \param Drain Take all waiting pulses (e.g. when closing the file).
+  void merge(MergedEvents &Result, bool Drain = false);
+
+  /// \brief The reference time of the last merged pulse.
+  [[nodiscard]] std::optional<std::int64_t> lastReferenceTime() const {
+    return LastReferenceTime;
+  }
+
+  /// \brief The number of merged pulses that were earlier than the pulse
+  /// before them (i.e. arrived after their window was full).
+  [[nodiscard]] std::uint64_t latePulses() const { return LatePulses; }
+
+  /// \brief The number of pulses waiting in the windows.
+  [[nodiscard]] size_t nrOfWaitingPulses() const;
+
+private:
+  struct Pulse {
+    std::int64_t ReferenceTime;
+    std::shared_ptr<MessageEvents const> Events;
+    size_t FirstEvent;
+    size_t NrOfEvents;
+  };
+  void append(Pulse const &Next, MergedEvents &Result);
+  size_t WindowSize;
+  std::vector<std::deque<Pulse>> Windows;
+  std::optional<std::int64_t> LastReferenceTime;
+  std::uint64_t LatePulses{0};
+};
+
+} // namespace WriterModule::ev44
@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#include "ev44_Histogram.h"
+#include "HDFAttributes.h"
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include <map>
+#include <stdexcept>
+
+namespace WriterModule::ev44 {
+
+std::optional<HistogramMode> histogramModeFromString(std::string Name) {
+  std::transform(Name.begin(), Name.end(), Name.begin(),
+                 [](auto C) { return std::tolower(C); });
+  std::map<std::string, HistogramMode> ModeMap{
+      {"none", HistogramMode::EVENTS},
+      {"with_events", HistogramMode::EVENTS_AND_HISTOGRAM},
+      {"only", HistogramMode::HISTOGRAM},
+      {"on_overload", HistogramMode::HISTOGRAM_ON_OVERLOAD}};
+  if (auto Found = ModeMap.find(Name); Found != ModeMap.end()) {
+    return Found->second;
+  }
+  return std::nullopt;
+}
+
+EventHistogram::EventHistogram(std::vector<std::int32_t> Edges,
+                               std::int32_t FirstPixelId,
+                               std::int32_t LastPixelId,
+                               std::uint32_t PixelsInGroup)
+    : TofEdges(std::move(Edges)), FirstPixel(FirstPixelId),
+      LastPixel(LastPixelId), PixelsPerGroup(PixelsInGroup) {
+  if (TofEdges.size() < 2 ||
+      std::adjacent_find(TofEdges.begin(), TofEdges.end(),
+                         std::greater_equal<>()) != TofEdges.end()) {
+    throw std::runtime_error("The time of flight bin edges must be (at least "
+                             "two) increasing values.");
+  }
+  if (LastPixel < FirstPixel || PixelsPerGroup == 0) {
+    throw std::runtime_error("Invalid pixel range or pixel group size.");
+  }
+  auto NrOfPixels = std::int64_t(LastPixel) - FirstPixel + 1;
+  NrOfPixelGroups = (NrOfPixels + PixelsPerGroup - 1) / PixelsPerGroup;
+  if (NrOfPixelGroups * nrOfTofBins() >= OutsideHistogram) {
+    throw std::runtime_error("The histogram has too many bins.");
+  }
+  TofBinWidth = std::int64_t(TofEdges[1]) - TofEdges[0];
+  for (size_t i = 1; i < TofEdges.size(); ++i) {
+    if (std::int64_t(TofEdges[i]) - TofEdges[i - 1] != TofBinWidth) {
+      TofBinWidth = 0;
+      break;
+    }
+  }
+  Counts.resize(NrOfPixelGroups * nrOfTofBins(), 0);
+}
+
+void EventHistogram::binIndices(std::int32_t const *TimeOfFlight,
+                                std::int32_t const *PixelId,
+                                size_t NrOfEvents,
+                                std::vector<std::uint32_t> &Bins) const {
+  Bins.resize(NrOfEvents);
+  auto const TofStart = std::int64_t(TofEdges.front());
+  auto const TofSpan = std::int64_t(TofEdges.back()) - TofStart;
+  auto const PixelSpan = std::int64_t(LastPixel) - FirstPixel + 1;
+  auto const NrOfBins = static_cast<std::int64_t>(nrOfTofBins());
+  auto const GroupSize = std::int64_t(PixelsPerGroup);
+  auto BinEvents = [&](auto TofBin, auto Pixel) {
+    for (size_t i = 0; i < NrOfEvents; ++i) {
+      auto TofOffset = std::int64_t(TimeOfFlight[i]) - TofStart;
+      auto PixelOffset = std::int64_t(Pixel(i)) - FirstPixel;
+      bool Inside = (TofOffset >= 0) & (TofOffset < TofSpan) &
+                    (PixelOffset >= 0) & (PixelOffset < PixelSpan);
+      auto Bin = PixelOffset / GroupSize * NrOfBins + TofBin(i, TofOffset);
+      Bins[i] = Inside ? static_cast<std::uint32_t>(Bin) : OutsideHistogram;
+    }
+  };
+  auto UniformBin = [Width = TofBinWidth](size_t, std::int64_t Offset) {
+    return Offset / Width;
+  };
+  auto SearchBin = [&](size_t i, std::int64_t) {
+    return std::int64_t(std::upper_bound(TofEdges.begin(), TofEdges.end(),
+                                         TimeOfFlight[i]) -
+                        TofEdges.begin()) -
+           1;
+  };
+  auto PixelOf = [PixelId](size_t i) { return PixelId[i]; };
+  auto NoPixel = [](size_t) { return std::int32_t(0); };
+  if (TofBinWidth > 0) {
+    if (PixelId != nullptr) {
+      BinEvents(UniformBin, PixelOf);
+    } else {
+      BinEvents(UniformBin, NoPixel);
+    }
+  } else {
+    if (PixelId != nullptr) {
+      BinEvents(SearchBin, PixelOf);
+    } else {
+      BinEvents(SearchBin, NoPixel);
+    }
+  }
+}
+
+void EventHistogram::count(std::vector<std::uint32_t> const &Bins) {
+  for (auto Bin : Bins) {
+    if (Bin == OutsideHistogram) {
+      ++EventsOutside;
+    } else {
+      ++Counts[Bin];
+    }
+  }
+  Changed = Changed || !Bins.empty();
+}
+
+void EventHistogram::createGroup(hdf5::node::Group const &Parent,
+                                 std::string const &Name) const {
+  auto Group = Parent.create_group(Name);
+  HDFAttributes::writeAttribute(Group, "NX_class", std::string("NXdata"));
+  HDFAttributes::writeAttribute(Group, "signal", std::string("counts"));
+  HDFAttributes::writeAttribute(
+      Group, "axes", std::vector<std::string>{"pixel_id", "time_of_flight"});
+
+  auto Counts = Group.create_dataset(
+      "counts", hdf5::datatype::create<std::uint64_t>(),
+      hdf5::dataspace::Simple({NrOfPixelGroups, nrOfTofBins()}));
+  Counts.write(std::vector<std::uint64_t>(NrOfPixelGroups * nrOfTofBins()));
+  HDFAttributes::writeAttribute(Counts, "events_outside", std::uint64_t(0));
+
+  auto Edges = Group.create_dataset(
+      "time_of_flight", hdf5::datatype::create<std::int32_t>(),
+      hdf5::dataspace::Simple({TofEdges.size()}));
+  Edges.write(TofEdges);
+  HDFAttributes::writeAttribute(Edges, "units", std::string("ns"));
+
+  // The first pixel id of every row.
+  std::vector<std::int32_t> PixelIds(NrOfPixelGroups);
+  for (size_t i = 0; i < PixelIds.size(); ++i) {
+    PixelIds[i] = static_cast<std::int32_t>(FirstPixel + i * PixelsPerGroup);
+  }
+  auto Pixels = Group.create_dataset(
+      "pixel_id", hdf5::datatype::create<std::int32_t>(),
+      hdf5::dataspace::Simple({PixelIds.size()}));
+  Pixels.write(PixelIds);
+  HDFAttributes::writeAttribute(Pixels, "pixels_per_group",
+                                std::uint32_t(PixelsPerGroup));
+}
+
+void EventHistogram::openGroup(hdf5::node::Group const &Parent,
+                               std::string const &Name) {
+  auto Group = hdf5::node::get_group(Parent, Name);
+  CountsDataset = Group.get_dataset("counts");
+  auto Shape = hdf5::dataspace::Simple(CountsDataset.dataspace())
+                   .current_dimensions();
+  if (Shape != hdf5::Dimensions{NrOfPixelGroups, nrOfTofBins()}) {
+    throw std::runtime_error(
+        "The histogram in the file does not match the configuration.");
+  }
+}
+
+void EventHistogram::write() {
+  CountsDataset.write(Counts);
+  CountsDataset.attributes["events_outside"].write(EventsOutside);
+  Changed = false;
+}
+
+} // namespace WriterModule::ev44
@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+/// \file
+/// \brief Histogramming of ev44 events over time of flight and pixels.
+
+#pragma once
+
+#include <cstdint>
+#include <h5cpp/hdf5.hpp>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace WriterModule::ev44 {
+
+/// \brief What the ev44 writer module writes to file.
+///
+/// EVENTS: Only the events.
+/// EVENTS_AND_HISTOGRAM: The events and a histogram of them.
+/// HISTOGRAM: Only a histogram of the events.
+/// HISTOGRAM_ON_OVERLOAD: The events, or a histogram of them while the writer
+/// module is overloaded.
+enum class HistogramMode {
+  EVENTS,
+  EVENTS_AND_HISTOGRAM,
+  HISTOGRAM,
+  HISTOGRAM_ON_OVERLOAD
+};
+
+/// \brief Get the histogram mode from its (case insensitive) name.
+///
+/// \param Name One of "none", "with_events", "only" or "on_overload".
+/// \return The mode or std::nullopt if the name is not known.
+std::optional<HistogramMode> histogramModeFromString(std::string Name);
+
+/// \brief A histogram of events over time of flight and (groups of) pixels.
+///
+/// The counts are kept in memory and written to the NXdata group created by
+/// createGroup(). Binning (binIndices()) only uses the (constant) bin edges
+/// and can be done while preparing a write, counting (count()) and writing
+/// (write()) must be done by the thread that writes to the file.
+class EventHistogram {
+public:
+  /// \brief The bin of events that are outside of the histogram.
+  static constexpr std::uint32_t OutsideHistogram{
+      std::numeric_limits<std::uint32_t>::max()};
+
+  /// \param TofEdges The (increasing) time of flight bin edges, at least two.
+  /// \param FirstPixel The first pixel id of the histogram.
+  /// \param LastPixel The last pixel id (inclusive) of the histogram.
+  /// \param PixelsPerGroup The number of consecutive pixel ids that are
+  /// added up in one row of the histogram.
+  /// \throws std::runtime_error If the bin edges or pixels are not valid.
+  EventHistogram(std::vector<std::int32_t> TofEdges, std::int32_t FirstPixel,
+                 std::int32_t LastPixel, std::uint32_t PixelsPerGroup);
+
+  /// \brief Get the (flat) bin of every event.
+  ///
+  /// The loop is free of branches (for uniform bin edges) so that the
+  /// compiler can vectorise it.
+  ///
+  /// \param TimeOfFlight The time of flight of the events.
+  /// \param PixelId The pixel id of the events, nullptr if the events do
+  /// not have pixel ids (all events are then in pixel 0).
+  /// \param NrOfEvents The number of events.
+  /// \param Bins Set to the bins, OutsideHistogram for events outside of the
+  /// histogram.
+  void binIndices(std::int32_t const *TimeOfFlight,
+                  std::int32_t const *PixelId, size_t NrOfEvents,
+                  std::vector<std::uint32_t> &Bins) const;
+
+  /// \brief Add events, binned by binIndices(), to the histogram.
+  void count(std::vector<std::uint32_t> const &Bins);
+
+  /// \brief Create the NXdata group of the histogram.
+  void createGroup(hdf5::node::Group const &Parent,
+                   std::string const &Name) const;
+
+  /// \brief Open the group created by createGroup() for write().
+  void openGroup(hdf5::node::Group const &Parent, std::string const &Name);
+
+  /// \brief Write the counts to the file.
+  void write();
+
+  /// \brief True if events have been counted since the last write().
+  [[nodiscard]] bool hasChanged() const { return Changed; }
+
+  [[nodiscard]] size_t nrOfTofBins() const { return TofEdges.size() - 1; }
+  [[nodiscard]] size_t nrOfPixelGroups() const { return NrOfPixelGroups; }
+
+  /// \brief The counts, nrOfPixelGroups() rows of nrOfTofBins() bins.
+  [[nodiscard]] std::vector<std::uint64_t> const &counts() const {
+    return Counts;
+  }
+
+  /// \brief The number of events that were not in the histogram.
+  [[nodiscard]] std::uint64_t eventsOutside() const { return EventsOutside; }
+
+private:
+  std::vector<std::int32_t> TofEdges;
+  /// The width of the time of flight bins, 0 if they are not uniform.
+  std::int64_t TofBinWidth{0};
+  std::int32_t FirstPixel;
+  std::int32_t LastPixel;
+  std::uint32_t PixelsPerGroup;
+  size_t NrOfPixelGroups;
+  std::vector<std::uint64_t> Counts;
+  std::uint64_t EventsOutside{0};
+  bool Changed{false};
+  hdf5::node::Dataset CountsDataset;
+};
+
+} // namespace WriterModule::ev44
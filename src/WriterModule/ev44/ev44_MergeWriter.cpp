@@ -0,0 +1,235 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#include <ev44_events_generated.h>
+
+#include "HDFAttributes.h"
+#include "WriterRegistrar.h"
+#include "ev44_MergeWriter.h"
+#include <algorithm>
+
+namespace WriterModule::ev44 {
+
+ev44_MergeWriter::~ev44_MergeWriter() {
+  if (!Merger || Merger->nrOfWaitingPulses() == 0) {
+    return;
+  }
+  try {
+    Merged.clear();
+    Merger->merge(Merged, true);
+    writeMerged(Merged);
+    flushBuffers();
+  } catch (std::exception &E) {
+    Logger::Error("Failed to write the events waiting to be merged: {}",
+                  E.what());
+  }
+}
+
+void ev44_MergeWriter::config_post_processing() {
+  SourceIndex.clear();
+  SourceIndex.emplace(SourceName.get_value(), 0);
+  for (auto const &Name : Sources.get_value()) {
+    SourceIndex.emplace(Name, SourceIndex.size());
+  }
+  Merger = std::make_unique<EventMerger>(SourceIndex.size(), ReorderWindow);
+}
+
+std::vector<std::string> ev44_MergeWriter::additionalSources() const {
+  std::vector<std::string> Names;
+  for (auto const &[Name, Index] : SourceIndex) {
+    if (Index != 0) {
+      Names.push_back(Name);
+    }
+  }
+  return Names;
+}
+
+InitResult ev44_MergeWriter::init_hdf(hdf5::node::Group &HDFGroup) {
+  auto Create = NeXusDataset::Mode::Create;
+  auto Types = LegacyTypes ? NeXusDataset::EventDataTypes::LEGACY
+                           : NeXusDataset::EventDataTypes::WIRE;
+  try {
+    // NOLINTNEXTLINE(bugprone-unused-raii)
+    NeXusDataset::EventTimeOffset(HDFGroup, Create, ChunkSize,
+                                  compression("event_time_offset"), Types);
+    // NOLINTNEXTLINE(bugprone-unused-raii)
+    NeXusDataset::EventId(HDFGroup, Create, ChunkSize,
+                          compression("event_id"), Types);
+    // NOLINTNEXTLINE(bugprone-unused-raii)
+    NeXusDataset::EventTimeZero(HDFGroup, Create, ChunkSize,
+                                compression("event_time_zero"), Types);
+    // NOLINTNEXTLINE(bugprone-unused-raii)
+    NeXusDataset::EventIndex(HDFGroup, Create, ChunkSize,
+                             compression("event_index"), Types);
+    // NOLINTNEXTLINE(bugprone-unused-raii)
+    NeXusDataset::CueIndex(HDFGroup, Create, ChunkSize,
+                           compression("cue_index"));
+    // NOLINTNEXTLINE(bugprone-unused-raii)
+    NeXusDataset::CueTimestampZero(HDFGroup, Create, ChunkSize,
+                                   compression("cue_timestamp_zero"));
+    std::vector<std::string> Names(SourceIndex.size());
+    for (auto const &[Name, Index] : SourceIndex) {
+      Names[Index] = Name;
+    }
+    HDFAttributes::writeAttribute(HDFGroup, "merged_sources", Names);
+    // Written by flushBuffers(), attributes can not be created in SWMR mode.
+    HDFAttributes::writeAttribute(HDFGroup, "late_pulses", std::uint64_t(0));
+    HDFAttributes::writeAttribute(HDFGroup, "rejected_messages",
+                                  std::uint64_t(0));
+  } catch (std::exception const &E) {
+    auto message = hdf5::error::print_nested(E);
+    Logger::Error("ev44_merge could not init_hdf hdf_parent: {}  trace: {}",
+                  static_cast<std::string>(HDFGroup.link().path()), message);
+    return InitResult::ERROR;
+  }
+  return InitResult::OK;
+}
+
+InitResult ev44_MergeWriter::reopen(hdf5::node::Group &HDFGroup) {
+  auto Open = NeXusDataset::Mode::Open;
+  try {
+    EventTimeOffset = NeXusDataset::EventTimeOffset(HDFGroup, Open);
+    EventId = NeXusDataset::EventId(HDFGroup, Open);
+    EventTimeZero = NeXusDataset::EventTimeZero(HDFGroup, Open);
+    EventIndex = NeXusDataset::EventIndex(HDFGroup, Open);
+    CueIndex = NeXusDataset::CueIndex(HDFGroup, Open);
+    CueTimestampZero = NeXusDataset::CueTimestampZero(HDFGroup, Open);
+    auto *CompressionPool = NeXusDataset::ChunkCompressionPool::instance();
+    EventTimeOffset.useDirectChunkWrites(CompressionPool);
+    EventId.useDirectChunkWrites(CompressionPool);
+    EventTimeZero.useDirectChunkWrites(CompressionPool);
+    EventIndex.useDirectChunkWrites(CompressionPool);
+    EventGroup = HDFGroup;
+  } catch (std::exception &E) {
+    Logger::Error(
+        R"(Failed to reopen datasets in HDF file with error message: "{}")",
+        std::string(E.what()));
+    return InitResult::ERROR;
+  }
+  return InitResult::OK;
+}
+
+bool ev44_MergeWriter::writeImpl(FileWriter::FlatbufferMessage const &Message,
+                                 bool is_buffered_message) {
+  return prepareImpl(Message, is_buffered_message)();
+}
+
+WriteStage
+ev44_MergeWriter::prepareImpl(FileWriter::FlatbufferMessage const &Message,
+                              bool is_buffered_message) {
+  if (is_buffered_message) {
+    // Ignore buffered data for event data
+    return []() { return false; };
+  }
+  auto Source = SourceIndex.find(Message.getSourceName());
+  if (Source == SourceIndex.end()) {
+    throw WriterModule::WriterException(
+        fmt::format(R"(Source "{}" is not merged by this writer module.)",
+                    Message.getSourceName()));
+  }
+  auto EventMsgFlatbuffer = GetEvent44Message(Message.data());
+  auto const *TimeOfFlight = EventMsgFlatbuffer->time_of_flight();
+  auto const *PixelId = EventMsgFlatbuffer->pixel_id();
+  if (TimeOfFlight->size() == 0) {
+    return []() { return false; };
+  }
+  if (PixelId->size() > 0 && PixelId->size() != TimeOfFlight->size()) {
+    throw WriterModule::WriterException(fmt::format(
+        "ev44 message data lengths differ (time_of_flight={} pixel_id={})",
+        TimeOfFlight->size(), PixelId->size()));
+  }
+  // The events are kept until merged, which can be after the message is
+  // gone.
+  auto Events = std::make_shared<MessageEvents>();
+  Events->TimeOfFlight.assign(TimeOfFlight->begin(), TimeOfFlight->end());
+  Events->PixelId.assign(PixelId->begin(), PixelId->end());
+  std::vector<std::int64_t> ReferenceTime(
+      EventMsgFlatbuffer->reference_time()->begin(),
+      EventMsgFlatbuffer->reference_time()->end());
+  std::vector<std::int32_t> ReferenceTimeIndex(
+      EventMsgFlatbuffer->reference_time_index()->begin(),
+      EventMsgFlatbuffer->reference_time_index()->end());
+  auto NrOfPulses = std::min(ReferenceTime.size(), ReferenceTimeIndex.size());
+
+  return [this, &Name = Source->first, Index = Source->second,
+          Events = std::move(Events),
+          ReferenceTime = std::move(ReferenceTime),
+          ReferenceTimeIndex = std::move(ReferenceTimeIndex), NrOfPulses]() {
+    // Concatenating the pixel ids of sources with and without them would
+    // give the events the wrong ids.
+    auto MessageHasPixelIds = !Events->PixelId.empty();
+    if (!HasPixelIds) {
+      HasPixelIds = MessageHasPixelIds;
+    } else if (*HasPixelIds != MessageHasPixelIds) {
+      ++RejectedMessages;
+      Logger::Debug(
+          R"(Rejected message of source "{}", pixel ids {} but {} expected.)",
+          Name, MessageHasPixelIds ? "present" : "missing",
+          *HasPixelIds ? "are" : "none are");
+      return false;
+    }
+    Merger->add(Index, Events, ReferenceTime.data(), ReferenceTimeIndex.data(),
+                NrOfPulses);
+    Merged.clear();
+    Merger->merge(Merged);
+    writeMerged(Merged);
+    return true;
+  };
+}
+
+void ev44_MergeWriter::writeMerged(MergedEvents const &Events) {
+  if (Events.TimeOfFlight.empty() && Events.ReferenceTime.empty()) {
+    return;
+  }
+  std::vector<std::int64_t> ShiftedIndex(Events.ReferenceTimeIndex.size());
+  std::transform(Events.ReferenceTimeIndex.begin(),
+                 Events.ReferenceTimeIndex.end(), ShiftedIndex.begin(),
+                 [this](auto Index) { return Index + EventsWritten; });
+  EventTimeOffset.appendArray(Events.TimeOfFlight);
+  EventId.appendArray(Events.PixelId);
+  EventTimeZero.appendArray(Events.ReferenceTime);
+  EventIndex.appendArray(ShiftedIndex);
+  EventsWritten += static_cast<int64_t>(Events.TimeOfFlight.size());
+  if (!Events.TimeOfFlight.empty() &&
+      EventsWritten > LastCueIndex + CueInterval) {
+    CueTimestampZero.appendElement(*Merger->lastReferenceTime() +
+                                   Events.TimeOfFlight.back());
+    CueIndex.appendElement(EventsWritten - 1);
+    LastCueIndex = EventsWritten - 1;
+  }
+  EventsWrittenMetadataField.setValue(EventsWritten);
+}
+
+void ev44_MergeWriter::flushBuffers() {
+  EventTimeOffset.flushBuffer();
+  EventId.flushBuffer();
+  EventTimeZero.flushBuffer();
+  EventIndex.flushBuffer();
+  CueIndex.flushBuffer();
+  CueTimestampZero.flushBuffer();
+  if (Merger && Merger->latePulses() != LatePulsesWritten) {
+    LatePulsesWritten = Merger->latePulses();
+    EventGroup.attributes["late_pulses"].write(LatePulsesWritten);
+  }
+  if (RejectedMessages != RejectedMessagesWritten) {
+    RejectedMessagesWritten = RejectedMessages;
+    EventGroup.attributes["rejected_messages"].write(RejectedMessagesWritten);
+  }
+}
+
+void ev44_MergeWriter::register_meta_data(
+    hdf5::node::Group const &HDFGroup, MetaData::TrackerPtr const &Tracker) {
+  EventsWrittenMetadataField = MetaData::Value<int64_t>(HDFGroup, "events");
+  Tracker->registerMetaData(EventsWrittenMetadataField);
+}
+
+static WriterModule::Registry::Registrar<ev44_MergeWriter>
+    RegisterWriter("ev44", "ev44_merge");
+
+} // namespace WriterModule::ev44
@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#pragma once
+
+#include "FlatbufferMessage.h"
+#include "MetaData/Value.h"
+#include "NeXusDataset/NeXusDataset.h"
+#include "WriterModuleBase.h"
+#include "ev44_EventMerger.h"
+#include <map>
+#include <memory>
+#include <optional>
+
+namespace WriterModule::ev44 {
+
+/// \brief Writes the events of several ev44 sources (e.g. detector banks
+/// streamed by separate processes) to one NXevent_data group.
+///
+/// The pulses of the sources are merged by reference time, see EventMerger.
+/// The events of all sources must either have pixel ids or none, which is
+/// decided by the first message with events. Messages that do not agree
+/// are not written, their number is written to the "rejected_messages"
+/// attribute.
+class ev44_MergeWriter : public WriterModule::Base {
+public:
+  ev44_MergeWriter()
+      : WriterModule::Base("ev44_merge", true, "NXevent_data"),
+        EventsWrittenMetadataField("", "events") {}
+
+  /// \brief Writes the pulses still waiting to be merged.
+  ~ev44_MergeWriter() override;
+
+  void config_post_processing() override;
+
+  std::vector<std::string> additionalSources() const override;
+
+  InitResult init_hdf(hdf5::node::Group &HDFGroup) override;
+  InitResult reopen(hdf5::node::Group &HDFGroup) override;
+
+  bool writeImpl(FileWriter::FlatbufferMessage const &Message,
+                 bool is_buffered_message) override;
+
+  /// \brief Copy the events of the message, the write stage merges them with
+  /// the events of the other sources and writes the merged pulses.
+  WriteStage prepareImpl(FileWriter::FlatbufferMessage const &Message,
+                         bool is_buffered_message) override;
+
+  bool hasPreparationStage() const override { return true; }
+
+  void flushBuffers() override;
+
+  void register_meta_data(hdf5::node::Group const &HDFGroup,
+                          MetaData::TrackerPtr const &Tracker) override;
+
+  NeXusDataset::EventTimeOffset EventTimeOffset;
+  NeXusDataset::EventId EventId;
+  NeXusDataset::EventTimeZero EventTimeZero;
+  NeXusDataset::EventIndex EventIndex;
+  NeXusDataset::CueIndex CueIndex;
+  NeXusDataset::CueTimestampZero CueTimestampZero;
+
+protected:
+  WritePriority defaultWritePriority() const override {
+    return WritePriority::LOW;
+  }
+
+private:
+  /// \brief Write merged pulses to the datasets.
+  void writeMerged(MergedEvents const &Events);
+
+  JsonConfig::Field<int64_t> CueInterval{this, "cue_interval", 100'000'000};
+  JsonConfig::Field<uint64_t> ChunkSize{this, "chunk_size", 1024 * 1024};
+  JsonConfig::Field<bool> LegacyTypes{this, "legacy_types", false};
+  /// The sources merged with "source".
+  JsonConfig::Field<std::vector<std::string>> Sources{
+      this, "sources", std::vector<std::string>{}};
+  /// The max number of pulses waiting to be merged per source.
+  JsonConfig::Field<uint64_t> ReorderWindow{this, "reorder_window", 16};
+  /// The index of every source in the merger.
+  std::map<std::string, size_t> SourceIndex;
+  std::unique_ptr<EventMerger> Merger;
+  /// Only used by the write stage, kept to reuse its memory.
+  MergedEvents Merged;
+  std::uint64_t LatePulsesWritten{0};
+  /// If the merged events have pixel ids, unknown until the first message
+  /// with events is written.
+  std::optional<bool> HasPixelIds;
+  std::uint64_t RejectedMessages{0};
+  std::uint64_t RejectedMessagesWritten{0};
+  hdf5::node::Group EventGroup;
+  int64_t EventsWritten{0};
+  int64_t LastCueIndex{-1};
+  MetaData::Value<int64_t> EventsWrittenMetadataField;
+};
+
+} // namespace WriterModule::ev44
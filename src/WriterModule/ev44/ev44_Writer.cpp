@@ -9,12 +9,14 @@
 
 #include <ev44_events_generated.h>
 
+#include "HDFAttributes.h"
 #include "HDFOperations.h"
 #include "WriterRegistrar.h"
 #include "ev44_Writer.h"
 #include "helper.h"
 #include "json.h"
 #include <algorithm>
+#include <optional>
 
 namespace {
 template <typename DataType>
@@ -28,40 +30,140 @@ namespace WriterModule::ev44 {
 
 using nlohmann::json;
 
+ev44_Writer::~ev44_Writer() {
+  try {
+    if (EventCounts && EventCounts->hasChanged()) {
+      EventCounts->write();
+    }
+  } catch (std::exception &E) {
+    Logger::Error("Failed to write the event histogram: {}", E.what());
+  }
+}
+
+void ev44_Writer::config_post_processing() {
+  std::optional<std::pair<std::int32_t, std::int32_t>> Window;
+  if (auto Tof = TofWindow.get_value(); Tof.size() == 2 && Tof[0] < Tof[1]) {
+    Window = {Tof[0], Tof[1]};
+  } else if (!Tof.empty()) {
+    Logger::Error("The time of flight window must be two increasing values, "
+                  "not using it.");
+  }
+  if (!PixelLookupTable.get_value().empty() ||
+      !MaskedPixels.get_value().empty() || Window) {
+    Filter = std::make_unique<EventFilter>(PixelLookupTable.get_value(),
+                                           PixelLookupOffset,
+                                           MaskedPixels.get_value(), Window);
+  }
+
+  auto ConfiguredMode = histogramModeFromString(Histogram.get_value());
+  if (ConfiguredMode) {
+    Mode = *ConfiguredMode;
+  } else {
+    Logger::Error(R"(Unknown histogram mode "{}", only writing events.)",
+                  Histogram.get_value());
+  }
+  if (Mode != HistogramMode::EVENTS) {
+    try {
+      auto Pixels = PixelRange.get_value();
+      if (Pixels.size() != 2) {
+        throw std::runtime_error(
+            "The pixel range must be the first and the last pixel id.");
+      }
+      EventCounts = std::make_unique<EventHistogram>(
+          TofBinEdges.get_value(), Pixels[0], Pixels[1], PixelGroupSize);
+    } catch (std::exception const &E) {
+      Logger::Error("Invalid histogram configuration, only writing events: {}",
+                    E.what());
+      Mode = HistogramMode::EVENTS;
+    }
+  }
+
+  bool OverloadConfigured = OverloadQueuedMessages.get_value() > 0 ||
+                            OverloadQueueTime.get_value() > 0;
+  DegradeOnOverload = OverloadConfigured && EventCounts &&
+                      Mode != HistogramMode::HISTOGRAM;
+  if (OverloadConfigured && !DegradeOnOverload) {
+    Logger::Error("Only histogramming the events on overload requires a "
+                  "histogram and the events to be written, not used.");
+  }
+  if (Mode == HistogramMode::HISTOGRAM_ON_OVERLOAD && !DegradeOnOverload) {
+    Logger::Error("No overload thresholds set, only writing events.");
+    EventCounts.reset();
+    Mode = HistogramMode::EVENTS;
+  }
+}
+
 InitResult ev44_Writer::init_hdf(hdf5::node::Group &HDFGroup) {
   auto Create = NeXusDataset::Mode::Create;
+  auto Types = LegacyTypes ? NeXusDataset::EventDataTypes::LEGACY
+                           : NeXusDataset::EventDataTypes::WIRE;
   try {
 
-    NeXusDataset::EventTimeOffset( // NOLINT(bugprone-unused-raii)
-        HDFGroup,                  // NOLINT(bugprone-unused-raii)
-        Create,                    // NOLINT(bugprone-unused-raii)
-        ChunkSize);                // NOLINT(bugprone-unused-raii)
-
-    NeXusDataset::EventId( // NOLINT(bugprone-unused-raii)
-        HDFGroup,          // NOLINT(bugprone-unused-raii)
-        Create,            // NOLINT(bugprone-unused-raii)
-        ChunkSize);        // NOLINT(bugprone-unused-raii)
+    NeXusDataset::EventTimeOffset(        // NOLINT(bugprone-unused-raii)
+        HDFGroup,                         // NOLINT(bugprone-unused-raii)
+        Create,                           // NOLINT(bugprone-unused-raii)
+        ChunkSize,                        // NOLINT(bugprone-unused-raii)
+        compression("event_time_offset"), // NOLINT(bugprone-unused-raii)
+        Types);                           // NOLINT(bugprone-unused-raii)
 
-    NeXusDataset::EventTimeZero( // NOLINT(bugprone-unused-raii)
+    NeXusDataset::EventId(       // NOLINT(bugprone-unused-raii)
         HDFGroup,                // NOLINT(bugprone-unused-raii)
         Create,                  // NOLINT(bugprone-unused-raii)
-        ChunkSize);              // NOLINT(bugprone-unused-raii)
-
-    NeXusDataset::EventIndex( // NOLINT(bugprone-unused-raii)
-        HDFGroup,             // NOLINT(bugprone-unused-raii)
-        Create,               // NOLINT(bugprone-unused-raii)
-        ChunkSize);           // NOLINT(bugprone-unused-raii)
+        ChunkSize,               // NOLINT(bugprone-unused-raii)
+        compression("event_id"), // NOLINT(bugprone-unused-raii)
+        Types);                  // NOLINT(bugprone-unused-raii)
 
-    NeXusDataset::CueIndex( // NOLINT(bugprone-unused-raii)
-        HDFGroup,           // NOLINT(bugprone-unused-raii)
-        Create,             // NOLINT(bugprone-unused-raii)
-        ChunkSize);         // NOLINT(bugprone-unused-raii)
+    NeXusDataset::EventTimeZero(        // NOLINT(bugprone-unused-raii)
+        HDFGroup,                       // NOLINT(bugprone-unused-raii)
+        Create,                         // NOLINT(bugprone-unused-raii)
+        ChunkSize,                      // NOLINT(bugprone-unused-raii)
+        compression("event_time_zero"), // NOLINT(bugprone-unused-raii)
+        Types);                         // NOLINT(bugprone-unused-raii)
 
-    NeXusDataset::CueTimestampZero( // NOLINT(bugprone-unused-raii)
+    NeXusDataset::EventIndex(       // NOLINT(bugprone-unused-raii)
         HDFGroup,                   // NOLINT(bugprone-unused-raii)
         Create,                     // NOLINT(bugprone-unused-raii)
-        ChunkSize);                 // NOLINT(bugprone-unused-raii)
+        ChunkSize,                  // NOLINT(bugprone-unused-raii)
+        compression("event_index"), // NOLINT(bugprone-unused-raii)
+        Types);                     // NOLINT(bugprone-unused-raii)
 
+    NeXusDataset::CueIndex(        // NOLINT(bugprone-unused-raii)
+        HDFGroup,                  // NOLINT(bugprone-unused-raii)
+        Create,                    // NOLINT(bugprone-unused-raii)
+        ChunkSize,                 // NOLINT(bugprone-unused-raii)
+        compression("cue_index")); // NOLINT(bugprone-unused-raii)
+
+    NeXusDataset::CueTimestampZero(         // NOLINT(bugprone-unused-raii)
+        HDFGroup,                           // NOLINT(bugprone-unused-raii)
+        Create,                             // NOLINT(bugprone-unused-raii)
+        ChunkSize,                          // NOLINT(bugprone-unused-raii)
+        compression("cue_timestamp_zero")); // NOLINT(bugprone-unused-raii)
+
+    if (EventCounts) {
+      EventCounts->createGroup(HDFGroup, "histogram");
+    }
+    if (Filter) {
+      // Written by flushBuffers(), attributes can not be created in SWMR
+      // mode.
+      for (auto const &Name : {"dropped_events_tof", "dropped_events_unmapped",
+                               "dropped_events_masked"}) {
+        HDFAttributes::writeAttribute(HDFGroup, Name, std::uint64_t(0));
+      }
+    }
+    if (DegradeOnOverload) {
+      auto ModeGroup = HDFGroup.create_group("write_mode");
+      HDFAttributes::writeAttribute(ModeGroup, "NX_class",
+                                    std::string("NXlog"));
+      NeXusDataset::ExtensibleDataset<std::int64_t> Time(ModeGroup, "time",
+                                                         Create);
+      HDFAttributes::writeAttribute(Time.dataset(), "units",
+                                    std::string("ns"));
+      NeXusDataset::ExtensibleDataset<std::uint8_t> Value(ModeGroup, "value",
+                                                          Create);
+      HDFAttributes::writeAttribute(
+          Value.dataset(), "description",
+          std::string("0: events written, 1: events only histogrammed"));
+    }
   } catch (std::exception const &E) {
     auto message = hdf5::error::print_nested(E);
     Logger::Error("ev44 could not init_hdf hdf_parent: {}  trace: {}",
@@ -80,6 +182,23 @@ WriterModule::InitResult ev44_Writer::reopen(hdf5::node::Group &HDFGroup) {
     EventIndex = NeXusDataset::EventIndex(HDFGroup, Open);
     CueIndex = NeXusDataset::CueIndex(HDFGroup, Open);
     CueTimestampZero = NeXusDataset::CueTimestampZero(HDFGroup, Open);
+    auto *CompressionPool = NeXusDataset::ChunkCompressionPool::instance();
+    EventTimeOffset.useDirectChunkWrites(CompressionPool);
+    EventId.useDirectChunkWrites(CompressionPool);
+    EventTimeZero.useDirectChunkWrites(CompressionPool);
+    EventIndex.useDirectChunkWrites(CompressionPool);
+    EventGroup = HDFGroup;
+    if (EventCounts) {
+      EventCounts->openGroup(HDFGroup, "histogram");
+      LastHistogramWrite = std::chrono::steady_clock::now();
+    }
+    if (DegradeOnOverload) {
+      auto ModeGroup = hdf5::node::get_group(HDFGroup, "write_mode");
+      WriteModeTime = NeXusDataset::ExtensibleDataset<std::int64_t>(
+          ModeGroup, "time", Open);
+      WriteModeValue = NeXusDataset::ExtensibleDataset<std::uint8_t>(
+          ModeGroup, "value", Open);
+    }
   } catch (std::exception &E) {
     Logger::Error(
         R"(Failed to reopen datasets in HDF file with error message: "{}")",
@@ -91,50 +210,201 @@ WriterModule::InitResult ev44_Writer::reopen(hdf5::node::Group &HDFGroup) {
 
 bool ev44_Writer::writeImpl(FlatbufferMessage const &Message,
                             bool is_buffered_message) {
+  return prepareImpl(Message, is_buffered_message)();
+}
+
+WriterModule::WriteStage
+ev44_Writer::prepareImpl(FlatbufferMessage const &Message,
+                         bool is_buffered_message) {
   if (is_buffered_message) {
     // Ignore buffered data for event data
-    return false;
+    return []() { return false; };
   }
   auto EventMsgFlatbuffer = GetEvent44Message(Message.data());
-  auto CurrentNumberOfEvents = EventMsgFlatbuffer->time_of_flight()->size();
+  size_t CurrentNumberOfEvents = EventMsgFlatbuffer->time_of_flight()->size();
   if (EventMsgFlatbuffer->pixel_id()->size() > 0 &&
       EventMsgFlatbuffer->pixel_id()->size() != CurrentNumberOfEvents) {
     Logger::Info(
         "ev44 message data lengths differ (time_of_flight={} pixel_id={})",
         CurrentNumberOfEvents, EventMsgFlatbuffer->pixel_id()->size());
   }
-  EventTimeOffset.appendArray(
-      getFBVectorAsArrayAdapter(EventMsgFlatbuffer->time_of_flight()));
-  EventId.appendArray(
-      getFBVectorAsArrayAdapter(EventMsgFlatbuffer->pixel_id()));
-  if (CurrentNumberOfEvents > 0) {
-    const flatbuffers::Vector<int64_t> *CurrentRefTime =
-        EventMsgFlatbuffer->reference_time();
+  auto TimeOfFlight =
+      getFBVectorAsArrayAdapter(EventMsgFlatbuffer->time_of_flight());
+  auto PixelId = getFBVectorAsArrayAdapter(EventMsgFlatbuffer->pixel_id());
+  auto const *ReferenceTimeIndex =
+      EventMsgFlatbuffer->reference_time_index()->data();
+  auto NrOfPulses = EventMsgFlatbuffer->reference_time_index()->size();
+
+  // Remap and filter the events before anything else is done with them. The
+  // filtered events are shared with the write stage.
+  std::shared_ptr<FilteredEvents> Filtered;
+  if (Filter) {
+    Filtered = std::make_shared<FilteredEvents>();
+    auto NrOfFiltered = CurrentNumberOfEvents;
+    std::int32_t const *Pixels = nullptr;
+    if (PixelId.size() > 0) {
+      NrOfFiltered = std::min<size_t>(PixelId.size(), CurrentNumberOfEvents);
+      Pixels = PixelId.data();
+    }
+    Filter->apply(TimeOfFlight.data(), Pixels, NrOfFiltered,
+                  ReferenceTimeIndex, NrOfPulses, *Filtered);
+    TimeOfFlight = {Filtered->TimeOfFlight.data(),
+                    Filtered->TimeOfFlight.size()};
+    PixelId = {Filtered->PixelId.data(), Filtered->PixelId.size()};
+    ReferenceTimeIndex = Filtered->ReferenceTimeIndex.data();
+    CurrentNumberOfEvents = Filtered->TimeOfFlight.size();
+  }
+
+  std::optional<std::int64_t> FirstReferenceTime;
+  if (EventMsgFlatbuffer->reference_time()->size() > 0) {
+    FirstReferenceTime = EventMsgFlatbuffer->reference_time()->Get(0);
+  }
+  bool HistogramOnly = Mode == HistogramMode::HISTOGRAM ||
+                       (DegradeOnOverload && updateOverloaded());
 
-    EventTimeZero.appendArray(getFBVectorAsArrayAdapter(CurrentRefTime));
+  std::vector<std::uint32_t> Bins;
+  if (EventCounts &&
+      (Mode != HistogramMode::HISTOGRAM_ON_OVERLOAD || HistogramOnly)) {
+    // Events without pixel ids are counted as pixel 0.
+    auto NrOfBinned = CurrentNumberOfEvents;
+    std::int32_t const *Pixels = nullptr;
+    if (PixelId.size() > 0) {
+      NrOfBinned = std::min<size_t>(PixelId.size(), CurrentNumberOfEvents);
+      Pixels = PixelId.data();
+    }
+    EventCounts->binIndices(TimeOfFlight.data(), Pixels, NrOfBinned, Bins);
+  }
+  if (HistogramOnly) {
+    return [this, Bins = std::move(Bins), Filtered, FirstReferenceTime]() {
+      recordWriteMode(true, FirstReferenceTime);
+      countDropped(Filtered.get());
+      EventCounts->count(Bins);
+      return true;
+    };
+  }
+
+  // The pulses of a message of which all events were filtered out are still
+  // written, pointing at the next event written.
+  if (CurrentNumberOfEvents == 0 &&
+      EventMsgFlatbuffer->time_of_flight()->size() == 0) {
+    return [this, TimeOfFlight, PixelId, Filtered, FirstReferenceTime]() {
+      recordWriteMode(false, FirstReferenceTime);
+      countDropped(Filtered.get());
+      EventTimeOffset.appendArray(TimeOfFlight);
+      EventId.appendArray(PixelId);
+      return true;
+    };
+  }
+  auto ReferenceTime =
+      getFBVectorAsArrayAdapter(EventMsgFlatbuffer->reference_time());
+  std::optional<std::int64_t> LastEventTime;
+  if (CurrentNumberOfEvents > 0) {
+    LastEventTime = *(EventMsgFlatbuffer->reference_time()->end() - 1) +
+                    TimeOfFlight.data()[CurrentNumberOfEvents - 1];
+  }
 
+  // The event count, the cues and the meta data depend on the writes done
+  // before, they are updated by the write stage.
+  return [this, TimeOfFlight, PixelId, ReferenceTime, ReferenceTimeIndex,
+          NrOfPulses, CurrentNumberOfEvents, LastEventTime,
+          Bins = std::move(Bins), Filtered, FirstReferenceTime]() {
+    recordWriteMode(false, FirstReferenceTime);
+    countDropped(Filtered.get());
+    if (EventCounts) {
+      EventCounts->count(Bins);
+    }
     // Shift incoming reference_time_index by the number of events already
     // stored
-    auto ReferenceTimeIndex = EventMsgFlatbuffer->reference_time_index();
-    ShiftedReferenceTimeIndex.resize(ReferenceTimeIndex->size());
+    std::vector<int64_t> ShiftedReferenceTimeIndex(NrOfPulses);
     std::transform(
-        ReferenceTimeIndex->begin(), ReferenceTimeIndex->end(),
+        ReferenceTimeIndex, ReferenceTimeIndex + NrOfPulses,
         ShiftedReferenceTimeIndex.begin(),
         [this](const int32_t elem) { return elem + this->EventsWritten; });
+    EventTimeOffset.appendArray(TimeOfFlight);
+    EventId.appendArray(PixelId);
+    EventTimeZero.appendArray(ReferenceTime);
     EventIndex.appendArray(ShiftedReferenceTimeIndex);
-
     EventsWritten += CurrentNumberOfEvents;
-    if (EventsWritten > LastCueIndex + CueInterval) {
-      auto LastRefTimeOffset = EventMsgFlatbuffer->time_of_flight()->operator[](
-          CurrentNumberOfEvents - 1);
-      CueTimestampZero.appendElement(*(CurrentRefTime->end() - 1) +
-                                     LastRefTimeOffset);
-      CueIndex.appendElement(EventsWritten - 1);
+    if (LastEventTime && EventsWritten > LastCueIndex + CueInterval) {
       LastCueIndex = EventsWritten - 1;
+      CueTimestampZero.appendElement(*LastEventTime);
+      CueIndex.appendElement(LastCueIndex);
     }
     EventsWrittenMetadataField.setValue(EventsWritten);
+    return true;
+  };
+}
+
+void ev44_Writer::countDropped(FilteredEvents const *Filtered) {
+  if (Filtered == nullptr) {
+    return;
+  }
+  DroppedEvents.DroppedTof += Filtered->DroppedTof;
+  DroppedEvents.DroppedUnmapped += Filtered->DroppedUnmapped;
+  DroppedEvents.DroppedMasked += Filtered->DroppedMasked;
+  DroppedEventsChanged = true;
+}
+
+bool ev44_Writer::updateOverloaded() {
+  // Switch back at half of the thresholds, to not switch back and forth.
+  std::uint64_t Divisor = Overloaded ? 2 : 1;
+  auto QueuedLimit = OverloadQueuedMessages.get_value();
+  auto TimeLimit = OverloadQueueTime.get_value();
+  auto QueueTime = toMilliSeconds(lastQueueTime());
+  bool NowOverloaded =
+      (QueuedLimit > 0 && nrOfMessagesInQueue() > QueuedLimit / Divisor) ||
+      (TimeLimit > 0 && QueueTime > 0 &&
+       std::uint64_t(QueueTime) > TimeLimit / Divisor);
+  if (NowOverloaded != Overloaded) {
+    if (NowOverloaded) {
+      Logger::Warn("Overloaded, only histogramming the events of source {} "
+                   "({} messages queued, {} ms queue time).",
+                   SourceName.get_value(), nrOfMessagesInQueue(), QueueTime);
+    } else {
+      Logger::Info("No longer overloaded, writing the events of source {}.",
+                   SourceName.get_value());
+    }
+  }
+  Overloaded = NowOverloaded;
+  return Overloaded;
+}
+
+void ev44_Writer::recordWriteMode(bool HistogramOnly,
+                                  std::optional<std::int64_t> Time) {
+  if (!DegradeOnOverload || !Time ||
+      (WrittenMode && *WrittenMode == HistogramOnly)) {
+    return;
+  }
+  WriteModeTime.appendElement(*Time);
+  WriteModeValue.appendElement(static_cast<std::uint8_t>(HistogramOnly));
+  WrittenMode = HistogramOnly;
+}
+
+void ev44_Writer::flushBuffers() {
+  EventTimeOffset.flushBuffer();
+  EventId.flushBuffer();
+  EventTimeZero.flushBuffer();
+  EventIndex.flushBuffer();
+  CueIndex.flushBuffer();
+  CueTimestampZero.flushBuffer();
+  WriteModeTime.flushBuffer();
+  WriteModeValue.flushBuffer();
+  if (DroppedEventsChanged) {
+    EventGroup.attributes["dropped_events_tof"].write(
+        DroppedEvents.DroppedTof);
+    EventGroup.attributes["dropped_events_unmapped"].write(
+        DroppedEvents.DroppedUnmapped);
+    EventGroup.attributes["dropped_events_masked"].write(
+        DroppedEvents.DroppedMasked);
+    DroppedEventsChanged = false;
+  }
+  auto Now = std::chrono::steady_clock::now();
+  if (EventCounts && EventCounts->hasChanged() &&
+      Now - LastHistogramWrite >=
+          std::chrono::milliseconds(HistogramInterval.get_value())) {
+    EventCounts->write();
+    LastHistogramWrite = Now;
   }
-  return true;
 }
 
 void ev44_Writer::register_meta_data(const hdf5::node::Group &HDFGroup,
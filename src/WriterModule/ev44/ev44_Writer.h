@@ -11,6 +11,11 @@
 #include "MetaData/Value.h"
 #include "NeXusDataset/NeXusDataset.h"
 #include "WriterModuleBase.h"
+#include "ev44_EventFilter.h"
+#include "ev44_Histogram.h"
+#include <chrono>
+#include <memory>
+#include <optional>
 
 namespace WriterModule::ev44 {
 
@@ -21,6 +26,14 @@ public:
   ev44_Writer()
       : WriterModule::Base("ev44", true, "NXevent_data"),
         EventsWrittenMetadataField("", "events") {}
+
+  /// \brief Writes the histogram (if any) if it has not been written since
+  /// the last events were counted.
+  ~ev44_Writer() override;
+
+  /// \brief Set up the event filter and the histogram (if configured).
+  void config_post_processing() override;
+
   InitResult init_hdf(hdf5::node::Group &HDFGroup) override;
   WriterModule::InitResult reopen(hdf5::node::Group &HDFGroup) override;
 
@@ -30,6 +43,18 @@ public:
   bool writeImpl(FlatbufferMessage const &Message,
                  bool is_buffered_message) override;
 
+  /// \brief Shift the reference time index and set up cues, the write stage
+  /// appends the (flatbuffer) arrays to file.
+  WriteStage prepareImpl(FlatbufferMessage const &Message,
+                         bool is_buffered_message) override;
+
+  bool hasPreparationStage() const override { return true; }
+
+  void flushBuffers() override;
+
+  /// \brief The histogram of the events, nullptr if not configured.
+  EventHistogram const *histogram() const { return EventCounts.get(); }
+
   NeXusDataset::EventTimeOffset EventTimeOffset;
   NeXusDataset::EventId EventId;
   NeXusDataset::EventTimeZero EventTimeZero;
@@ -44,16 +69,79 @@ public:
     CueInterval.setValue("", std::to_string(interval));
   }
 
+protected:
+  WritePriority defaultWritePriority() const override {
+    return WritePriority::LOW;
+  }
+
 private:
   JsonConfig::Field<int64_t> CueInterval{this, "cue_interval", 100'000'000};
   JsonConfig::Field<uint64_t> ChunkSize{this, "chunk_size", 1024 * 1024};
+  /// Write the event data with the types used by earlier versions, see
+  /// NeXusDataset::EventDataTypes.
+  JsonConfig::Field<bool> LegacyTypes{this, "legacy_types", false};
+  /// "none", "with_events", "only" or "on_overload", see HistogramMode.
+  JsonConfig::Field<std::string> Histogram{this, "histogram", "none"};
+  JsonConfig::Field<std::vector<std::int32_t>> TofBinEdges{
+      this, "tof_bin_edges", std::vector<std::int32_t>{}};
+  /// The first and the last (inclusive) pixel id of the histogram.
+  JsonConfig::Field<std::vector<std::int32_t>> PixelRange{
+      this, "pixel_range", std::vector<std::int32_t>{}};
+  JsonConfig::Field<std::uint32_t> PixelGroupSize{this, "pixel_group_size",
+                                                  1};
+  /// The minimum time between writes of the histogram (on flush).
+  JsonConfig::Field<std::uint64_t> HistogramInterval{
+      this, "histogram_interval_ms", 5000};
+  /// Raw pixel id to pixel id lookup table, see EventFilter.
+  JsonConfig::Field<std::vector<std::int32_t>> PixelLookupTable{
+      this, "pixel_lookup_table", std::vector<std::int32_t>{}};
+  /// The raw pixel id of the first entry of the lookup table.
+  JsonConfig::Field<std::int32_t> PixelLookupOffset{this,
+                                                    "pixel_lookup_offset", 0};
+  JsonConfig::Field<std::vector<std::int32_t>> MaskedPixels{
+      this, "masked_pixels", std::vector<std::int32_t>{}};
+  /// The first and (one after) the last time of flight of the written
+  /// events.
+  JsonConfig::Field<std::vector<std::int32_t>> TofWindow{
+      this, "tof_window", std::vector<std::int32_t>{}};
+  /// Only histogram the events while more than this many messages of the
+  /// module are queued, 0 to disable.
+  JsonConfig::Field<std::uint64_t> OverloadQueuedMessages{
+      this, "overload_queued_messages", 0};
+  /// Only histogram the events while messages are queued for longer than
+  /// this, 0 to disable.
+  JsonConfig::Field<std::uint64_t> OverloadQueueTime{
+      this, "overload_queue_time_ms", 0};
+  std::unique_ptr<EventFilter> Filter;
+  /// The number of events dropped by the filter, written as attributes of
+  /// the group on flush.
+  FilteredEvents DroppedEvents;
+  bool DroppedEventsChanged{false};
+  hdf5::node::Group EventGroup;
+  HistogramMode Mode{HistogramMode::EVENTS};
+  std::unique_ptr<EventHistogram> EventCounts;
+  std::chrono::steady_clock::time_point LastHistogramWrite;
+  /// \brief Add the numbers of dropped events of a write to DroppedEvents.
+  void countDropped(FilteredEvents const *Filtered);
+  /// \brief Determine if the module is overloaded, with hysteresis.
+  ///
+  /// Only called by prepareImpl().
+  bool updateOverloaded();
+  /// \brief Add a row to the write mode table if the mode has changed.
+  ///
+  /// \param HistogramOnly True if the events are only histogrammed.
+  /// \param Time The first reference time of the message, if any.
+  void recordWriteMode(bool HistogramOnly, std::optional<std::int64_t> Time);
+  /// Only histogram the events while overloaded.
+  bool DegradeOnOverload{false};
+  bool Overloaded{false};
+  /// The mode of the last row of the write mode table.
+  std::optional<bool> WrittenMode;
+  NeXusDataset::ExtensibleDataset<std::int64_t> WriteModeTime;
+  NeXusDataset::ExtensibleDataset<std::uint8_t> WriteModeValue;
+  /// The events written and the last cue, only used by the write stage.
   int64_t EventsWritten{0};
   int64_t LastCueIndex{-1};
   MetaData::Value<int64_t> EventsWrittenMetadataField;
-
-  // Buffer where ReferenceTimeIndex of every message is shifted by the number
-  // of EventsWritten before storing it on file. Using a member variable to
-  // reduce memory allocations.
-  std::vector<int64_t> ShiftedReferenceTimeIndex;
 };
 } // namespace WriterModule::ev44
@@ -8,12 +8,14 @@
 // Screaming Udder!                              https://esss.se
 
 #include "f144_Writer.h"
+#include "HDFAttributes.h"
 #include "MetaData/HDF5DataWriter.h"
 #include "WriterRegistrar.h"
 #include "json.h"
 #include "logger.h"
 #include <algorithm>
 #include <cctype>
+#include <cmath>
 #include <f144_logdata_generated.h>
 
 namespace WriterModule::f144 {
@@ -29,25 +31,40 @@ struct ValuesInformation {
   uint64_t NrOfElements{0};
 };
 
-template <typename Type> void makeIt(hdf5::node::Group const &Parent) {
+template <typename Type>
+void makeIt(hdf5::node::Group const &Parent, size_t ArraySize,
+            size_t ChunkSize, NeXusDataset::Compression const &Settings) {
+  if (ArraySize > 1) {
+    // One row per f144 update, rows are collected into chunks of (about)
+    // ChunkSize elements.
+    NeXusDataset::MultiDimDataset<Type>( // NOLINT(bugprone-unused-raii)
+        Parent, "value", NeXusDataset::Mode::Create, {ArraySize}, {ChunkSize},
+        Settings); // NOLINT(bugprone-unused-raii)
+    return;
+  }
   NeXusDataset::ExtensibleDataset<Type>( // NOLINT(bugprone-unused-raii)
-      Parent, "value",
-      NeXusDataset::Mode::Create); // NOLINT(bugprone-unused-raii)
+      Parent, "value", NeXusDataset::Mode::Create, ChunkSize,
+      Settings); // NOLINT(bugprone-unused-raii)
 }
 
-void initValueDataset(hdf5::node::Group const &Parent, Type ElementType) {
+void initValueDataset(hdf5::node::Group const &Parent, Type ElementType,
+                      size_t ArraySize, size_t ChunkSize,
+                      NeXusDataset::Compression const &Settings) {
+  auto Create = [&](auto TypeTag) {
+    makeIt<decltype(TypeTag)>(Parent, ArraySize, ChunkSize, Settings);
+  };
   using OpenFuncType = std::function<void()>;
   std::map<Type, OpenFuncType> CreateValuesMap{
-      {Type::int8, [&]() { makeIt<std::int8_t>(Parent); }},
-      {Type::uint8, [&]() { makeIt<std::uint8_t>(Parent); }},
-      {Type::int16, [&]() { makeIt<std::int16_t>(Parent); }},
-      {Type::uint16, [&]() { makeIt<std::uint16_t>(Parent); }},
-      {Type::int32, [&]() { makeIt<std::int32_t>(Parent); }},
-      {Type::uint32, [&]() { makeIt<std::uint32_t>(Parent); }},
-      {Type::int64, [&]() { makeIt<std::int64_t>(Parent); }},
-      {Type::uint64, [&]() { makeIt<std::uint64_t>(Parent); }},
-      {Type::float32, [&]() { makeIt<std::float_t>(Parent); }},
-      {Type::float64, [&]() { makeIt<std::double_t>(Parent); }},
+      {Type::int8, [&]() { Create(std::int8_t{}); }},
+      {Type::uint8, [&]() { Create(std::uint8_t{}); }},
+      {Type::int16, [&]() { Create(std::int16_t{}); }},
+      {Type::uint16, [&]() { Create(std::uint16_t{}); }},
+      {Type::int32, [&]() { Create(std::int32_t{}); }},
+      {Type::uint32, [&]() { Create(std::uint32_t{}); }},
+      {Type::int64, [&]() { Create(std::int64_t{}); }},
+      {Type::uint64, [&]() { Create(std::uint64_t{}); }},
+      {Type::float32, [&]() { Create(std::float_t{}); }},
+      {Type::float64, [&]() { Create(std::double_t{}); }},
   };
   CreateValuesMap.at(ElementType)();
 }
@@ -83,15 +100,22 @@ void f144_Writer::config_post_processing() {
 InitResult f144_Writer::init_hdf(hdf5::node::Group &HDFGroup) {
   auto Create = NeXusDataset::Mode::Create;
   try {
-    NeXusDataset::Time(HDFGroup, Create,
-                       ChunkSize); // NOLINT(bugprone-unused-raii)
-    NeXusDataset::CueTimestampZero(HDFGroup, Create,
-                                   ChunkSize); // NOLINT(bugprone-unused-raii)
-    NeXusDataset::CueIndex(HDFGroup, Create,
-                           ChunkSize); // NOLINT(bugprone-unused-raii)
-    initValueDataset(HDFGroup, ElementType);
+    NeXusDataset::Time(HDFGroup, Create, ChunkSize,
+                       compression("time")); // NOLINT(bugprone-unused-raii)
+    NeXusDataset::CueTimestampZero( // NOLINT(bugprone-unused-raii)
+        HDFGroup, Create, ChunkSize,
+        compression("cue_timestamp_zero")); // NOLINT(bugprone-unused-raii)
+    NeXusDataset::CueIndex( // NOLINT(bugprone-unused-raii)
+        HDFGroup, Create, ChunkSize,
+        compression("cue_index")); // NOLINT(bugprone-unused-raii)
+    initValueDataset(HDFGroup, ElementType, ArraySize, ChunkSize,
+                     compression("value"));
 
-    HDFGroup["value"].attributes.create_from<std::string>("units", Unit);
+    auto Value = HDFGroup["value"];
+    Value.attributes.create_from<std::string>("units", Unit);
+    // Written by flushBuffers(), attributes can not be created in SWMR mode.
+    HDFAttributes::writeAttribute(Value, "raw_updates", std::uint64_t(0));
+    HDFAttributes::writeAttribute(Value, "written_updates", std::uint64_t(0));
 
   } catch (std::exception const &E) {
     auto message = hdf5::error::print_nested(E);
@@ -111,7 +135,14 @@ InitResult f144_Writer::reopen(hdf5::node::Group &HDFGroup) {
     Timestamp = NeXusDataset::Time(HDFGroup, Open);
     CueIndex = NeXusDataset::CueIndex(HDFGroup, Open);
     CueTimestampZero = NeXusDataset::CueTimestampZero(HDFGroup, Open);
-    Values = NeXusDataset::ExtensibleDatasetBase(HDFGroup, "value", Open);
+    ValueDataset = HDFGroup.get_dataset("value");
+    if (hdf5::dataspace::Simple(ValueDataset.dataspace()).rank() > 1) {
+      ArrayValues = std::make_unique<NeXusDataset::MultiDimDatasetBase>(
+          HDFGroup, "value", Open);
+      ArrayValues->setFramesPerWrite(arraysPerWrite(ValueDataset));
+    } else {
+      Values = NeXusDataset::ExtensibleDatasetBase(HDFGroup, "value", Open);
+    }
   } catch (std::exception &E) {
     Logger::Error(
         R"(Failed to reopen datasets in HDF file with error message: "{}")",
@@ -121,6 +152,14 @@ InitResult f144_Writer::reopen(hdf5::node::Group &HDFGroup) {
   return InitResult::OK;
 }
 
+size_t f144_Writer::arraysPerWrite(hdf5::node::Dataset const &ValueDataset) {
+  if (ArraysPerWrite.get_value() > 0) {
+    return ArraysPerWrite;
+  }
+  // Write (about) one chunk at a time.
+  return ValueDataset.creation_list().chunk().at(0);
+}
+
 template <typename FBValueType, typename ReturnType>
 ReturnType extractScalarValue(const f144_LogData *LogDataMessage) {
   auto LogValue = LogDataMessage->value_as<FBValueType>();
@@ -128,11 +167,105 @@ ReturnType extractScalarValue(const f144_LogData *LogDataMessage) {
 }
 
 template <typename DataType, typename ValueType, class DatasetType>
-ValuesInformation appendScalarData(DatasetType &Dataset,
-                                   const f144_LogData *LogDataMessage) {
+void appendScalarData(DatasetType &Dataset,
+                      const f144_LogData *LogDataMessage) {
   auto ScalarValue = extractScalarValue<ValueType, DataType>(LogDataMessage);
   Dataset.template appendElement<DataType>(ScalarValue);
-  return {double(ScalarValue), double(ScalarValue), double(ScalarValue), 1};
+}
+
+template <typename DataType, typename ValueType>
+void appendArrayData(
+    std::unique_ptr<NeXusDataset::MultiDimDatasetBase> &Dataset,
+    const f144_LogData *LogDataMessage) {
+  if (!Dataset) {
+    throw WriterModule::WriterException(
+        "Got an f144 array value but the value dataset is not an array "
+        "dataset (set \"array_size\").");
+  }
+  auto Array = LogDataMessage->value_as<ValueType>()->value();
+  if (Array == nullptr || Array->size() == 0) {
+    throw WriterModule::WriterException("Got an empty f144 array value.");
+  }
+  hdf5::ArrayAdapter<const DataType> Data(Array->data(), Array->size());
+  Dataset->appendArray(Data, {Array->size()});
+}
+
+template <typename ValueType>
+ValuesInformation scalarInformation(const f144_LogData *LogDataMessage) {
+  auto ScalarValue =
+      double(extractScalarValue<ValueType, double>(LogDataMessage));
+  return {ScalarValue, ScalarValue, ScalarValue, 1};
+}
+
+template <typename ValueType>
+ValuesInformation arrayInformation(const f144_LogData *LogDataMessage) {
+  auto Array = LogDataMessage->value_as<ValueType>()->value();
+  if (Array == nullptr || Array->size() == 0) {
+    return {};
+  }
+  ValuesInformation Info{double(Array->Get(0)), double(Array->Get(0)), 0,
+                         Array->size()};
+  for (auto Element : *Array) {
+    Info.Min = std::min(Info.Min, double(Element));
+    Info.Max = std::max(Info.Max, double(Element));
+    Info.Sum += double(Element);
+  }
+  return Info;
+}
+
+bool isScalar(Value Type) {
+  return Type >= Value::Byte && Type <= Value::Double;
+}
+
+/// \brief Get the statistics of the value(s) of an f144 update.
+ValuesInformation valuesInformation(const f144_LogData *LogDataMessage) {
+  switch (LogDataMessage->value_type()) {
+  case Value::Byte:
+    return scalarInformation<Byte>(LogDataMessage);
+  case Value::UByte:
+    return scalarInformation<UByte>(LogDataMessage);
+  case Value::Short:
+    return scalarInformation<Short>(LogDataMessage);
+  case Value::UShort:
+    return scalarInformation<UShort>(LogDataMessage);
+  case Value::Int:
+    return scalarInformation<Int>(LogDataMessage);
+  case Value::UInt:
+    return scalarInformation<UInt>(LogDataMessage);
+  case Value::Long:
+    return scalarInformation<Long>(LogDataMessage);
+  case Value::ULong:
+    return scalarInformation<ULong>(LogDataMessage);
+  case Value::Float:
+    return scalarInformation<Float>(LogDataMessage);
+  case Value::Double:
+    return scalarInformation<Double>(LogDataMessage);
+  case Value::ArrayByte:
+    return arrayInformation<ArrayByte>(LogDataMessage);
+  case Value::ArrayUByte:
+    return arrayInformation<ArrayUByte>(LogDataMessage);
+  case Value::ArrayShort:
+    return arrayInformation<ArrayShort>(LogDataMessage);
+  case Value::ArrayUShort:
+    return arrayInformation<ArrayUShort>(LogDataMessage);
+  case Value::ArrayInt:
+    return arrayInformation<ArrayInt>(LogDataMessage);
+  case Value::ArrayUInt:
+    return arrayInformation<ArrayUInt>(LogDataMessage);
+  case Value::ArrayLong:
+    return arrayInformation<ArrayLong>(LogDataMessage);
+  case Value::ArrayULong:
+    return arrayInformation<ArrayULong>(LogDataMessage);
+  case Value::ArrayFloat:
+    return arrayInformation<ArrayFloat>(LogDataMessage);
+  case Value::ArrayDouble:
+    return arrayInformation<ArrayDouble>(LogDataMessage);
+  default:
+    Logger::Info("Unknown data type in f144 message with source '{}'",
+                 LogDataMessage->source_name()->str());
+    throw WriterModule::WriterException(
+        "Unknown data type in f144 flatbuffer.");
+  }
 }
 
 void msgTypeIsConfigType(f144_Writer::Type ConfigType, Value MsgType) {
@@ -197,7 +330,6 @@ void msgTypeIsConfigType(f144_Writer::Type ConfigType, Value MsgType) {
 bool f144_Writer::writeImpl(FlatbufferMessage const &Message,
                             [[maybe_unused]] bool is_buffered_message) {
   auto LogDataMessage = Getf144_LogData(Message.data());
-  Timestamp.appendElement(LogDataMessage->timestamp());
   auto Type = LogDataMessage->value_type();
 
   if (!HasCheckedMessageType) {
@@ -205,76 +337,194 @@ bool f144_Writer::writeImpl(FlatbufferMessage const &Message,
     HasCheckedMessageType = true;
   }
 
-  ValuesInformation CValuesInfo;
-  switch (Type) {
+  if (ArrayValues && isScalar(Type)) {
+    throw WriterModule::WriterException(
+        "Got an f144 scalar value but the value dataset is an array dataset.");
+  }
+
+  // The statistics cover every update, also those that are not written.
+  auto CValuesInfo = valuesInformation(LogDataMessage);
+  ++NrOfRawUpdates;
+  if (MetaData.get_value() && CValuesInfo.NrOfElements > 0) {
+    if (TotalNrOfElementsWritten == 0) {
+      Min = CValuesInfo.Min;
+      Max = CValuesInfo.Max;
+    }
+    Min = std::min(Min, CValuesInfo.Min);
+    Max = std::max(Max, CValuesInfo.Max);
+    Sum += CValuesInfo.Sum;
+    TotalNrOfElementsWritten += CValuesInfo.NrOfElements;
+  }
+
+  if (!passesFilter(LogDataMessage->timestamp(), CValuesInfo.Min,
+                    isScalar(Type))) {
+    return true;
+  }
+  if (Decimation.get_value() > 1 && isScalar(Type)) {
+    decimate(Message, CValuesInfo.Min);
+    return true;
+  }
+  writeUpdate(LogDataMessage);
+  return true;
+}
+
+bool f144_Writer::passesFilter(std::int64_t UpdateTime, double Value,
+                               bool IsScalar) {
+  if (NrOfPassedUpdates > 0) {
+    auto Interval = MinimumInterval.get_value();
+    if (Interval > 0 && UpdateTime - LastPassedTime < Interval) {
+      return false;
+    }
+    // The dead band only applies to scalar values.
+    auto Deadband = std::max(AbsoluteDeadband.get_value(),
+                             RelativeDeadband.get_value() *
+                                 std::abs(LastPassedValue));
+    if (IsScalar && Deadband > 0 &&
+        std::abs(Value - LastPassedValue) <= Deadband) {
+      return false;
+    }
+  }
+  ++NrOfPassedUpdates;
+  LastPassedTime = UpdateTime;
+  LastPassedValue = Value;
+  return true;
+}
+
+void f144_Writer::decimate(FlatbufferMessage const &Message, double Value) {
+  auto CopyUpdate = [&Message](std::vector<std::uint8_t> &Update) {
+    Update.assign(Message.data(), Message.data() + Message.size());
+  };
+  if (Window.NrOfUpdates == 0 || Value < Window.Min) {
+    Window.Min = Value;
+    Window.MinIndex = Window.NrOfUpdates;
+    CopyUpdate(Window.MinUpdate);
+  }
+  if (Window.NrOfUpdates == 0 || Value > Window.Max) {
+    Window.Max = Value;
+    Window.MaxIndex = Window.NrOfUpdates;
+    CopyUpdate(Window.MaxUpdate);
+  }
+  if (++Window.NrOfUpdates >= Decimation.get_value()) {
+    writeDecimationWindow();
+  }
+}
+
+void f144_Writer::writeDecimationWindow() {
+  if (Window.NrOfUpdates == 0) {
+    return;
+  }
+  Window.NrOfUpdates = 0;
+  // Write the minimum and the maximum in the order in which they arrived.
+  auto *First = &Window.MinUpdate;
+  auto *Second = &Window.MaxUpdate;
+  if (Window.MaxIndex < Window.MinIndex) {
+    std::swap(First, Second);
+  }
+  writeUpdate(Getf144_LogData(First->data()));
+  if (Window.MinIndex != Window.MaxIndex) {
+    writeUpdate(Getf144_LogData(Second->data()));
+  }
+}
+
+void f144_Writer::writeUpdate(const f144_LogData *LogDataMessage) {
+  // The value is appended first so that a value that can not be written does
+  // not leave a time stamp without a value.
+  switch (LogDataMessage->value_type()) {
   case Value::Byte:
-    CValuesInfo =
-        appendScalarData<const std::int8_t, Byte>(Values, LogDataMessage);
+    appendScalarData<const std::int8_t, Byte>(Values, LogDataMessage);
     break;
   case Value::UByte:
-    CValuesInfo =
-        appendScalarData<const std::uint8_t, UByte>(Values, LogDataMessage);
+    appendScalarData<const std::uint8_t, UByte>(Values, LogDataMessage);
     break;
   case Value::Short:
-    CValuesInfo =
-        appendScalarData<const std::int16_t, Short>(Values, LogDataMessage);
+    appendScalarData<const std::int16_t, Short>(Values, LogDataMessage);
     break;
   case Value::UShort:
-    CValuesInfo =
-        appendScalarData<const std::uint16_t, UShort>(Values, LogDataMessage);
+    appendScalarData<const std::uint16_t, UShort>(Values, LogDataMessage);
     break;
   case Value::Int:
-    CValuesInfo =
-        appendScalarData<const std::int32_t, Int>(Values, LogDataMessage);
+    appendScalarData<const std::int32_t, Int>(Values, LogDataMessage);
     break;
   case Value::UInt:
-    CValuesInfo =
-        appendScalarData<const std::uint32_t, UInt>(Values, LogDataMessage);
+    appendScalarData<const std::uint32_t, UInt>(Values, LogDataMessage);
     break;
   case Value::Long:
-    CValuesInfo =
-        appendScalarData<const std::int64_t, Long>(Values, LogDataMessage);
+    appendScalarData<const std::int64_t, Long>(Values, LogDataMessage);
     break;
   case Value::ULong:
-    CValuesInfo =
-        appendScalarData<const std::uint64_t, ULong>(Values, LogDataMessage);
+    appendScalarData<const std::uint64_t, ULong>(Values, LogDataMessage);
     break;
   case Value::Float:
-    CValuesInfo = appendScalarData<const float, Float>(Values, LogDataMessage);
+    appendScalarData<const float, Float>(Values, LogDataMessage);
     break;
   case Value::Double:
-    CValuesInfo =
-        appendScalarData<const double, Double>(Values, LogDataMessage);
+    appendScalarData<const double, Double>(Values, LogDataMessage);
+    break;
+  case Value::ArrayByte:
+    appendArrayData<std::int8_t, ArrayByte>(ArrayValues, LogDataMessage);
+    break;
+  case Value::ArrayUByte:
+    appendArrayData<std::uint8_t, ArrayUByte>(ArrayValues, LogDataMessage);
+    break;
+  case Value::ArrayShort:
+    appendArrayData<std::int16_t, ArrayShort>(ArrayValues, LogDataMessage);
+    break;
+  case Value::ArrayUShort:
+    appendArrayData<std::uint16_t, ArrayUShort>(ArrayValues, LogDataMessage);
+    break;
+  case Value::ArrayInt:
+    appendArrayData<std::int32_t, ArrayInt>(ArrayValues, LogDataMessage);
+    break;
+  case Value::ArrayUInt:
+    appendArrayData<std::uint32_t, ArrayUInt>(ArrayValues, LogDataMessage);
+    break;
+  case Value::ArrayLong:
+    appendArrayData<std::int64_t, ArrayLong>(ArrayValues, LogDataMessage);
+    break;
+  case Value::ArrayULong:
+    appendArrayData<std::uint64_t, ArrayULong>(ArrayValues, LogDataMessage);
+    break;
+  case Value::ArrayFloat:
+    appendArrayData<float, ArrayFloat>(ArrayValues, LogDataMessage);
+    break;
+  case Value::ArrayDouble:
+    appendArrayData<double, ArrayDouble>(ArrayValues, LogDataMessage);
     break;
   default:
-    Logger::Info(
-        "f144 writer module no longer supports array types, so ignoring "
-        "message with source '{}'",
-        LogDataMessage->source_name()->str());
     throw WriterModule::WriterException(
         "Unknown data type in f144 flatbuffer.");
   }
-
+  // Values and Timestamp buffer the same number of elements (one chunk), so
+  // the two columns are written to the file together.
+  Timestamp.appendElement(LogDataMessage->timestamp());
   ++NrOfWrites;
   if ((NrOfWrites - LastIndexAtWrite) / ValueIndexInterval.get_value() > 0) {
     LastIndexAtWrite = NrOfWrites;
     CueIndex.appendElement(NrOfWrites - 1);
     CueTimestampZero.appendElement(LogDataMessage->timestamp());
   }
-  if (MetaData.get_value()) {
-    if (TotalNrOfElementsWritten == 0) {
-      Min = CValuesInfo.Min;
-      Max = CValuesInfo.Max;
-    }
-    Min = std::min(Min, CValuesInfo.Min);
-    Max = std::max(Max, CValuesInfo.Max);
-    Sum += CValuesInfo.Sum;
-    TotalNrOfElementsWritten += CValuesInfo.NrOfElements;
+}
+
+void f144_Writer::flushBuffers() {
+  writeDecimationWindow();
+  Values.flushBuffer();
+  if (ArrayValues) {
+    ArrayValues->flushBuffer();
+  }
+  Timestamp.flushBuffer();
+  CueTimestampZero.flushBuffer();
+  CueIndex.flushBuffer();
+  if (NrOfRawUpdates != NrOfRawUpdatesAtFlush) {
+    NrOfRawUpdatesAtFlush = NrOfRawUpdates;
+    ValueDataset.attributes["raw_updates"].write(NrOfRawUpdates);
+    ValueDataset.attributes["written_updates"].write(NrOfWrites);
+  }
+  // The (shared) meta data values are only updated here, not per update.
+  if (MetaData.get_value() && TotalNrOfElementsWritten > 0) {
     MetaDataMin.setValue(Min);
     MetaDataMax.setValue(Max);
     MetaDataMean.setValue(Sum / TotalNrOfElementsWritten);
   }
-  return true;
 }
 
 void f144_Writer::register_meta_data(hdf5::node::Group const &HDFGroup,
@@ -22,6 +22,8 @@
 #include <optional>
 #include <vector>
 
+struct f144_LogData;
+
 namespace WriterModule::f144 {
 using FlatbufferMessage = FileWriter::FlatbufferMessage;
 
@@ -42,6 +44,8 @@ public:
   bool writeImpl(FlatbufferMessage const &Message,
                  bool is_buffered_message) override;
 
+  void flushBuffers() override;
+
   f144_Writer()
       : WriterModule::Base("f144", false, "NXlog",
                            {"epics_con_info", "alarm_info"}) {}
@@ -61,10 +65,45 @@ public:
   };
 
 protected:
+  WritePriority defaultWritePriority() const override {
+    return WritePriority::HIGH;
+  }
+
   Type ElementType{Type::float64};
 
+  /// \brief The number of array values to write with one write, see
+  /// ArraysPerWrite.
+  size_t arraysPerWrite(hdf5::node::Dataset const &ValueDataset);
+
+  /// \brief Apply the minimum interval and the dead band to an update.
+  ///
+  /// \param UpdateTime The time stamp of the update.
+  /// \param Value The (scalar) value of the update.
+  /// \param IsScalar The dead band is only applied to scalar values.
+  /// \return True if the update should be written (or decimated).
+  bool passesFilter(std::int64_t UpdateTime, double Value, bool IsScalar);
+
+  /// \brief Add an update to the decimation window, the minimum and the
+  /// maximum of the window are written when it is full.
+  void decimate(FlatbufferMessage const &Message, double Value);
+
+  /// \brief Write the minimum and the maximum of the (partial) decimation
+  /// window.
+  void writeDecimationWindow();
+
+  /// \brief Append the value(s) and time stamp of an update to the datasets.
+  void writeUpdate(const f144_LogData *LogDataMessage);
+
+  /// The scalar values, buffered (like Timestamp) and written in chunk sized
+  /// batches.
   NeXusDataset::ExtensibleDatasetBase Values;
 
+  /// The array values (if array_size > 1), one row per f144 update.
+  std::unique_ptr<NeXusDataset::MultiDimDatasetBase> ArrayValues;
+
+  /// The value dataset, for the update count attributes.
+  hdf5::node::Dataset ValueDataset;
+
   /// Timestamps of the f144 updates.
   NeXusDataset::Time Timestamp;
 
@@ -78,9 +117,24 @@ protected:
       this, "cue_interval", std::numeric_limits<uint32_t>::max()};
   JsonConfig::Field<size_t> ArraySize{this, "array_size", 1};
   JsonConfig::Field<size_t> ChunkSize{this, "chunk_size", 1024};
+  /// The number of array values collected in memory and written to the file
+  /// with one write. 0 means as many as fit in one chunk.
+  JsonConfig::Field<size_t> ArraysPerWrite{this, "arrays_per_write", 0};
   JsonConfig::Field<std::string> DataType{this, {"type", "dtype"}, "double"};
   JsonConfig::Field<std::string> Unit{this, {"value_units", "unit"}, ""};
   JsonConfig::Field<bool> MetaData{this, "meta_data", true};
+  /// Scalar updates that differ by at most this much from the previous
+  /// written update are not written, 0 to disable.
+  JsonConfig::Field<double> AbsoluteDeadband{this, "deadband", 0.0};
+  /// As AbsoluteDeadband but relative to the previous written value.
+  JsonConfig::Field<double> RelativeDeadband{this, "relative_deadband", 0.0};
+  /// Updates less than this many ns after the previous written update are
+  /// not written, 0 to disable.
+  JsonConfig::Field<std::int64_t> MinimumInterval{this, "minimum_interval_ns",
+                                                  0};
+  /// Only write the minimum and the maximum of every this many scalar
+  /// updates, 0 or 1 to disable.
+  JsonConfig::Field<uint32_t> Decimation{this, "decimation", 0};
 
   MetaData::Value<double> MetaDataMin{"", "minimum_value"};
   MetaData::Value<double> MetaDataMax{"", "maximum_value"};
@@ -88,6 +142,22 @@ protected:
   double Min{0};
   double Max{0};
   double Sum{0};
+  uint64_t NrOfRawUpdates{0};
+  uint64_t NrOfRawUpdatesAtFlush{0};
+  uint64_t NrOfPassedUpdates{0};
+  std::int64_t LastPassedTime{0};
+  double LastPassedValue{0};
+  /// The (copied) updates with the minimum and the maximum value of the
+  /// current decimation window.
+  struct DecimationWindow {
+    uint32_t NrOfUpdates{0};
+    double Min{0};
+    double Max{0};
+    uint32_t MinIndex{0};
+    uint32_t MaxIndex{0};
+    std::vector<std::uint8_t> MinUpdate;
+    std::vector<std::uint8_t> MaxUpdate;
+  } Window;
   uint64_t LastIndexAtWrite{0};
   uint64_t NrOfWrites{0};
   uint64_t TotalNrOfElementsWritten{0};
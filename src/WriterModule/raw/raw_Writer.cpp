@@ -0,0 +1,192 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#include "raw_Writer.h"
+#include "HDFAttributes.h"
+#include "WriterRegistrar.h"
+#include <algorithm>
+
+namespace WriterModule::raw {
+
+// The flatbuffer id of the module is not used, the messages are those of the
+// configured schema, see messageFlatbufferID().
+static WriterModule::Registry::Registrar<raw_Writer>
+    RegisterRawWriter("raw0", "raw");
+
+raw_Writer::~raw_Writer() {
+  try {
+    writeBatch();
+  } catch (std::exception &E) {
+    Logger::Error("Failed to write the batched messages: {}", E.what());
+  }
+}
+
+void raw_Writer::config_post_processing() {
+  if (!Schema.get_value().empty() && Schema.get_value().size() != 4) {
+    Logger::Error(
+        R"(The schema ("{}") of the archived messages must be a four character flatbuffer id.)",
+        Schema.get_value());
+  }
+}
+
+std::optional<std::string> raw_Writer::messageFlatbufferID() const {
+  if (Schema.get_value().size() != 4) {
+    return std::nullopt;
+  }
+  return Schema.get_value();
+}
+
+bool raw_Writer::writesAllMessagesOfTopic() const {
+  return Schema.get_value().empty();
+}
+
+InitResult raw_Writer::init_hdf(hdf5::node::Group &HDFGroup) {
+  auto Create = NeXusDataset::Mode::Create;
+  try {
+    NeXusDataset::ExtensibleDataset<std::uint8_t> Bytes(
+        HDFGroup, "payload", Create, ChunkSize, compression("payload"));
+    HDFAttributes::writeAttribute(Bytes.dataset(), "flatbuffer_id",
+                                  Schema.get_value());
+    // NOLINTNEXTLINE(bugprone-unused-raii)
+    NeXusDataset::ExtensibleDataset<std::uint64_t>(HDFGroup, "message_offset",
+                                                   Create);
+    // NOLINTNEXTLINE(bugprone-unused-raii)
+    NeXusDataset::ExtensibleDataset<std::uint32_t>(HDFGroup, "message_size",
+                                                   Create);
+    NeXusDataset::ExtensibleDataset<std::int64_t> Time(HDFGroup, "timestamp",
+                                                       Create);
+    HDFAttributes::writeAttribute(Time.dataset(), "units", std::string("ns"));
+    // NOLINTNEXTLINE(bugprone-unused-raii)
+    NeXusDataset::ExtensibleDataset<std::int64_t>(HDFGroup, "kafka_offset",
+                                                  Create);
+    // NOLINTNEXTLINE(bugprone-unused-raii)
+    NeXusDataset::ExtensibleDataset<std::int32_t>(HDFGroup, "kafka_partition",
+                                                  Create);
+    NeXusDataset::ExtensibleDataset<std::int64_t> KafkaTime(
+        HDFGroup, "kafka_timestamp", Create);
+    HDFAttributes::writeAttribute(KafkaTime.dataset(), "units",
+                                  std::string("ms"));
+  } catch (std::exception const &E) {
+    auto message = hdf5::error::print_nested(E);
+    Logger::Error("raw could not init_hdf hdf_parent: {}  trace: {}",
+                  static_cast<std::string>(HDFGroup.link().path()), message);
+    return InitResult::ERROR;
+  }
+  return InitResult::OK;
+}
+
+InitResult raw_Writer::reopen(hdf5::node::Group &HDFGroup) {
+  auto Open = NeXusDataset::Mode::Open;
+  try {
+    Payload = NeXusDataset::ExtensibleDataset<std::uint8_t>(HDFGroup,
+                                                            "payload", Open);
+    MessageOffset = NeXusDataset::ExtensibleDataset<std::uint64_t>(
+        HDFGroup, "message_offset", Open);
+    MessageSize = NeXusDataset::ExtensibleDataset<std::uint32_t>(
+        HDFGroup, "message_size", Open);
+    Timestamp = NeXusDataset::ExtensibleDataset<std::int64_t>(
+        HDFGroup, "timestamp", Open);
+    KafkaOffset = NeXusDataset::ExtensibleDataset<std::int64_t>(
+        HDFGroup, "kafka_offset", Open);
+    KafkaPartition = NeXusDataset::ExtensibleDataset<std::int32_t>(
+        HDFGroup, "kafka_partition", Open);
+    KafkaTimestamp = NeXusDataset::ExtensibleDataset<std::int64_t>(
+        HDFGroup, "kafka_timestamp", Open);
+    Payload.useDirectChunkWrites(
+        NeXusDataset::ChunkCompressionPool::instance());
+    NrOfBytesArchived = Payload.size();
+    BatchedPayloads.reserve(BatchSize);
+  } catch (std::exception &E) {
+    Logger::Error(
+        R"(Failed to reopen datasets in HDF file with error message: "{}")",
+        std::string(E.what()));
+    return InitResult::ERROR;
+  }
+  return InitResult::OK;
+}
+
+bool raw_Writer::writeImpl(FlatbufferMessage const &Message,
+                           [[maybe_unused]] bool is_buffered_message) {
+  auto const &Origin = Message.getKafkaOrigin();
+  MessageOffset.appendElement(NrOfBytesArchived);
+  MessageSize.appendElement(static_cast<std::uint32_t>(Message.size()));
+  Timestamp.appendElement(Message.getTimestamp());
+  KafkaOffset.appendElement(Origin.Offset);
+  KafkaPartition.appendElement(Origin.Partition);
+  KafkaTimestamp.appendElement(Origin.TimestampMs);
+  NrOfBytesArchived += Message.size();
+  BatchedPayloads.insert(BatchedPayloads.end(), Message.data(),
+                         Message.data() + Message.size());
+  if (BatchedPayloads.size() >= BatchSize) {
+    writeBatch();
+  }
+  return true;
+}
+
+void raw_Writer::writeBatch() {
+  if (BatchedPayloads.empty()) {
+    return;
+  }
+  Payload.appendArray(BatchedPayloads);
+  BatchedPayloads.clear();
+}
+
+void raw_Writer::flushBuffers() {
+  writeBatch();
+  Payload.flushBuffer();
+  MessageOffset.flushBuffer();
+  MessageSize.flushBuffer();
+  Timestamp.flushBuffer();
+  KafkaOffset.flushBuffer();
+  KafkaPartition.flushBuffer();
+  KafkaTimestamp.flushBuffer();
+}
+
+ArchiveReader::ArchiveReader(hdf5::node::Group const &HDFGroup)
+    : Payload(HDFGroup.get_dataset("payload")),
+      PayloadSize(Payload.dataspace().size()) {
+  auto read = [&HDFGroup](std::string const &Name, auto &Values) {
+    auto Dataset = HDFGroup.get_dataset(Name);
+    Values.resize(Dataset.dataspace().size());
+    Dataset.read(Values);
+  };
+  read("message_offset", Offsets);
+  read("message_size", Sizes);
+  read("timestamp", Timestamps);
+  read("kafka_offset", KafkaOffsets);
+  read("kafka_partition", KafkaPartitions);
+  read("kafka_timestamp", KafkaTimestamps);
+  NrOfMessages = std::min({Offsets.size(), Sizes.size(), Timestamps.size(),
+                           KafkaOffsets.size(), KafkaPartitions.size(),
+                           KafkaTimestamps.size()});
+}
+
+void ArchiveReader::read(size_t Index, ArchivedMessage &Message) const {
+  if (Index >= NrOfMessages || Offsets[Index] + Sizes[Index] > PayloadSize) {
+    throw std::runtime_error(fmt::format(
+        "Archived message {} is outside of the archived payload.", Index));
+  }
+  Message.Payload.resize(Sizes[Index]);
+  if (Sizes[Index] > 0) {
+    Payload.read(Message.Payload,
+                 hdf5::dataspace::Hyperslab(hdf5::Dimensions{Offsets[Index]},
+                                            hdf5::Dimensions{Sizes[Index]}));
+  }
+  Message.Timestamp = Timestamps[Index];
+  Message.Origin = {KafkaOffsets[Index], KafkaPartitions[Index],
+                    KafkaTimestamps[Index]};
+}
+
+ArchivedMessage ArchiveReader::read(size_t Index) const {
+  ArchivedMessage Message;
+  read(Index, Message);
+  return Message;
+}
+
+} // namespace WriterModule::raw
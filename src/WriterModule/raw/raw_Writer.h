@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+/// \file
+/// \brief Writer module that archives the raw flatbuffer messages of a
+/// source.
+
+#pragma once
+
+#include "FlatbufferMessage.h"
+#include "JsonConfig/Field.h"
+#include "NeXusDataset/NeXusDataset.h"
+#include "WriterModuleBase.h"
+#include <cstdint>
+#include <vector>
+
+namespace WriterModule::raw {
+using FlatbufferMessage = FileWriter::FlatbufferMessage;
+
+/// \brief Archives the messages of a source verbatim, whatever their schema.
+///
+/// Without a "schema" in the configuration, all messages of the topic are
+/// archived instead, including messages that can not be read (e.g. of a
+/// schema unknown to the file-writer or broken).
+///
+/// The messages are appended to the (compressed) byte dataset "payload", with
+/// the position and size of every message in "message_offset" and
+/// "message_size". The timestamp and the Kafka offset, partition and
+/// timestamp of every message are also written. The messages are batched
+/// (by "batch_size" bytes) to write them with few writes. See ArchiveReader
+/// for reading the messages back.
+class raw_Writer : public WriterModule::Base {
+public:
+  raw_Writer() : WriterModule::Base("raw", true, "NXcollection") {}
+
+  /// \brief Writes the batched messages.
+  ~raw_Writer() override;
+
+  void config_post_processing() override;
+
+  /// \brief The flatbuffer id of the archived messages, from the "schema" key
+  /// of the configuration.
+  std::optional<std::string> messageFlatbufferID() const override;
+
+  /// \brief True if no schema is configured.
+  bool writesAllMessagesOfTopic() const override;
+
+  InitResult init_hdf(hdf5::node::Group &HDFGroup) override;
+
+  InitResult reopen(hdf5::node::Group &HDFGroup) override;
+
+  bool writeImpl(FlatbufferMessage const &Message,
+                 bool is_buffered_message) override;
+
+  /// \brief Writes the batched messages before flushing the datasets.
+  void flushBuffers() override;
+
+protected:
+  WritePriority defaultWritePriority() const override {
+    return WritePriority::LOW;
+  }
+
+  /// \brief Write the batched payloads with one write.
+  void writeBatch();
+
+  NeXusDataset::ExtensibleDataset<std::uint8_t> Payload;
+  NeXusDataset::ExtensibleDataset<std::uint64_t> MessageOffset;
+  NeXusDataset::ExtensibleDataset<std::uint32_t> MessageSize;
+  NeXusDataset::ExtensibleDataset<std::int64_t> Timestamp;
+  NeXusDataset::ExtensibleDataset<std::int64_t> KafkaOffset;
+  NeXusDataset::ExtensibleDataset<std::int32_t> KafkaPartition;
+  NeXusDataset::ExtensibleDataset<std::int64_t> KafkaTimestamp;
+  JsonConfig::Field<std::string> Schema{this, "schema", ""};
+  JsonConfig::Field<size_t> ChunkSize{this, "chunk_size", 1024 * 1024};
+  /// The nr of bytes batched before they are written.
+  JsonConfig::Field<size_t> BatchSize{this, "batch_size", 1024 * 1024};
+  std::vector<std::uint8_t> BatchedPayloads;
+  std::uint64_t NrOfBytesArchived{0};
+};
+
+/// \brief A message read back from an archive written by raw_Writer.
+struct ArchivedMessage {
+  std::vector<std::uint8_t> Payload;
+  std::int64_t Timestamp{0};
+  FileWriter::KafkaOrigin Origin;
+};
+
+/// \brief Reads the messages archived in a group one by one, e.g. to replay
+/// them.
+///
+/// Only the positions, sizes, timestamps and Kafka origins of the messages
+/// are kept in memory, the bytes of a message are read (as a hyperslab of the
+/// payload) when the message is read.
+class ArchiveReader {
+public:
+  /// \param HDFGroup The group written by raw_Writer.
+  explicit ArchiveReader(hdf5::node::Group const &HDFGroup);
+
+  /// \brief The number of archived messages.
+  [[nodiscard]] size_t size() const { return NrOfMessages; }
+
+  /// \brief Read a message, reusing the memory of the payload of \p Message.
+  ///
+  /// \param Index The index of the message, in the order they were archived.
+  /// \throws std::runtime_error If the message is outside of the archived
+  /// payload.
+  void read(size_t Index, ArchivedMessage &Message) const;
+
+  ArchivedMessage read(size_t Index) const;
+
+private:
+  hdf5::node::Dataset Payload;
+  hsize_t PayloadSize{0};
+  std::vector<std::uint64_t> Offsets;
+  std::vector<std::uint32_t> Sizes;
+  std::vector<std::int64_t> Timestamps;
+  std::vector<std::int64_t> KafkaOffsets;
+  std::vector<std::int32_t> KafkaPartitions;
+  std::vector<std::int64_t> KafkaTimestamps;
+  size_t NrOfMessages{0};
+};
+
+} // namespace WriterModule::raw
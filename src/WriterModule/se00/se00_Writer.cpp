@@ -14,10 +14,14 @@
 
 #include "helper.h"
 
+#include "HDFAttributes.h"
 #include "HDFOperations.h"
 #include "WriterRegistrar.h"
 #include "se00_Writer.h"
+#include <algorithm>
+#include <cmath>
 #include <se00_data_generated.h>
+#include <tuple>
 
 namespace WriterModule::se00 {
 
@@ -25,16 +29,35 @@ namespace WriterModule::se00 {
 static WriterModule::Registry::Registrar<se00_Writer>
     RegisterSenvWriter("se00", "se00");
 
+se00_Writer::~se00_Writer() {
+  try {
+    writeBatch();
+  } catch (std::exception &E) {
+    Logger::Error("Failed to write the batched values: {}", E.what());
+  }
+}
+
 WriterModule::InitResult se00_Writer::init_hdf(hdf5::node::Group &HDFGroup) {
   try {
     initValueDataset(HDFGroup);
     auto const &CurrentGroup = HDFGroup;
-    Timestamp =
-        NeXusDataset::Time(CurrentGroup, NeXusDataset::Mode::Create, ChunkSize);
-    CueTimestampIndex = NeXusDataset::CueIndex(
-        CurrentGroup, NeXusDataset::Mode::Create, ChunkSize);
+    if (ImplicitTimestamps) {
+      NeXusDataset::ExtensibleDataset<double> Delta(
+          CurrentGroup, "time_delta", NeXusDataset::Mode::Create, ChunkSize,
+          compression("time_delta"));
+      HDFAttributes::writeAttribute(Delta.dataset(), "units",
+                                    std::string("ns"));
+    }
+    // Also created with implicit time stamps, in case they have to be
+    // written explicitly (datasets can not be created in SWMR mode).
+    Timestamp = NeXusDataset::Time(CurrentGroup, NeXusDataset::Mode::Create,
+                                   ChunkSize, compression("time"));
+    CueTimestampIndex =
+        NeXusDataset::CueIndex(CurrentGroup, NeXusDataset::Mode::Create,
+                               ChunkSize, compression("cue_index"));
     CueTimestamp = NeXusDataset::CueTimestampZero(
-        CurrentGroup, NeXusDataset::Mode::Create, ChunkSize);
+        CurrentGroup, NeXusDataset::Mode::Create, ChunkSize,
+        compression("cue_timestamp_zero"));
   } catch (std::exception &E) {
     Logger::Error(
         R"(Unable to initialise fast sample environment data tree in HDF file with error message: "{}")",
@@ -49,11 +72,21 @@ WriterModule::InitResult se00_Writer::reopen(hdf5::node::Group &HDFGroup) {
     auto &CurrentGroup = HDFGroup;
     Value = std::make_unique<NeXusDataset::ExtensibleDatasetBase>(
         CurrentGroup, "value", NeXusDataset::Mode::Open);
+    if (ImplicitTimestamps) {
+      TimeDelta = NeXusDataset::ExtensibleDataset<double>(
+          CurrentGroup, "time_delta", NeXusDataset::Mode::Open);
+    }
     Timestamp = NeXusDataset::Time(CurrentGroup, NeXusDataset::Mode::Open);
+    TimestampsAreImplicit = ImplicitTimestamps && Timestamp.size() == 0;
     CueTimestampIndex =
         NeXusDataset::CueIndex(CurrentGroup, NeXusDataset::Mode::Open);
     CueTimestamp =
         NeXusDataset::CueTimestampZero(CurrentGroup, NeXusDataset::Mode::Open);
+    NrOfValuesWritten = Value->current_size();
+    BatchedValues.reserve(BatchSize * sizeof(std::uint64_t));
+    if (!ImplicitTimestamps) {
+      BatchedTimestamps.reserve(BatchSize);
+    }
   } catch (std::exception &E) {
     Logger::Error(
         R"(Failed to reopen datasets in HDF file with error message: "{}")",
@@ -83,12 +116,28 @@ std::vector<std::uint64_t> GenerateTimeStamps(std::uint64_t OriginTimeStamp,
                                               double TimeDelta,
                                               int NumberOfElements) {
   std::vector<std::uint64_t> ReturnVector(NumberOfElements);
-  for (int i = 0; i < NumberOfElements; i++) {
-    ReturnVector[i] = OriginTimeStamp + std::llround(i * TimeDelta);
-  }
+  GenerateTimeStamps(OriginTimeStamp, TimeDelta, ReturnVector.size(),
+                     ReturnVector.data());
   return ReturnVector;
 }
 
+void GenerateTimeStamps(std::uint64_t OriginTimeStamp, double TimeDelta,
+                        size_t NumberOfElements, std::uint64_t *Result) {
+  if (TimeDelta < 0) {
+    for (size_t i = 0; i < NumberOfElements; i++) {
+      Result[i] = OriginTimeStamp + std::llround(i * TimeDelta);
+    }
+    return;
+  }
+  // For non-negative offsets, truncating offset + 0.5 rounds as std::llround
+  // does, without the library call that keeps the loop from being
+  // vectorised.
+  for (size_t i = 0; i < NumberOfElements; i++) {
+    Result[i] = OriginTimeStamp + static_cast<std::uint64_t>(
+                                      static_cast<double>(i) * TimeDelta + 0.5);
+  }
+}
+
 void msgTypeIsConfigType(se00_Writer::Type ConfigType, ValueUnion MsgType) {
   std::unordered_map<ValueUnion, se00_Writer::Type> TypeComparison{
       {ValueUnion::Int8Array, se00_Writer::Type::int8},
@@ -132,10 +181,51 @@ void msgTypeIsConfigType(se00_Writer::Type ConfigType, ValueUnion MsgType) {
   }
 }
 
+namespace {
+/// \brief The values of a message as bytes, the number of values and the
+/// size of a value.
+template <typename FBArrayType>
+std::tuple<std::uint8_t const *, size_t, size_t>
+valueBytes(FBArrayType const *FBArray) {
+  auto ValuePtr = FBArray->value();
+  return {reinterpret_cast<std::uint8_t const *>(ValuePtr->data()),
+          ValuePtr->size(), sizeof(*ValuePtr->data())};
+}
+
+template <typename Type>
+void appendValues(NeXusDataset::ExtensibleDatasetBase &Dataset,
+                  std::vector<std::uint8_t> const &Values) {
+  hdf5::ArrayAdapter<const Type> Array(
+      reinterpret_cast<const Type *>(Values.data()),
+      Values.size() / sizeof(Type));
+  Dataset.appendArray(Array);
+}
+
+/// \brief Check if the time stamps are the first time stamp plus a multiple
+/// of \p Delta, to within \p Tolerance times \p Delta.
+bool areEvenlySpaced(std::int64_t const *Timestamps, size_t NrOfTimestamps,
+                     double Delta, double Tolerance) {
+  auto const MaxDeviation = Tolerance * std::abs(Delta);
+  for (size_t i = 1; i < NrOfTimestamps; i++) {
+    auto Offset = static_cast<double>(Timestamps[i] - Timestamps[0]);
+    if (std::abs(Offset - static_cast<double>(i) * Delta) > MaxDeviation) {
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace
+
 bool se00_Writer::writeImpl(const FileWriter::FlatbufferMessage &Message,
-                            [[maybe_unused]] bool is_buffered_message) {
+                            bool is_buffered_message) {
+  return prepareImpl(Message, is_buffered_message)();
+}
+
+WriterModule::WriteStage
+se00_Writer::prepareImpl(const FileWriter::FlatbufferMessage &Message,
+                         [[maybe_unused]] bool is_buffered_message) {
   auto FbPointer = Getse00_SampleEnvironmentData(Message.data());
-  auto CueIndexValue = Value->current_size();
+  auto CueIndexValue = NrOfValuesWritten;
   auto ValuesType = FbPointer->values_type();
 
   if (!HasCheckedMessageType) {
@@ -143,122 +233,251 @@ bool se00_Writer::writeImpl(const FileWriter::FlatbufferMessage &Message,
     HasCheckedMessageType = true;
   }
 
+  std::uint8_t const *Data{nullptr};
   size_t NrOfElements{0};
+  size_t ElementSize{0};
   switch (ValuesType) {
-  case ValueUnion::Int8Array: {
-    auto ValuePtr = FbPointer->values_as_Int8Array()->value();
-    NrOfElements = ValuePtr->size();
-    Value->appendArray(hdf5::ArrayAdapter(ValuePtr->data(), NrOfElements));
+  case ValueUnion::Int8Array:
+    std::tie(Data, NrOfElements, ElementSize) =
+        valueBytes(FbPointer->values_as_Int8Array());
+    break;
+  case ValueUnion::UInt8Array:
+    std::tie(Data, NrOfElements, ElementSize) =
+        valueBytes(FbPointer->values_as_UInt8Array());
+    break;
+  case ValueUnion::Int16Array:
+    std::tie(Data, NrOfElements, ElementSize) =
+        valueBytes(FbPointer->values_as_Int16Array());
+    break;
+  case ValueUnion::UInt16Array:
+    std::tie(Data, NrOfElements, ElementSize) =
+        valueBytes(FbPointer->values_as_UInt16Array());
+    break;
+  case ValueUnion::Int32Array:
+    std::tie(Data, NrOfElements, ElementSize) =
+        valueBytes(FbPointer->values_as_Int32Array());
+    break;
+  case ValueUnion::UInt32Array:
+    std::tie(Data, NrOfElements, ElementSize) =
+        valueBytes(FbPointer->values_as_UInt32Array());
+    break;
+  case ValueUnion::Int64Array:
+    std::tie(Data, NrOfElements, ElementSize) =
+        valueBytes(FbPointer->values_as_Int64Array());
+    break;
+  case ValueUnion::UInt64Array:
+    std::tie(Data, NrOfElements, ElementSize) =
+        valueBytes(FbPointer->values_as_UInt64Array());
+    break;
+  case ValueUnion::FloatArray:
+    std::tie(Data, NrOfElements, ElementSize) =
+        valueBytes(FbPointer->values_as_FloatArray());
+    break;
+  case ValueUnion::DoubleArray:
+    std::tie(Data, NrOfElements, ElementSize) =
+        valueBytes(FbPointer->values_as_DoubleArray());
     break;
-  }
-  case ValueUnion::UInt8Array: {
-    auto ValuePtr = FbPointer->values_as_UInt8Array()->value();
-    NrOfElements = ValuePtr->size();
-    Value->appendArray(hdf5::ArrayAdapter(ValuePtr->data(), NrOfElements));
-  } break;
-  case ValueUnion::Int16Array: {
-    auto ValuePtr = FbPointer->values_as_Int16Array()->value();
-    NrOfElements = ValuePtr->size();
-    Value->appendArray(hdf5::ArrayAdapter(ValuePtr->data(), NrOfElements));
-  } break;
-  case ValueUnion::UInt16Array: {
-    auto ValuePtr = FbPointer->values_as_UInt16Array()->value();
-    NrOfElements = ValuePtr->size();
-    Value->appendArray(hdf5::ArrayAdapter(ValuePtr->data(), NrOfElements));
-  } break;
-  case ValueUnion::Int32Array: {
-    auto ValuePtr = FbPointer->values_as_Int32Array()->value();
-    NrOfElements = ValuePtr->size();
-    Value->appendArray(hdf5::ArrayAdapter(ValuePtr->data(), NrOfElements));
-  } break;
-  case ValueUnion::UInt32Array: {
-    auto ValuePtr = FbPointer->values_as_UInt32Array()->value();
-    NrOfElements = ValuePtr->size();
-    Value->appendArray(hdf5::ArrayAdapter(ValuePtr->data(), NrOfElements));
-  } break;
-  case ValueUnion::Int64Array: {
-    auto ValuePtr = FbPointer->values_as_Int64Array()->value();
-    NrOfElements = ValuePtr->size();
-    Value->appendArray(hdf5::ArrayAdapter(ValuePtr->data(), NrOfElements));
-  } break;
-  case ValueUnion::UInt64Array: {
-    auto ValuePtr = FbPointer->values_as_UInt64Array()->value();
-    NrOfElements = ValuePtr->size();
-    Value->appendArray(hdf5::ArrayAdapter(ValuePtr->data(), NrOfElements));
-  } break;
-  case ValueUnion::FloatArray: {
-    auto ValuePtr = FbPointer->values_as_FloatArray()->value();
-    NrOfElements = ValuePtr->size();
-    Value->appendArray(hdf5::ArrayAdapter(ValuePtr->data(), NrOfElements));
-  } break;
-  case ValueUnion::DoubleArray: {
-    auto ValuePtr = FbPointer->values_as_DoubleArray()->value();
-    NrOfElements = ValuePtr->size();
-    Value->appendArray(hdf5::ArrayAdapter(ValuePtr->data(), NrOfElements));
-  } break;
   default:
     Logger::Info("Unknown data type in flatbuffer.");
   }
   if (NrOfElements == 0) {
-    return false;
+    return []() { return false; };
   }
-  CueTimestampIndex.appendElement(static_cast<std::uint32_t>(CueIndexValue));
-  CueTimestamp.appendElement(FbPointer->packet_timestamp());
+  auto PacketTimestamp = FbPointer->packet_timestamp();
+  auto Delta = FbPointer->time_delta();
 
   // Time-stamps are available in the flatbuffer
+  std::int64_t const *Timestamps{nullptr};
+  size_t NrOfTimestamps{0};
   if (flatbuffers::IsFieldPresent(FbPointer,
                                   se00_SampleEnvironmentData::VT_TIMESTAMPS)) {
-    auto TimestampPtr = FbPointer->timestamps()->data();
-    auto TimestampSize = FbPointer->timestamps()->size();
-    hdf5::ArrayAdapter<const std::int64_t> TSArray(TimestampPtr, TimestampSize);
-    Timestamp.appendArray(TSArray);
-  } else { // If timestamps are not available, generate them
-    std::vector<std::uint64_t> TempTimeStamps(GenerateTimeStamps(
-        FbPointer->packet_timestamp(), FbPointer->time_delta(), NrOfElements));
-    Timestamp.appendArray(TempTimeStamps);
+    Timestamps = FbPointer->timestamps()->data();
+    NrOfTimestamps = FbPointer->timestamps()->size();
   }
-  return true;
+  bool SwitchToExplicit{false};
+  if (TimestampsAreImplicit && NrOfTimestamps > 0) {
+    // The time stamps are only replaced by the first and their spacing if
+    // that gives the same time stamps (to within the tolerance).
+    auto Origin = static_cast<std::uint64_t>(Timestamps[0]);
+    auto Spacing = NrOfTimestamps > 1
+                       ? static_cast<double>(Timestamps[NrOfTimestamps - 1] -
+                                             Timestamps[0]) /
+                             static_cast<double>(NrOfTimestamps - 1)
+                       : 0.0;
+    if (areEvenlySpaced(Timestamps, NrOfTimestamps, Spacing,
+                        ImplicitTimestampsTolerance)) {
+      PacketTimestamp = Origin;
+      Delta = Spacing;
+    } else {
+      Logger::Info("The time stamps of an se00 message are not evenly "
+                   "spaced, writing all time stamps explicitly from now on.");
+      TimestampsAreImplicit = false;
+      SwitchToExplicit = true;
+    }
+  }
+  NrOfValuesWritten += NrOfElements;
+  return [this, ValuesType, Data, NrOfElements, ElementSize, CueIndexValue,
+          PacketTimestamp, Delta, Timestamps, NrOfTimestamps,
+          Implicit = TimestampsAreImplicit, SwitchToExplicit]() {
+    if (SwitchToExplicit) {
+      writeImplicitTimestamps(CueIndexValue);
+    }
+    batchValues(ValuesType, Data, NrOfElements, ElementSize);
+    CueTimestampIndex.appendElement(static_cast<std::uint32_t>(CueIndexValue));
+    CueTimestamp.appendElement(PacketTimestamp);
+    if (Implicit) {
+      TimeDelta.appendElement(Delta);
+    } else if (Timestamps != nullptr) {
+      BatchedTimestamps.insert(BatchedTimestamps.end(), Timestamps,
+                               Timestamps + NrOfTimestamps);
+    } else {
+      // If timestamps are not available, generate them
+      auto Offset = BatchedTimestamps.size();
+      BatchedTimestamps.resize(Offset + NrOfElements);
+      GenerateTimeStamps(PacketTimestamp, Delta, NrOfElements,
+                         BatchedTimestamps.data() + Offset);
+    }
+    if (NrOfBatchedValues >= BatchSize) {
+      writeBatch();
+    }
+    return true;
+  };
+}
+
+void se00_Writer::writeImplicitTimestamps(hssize_t NrOfValues) {
+  std::vector<std::uint32_t> FirstIndices(CueTimestampIndex.size());
+  std::vector<std::uint64_t> Origins(CueTimestamp.size());
+  std::vector<double> Deltas(TimeDelta.size());
+  if (Deltas.empty()) {
+    return;
+  }
+  CueTimestampIndex.read_data(FirstIndices);
+  CueTimestamp.read_data(Origins);
+  TimeDelta.read_data(Deltas);
+  auto NrOfMessages = std::min({FirstIndices.size(), Origins.size(),
+                                Deltas.size()});
+  std::vector<std::uint64_t> Timestamps(static_cast<size_t>(NrOfValues));
+  for (size_t i = 0; i < NrOfMessages; i++) {
+    auto First = std::min<size_t>(FirstIndices[i], Timestamps.size());
+    auto End = i + 1 < NrOfMessages
+                   ? std::min<size_t>(FirstIndices[i + 1], Timestamps.size())
+                   : Timestamps.size();
+    if (End > First) {
+      GenerateTimeStamps(Origins[i], Deltas[i], End - First,
+                         Timestamps.data() + First);
+    }
+  }
+  Timestamp.appendArray(Timestamps);
+}
+
+void se00_Writer::batchValues(ValueUnion ValuesType, std::uint8_t const *Data,
+                              size_t NrOfElements, size_t ElementSize) {
+  if (ValuesType != BatchedValuesType) {
+    writeBatch();
+    BatchedValuesType = ValuesType;
+  }
+  BatchedValues.insert(BatchedValues.end(), Data,
+                       Data + NrOfElements * ElementSize);
+  NrOfBatchedValues += NrOfElements;
+}
+
+void se00_Writer::writeBatch() {
+  if (!BatchedValues.empty() && Value) {
+    switch (BatchedValuesType) {
+    case ValueUnion::Int8Array:
+      appendValues<std::int8_t>(*Value, BatchedValues);
+      break;
+    case ValueUnion::UInt8Array:
+      appendValues<std::uint8_t>(*Value, BatchedValues);
+      break;
+    case ValueUnion::Int16Array:
+      appendValues<std::int16_t>(*Value, BatchedValues);
+      break;
+    case ValueUnion::UInt16Array:
+      appendValues<std::uint16_t>(*Value, BatchedValues);
+      break;
+    case ValueUnion::Int32Array:
+      appendValues<std::int32_t>(*Value, BatchedValues);
+      break;
+    case ValueUnion::UInt32Array:
+      appendValues<std::uint32_t>(*Value, BatchedValues);
+      break;
+    case ValueUnion::Int64Array:
+      appendValues<std::int64_t>(*Value, BatchedValues);
+      break;
+    case ValueUnion::UInt64Array:
+      appendValues<std::uint64_t>(*Value, BatchedValues);
+      break;
+    case ValueUnion::FloatArray:
+      appendValues<float>(*Value, BatchedValues);
+      break;
+    case ValueUnion::DoubleArray:
+      appendValues<double>(*Value, BatchedValues);
+      break;
+    default:
+      break;
+    }
+  }
+  BatchedValues.clear();
+  NrOfBatchedValues = 0;
+  if (!BatchedTimestamps.empty()) {
+    Timestamp.appendArray(BatchedTimestamps);
+    BatchedTimestamps.clear();
+  }
+}
+
+void se00_Writer::flushBuffers() {
+  writeBatch();
+  if (Value) {
+    Value->flushBuffer();
+  }
+  Timestamp.flushBuffer();
+  TimeDelta.flushBuffer();
+  CueTimestampIndex.flushBuffer();
+  CueTimestamp.flushBuffer();
 }
 
 template <typename Type>
 std::unique_ptr<NeXusDataset::ExtensibleDatasetBase>
-makeIt(hdf5::node::Group const &Parent, size_t const &ChunkSize) {
+makeIt(hdf5::node::Group const &Parent, size_t const &ChunkSize,
+       NeXusDataset::Compression const &Settings) {
   return std::make_unique<NeXusDataset::ExtensibleDataset<Type>>(
-      Parent, "value", NeXusDataset::Mode::Create, ChunkSize);
+      Parent, "value", NeXusDataset::Mode::Create, ChunkSize, Settings);
 }
 
 void se00_Writer::initValueDataset(hdf5::node::Group const &Parent) {
   std::unique_ptr<NeXusDataset::ExtensibleDatasetBase> temporary = nullptr;
+  auto Settings = compression("value");
   switch (ElementType) {
   case Type::int8:
-    temporary = makeIt<std::int8_t>(Parent, ChunkSize);
+    temporary = makeIt<std::int8_t>(Parent, ChunkSize, Settings);
     break;
   case Type::uint8:
-    temporary = makeIt<std::uint8_t>(Parent, ChunkSize);
+    temporary = makeIt<std::uint8_t>(Parent, ChunkSize, Settings);
     break;
   case Type::int16:
-    temporary = makeIt<std::int16_t>(Parent, ChunkSize);
+    temporary = makeIt<std::int16_t>(Parent, ChunkSize, Settings);
     break;
   case Type::uint16:
-    temporary = makeIt<std::uint16_t>(Parent, ChunkSize);
+    temporary = makeIt<std::uint16_t>(Parent, ChunkSize, Settings);
     break;
   case Type::int32:
-    temporary = makeIt<std::int32_t>(Parent, ChunkSize);
+    temporary = makeIt<std::int32_t>(Parent, ChunkSize, Settings);
     break;
   case Type::uint32:
-    temporary = makeIt<std::uint32_t>(Parent, ChunkSize);
+    temporary = makeIt<std::uint32_t>(Parent, ChunkSize, Settings);
     break;
   case Type::int64:
-    temporary = makeIt<std::int64_t>(Parent, ChunkSize);
+    temporary = makeIt<std::int64_t>(Parent, ChunkSize, Settings);
     break;
   case Type::uint64:
-    temporary = makeIt<std::uint64_t>(Parent, ChunkSize);
+    temporary = makeIt<std::uint64_t>(Parent, ChunkSize, Settings);
     break;
   case Type::float32:
-    temporary = makeIt<std::float_t>(Parent, ChunkSize);
+    temporary = makeIt<std::float_t>(Parent, ChunkSize, Settings);
     break;
   case Type::float64:
-    temporary = makeIt<std::double_t>(Parent, ChunkSize);
+    temporary = makeIt<std::double_t>(Parent, ChunkSize, Settings);
     break;
   }
   Value.swap(temporary);
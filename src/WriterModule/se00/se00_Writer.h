@@ -20,6 +20,7 @@
 #include "Msg.h"
 #include "NeXusDataset/NeXusDataset.h"
 #include "WriterModuleBase.h"
+#include <se00_data_generated.h>
 
 namespace WriterModule {
 namespace se00 {
@@ -30,13 +31,20 @@ std::vector<std::uint64_t> GenerateTimeStamps(std::uint64_t OriginTimeStamp,
                                               double TimeDelta,
                                               int NumberOfElements);
 
+/// \brief Generate linearly spaced time stamps into a buffer.
+///
+/// \param Result Must have room for NumberOfElements time stamps.
+void GenerateTimeStamps(std::uint64_t OriginTimeStamp, double TimeDelta,
+                        size_t NumberOfElements, std::uint64_t *Result);
+
 /// See parent class for documentation.
 class se00_Writer : public FileWriterBase {
 public:
   se00_Writer()
       : FileWriterBase("se00", false, "NXlog",
                        {"epics_con_info", "alarm_info"}) {}
-  ~se00_Writer() override = default;
+  /// \brief Writes the values and time stamps waiting to be written.
+  ~se00_Writer() override;
 
   void config_post_processing() override;
 
@@ -47,6 +55,16 @@ public:
   bool writeImpl(FlatbufferMessage const &Message,
                  bool is_buffered_message) override;
 
+  /// \brief Set up the cue, the write stage adds the values and time stamps
+  /// (generated if needed) to the batch that is written to file.
+  WriteStage prepareImpl(FlatbufferMessage const &Message,
+                         bool is_buffered_message) override;
+
+  bool hasPreparationStage() const override { return true; }
+
+  /// \brief Also writes the batched values and time stamps.
+  void flushBuffers() override;
+
   enum class Type {
     int8,
     uint8,
@@ -62,14 +80,47 @@ public:
 
 protected:
   void initValueDataset(hdf5::node::Group const &Parent);
+  /// \brief Add the values of a message to the batch.
+  void batchValues(ValueUnion ValuesType, std::uint8_t const *Data,
+                   size_t NrOfElements, size_t ElementSize);
+  /// \brief Write the batched values and time stamps with one write each.
+  void writeBatch();
+  /// \brief Write the time stamps of the first \p NrOfValues values, which
+  /// were written with implicit time stamps, to the time dataset.
+  void writeImplicitTimestamps(hssize_t NrOfValues);
   Type ElementType{Type::int64};
   std::unique_ptr<NeXusDataset::ExtensibleDatasetBase> Value;
   NeXusDataset::Time Timestamp;
   NeXusDataset::CueIndex CueTimestampIndex;
   NeXusDataset::CueTimestampZero CueTimestamp;
+  /// The time between the values of every message, only written if the time
+  /// stamps are implicit.
+  NeXusDataset::ExtensibleDataset<double> TimeDelta;
   JsonConfig::Field<size_t> ChunkSize{this, "chunk_size", 4096};
   JsonConfig::Field<std::string> DataType{this, {"type", "dtype"}, "int64"};
+  /// The nr of values batched before they are written.
+  JsonConfig::Field<size_t> BatchSize{this, "batch_size", 4096};
+  /// Store the time of the first value and the time between the values of
+  /// every message instead of the time of every value. After the first
+  /// message with time stamps that are not evenly spaced, the time of every
+  /// value is stored.
+  JsonConfig::Field<bool> ImplicitTimestamps{this, "implicit_timestamps",
+                                             false};
+  /// The max deviation of a time stamp from being evenly spaced, relative to
+  /// the time between the values, for it to be stored implicitly.
+  JsonConfig::Field<double> ImplicitTimestampsTolerance{
+      this, "implicit_timestamps_tolerance", 0.01};
+  /// Only used by prepareImpl().
+  bool TimestampsAreImplicit{false};
   bool HasCheckedMessageType{false};
+  /// The values and time stamps waiting to be written, the buffers are
+  /// reused.
+  ValueUnion BatchedValuesType{ValueUnion::NONE};
+  std::vector<std::uint8_t> BatchedValues;
+  size_t NrOfBatchedValues{0};
+  std::vector<std::uint64_t> BatchedTimestamps;
+  /// Kept in memory to not have to query the dataset when preparing writes.
+  hssize_t NrOfValuesWritten{0};
 };
 } // namespace se00
 } // namespace WriterModule
@@ -82,4 +82,10 @@ bool tdct_Writer::writeImpl(const FileWriter::FlatbufferMessage &Message,
   return true;
 }
 
+void tdct_Writer::flushBuffers() {
+  Timestamp.flushBuffer();
+  CueTimestampIndex.flushBuffer();
+  CueTimestamp.flushBuffer();
+}
+
 } // namespace WriterModule::tdct
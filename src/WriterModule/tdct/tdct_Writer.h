@@ -37,6 +37,8 @@ public:
   bool writeImpl(FlatbufferMessage const &Message,
                  bool is_buffered_message) override;
 
+  void flushBuffers() override;
+
 protected:
   NeXusDataset::Time Timestamp;
   NeXusDataset::CueIndex CueTimestampIndex;
@@ -9,8 +9,37 @@
 
 #include "WriterModuleBase.h"
 #include "WriterRegistrar.h"
+#include <algorithm>
+#include <cctype>
 
 namespace WriterModule {
+
+std::optional<WritePriority> writePriorityFromString(std::string Name) {
+  std::transform(Name.begin(), Name.end(), Name.begin(),
+                 [](auto C) { return std::tolower(C); });
+  std::map<std::string, WritePriority> PriorityMap{
+      {"high", WritePriority::HIGH},
+      {"normal", WritePriority::NORMAL},
+      {"low", WritePriority::LOW}};
+  if (auto Found = PriorityMap.find(Name); Found != PriorityMap.end()) {
+    return Found->second;
+  }
+  return std::nullopt;
+}
+
+std::optional<DropPolicy> dropPolicyFromString(std::string Name) {
+  std::transform(Name.begin(), Name.end(), Name.begin(),
+                 [](auto C) { return std::tolower(C); });
+  std::map<std::string, DropPolicy> PolicyMap{
+      {"never", DropPolicy::NEVER},
+      {"drop_oldest", DropPolicy::DROP_OLDEST},
+      {"keep_every_nth", DropPolicy::KEEP_EVERY_NTH}};
+  if (auto Found = PolicyMap.find(Name); Found != PolicyMap.end()) {
+    return Found->second;
+  }
+  return std::nullopt;
+}
+
 Base::Base(std::string_view WriterModuleId, bool AcceptRepeatedTimestamps,
            std::string_view const &NX_class,
            std::vector<std::string> ExtraModules)
@@ -30,4 +59,92 @@ Base::Base(std::string_view WriterModuleId, bool AcceptRepeatedTimestamps,
     }
   }
 }
+
+void Base::process_write_priority() {
+  if (WritePriorityName.get_value().empty()) {
+    return;
+  }
+  ConfiguredWritePriority = writePriorityFromString(WritePriorityName);
+  if (!ConfiguredWritePriority) {
+    Logger::Error(
+        R"(Unknown write priority "{}" (module={} source={}), using the module default.)",
+        WritePriorityName.get_value(), WriterModuleId, SourceName.get_value());
+  }
+}
+
+void Base::process_drop_policy() {
+  auto Policy = dropPolicyFromString(DropPolicyName);
+  if (!Policy) {
+    Logger::Error(
+        R"(Unknown drop policy "{}" (module={} source={}), messages will never be dropped.)",
+        DropPolicyName.get_value(), WriterModuleId, SourceName.get_value());
+    return;
+  }
+  ConfiguredDropPolicy = *Policy;
+}
+
+NeXusDataset::Compression
+Base::compression(std::string const &DatasetName) const {
+  auto FilterName = CompressionName.get_value();
+  auto Level = CompressionLevel.get_value();
+  auto Shuffle = CompressionShuffle.get_value();
+  try {
+    auto const &PerDataset = DatasetCompression.get_value();
+    if (PerDataset.is_object() && PerDataset.contains(DatasetName)) {
+      auto const &DatasetSettings = PerDataset.at(DatasetName);
+      FilterName = DatasetSettings.value("compression", FilterName);
+      Level = DatasetSettings.value("compression_level", Level);
+      Shuffle = DatasetSettings.value("shuffle", Shuffle);
+    }
+  } catch (nlohmann::json::exception const &E) {
+    Logger::Error(
+        R"(Invalid compression settings for dataset "{}" (module={} source={}): {})",
+        DatasetName, WriterModuleId, SourceName.get_value(), E.what());
+    return {};
+  }
+  auto Filter = NeXusDataset::compressionFilterFromString(FilterName);
+  if (!Filter) {
+    Logger::Error(
+        R"(Unknown compression filter "{}" (module={} source={}), the data will not be compressed.)",
+        FilterName, WriterModuleId, SourceName.get_value());
+    return {};
+  }
+  return {*Filter, Level, Shuffle};
+}
+
+void Base::countDroppedMessage(size_t Bytes) {
+  std::lock_guard Lock(DropCountMutex);
+  ++DroppedMessages;
+  DroppedBytes += Bytes;
+  DroppedMessagesMetaData.setValue(DroppedMessages);
+  DroppedBytesMetaData.setValue(DroppedBytes);
+}
+
+void Base::countDuplicateMessage() {
+  std::lock_guard Lock(DropCountMutex);
+  ++DuplicateMessages;
+  DuplicateMessagesMetaData.setValue(DuplicateMessages);
+}
+
+void Base::register_load_shedding_meta_data(
+    hdf5::node::Group const &HDFGroup, MetaData::TrackerPtr const &Tracker) {
+  std::lock_guard Lock(DropCountMutex);
+  if (dedupWindow() > 0) {
+    DuplicateMessagesMetaData =
+        MetaData::Value<int64_t>(HDFGroup, "duplicate_messages");
+    DuplicateMessagesMetaData.setValue(DuplicateMessages);
+    Tracker->registerMetaData(DuplicateMessagesMetaData);
+  }
+  if (ConfiguredDropPolicy == DropPolicy::NEVER) {
+    return;
+  }
+  DroppedMessagesMetaData =
+      MetaData::Value<int64_t>(HDFGroup, "dropped_messages");
+  DroppedMessagesMetaData.setValue(DroppedMessages);
+  Tracker->registerMetaData(DroppedMessagesMetaData);
+  DroppedBytesMetaData = MetaData::Value<int64_t>(HDFGroup, "dropped_bytes");
+  DroppedBytesMetaData.setValue(DroppedBytes);
+  Tracker->registerMetaData(DroppedBytesMetaData);
+}
+
 } // namespace WriterModule
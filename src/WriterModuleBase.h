@@ -13,14 +13,55 @@
 #include "JsonConfig/Field.h"
 #include "JsonConfig/FieldHandler.h"
 #include "MetaData/Tracker.h"
+#include "NeXusDataset/Compression.h"
+#include "TimeUtility.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <h5cpp/hdf5.hpp>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <string_view>
 
 namespace WriterModule {
 enum class InitResult { ERROR = -1, OK = 0 };
 
+/// \brief Scheduling class used by the writer thread for writes of a module.
+///
+/// Writes are queued in one lane per priority class and the lanes are serviced
+/// with weighted round-robin, see Stream::MessageWriter. This keeps low-rate
+/// (e.g. slow-control) data from being starved by high-rate (e.g. event) data.
+enum class WritePriority { HIGH = 0, NORMAL = 1, LOW = 2 };
+
+/// \brief Get the write priority corresponding to a (case-insensitive) name.
+///
+/// \param Name One of "high", "normal" or "low".
+/// \return The write priority, std::nullopt if the name is unknown.
+std::optional<WritePriority> writePriorityFromString(std::string Name);
+
+/// \brief What to do with the messages of a stream when load shedding.
+///
+/// Load shedding is activated (if enabled) when the writer thread can not
+/// keep up with the incoming data, see Stream::MessageWriter.
+/// - NEVER: Write all messages.
+/// - DROP_OLDEST: Only keep the most recent queued messages, older queued
+///   messages are dropped.
+/// - KEEP_EVERY_NTH: Only queue every Nth message.
+enum class DropPolicy { NEVER, DROP_OLDEST, KEEP_EVERY_NTH };
+
+/// \brief Get the drop policy corresponding to a (case-insensitive) name.
+///
+/// \param Name One of "never", "drop_oldest" or "keep_every_nth".
+/// \return The drop policy, std::nullopt if the name is unknown.
+std::optional<DropPolicy> dropPolicyFromString(std::string Name);
+
+/// \brief The part of a write that does the HDF5 calls.
+///
+/// Produced by Base::prepareWrite(), returns true if something was written.
+using WriteStage = std::function<bool()>;
+
 /// \brief Writes a given flatbuffer to HDF.
 ///
 /// Base class for the writer modules which are responsible for actually
@@ -64,6 +105,8 @@ public:
   /// stream.
   void parse_config(std::string const &ConfigurationStream) {
     ConfigHandler.processConfigData(ConfigurationStream);
+    process_write_priority();
+    process_drop_policy();
     config_post_processing();
   }
 
@@ -124,6 +167,58 @@ public:
   virtual bool writeImpl(FileWriter::FlatbufferMessage const &Message,
                          bool is_buffered_message) = 0;
 
+  /// \brief Do the CPU bound part of processing a message.
+  ///
+  /// Called in message order for a writer module but possibly on another
+  /// thread than the one doing the HDF5 calls. Never called concurrently
+  /// for the same writer module.
+  /// \param Message The message to process. Guaranteed to outlive the call
+  /// of the returned stage.
+  /// \return The part of the write that does the HDF5 calls, to be passed
+  /// to commitWrite().
+  WriteStage prepareWrite(FileWriter::FlatbufferMessage const &Message,
+                          bool is_buffered_message) {
+    return prepareImpl(Message, is_buffered_message);
+  }
+
+  /// \brief Do the HDF5 calls of a write prepared by prepareWrite().
+  void commitWrite(WriteStage const &Stage) {
+    if (Stage && Stage()) {
+      WriteCount++;
+    }
+  }
+
+  /// \brief True if the writer module implements prepareImpl().
+  ///
+  /// The writes of other writer modules are done directly by the writer
+  /// thread, without a preparation step.
+  [[nodiscard]] virtual bool hasPreparationStage() const { return false; }
+
+  /// \brief Split the processing of a message into a preparation step and a
+  /// write stage.
+  ///
+  /// The default implementation defers all of the work to writeImpl() in the
+  /// write stage. Writer modules with a significant amount of processing
+  /// (e.g. transforming or collecting data) should do it here instead,
+  /// implement writeImpl() as `return prepareImpl(Message, Buffered)();` and
+  /// return true from hasPreparationStage().
+  /// Must not access any HDF5 objects, the returned stage must only access
+  /// HDF5 objects and state not touched by later prepareImpl() calls.
+  virtual WriteStage prepareImpl(FileWriter::FlatbufferMessage const &Message,
+                                 bool is_buffered_message) {
+    return [this, &Message, is_buffered_message]() {
+      return writeImpl(Message, is_buffered_message);
+    };
+  }
+
+  /// \brief Write data buffered in memory by the writer module (e.g. by
+  /// NeXusDataset::ExtensibleDatasetBase::appendElement()) to file.
+  ///
+  /// Called by the writer thread before flushing the file. Writer modules
+  /// must write any buffered data here for it to become visible to (SWMR)
+  /// readers.
+  virtual void flushBuffers() {}
+
   void registerField(JsonConfig::FieldBase *Ptr) {
     ConfigHandler.registerField(Ptr);
   }
@@ -142,19 +237,204 @@ public:
   /// \brief Determine if this writer module can spawn extra writer modules.
   auto hasExtraModules() const { return !FoundExtraModules.empty(); }
 
+  /// \brief Get the names of the sources (on the same topic), other than the
+  /// one of the stream, of which the messages are also written by this
+  /// writer module.
+  virtual std::vector<std::string> additionalSources() const { return {}; }
+
+  /// \brief Get the flatbuffer id of the messages written by this writer
+  /// module, if it is not the id the module is registered with (e.g. for a
+  /// module that writes the messages of any schema).
+  virtual std::optional<std::string> messageFlatbufferID() const {
+    return std::nullopt;
+  }
+
+  /// \brief True if the writer module writes all messages of its topic,
+  /// whatever their source, including messages that can not be read (e.g.
+  /// of an unknown schema or broken). Such messages are not valid and only
+  /// their data, timestamp (the Kafka timestamp) and Kafka origin are set.
+  virtual bool writesAllMessagesOfTopic() const { return false; }
+
   /// \brief Get the number of writes performed by the module.
   auto getWriteCount() const { return WriteCount; }
 
+  /// \brief The priority class used when queueing writes for this module.
+  ///
+  /// Set by the "write_priority" key of the stream configuration. If not set,
+  /// the default of the writer module is used.
+  WritePriority writePriority() const {
+    return ConfiguredWritePriority.value_or(defaultWritePriority());
+  }
+
+  /// \brief The load shedding policy, set by the "drop_policy" key of the
+  /// stream configuration.
+  DropPolicy dropPolicy() const { return ConfiguredDropPolicy; }
+
+  /// \brief Max nr of queued messages kept with DropPolicy::DROP_OLDEST.
+  uint64_t dropKeepNewest() const {
+    return std::max(DropKeepNewest.get_value(), uint64_t(1));
+  }
+
+  /// \brief The N of DropPolicy::KEEP_EVERY_NTH.
+  uint64_t dropKeepEveryNth() const {
+    return std::max(DropKeepEveryNth.get_value(), uint64_t(1));
+  }
+
+  /// \brief Get the sequence number of a message that is being queued.
+  uint64_t nextQueueSequenceNumber() { return NrOfMessagesQueued++; }
+
+  /// \brief Nr of messages queued for this module (over time).
+  uint64_t nrOfMessagesQueued() const { return NrOfMessagesQueued; }
+
+  /// \brief Count a message of this module that was taken from the write
+  /// queue (to be written or dropped).
+  ///
+  /// Thread safe.
+  /// \param QueueTime The time the message spent in the queue.
+  void countDequeuedMessage(duration QueueTime) {
+    ++NrOfMessagesDequeued;
+    LastQueueTime = QueueTime.count();
+  }
+
+  /// \brief The (approximate) nr of messages of this module in the write
+  /// queue.
+  uint64_t nrOfMessagesInQueue() const {
+    auto Dequeued = NrOfMessagesDequeued.load();
+    auto Queued = NrOfMessagesQueued.load();
+    return Queued > Dequeued ? Queued - Dequeued : 0;
+  }
+
+  /// \brief The time the last message taken from the write queue spent in
+  /// it.
+  duration lastQueueTime() const { return duration(LastQueueTime.load()); }
+
+  /// \brief Determine if a message is kept when load shedding with
+  /// DropPolicy::KEEP_EVERY_NTH.
+  bool keepWhileSheddingLoad() {
+    return NrOfMessagesWhileSheddingLoad++ % dropKeepEveryNth() == 0;
+  }
+
+  /// \brief Count a message dropped due to load shedding.
+  ///
+  /// Thread safe.
+  void countDroppedMessage(size_t Bytes);
+
+  int64_t nrOfDroppedMessages() const {
+    std::lock_guard Lock(DropCountMutex);
+    return DroppedMessages;
+  }
+  int64_t nrOfDroppedBytes() const {
+    std::lock_guard Lock(DropCountMutex);
+    return DroppedBytes;
+  }
+
+  /// \brief Count a duplicate message dropped by the source filter, see
+  /// dedupWindow().
+  ///
+  /// Thread safe.
+  void countDuplicateMessage();
+
+  int64_t nrOfDuplicateMessages() const {
+    std::lock_guard Lock(DropCountMutex);
+    return DuplicateMessages;
+  }
+
+  /// \brief The nr of (recent) messages that the source filter remembers to
+  /// detect duplicates of, 0 to not detect duplicates.
+  ///
+  /// Set by the "dedup_window" key of the stream configuration, see
+  /// Stream::DuplicateFilter.
+  size_t dedupWindow() const {
+    return static_cast<size_t>(DedupWindow.get_value());
+  }
+
+  /// \brief Register the meta data fields for the number of messages and
+  /// bytes dropped due to load shedding and the number of duplicate messages
+  /// dropped.
+  ///
+  /// The former are only registered if the drop policy is not
+  /// DropPolicy::NEVER, the latter only if duplicates are detected.
+  void register_load_shedding_meta_data(hdf5::node::Group const &HDFGroup,
+                                        MetaData::TrackerPtr const &Tracker);
+
+  /// \brief Max amount of time from writing data to it being flushed to file.
+  ///
+  /// Set (in ms) by the "max_staleness_ms" key of the stream configuration.
+  /// If not set there is no bound, i.e. the data is flushed according to the
+  /// file level flush policy only.
+  std::optional<duration> maxStaleness() const {
+    if (MaxStalenessMs.get_value() > 0) {
+      return std::chrono::milliseconds(MaxStalenessMs.get_value());
+    }
+    return std::nullopt;
+  }
+
+  /// \brief The max nr of messages in the reorder window of the source of
+  /// the stream, 0 for no limit.
+  ///
+  /// Set by the "reorder_window_messages" key of the stream configuration.
+  /// Messages are only reordered if this or reorderWindowTime() is set, see
+  /// Stream::ReorderBuffer.
+  size_t reorderWindowMessages() const {
+    return static_cast<size_t>(ReorderWindowMessages.get_value());
+  }
+
+  /// \brief The max difference between the timestamps of the messages in the
+  /// reorder window, zero for no limit.
+  ///
+  /// Set (in ms) by the "reorder_window_ms" key of the stream configuration.
+  duration reorderWindowTime() const {
+    return std::chrono::milliseconds(ReorderWindowMs.get_value());
+  }
+
+  /// \brief The compression to use when creating a dataset.
+  ///
+  /// Set by the "compression" (filter name), "compression_level" and
+  /// "shuffle" keys of the stream configuration. These can be overridden per
+  /// dataset with the "dataset_compression" key, an object with dataset
+  /// names as keys and objects with (some of) the same three keys as values.
+  NeXusDataset::Compression compression(std::string const &DatasetName) const;
+
+protected:
+  /// \brief The write priority used if none is set in the configuration.
+  ///
+  /// Writer modules for low-rate data that should be visible to (SWMR)
+  /// readers with little delay should return WritePriority::HIGH, writer
+  /// modules for bulk data should return WritePriority::LOW.
+  virtual WritePriority defaultWritePriority() const {
+    return WritePriority::NORMAL;
+  }
+
 private:
+  void process_write_priority();
+  void process_drop_policy();
+
   // Must appear before any config field object.
   JsonConfig::FieldHandler ConfigHandler;
   std::vector<std::string> FoundExtraModules;
+  std::optional<WritePriority> ConfiguredWritePriority;
+  DropPolicy ConfiguredDropPolicy{DropPolicy::NEVER};
 
 protected:
   std::string_view WriterModuleId;
   JsonConfig::Field<std::string> SourceName{this, "source", ""};
   JsonConfig::Field<std::string> Topic{this, "topic", ""};
   JsonConfig::Field<std::string> WriterModule{this, "writer_module", ""};
+  JsonConfig::Field<std::string> WritePriorityName{this, "write_priority", ""};
+  JsonConfig::Field<int64_t> MaxStalenessMs{this, "max_staleness_ms", 0};
+  JsonConfig::Field<uint64_t> ReorderWindowMessages{
+      this, "reorder_window_messages", 0};
+  JsonConfig::Field<uint64_t> ReorderWindowMs{this, "reorder_window_ms", 0};
+  JsonConfig::Field<uint64_t> DedupWindow{this, "dedup_window", 0};
+  JsonConfig::Field<std::string> DropPolicyName{this, "drop_policy", "never"};
+  JsonConfig::Field<uint64_t> DropKeepNewest{this, "drop_keep_newest", 100};
+  JsonConfig::Field<uint64_t> DropKeepEveryNth{this, "drop_keep_every_nth",
+                                               10};
+  JsonConfig::Field<std::string> CompressionName{this, "compression", "none"};
+  JsonConfig::Field<int> CompressionLevel{this, "compression_level", -1};
+  JsonConfig::Field<bool> CompressionShuffle{this, "shuffle", false};
+  JsonConfig::Field<nlohmann::json> DatasetCompression{
+      this, "dataset_compression", ""};
   std::map<std::string, std::unique_ptr<JsonConfig::Field<bool>>>
       ExtraModuleEnabled;
 
@@ -162,6 +442,18 @@ private:
   bool WriteRepeatedTimestamps;
   std::string_view NX_class;
   std::size_t WriteCount{0};
+  std::atomic<uint64_t> NrOfMessagesQueued{0};
+  std::atomic<uint64_t> NrOfMessagesDequeued{0};
+  std::atomic<duration::rep> LastQueueTime{0};
+  std::atomic<uint64_t> NrOfMessagesWhileSheddingLoad{0};
+  mutable std::mutex DropCountMutex;
+  int64_t DroppedMessages{0};
+  int64_t DroppedBytes{0};
+  MetaData::Value<int64_t> DroppedMessagesMetaData{"", "dropped_messages"};
+  MetaData::Value<int64_t> DroppedBytesMetaData{"", "dropped_bytes"};
+  int64_t DuplicateMessages{0};
+  MetaData::Value<int64_t> DuplicateMessagesMetaData{"",
+                                                     "duplicate_messages"};
 };
 
 class WriterException : public std::runtime_error {
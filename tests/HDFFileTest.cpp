@@ -215,3 +215,26 @@ TEST_F(HDFFile, WithTemplatePathWithInstrumentName) {
     FAIL() << "Expected std::exception";
   }
 }
+
+TEST_F(HDFFile, IncrementalFlushFlushesOneDatasetPerStepWithoutTimeBudget) {
+  FileWriter::HDFFile UnderTest{FileName, NexusStructure, ModuleHDFInfoList,
+                                Tracker,  template_path,  is_legacy_writing};
+  auto RootGroup = UnderTest.hdfGroup();
+  hdf5::property::DatasetCreationList CreationProperties;
+  CreationProperties.layout(hdf5::property::DatasetLayout::Chunked);
+  CreationProperties.chunk({16});
+  auto DataSpace =
+      hdf5::dataspace::Simple({0}, {hdf5::dataspace::Simple::unlimited});
+  std::vector<hdf5::node::Dataset> Datasets;
+  for (int i = 0; i < 3; ++i) {
+    Datasets.emplace_back(RootGroup.create_dataset(
+        "dataset_" + std::to_string(i), hdf5::datatype::create<int>(),
+        DataSpace, CreationProperties));
+  }
+  EXPECT_FALSE(UnderTest.flushIncrementally(0s));
+  EXPECT_FALSE(UnderTest.flushIncrementally(0s));
+  EXPECT_TRUE(UnderTest.flushIncrementally(0s));
+  // A new flush cycle is started after a completed one.
+  EXPECT_FALSE(UnderTest.flushIncrementally(0s));
+  EXPECT_TRUE(UnderTest.flushIncrementally(10s));
+}
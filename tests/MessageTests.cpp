@@ -90,3 +90,17 @@ TEST_F(MessageClassTest, InvalidFlatbuffer) {
   ASSERT_THROW(FlatbufferMessage(TestData.get(), 8),
                FileWriter::NotValidFlatbuffer);
 }
+
+TEST_F(MessageClassTest, UnparsedMessageKeepsDataAndKafkaTimestamp) {
+  std::memcpy(TestData.get() + 4, TestKey.c_str(), 4);
+  MessageMetaData MetaData;
+  MetaData.Timestamp = std::chrono::milliseconds(1000);
+  MetaData.Offset = 7;
+  Msg KafkaMessage(TestData.get(), 8, MetaData);
+  auto CurrentMessage = FlatbufferMessage::unparsed(KafkaMessage);
+  EXPECT_FALSE(CurrentMessage.isValid());
+  EXPECT_EQ(CurrentMessage.size(), size_t(8));
+  EXPECT_EQ(CurrentMessage.getFlatbufferID(), TestKey);
+  EXPECT_EQ(CurrentMessage.getTimestamp(), std::int64_t(1'000'000'000));
+  EXPECT_EQ(CurrentMessage.getKafkaOrigin().Offset, 7);
+}
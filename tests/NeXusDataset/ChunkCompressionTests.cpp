@@ -0,0 +1,156 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#include "NeXusDataset/ChunkCompression.h"
+#include "NeXusDataset/ExtensibleDataset.h"
+#include <cstring>
+#include <gtest/gtest.h>
+#include <h5cpp/hdf5.hpp>
+#include <numeric>
+#include <zlib.h>
+
+namespace {
+std::vector<char> decompress(std::vector<char> const &Compressed,
+                             size_t RawSize) {
+  std::vector<char> Raw(RawSize);
+  uLongf Size = RawSize;
+  EXPECT_EQ(uncompress(reinterpret_cast<Bytef *>(Raw.data()), &Size,
+                       reinterpret_cast<Bytef const *>(Compressed.data()),
+                       Compressed.size()),
+            Z_OK);
+  EXPECT_EQ(Size, RawSize);
+  return Raw;
+}
+
+NeXusDataset::Compression const Deflate{
+    NeXusDataset::CompressionFilter::DEFLATE, 6, false};
+NeXusDataset::Compression const DeflateWithShuffle{
+    NeXusDataset::CompressionFilter::DEFLATE, 6, true};
+} // namespace
+
+TEST(ChunkCompression, OnlyDeflateIsSupported) {
+  EXPECT_TRUE(NeXusDataset::canCompressChunks(Deflate));
+  EXPECT_TRUE(NeXusDataset::canCompressChunks(DeflateWithShuffle));
+  EXPECT_FALSE(NeXusDataset::canCompressChunks({}));
+  EXPECT_FALSE(NeXusDataset::canCompressChunks(
+      {NeXusDataset::CompressionFilter::ZSTD, 3, false}));
+}
+
+TEST(ChunkCompression, DeflatedChunkCanBeDecompressed) {
+  std::vector<char> RawChunk(1000);
+  for (size_t i = 0; i < RawChunk.size(); ++i) {
+    RawChunk[i] = static_cast<char>(i % 7);
+  }
+  auto Compressed = NeXusDataset::compressChunk(RawChunk, Deflate, 4);
+  EXPECT_LT(Compressed.size(), RawChunk.size());
+  EXPECT_EQ(decompress(Compressed, RawChunk.size()), RawChunk);
+}
+
+TEST(ChunkCompression, ShuffledChunkHasBytesGroupedBySignificance) {
+  std::vector<std::uint16_t> Values{0x0102, 0x0304, 0x0506};
+  std::vector<char> RawChunk(Values.size() * sizeof(std::uint16_t));
+  std::memcpy(RawChunk.data(), Values.data(), RawChunk.size());
+  auto Compressed =
+      NeXusDataset::compressChunk(RawChunk, DeflateWithShuffle, 2);
+  auto Shuffled = decompress(Compressed, RawChunk.size());
+  for (size_t i = 0; i < Values.size(); ++i) {
+    EXPECT_EQ(Shuffled[i], RawChunk[i * 2]);
+    EXPECT_EQ(Shuffled[Values.size() + i], RawChunk[i * 2 + 1]);
+  }
+}
+
+TEST(ChunkCompression, PoolCompressesChunks) {
+  NeXusDataset::ChunkCompressionPool Pool(2);
+  std::vector<char> RawChunk(256, 'a');
+  auto Result = Pool.compress(RawChunk, Deflate, 1);
+  EXPECT_EQ(decompress(Result.get(), RawChunk.size()), RawChunk);
+}
+
+class DirectChunkWrites : public ::testing::Test {
+public:
+  void SetUp() override {
+    File = hdf5::file::create(TestFileName, hdf5::file::AccessFlags::Truncate);
+    RootGroup = File.root();
+  };
+
+  void TearDown() override { File.close(); };
+  std::string TestFileName{"DirectChunkWritesTestFile.hdf5"};
+  hdf5::file::File File;
+  hdf5::node::Group RootGroup;
+  NeXusDataset::ChunkCompressionPool Pool{2};
+};
+
+TEST_F(DirectChunkWrites, NotUsedForUncompressedDataset) {
+  NeXusDataset::ExtensibleDataset<std::uint32_t>( // NOLINT
+      RootGroup, "SomeDataset", NeXusDataset::Mode::Create, 16);
+  auto Dataset = RootGroup.get_dataset("SomeDataset");
+  EXPECT_EQ(NeXusDataset::ChunkAssembler::create(Dataset, &Pool, 0), nullptr);
+  EXPECT_EQ(NeXusDataset::ChunkAssembler::create(Dataset, nullptr, 0),
+            nullptr);
+}
+
+TEST_F(DirectChunkWrites, ExtensibleDatasetReadsBackWrittenData) {
+  size_t ChunkSize = 16;
+  std::vector<std::uint32_t> SomeData(10);
+  std::iota(SomeData.begin(), SomeData.end(), 0);
+  std::vector<std::uint32_t> Expected;
+  {
+    NeXusDataset::ExtensibleDataset<std::uint32_t>( // NOLINT
+        RootGroup, "SomeDataset", NeXusDataset::Mode::Create, ChunkSize,
+        DeflateWithShuffle);
+    NeXusDataset::ExtensibleDataset<std::uint32_t> TestDataset(
+        RootGroup, "SomeDataset", NeXusDataset::Mode::Open);
+    TestDataset.useDirectChunkWrites(&Pool);
+    for (int i = 0; i < 7; ++i) {
+      TestDataset.appendArray(SomeData);
+      Expected.insert(Expected.end(), SomeData.begin(), SomeData.end());
+      if (i == 3) {
+        // A flush writes the partial chunk, which is later written again.
+        TestDataset.flushBuffer();
+      }
+    }
+    TestDataset.appendElement(std::uint32_t(42));
+    Expected.push_back(42);
+  }
+  auto Dataset = RootGroup.get_dataset("SomeDataset");
+  std::vector<std::uint32_t> Buffer(Dataset.dataspace().size());
+  Dataset.read(Buffer);
+  EXPECT_EQ(Buffer, Expected);
+}
+
+TEST_F(DirectChunkWrites, OtherDataTypeIsWrittenNormally) {
+  std::vector<std::uint32_t> SomeData{1, 2, 3};
+  std::vector<std::uint16_t> OtherData{4, 5};
+  NeXusDataset::ExtensibleDataset<std::uint32_t> TestDataset(
+      RootGroup, "SomeDataset", NeXusDataset::Mode::Create, 2, Deflate);
+  TestDataset.useDirectChunkWrites(&Pool);
+  TestDataset.appendArray(SomeData);
+  TestDataset.appendArray(OtherData);
+  std::vector<std::uint32_t> Buffer(5);
+  TestDataset.read_data(Buffer);
+  EXPECT_EQ(Buffer, (std::vector<std::uint32_t>{1, 2, 3, 4, 5}));
+}
+
+TEST_F(DirectChunkWrites, MultiDimDatasetReadsBackWrittenFrames) {
+  hdf5::Dimensions FrameShape{3, 2};
+  std::vector<std::int16_t> Expected;
+  NeXusDataset::MultiDimDataset<std::int16_t> TestDataset(
+      RootGroup, "SomeDataset", NeXusDataset::Mode::Create, FrameShape, {12},
+      Deflate);
+  TestDataset.useDirectChunkWrites(&Pool);
+  for (std::int16_t i = 0; i < 5; ++i) {
+    std::vector<std::int16_t> Frame(6, i);
+    TestDataset.appendArray(Frame, FrameShape);
+    Expected.insert(Expected.end(), Frame.begin(), Frame.end());
+  }
+  EXPECT_EQ(TestDataset.dimensions(), (hdf5::Dimensions{5, 3, 2}));
+  std::vector<std::int16_t> Buffer(Expected.size());
+  TestDataset.read(Buffer);
+  EXPECT_EQ(Buffer, Expected);
+}
@@ -13,6 +13,7 @@
 #include <h5cpp/dataspace/simple.hpp>
 #include <h5cpp/datatype/type_trait.hpp>
 #include <h5cpp/hdf5.hpp>
+#include <numeric>
 
 class DatasetCreation : public ::testing::Test {
 public:
@@ -309,6 +310,213 @@ TEST_F(DatasetCreation, AppendArrayAdpaterDataTwice) {
   }
 }
 
+TEST_F(DatasetCreation, AppendedElementsAreBufferedUntilChunkIsFull) {
+  int ChunkSize = 4;
+  NeXusDataset::ExtensibleDataset<std::uint16_t> TestDataset(
+      RootGroup, "SomeDataset", NeXusDataset::Mode::Create, ChunkSize);
+  for (std::uint16_t i = 0; i < 6; ++i) {
+    TestDataset.appendElement(i);
+  }
+  EXPECT_EQ(TestDataset.current_size(), 6);
+  EXPECT_EQ(TestDataset.dataset().dataspace().size(), 4);
+  EXPECT_EQ(TestDataset.nrOfBufferedElements(), 2u);
+  TestDataset.flushBuffer();
+  EXPECT_EQ(TestDataset.dataset().dataspace().size(), 6);
+  EXPECT_EQ(TestDataset.nrOfBufferedElements(), 0u);
+  std::vector<std::uint16_t> Buffer(6);
+  TestDataset.read_data(Buffer);
+  for (std::uint16_t i = 0; i < 6; ++i) {
+    ASSERT_EQ(Buffer.at(i), i);
+  }
+}
+
+TEST_F(DatasetCreation, BufferedElementsAreWrittenBeforeArray) {
+  int ChunkSize = 256;
+  std::array<const std::uint16_t, 2> SomeData{{2, 3}};
+  {
+    NeXusDataset::ExtensibleDataset<std::uint16_t> TestDataset(
+        RootGroup, "SomeDataset", NeXusDataset::Mode::Create, ChunkSize);
+    TestDataset.appendElement(std::uint16_t(0));
+    TestDataset.appendElement(std::int32_t(1));
+    TestDataset.appendArray(SomeData);
+    TestDataset.appendElement(std::uint16_t(4));
+  }
+  std::vector<std::uint16_t> Buffer(5);
+  auto Dataset = RootGroup.get_dataset("SomeDataset");
+  ASSERT_EQ(Dataset.dataspace().size(), 5);
+  Dataset.read(Buffer);
+  for (std::uint16_t i = 0; i < 5; ++i) {
+    ASSERT_EQ(Buffer.at(i), i);
+  }
+}
+
+TEST_F(DatasetCreation, ExtentIsSetToTheElementsWritten) {
+  int ChunkSize = 16;
+  std::array<const std::uint16_t, 4> SomeData{{0, 1, 2, 3}};
+  NeXusDataset::ExtensibleDataset<std::uint16_t> TestDataset(
+      RootGroup, "SomeDataset", NeXusDataset::Mode::Create, ChunkSize);
+  TestDataset.appendArray(SomeData);
+  EXPECT_EQ(TestDataset.current_size(), 4);
+  EXPECT_EQ(TestDataset.dataset().dataspace().size(), 4);
+  for (int i = 0; i < 5; ++i) {
+    TestDataset.appendArray(SomeData);
+  }
+  EXPECT_EQ(TestDataset.current_size(), 24);
+  EXPECT_EQ(TestDataset.dataset().dataspace().size(), 24);
+}
+
+TEST_F(DatasetCreation, AppendElementsAndArraysAcrossFlushes) {
+  int ChunkSize = 16;
+  std::vector<std::uint16_t> SomeData(10);
+  std::iota(SomeData.begin(), SomeData.end(), 0);
+  std::vector<std::uint16_t> Expected;
+  NeXusDataset::ExtensibleDataset<std::uint16_t> TestDataset(
+      RootGroup, "SomeDataset", NeXusDataset::Mode::Create, ChunkSize);
+  for (int i = 0; i < 6; ++i) {
+    TestDataset.appendArray(SomeData);
+    Expected.insert(Expected.end(), SomeData.begin(), SomeData.end());
+    TestDataset.appendElement(std::uint16_t(100 + i));
+    Expected.push_back(100 + i);
+    if (i % 2 == 0) {
+      TestDataset.flushBuffer();
+    }
+  }
+  std::vector<std::uint16_t> Buffer(Expected.size());
+  TestDataset.read_data(Buffer);
+  EXPECT_EQ(Buffer, Expected);
+}
+
+TEST_F(DatasetCreation, MultiDimAppendManyWithGrowingShape) {
+  hdf5::Dimensions DatasetDimensions{2, 2};
+  NeXusDataset::MultiDimDataset<int> Dataset(
+      RootGroup, "value", NeXusDataset::Mode::Create, DatasetDimensions, {});
+  for (int i = 0; i < 3; ++i) {
+    Dataset.appendArray(std::vector<int>(4, i), DatasetDimensions);
+  }
+  Dataset.appendArray(std::vector<int>(6, 3), {2, 3});
+  EXPECT_EQ(Dataset.dimensions(), (hdf5::Dimensions{4, 2, 3}));
+  std::vector<int> StoredData(4 * 2 * 3);
+  Dataset.read(StoredData);
+  std::vector<int> Expected{0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 1, 0,
+                            2, 2, 0, 2, 2, 0, 3, 3, 3, 3, 3, 3};
+  EXPECT_EQ(StoredData, Expected);
+}
+
+TEST_F(DatasetCreation, MultiDimFramesAreWrittenInBatches) {
+  hdf5::Dimensions FrameShape{2, 2};
+  NeXusDataset::MultiDimDataset<int> Dataset(
+      RootGroup, "value", NeXusDataset::Mode::Create, FrameShape, {8, 2, 2});
+  Dataset.setFramesPerWrite(4);
+  std::vector<int> Expected;
+  for (int i = 0; i < 6; ++i) {
+    std::vector<int> Frame(4, i);
+    Dataset.appendArray(Frame, FrameShape);
+    Expected.insert(Expected.end(), Frame.begin(), Frame.end());
+  }
+  EXPECT_EQ(Dataset.nrOfStagedFrames(), 2u);
+  EXPECT_EQ(Dataset.dimensions(), (hdf5::Dimensions{6, 2, 2}));
+  auto WrittenExtent =
+      hdf5::dataspace::Simple(RootGroup.get_dataset("value").dataspace())
+          .current_dimensions();
+  EXPECT_EQ(WrittenExtent, (hdf5::Dimensions{4, 2, 2}));
+  Dataset.flushBuffer();
+  EXPECT_EQ(Dataset.nrOfStagedFrames(), 0u);
+  std::vector<int> StoredData(Expected.size());
+  Dataset.read(StoredData);
+  EXPECT_EQ(StoredData, Expected);
+}
+
+TEST_F(DatasetCreation, MultiDimFramesOfOtherShapeAreNotBatched) {
+  hdf5::Dimensions FrameShape{2, 2};
+  NeXusDataset::MultiDimDataset<int> Dataset(
+      RootGroup, "value", NeXusDataset::Mode::Create, FrameShape, {});
+  Dataset.setFramesPerWrite(4);
+  Dataset.appendArray(std::vector<int>{1, 2, 3, 4}, FrameShape);
+  Dataset.appendArray(std::vector<double>{5, 6, 7, 8}, FrameShape);
+  Dataset.appendArray(std::vector<int>{9, 10}, {1, 2});
+  EXPECT_EQ(Dataset.nrOfStagedFrames(), 0u);
+  EXPECT_EQ(Dataset.dimensions(), (hdf5::Dimensions{3, 2, 2}));
+  std::vector<int> StoredData(12);
+  Dataset.read(StoredData);
+  EXPECT_EQ(StoredData,
+            (std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 0, 0}));
+}
+
+TEST(Compression, FilterFromString) {
+  using NeXusDataset::CompressionFilter;
+  EXPECT_EQ(NeXusDataset::compressionFilterFromString("none"),
+            CompressionFilter::NONE);
+  EXPECT_EQ(NeXusDataset::compressionFilterFromString("Deflate"),
+            CompressionFilter::DEFLATE);
+  EXPECT_EQ(NeXusDataset::compressionFilterFromString("LZ4"),
+            CompressionFilter::LZ4);
+  EXPECT_EQ(NeXusDataset::compressionFilterFromString("zstd"),
+            CompressionFilter::ZSTD);
+  EXPECT_FALSE(NeXusDataset::compressionFilterFromString("gzip9"));
+}
+
+TEST_F(DatasetCreation, UncompressedDatasetHasNoCompressionAttributes) {
+  NeXusDataset::ExtensibleDataset<std::uint16_t> TestDataset(
+      RootGroup, "SomeDataset", NeXusDataset::Mode::Create);
+  EXPECT_FALSE(TestDataset.dataset().attributes.exists("compression"));
+}
+
+TEST_F(DatasetCreation, DeflateCompressedDatasetIsSmaller) {
+  size_t const ChunkSize = 1024;
+  std::vector<std::uint32_t> SomeData(16 * ChunkSize);
+  for (size_t i = 0; i < SomeData.size(); ++i) {
+    SomeData[i] = static_cast<std::uint32_t>(i % 100);
+  }
+  NeXusDataset::Compression Settings{NeXusDataset::CompressionFilter::DEFLATE,
+                                     -1, true};
+  NeXusDataset::ExtensibleDataset<std::uint32_t> Compressed(
+      RootGroup, "Compressed", NeXusDataset::Mode::Create, ChunkSize,
+      Settings);
+  NeXusDataset::ExtensibleDataset<std::uint32_t> Uncompressed(
+      RootGroup, "Uncompressed", NeXusDataset::Mode::Create, ChunkSize);
+  Compressed.appendArray(SomeData);
+  Uncompressed.appendArray(SomeData);
+  Compressed.flushBuffer();
+  Uncompressed.flushBuffer();
+
+  std::string FilterName;
+  Compressed.dataset().attributes["compression"].read(FilterName);
+  EXPECT_EQ(FilterName, "deflate");
+  std::int32_t Level{0};
+  Compressed.dataset().attributes["compression_level"].read(Level);
+  EXPECT_EQ(Level, 6);
+  std::int32_t Shuffle{0};
+  Compressed.dataset().attributes["compression_shuffle"].read(Shuffle);
+  EXPECT_EQ(Shuffle, 1);
+
+  auto CompressedSize =
+      H5Dget_storage_size(static_cast<hid_t>(Compressed.dataset().id()));
+  auto UncompressedSize =
+      H5Dget_storage_size(static_cast<hid_t>(Uncompressed.dataset().id()));
+  EXPECT_LT(CompressedSize * 4, UncompressedSize);
+
+  std::vector<std::uint32_t> ReadBack(SomeData.size());
+  Compressed.dataset().read(ReadBack);
+  EXPECT_EQ(ReadBack, SomeData);
+}
+
+TEST_F(DatasetCreation, BufferedElementsAreNotInTheExtentUntilWritten) {
+  int ChunkSize = 16;
+  std::array<const std::uint16_t, 4> SomeData{{0, 1, 2, 3}};
+  NeXusDataset::ExtensibleDataset<std::uint16_t> TestDataset(
+      RootGroup, "SomeDataset", NeXusDataset::Mode::Create, ChunkSize);
+  TestDataset.appendArray(SomeData);
+  TestDataset.appendElement(std::uint16_t{4});
+  EXPECT_EQ(TestDataset.current_size(), 5);
+  EXPECT_EQ(TestDataset.dataset().dataspace().size(), 4);
+  TestDataset.flushBuffer();
+  EXPECT_EQ(TestDataset.dataset().dataspace().size(), 5);
+  TestDataset.appendElement(std::uint16_t{5});
+  TestDataset.appendArray(SomeData);
+  EXPECT_EQ(TestDataset.current_size(), 10);
+  EXPECT_EQ(TestDataset.dataset().dataspace().size(), 10);
+}
+
 TEST_F(DatasetCreation, StringDatasetDefaultCreation) {
   std::string DatasetName{"SomeName"};
   size_t StringLength{24};
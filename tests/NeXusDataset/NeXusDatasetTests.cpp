@@ -158,7 +158,7 @@ TEST_F(NeXusDatasetCreation, CueTimestampZeroOpen) {
 TEST_F(NeXusDatasetCreation, EventIdOpen) {
   using TypeUnderTest = NeXusDataset::EventId;
   std::string DatasetName{"event_id"};
-  defaultDatasetCreation<TypeUnderTest, std::uint32_t>(RootGroup, DatasetName);
+  defaultDatasetCreation<TypeUnderTest, std::int32_t>(RootGroup, DatasetName);
   reOpenDataset<TypeUnderTest>(RootGroup, DatasetName);
   wrongModeOpen<TypeUnderTest>(RootGroup);
   failOnReCreateDataset<TypeUnderTest>(RootGroup, DatasetName);
@@ -169,7 +169,7 @@ TEST_F(NeXusDatasetCreation, EventIdOpen) {
 TEST_F(NeXusDatasetCreation, EventIndexOpen) {
   using TypeUnderTest = NeXusDataset::EventIndex;
   std::string DatasetName{"event_index"};
-  defaultDatasetCreation<TypeUnderTest, std::uint32_t>(RootGroup, DatasetName);
+  defaultDatasetCreation<TypeUnderTest, std::int64_t>(RootGroup, DatasetName);
   reOpenDataset<TypeUnderTest>(RootGroup, DatasetName);
   wrongModeOpen<TypeUnderTest>(RootGroup);
   failOnReCreateDataset<TypeUnderTest>(RootGroup, DatasetName);
@@ -180,7 +180,7 @@ TEST_F(NeXusDatasetCreation, EventIndexOpen) {
 TEST_F(NeXusDatasetCreation, EventTimeOffsetOpen) {
   using TypeUnderTest = NeXusDataset::EventTimeOffset;
   std::string DatasetName{"event_time_offset"};
-  defaultDatasetCreation<TypeUnderTest, std::uint32_t>(RootGroup, DatasetName);
+  defaultDatasetCreation<TypeUnderTest, std::int32_t>(RootGroup, DatasetName);
   reOpenDataset<TypeUnderTest>(RootGroup, DatasetName);
   wrongModeOpen<TypeUnderTest>(RootGroup);
   failOnReCreateDataset<TypeUnderTest>(RootGroup, DatasetName);
@@ -191,9 +191,28 @@ TEST_F(NeXusDatasetCreation, EventTimeOffsetOpen) {
 TEST_F(NeXusDatasetCreation, EventTimeZeroOpen) {
   using TypeUnderTest = NeXusDataset::EventTimeZero;
   std::string DatasetName{"event_time_zero"};
-  defaultTimeDatasetCreation<TypeUnderTest, std::uint64_t>(RootGroup,
-                                                           DatasetName);
+  defaultTimeDatasetCreation<TypeUnderTest, std::int64_t>(RootGroup,
+                                                          DatasetName);
   reOpenDataset<TypeUnderTest>(RootGroup, DatasetName);
   wrongModeOpen<TypeUnderTest>(RootGroup);
   failOnReCreateDataset<TypeUnderTest>(RootGroup, DatasetName);
 }
+
+//--------------------------------------------------
+
+TEST_F(NeXusDatasetCreation, EventDatasetsWithLegacyTypes) {
+  auto Create = NeXusDataset::Mode::Create;
+  auto Legacy = NeXusDataset::EventDataTypes::LEGACY;
+  NeXusDataset::EventId(RootGroup, Create, 256, {}, Legacy); // NOLINT
+  NeXusDataset::EventTimeOffset(RootGroup, Create, 256, {}, Legacy); // NOLINT
+  NeXusDataset::EventIndex(RootGroup, Create, 256, {}, Legacy); // NOLINT
+  NeXusDataset::EventTimeZero(RootGroup, Create, 256, {}, Legacy); // NOLINT
+  EXPECT_EQ(RootGroup.get_dataset("event_id").datatype(),
+            hdf5::datatype::create<std::uint32_t>());
+  EXPECT_EQ(RootGroup.get_dataset("event_time_offset").datatype(),
+            hdf5::datatype::create<std::uint32_t>());
+  EXPECT_EQ(RootGroup.get_dataset("event_index").datatype(),
+            hdf5::datatype::create<std::uint32_t>());
+  EXPECT_EQ(RootGroup.get_dataset("event_time_zero").datatype(),
+            hdf5::datatype::create<std::uint64_t>());
+}
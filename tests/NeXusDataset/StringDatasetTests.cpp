@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#include "NeXusDataset/StringDataset.h"
+#include <gtest/gtest.h>
+#include <h5cpp/hdf5.hpp>
+
+class StringDatasetTest : public ::testing::Test {
+public:
+  void SetUp() override {
+    File = hdf5::file::create(TestFileName, hdf5::file::AccessFlags::Truncate);
+    RootGroup = File.root();
+  };
+
+  void TearDown() override { File.close(); };
+  std::string TestFileName{"StringDatasetTestFile.hdf5"};
+  hdf5::file::File File;
+  hdf5::node::Group RootGroup;
+  std::vector<std::string> const SomeStrings{"HIHI alarm", "LOW alarm",
+                                             "HIHI alarm", "", "HIHI alarm"};
+};
+
+TEST(StringEncoding, EncodingFromString) {
+  using NeXusDataset::StringEncoding;
+  EXPECT_EQ(NeXusDataset::stringEncodingFromString("fixed"),
+            StringEncoding::FIXED);
+  EXPECT_EQ(NeXusDataset::stringEncodingFromString("Variable"),
+            StringEncoding::VARIABLE);
+  EXPECT_EQ(NeXusDataset::stringEncodingFromString("DICTIONARY"),
+            StringEncoding::DICTIONARY);
+  EXPECT_FALSE(NeXusDataset::stringEncodingFromString("enum"));
+}
+
+TEST_F(StringDatasetTest, FixedSizeStringsAreWrittenOnFlush) {
+  NeXusDataset::FixedSizeString Strings(RootGroup, "strings",
+                                        NeXusDataset::Mode::Create, 16);
+  for (auto const &String : SomeStrings) {
+    Strings.appendStringElement(String);
+  }
+  EXPECT_EQ(Strings.current_size(), 5);
+  EXPECT_EQ(RootGroup.get_dataset("strings").dataspace().size(), 0);
+  Strings.flushBuffer();
+  EXPECT_EQ(RootGroup.get_dataset("strings").dataspace().size(), 5);
+  EXPECT_EQ(std::string(Strings.read_element(1).c_str()), "LOW alarm");
+}
+
+TEST_F(StringDatasetTest, PackedStringsAreWrittenAndRead) {
+  NeXusDataset::PackedStrings Strings(RootGroup, "strings",
+                                      NeXusDataset::Mode::Create);
+  for (auto const &String : SomeStrings) {
+    Strings.appendStringElement(String);
+  }
+  Strings.appendStringElement("");
+  auto Expected = SomeStrings;
+  Expected.emplace_back("");
+  EXPECT_EQ(Strings.readAll(), Expected);
+}
+
+TEST_F(StringDatasetTest, PackedStringsAreNotVariableLengthStrings) {
+  {
+    NeXusDataset::PackedStrings Strings(RootGroup, "strings",
+                                        NeXusDataset::Mode::Create);
+    Strings.appendStringElement("LOW alarm");
+    Strings.appendStringElement("HIGH");
+  }
+  // Variable length data is stored on the global heap, which is not
+  // supported by SWMR.
+  auto Characters = RootGroup.get_dataset("strings");
+  EXPECT_EQ(Characters.datatype().get_class(),
+            hdf5::datatype::Class::Integer);
+  EXPECT_EQ(Characters.dataspace().size(), 13);
+  auto Offsets = RootGroup.get_dataset("strings_offsets");
+  std::vector<std::uint64_t> Ends(Offsets.dataspace().size());
+  Offsets.read(Ends);
+  EXPECT_EQ(Ends, (std::vector<std::uint64_t>{9, 13}));
+}
+
+TEST_F(StringDatasetTest, AllEncodingsReadBackTheSameStrings) {
+  using NeXusDataset::StringEncoding;
+  for (auto Encoding : {StringEncoding::FIXED, StringEncoding::VARIABLE,
+                        StringEncoding::DICTIONARY}) {
+    auto Group = RootGroup.create_group(
+        "group_" + std::to_string(static_cast<int>(Encoding)));
+    NeXusDataset::StringDataset Strings(Group, "strings",
+                                        NeXusDataset::Mode::Create, Encoding);
+    for (auto const &String : SomeStrings) {
+      Strings.appendStringElement(String);
+    }
+    EXPECT_EQ(Strings.readAll(), SomeStrings);
+  }
+}
+
+TEST_F(StringDatasetTest, DictionaryStoresDistinctStringsOnce) {
+  {
+    NeXusDataset::StringDataset Strings(
+        RootGroup, "strings", NeXusDataset::Mode::Create,
+        NeXusDataset::StringEncoding::DICTIONARY);
+    for (auto const &String : SomeStrings) {
+      Strings.appendStringElement(String);
+    }
+  }
+  EXPECT_FALSE(RootGroup.has_dataset("strings"));
+  EXPECT_EQ(RootGroup.get_dataset("strings_table_offsets").dataspace().size(),
+            3);
+  auto IndexDataset = RootGroup.get_dataset("strings_index");
+  std::vector<std::uint32_t> Indices(IndexDataset.dataspace().size());
+  IndexDataset.read(Indices);
+  EXPECT_EQ(Indices, (std::vector<std::uint32_t>{0, 1, 0, 2, 0}));
+}
+
+TEST_F(StringDatasetTest, ReopenedDictionaryReusesTable) {
+  NeXusDataset::StringDataset( // NOLINT(bugprone-unused-raii)
+      RootGroup, "strings", NeXusDataset::Mode::Create,
+      NeXusDataset::StringEncoding::DICTIONARY);
+  {
+    NeXusDataset::StringDataset Strings(RootGroup, "strings",
+                                        NeXusDataset::Mode::Open);
+    EXPECT_EQ(Strings.encoding(), NeXusDataset::StringEncoding::DICTIONARY);
+    Strings.appendStringElement("first");
+    Strings.appendStringElement("second");
+  }
+  NeXusDataset::StringDataset Strings(RootGroup, "strings",
+                                      NeXusDataset::Mode::Open);
+  Strings.appendStringElement("second");
+  Strings.appendStringElement("first");
+  EXPECT_EQ(Strings.readAll(),
+            (std::vector<std::string>{"first", "second", "second", "first"}));
+  EXPECT_EQ(RootGroup.get_dataset("strings_table_offsets").dataspace().size(),
+            2);
+}
@@ -49,6 +49,16 @@ TEST_F(SourceTests, ConstructorSetsMembers) {
   ASSERT_EQ(TestSource.sourcename(), SourceName);
 }
 
+TEST_F(SourceTests, SourceWithSharedWriterUsesTheSameWriter) {
+  auto WriterModule = std::make_unique<StubWriterModule>();
+  Source Owner("Bank0", "fbid", "test", "TestTopicName",
+               std::move(WriterModule));
+  Source Shared("Bank1", "fbid", "test", "TestTopicName",
+                Owner.getWriterPtr());
+  EXPECT_EQ(Shared.getWriterPtr(), Owner.getWriterPtr());
+  EXPECT_NE(Shared.getSrcHash(), Owner.getSrcHash());
+}
+
 TEST_F(SourceTests, MovedSourceHasCorrectState) {
   std::string SourceName("TestSourceName");
   std::string TopicName("TestTopicName");
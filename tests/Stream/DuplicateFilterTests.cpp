@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#include "FlatBufferGenerators.h"
+#include "Stream/DuplicateFilter.h"
+#include <gtest/gtest.h>
+
+namespace {
+FileWriter::FlatbufferMessage create_message(double value,
+                                             int64_t timestamp_ms) {
+  auto const [buffer, size] = FlatBuffers::create_f144_message_double(
+      "::source::", value, timestamp_ms);
+  return {buffer.get(), size};
+}
+} // namespace
+
+TEST(DuplicateFilter, repeated_message_is_a_duplicate) {
+  Stream::DuplicateFilter filter(10);
+  EXPECT_FALSE(filter.isDuplicate(create_message(1, 100)));
+  EXPECT_TRUE(filter.isDuplicate(create_message(1, 100)));
+}
+
+TEST(DuplicateFilter, messages_with_different_content_are_not_duplicates) {
+  Stream::DuplicateFilter filter(10);
+  EXPECT_FALSE(filter.isDuplicate(create_message(1, 100)));
+  EXPECT_FALSE(filter.isDuplicate(create_message(2, 100)));
+  EXPECT_FALSE(filter.isDuplicate(create_message(1, 200)));
+}
+
+TEST(DuplicateFilter, oldest_message_is_forgotten) {
+  Stream::DuplicateFilter filter(2);
+  filter.isDuplicate(create_message(1, 100));
+  filter.isDuplicate(create_message(1, 200));
+  filter.isDuplicate(create_message(1, 300));
+  EXPECT_EQ(2u, filter.size());
+  EXPECT_FALSE(filter.isDuplicate(create_message(1, 100)));
+  EXPECT_TRUE(filter.isDuplicate(create_message(1, 300)));
+}
+
+TEST(DuplicateFilter, only_the_messages_in_the_window_are_remembered) {
+  Stream::DuplicateFilter filter(3);
+  for (int64_t timestamp = 1; timestamp <= 100; ++timestamp) {
+    EXPECT_FALSE(filter.isDuplicate(create_message(1, timestamp)));
+  }
+  EXPECT_EQ(3u, filter.size());
+  for (int64_t timestamp : {98, 99, 100}) {
+    EXPECT_TRUE(filter.isDuplicate(create_message(1, timestamp)));
+  }
+  EXPECT_FALSE(filter.isDuplicate(create_message(1, 97)));
+}
+
+TEST(DuplicateFilter, window_of_zero_messages_throws) {
+  EXPECT_THROW(Stream::DuplicateFilter(0), std::invalid_argument);
+}
@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#include "Stream/FlushPolicy.h"
+#include <gtest/gtest.h>
+
+using Stream::FlushPolicy;
+
+class FlushPolicyTest : public ::testing::Test {
+public:
+  time_point StartTime{std::chrono::system_clock::now()};
+};
+
+TEST_F(FlushPolicyTest, NoFlushBeforeMaxInterval) {
+  FlushPolicy UnderTest(10s, 0, StartTime);
+  EXPECT_EQ(UnderTest.shouldFlush(StartTime + 9s), FlushPolicy::Reason::NONE);
+  EXPECT_EQ(UnderTest.shouldFlush(StartTime + 10s),
+            FlushPolicy::Reason::INTERVAL);
+}
+
+TEST_F(FlushPolicyTest, FlushStartedResetsInterval) {
+  FlushPolicy UnderTest(10s, 0, StartTime);
+  UnderTest.flushStarted(StartTime + 10s);
+  EXPECT_EQ(UnderTest.shouldFlush(StartTime + 15s), FlushPolicy::Reason::NONE);
+  EXPECT_EQ(UnderTest.shouldFlush(StartTime + 20s),
+            FlushPolicy::Reason::INTERVAL);
+}
+
+TEST_F(FlushPolicyTest, FlushOnBytesWritten) {
+  FlushPolicy UnderTest(10s, 1000, StartTime);
+  UnderTest.registerWrite(600, std::nullopt, StartTime);
+  EXPECT_EQ(UnderTest.shouldFlush(StartTime), FlushPolicy::Reason::NONE);
+  UnderTest.registerWrite(600, std::nullopt, StartTime);
+  EXPECT_EQ(UnderTest.bytesSinceFlush(), 1200u);
+  EXPECT_EQ(UnderTest.shouldFlush(StartTime), FlushPolicy::Reason::BYTES);
+  UnderTest.flushStarted(StartTime);
+  EXPECT_EQ(UnderTest.bytesSinceFlush(), 0u);
+  EXPECT_EQ(UnderTest.shouldFlush(StartTime), FlushPolicy::Reason::NONE);
+}
+
+TEST_F(FlushPolicyTest, NoFlushOnBytesIfDisabled) {
+  FlushPolicy UnderTest(10s, 0, StartTime);
+  UnderTest.registerWrite(1'000'000'000, std::nullopt, StartTime);
+  EXPECT_EQ(UnderTest.shouldFlush(StartTime), FlushPolicy::Reason::NONE);
+}
+
+TEST_F(FlushPolicyTest, FlushOnStalenessOfFirstUnflushedWrite) {
+  FlushPolicy UnderTest(10s, 0, StartTime);
+  UnderTest.registerWrite(10, 1s, StartTime + 2s);
+  UnderTest.registerWrite(10, 1s, StartTime + 2500ms);
+  EXPECT_EQ(UnderTest.shouldFlush(StartTime + 2900ms),
+            FlushPolicy::Reason::NONE);
+  EXPECT_EQ(UnderTest.shouldFlush(StartTime + 3s),
+            FlushPolicy::Reason::STALENESS);
+  UnderTest.flushStarted(StartTime + 3s);
+  EXPECT_EQ(UnderTest.shouldFlush(StartTime + 5s), FlushPolicy::Reason::NONE);
+}
+
+TEST_F(FlushPolicyTest, ShortestStalenessBoundIsUsed) {
+  FlushPolicy UnderTest(10s, 0, StartTime);
+  UnderTest.registerWrite(10, 5s, StartTime);
+  UnderTest.registerWrite(10, 1s, StartTime + 1s);
+  EXPECT_EQ(UnderTest.shouldFlush(StartTime + 2s),
+            FlushPolicy::Reason::STALENESS);
+}
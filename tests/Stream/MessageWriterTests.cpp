@@ -14,7 +14,10 @@
 #include "WriterRegistrar.h"
 #include "helpers/SetExtractorModule.h"
 #include <array>
+#include <atomic>
+#include <future>
 #include <gtest/gtest.h>
+#include <thread>
 #include <trompeloeil.hpp>
 
 class WriterModuleStandIn : public WriterModule::Base {
@@ -87,7 +90,8 @@ TEST_F(DataMessageWriterTest, WriteMessageSuccess) {
       reinterpret_cast<Stream::Message::DestPtrType>(&WriterModule), Msg);
   {
     Stream::MessageWriter Writer{
-        []() {}, 1s, std::make_unique<Metrics::Registrar>("some_prefix")};
+        [](duration) { return true; }, 1s,
+        std::make_unique<Metrics::Registrar>("some_prefix")};
     Writer.addMessage(SomeMessage, false);
     Writer.runJob([&Writer]() {
       EXPECT_TRUE(Writer.nrOfWritesDone() == 1);
@@ -107,7 +111,8 @@ TEST_F(DataMessageWriterTest, WriteMessageExceptionUnknownFb) {
       reinterpret_cast<Stream::Message::DestPtrType>(&WriterModule), Msg);
   {
     Stream::MessageWriter Writer{
-        []() {}, 1s, std::make_unique<Metrics::Registrar>("some_prefix")};
+        [](duration) { return true; }, 1s,
+        std::make_unique<Metrics::Registrar>("some_prefix")};
     Writer.runJob([&Writer]() {
       EXPECT_TRUE(Writer.nrOfWriterModulesWithErrors() == 1);
     });
@@ -120,3 +125,228 @@ TEST_F(DataMessageWriterTest, WriteMessageExceptionUnknownFb) {
   }
   EXPECT_EQ(InitialWriteCount, WriterModule.getWriteCount());
 }
+
+TEST_F(DataMessageWriterTest, UnknownWritePriorityUsesModuleDefault) {
+  WriterModuleStandIn TestWriterModule;
+  REQUIRE_CALL(TestWriterModule, config_post_processing()).TIMES(1);
+  TestWriterModule.parse_config(R"({"write_priority": "urgent"})");
+  EXPECT_EQ(TestWriterModule.writePriority(),
+            WriterModule::WritePriority::NORMAL);
+}
+
+TEST_F(DataMessageWriterTest, StalenessIsOnlyBoundIfConfigured) {
+  WriterModuleStandIn HighPriorityModule;
+  WriterModuleStandIn BoundModule;
+  REQUIRE_CALL(HighPriorityModule, config_post_processing()).TIMES(1);
+  REQUIRE_CALL(BoundModule, config_post_processing()).TIMES(1);
+  HighPriorityModule.parse_config(R"({"write_priority": "high"})");
+  BoundModule.parse_config(R"({"max_staleness_ms": 250})");
+  EXPECT_FALSE(HighPriorityModule.maxStaleness().has_value());
+  EXPECT_EQ(BoundModule.maxStaleness(), std::chrono::milliseconds(250));
+}
+
+TEST_F(DataMessageWriterTest, HighPriorityWritesOvertakeLowPriorityWrites) {
+  WriterModuleStandIn LowPriorityModule;
+  WriterModuleStandIn HighPriorityModule;
+  REQUIRE_CALL(LowPriorityModule, config_post_processing()).TIMES(1);
+  REQUIRE_CALL(HighPriorityModule, config_post_processing()).TIMES(1);
+  LowPriorityModule.parse_config(R"({"write_priority": "low"})");
+  HighPriorityModule.parse_config(R"({"write_priority": "High"})");
+  EXPECT_EQ(HighPriorityModule.writePriority(),
+            WriterModule::WritePriority::HIGH);
+
+  std::vector<std::string> WriteOrder;
+  ALLOW_CALL(LowPriorityModule, writeImpl(_, _))
+      .SIDE_EFFECT(WriteOrder.emplace_back("low"))
+      .RETURN(true);
+  ALLOW_CALL(HighPriorityModule, writeImpl(_, _))
+      .SIDE_EFFECT(WriteOrder.emplace_back("high"))
+      .RETURN(true);
+  FileWriter::FlatbufferMessage Msg;
+  {
+    Stream::MessageWriter Writer{
+        [](duration) { return true; }, 1s,
+        std::make_unique<Metrics::Registrar>("some_prefix")};
+    std::promise<void> Blocker;
+    auto BlockerFuture = Blocker.get_future();
+    // Keep the writer thread busy until all messages have been queued.
+    Writer.runJob([&BlockerFuture]() { BlockerFuture.wait(); },
+                  WriterModule::WritePriority::LOW);
+    for (int i = 0; i < 5; ++i) {
+      Writer.addMessage({&LowPriorityModule, Msg}, false);
+    }
+    Writer.addMessage({&HighPriorityModule, Msg}, false);
+    Blocker.set_value();
+  }
+  ASSERT_EQ(WriteOrder.size(), 6u);
+  EXPECT_EQ(WriteOrder.front(), "high");
+}
+
+class PreparingWriterModuleStandIn : public WriterModule::Base {
+public:
+  PreparingWriterModuleStandIn() : WriterModule::Base("test", true, "test") {}
+  WriterModule::InitResult init_hdf(hdf5::node::Group &) override {
+    return WriterModule::InitResult::OK;
+  }
+  WriterModule::InitResult reopen(hdf5::node::Group &) override {
+    return WriterModule::InitResult::OK;
+  }
+  bool writeImpl(FileWriter::FlatbufferMessage const &Message,
+                 bool is_buffered_message) override {
+    return prepareImpl(Message, is_buffered_message)();
+  }
+  bool hasPreparationStage() const override { return PrepareSeparately; }
+  WriterModule::WriteStage prepareImpl(FileWriter::FlatbufferMessage const &,
+                                       bool) override {
+    PrepareThreads.push_back(std::this_thread::get_id());
+    auto MessageIndex = NrOfPreparedWrites++;
+    return [this, MessageIndex]() {
+      WriteThreads.push_back(std::this_thread::get_id());
+      WriteOrder.push_back(MessageIndex);
+      return true;
+    };
+  }
+  std::vector<std::thread::id> PrepareThreads;
+  std::vector<std::thread::id> WriteThreads;
+  std::vector<int> WriteOrder;
+  int NrOfPreparedWrites{0};
+  bool PrepareSeparately{true};
+};
+
+TEST_F(DataMessageWriterTest, PreparedWritesAreDoneInOrderOnWriterThread) {
+  PreparingWriterModuleStandIn TestWriterModule;
+  FileWriter::FlatbufferMessage Msg;
+  int const NrOfMessages{20};
+  {
+    Stream::MessageWriter Writer{
+        [](duration) { return true; }, 1s,
+        std::make_unique<Metrics::Registrar>("some_prefix"), 2};
+    for (int i = 0; i < NrOfMessages; ++i) {
+      Writer.addMessage({&TestWriterModule, Msg}, false);
+    }
+  }
+  EXPECT_EQ(TestWriterModule.getWriteCount(), size_t(NrOfMessages));
+  ASSERT_EQ(TestWriterModule.WriteOrder.size(), size_t(NrOfMessages));
+  for (int i = 0; i < NrOfMessages; ++i) {
+    EXPECT_EQ(TestWriterModule.WriteOrder[i], i);
+  }
+  auto WriterThreadId = TestWriterModule.WriteThreads.front();
+  for (auto const &ThreadId : TestWriterModule.WriteThreads) {
+    EXPECT_EQ(ThreadId, WriterThreadId);
+  }
+  for (auto const &ThreadId : TestWriterModule.PrepareThreads) {
+    EXPECT_NE(ThreadId, WriterThreadId);
+  }
+}
+
+TEST_F(DataMessageWriterTest, WritesWithoutPreparationStageAreNotPrepared) {
+  PreparingWriterModuleStandIn TestWriterModule;
+  TestWriterModule.PrepareSeparately = false;
+  FileWriter::FlatbufferMessage Msg;
+  int const NrOfMessages{5};
+  {
+    Stream::MessageWriter Writer{
+        [](duration) { return true; }, 1s,
+        std::make_unique<Metrics::Registrar>("some_prefix"), 2};
+    for (int i = 0; i < NrOfMessages; ++i) {
+      Writer.addMessage({&TestWriterModule, Msg}, false);
+    }
+  }
+  EXPECT_EQ(TestWriterModule.getWriteCount(), size_t(NrOfMessages));
+  // Prepared by writeImpl() on the writer thread.
+  ASSERT_EQ(TestWriterModule.PrepareThreads.size(), size_t(NrOfMessages));
+  EXPECT_EQ(TestWriterModule.PrepareThreads, TestWriterModule.WriteThreads);
+}
+
+TEST_F(DataMessageWriterTest, WritesAreDoneInBetweenFlushSteps) {
+  std::vector<std::string> Events;
+  std::atomic<Stream::MessageWriter *> WriterPtr{nullptr};
+  std::atomic_int FlushStep{0};
+  {
+    Stream::MessageWriter Writer{
+        [&](duration) {
+          auto CurrentWriter = WriterPtr.load();
+          if (CurrentWriter == nullptr || FlushStep >= 2) {
+            return true;
+          }
+          ++FlushStep;
+          Events.emplace_back("flush_step_" + std::to_string(FlushStep));
+          if (FlushStep == 1) {
+            CurrentWriter->runJob(
+                [&Events]() { Events.emplace_back("write"); });
+            return false;
+          }
+          return true;
+        },
+        10ms, std::make_unique<Metrics::Registrar>("some_prefix")};
+    WriterPtr = &Writer;
+    for (int i = 0; i < 500 && FlushStep < 2; ++i) {
+      std::this_thread::sleep_for(10ms);
+    }
+  }
+  std::vector<std::string> ExpectedEvents{"flush_step_1", "write",
+                                          "flush_step_2"};
+  EXPECT_EQ(Events, ExpectedEvents);
+}
+
+TEST_F(DataMessageWriterTest, KeepEveryNthMessageWhenSheddingLoad) {
+  WriterModuleStandIn TestWriterModule;
+  REQUIRE_CALL(TestWriterModule, config_post_processing()).TIMES(1);
+  TestWriterModule.parse_config(
+      R"({"drop_policy": "keep_every_nth", "drop_keep_every_nth": 3})");
+  REQUIRE_CALL(TestWriterModule, writeImpl(_, _)).TIMES(4).RETURN(true);
+  FileWriter::FlatbufferMessage Msg;
+  {
+    Stream::MessageWriter Writer{
+        [](duration) { return true; }, 1s,
+        std::make_unique<Metrics::Registrar>("some_prefix")};
+    Writer.setLoadShedding(true);
+    for (int i = 0; i < 10; ++i) {
+      Writer.addMessage({&TestWriterModule, Msg}, false);
+    }
+    Writer.runJob([&Writer]() { EXPECT_EQ(Writer.nrOfMessagesDropped(), 6); });
+  }
+  EXPECT_EQ(TestWriterModule.nrOfDroppedMessages(), 6);
+}
+
+TEST_F(DataMessageWriterTest, DropOldestQueuedMessagesWhenSheddingLoad) {
+  WriterModuleStandIn TestWriterModule;
+  REQUIRE_CALL(TestWriterModule, config_post_processing()).TIMES(1);
+  TestWriterModule.parse_config(
+      R"({"drop_policy": "drop_oldest", "drop_keep_newest": 2})");
+  REQUIRE_CALL(TestWriterModule, writeImpl(_, _)).TIMES(2).RETURN(true);
+  FileWriter::FlatbufferMessage Msg;
+  {
+    Stream::MessageWriter Writer{
+        [](duration) { return true; }, 1s,
+        std::make_unique<Metrics::Registrar>("some_prefix")};
+    std::promise<void> Blocker;
+    auto BlockerFuture = Blocker.get_future();
+    // Keep the writer thread busy until all messages have been queued.
+    Writer.runJob([&BlockerFuture]() { BlockerFuture.wait(); });
+    Writer.setLoadShedding(true);
+    for (int i = 0; i < 5; ++i) {
+      Writer.addMessage({&TestWriterModule, Msg}, false);
+    }
+    Blocker.set_value();
+  }
+  EXPECT_EQ(TestWriterModule.nrOfDroppedMessages(), 3);
+}
+
+TEST_F(DataMessageWriterTest, NoMessagesDroppedWithoutLoadShedding) {
+  WriterModuleStandIn TestWriterModule;
+  REQUIRE_CALL(TestWriterModule, config_post_processing()).TIMES(1);
+  TestWriterModule.parse_config(
+      R"({"drop_policy": "keep_every_nth", "drop_keep_every_nth": 3})");
+  REQUIRE_CALL(TestWriterModule, writeImpl(_, _)).TIMES(5).RETURN(true);
+  FileWriter::FlatbufferMessage Msg;
+  {
+    Stream::MessageWriter Writer{
+        [](duration) { return true; }, 1s,
+        std::make_unique<Metrics::Registrar>("some_prefix")};
+    for (int i = 0; i < 5; ++i) {
+      Writer.addMessage({&TestWriterModule, Msg}, false);
+    }
+  }
+  EXPECT_EQ(TestWriterModule.nrOfDroppedMessages(), 0);
+}
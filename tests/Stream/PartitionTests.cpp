@@ -73,6 +73,10 @@ public:
     source_hash = new_source_hash;
   }
 
+  void forward_waiting_messages(time_point) override {}
+
+  bool accepts_all_messages() const override { return false; }
+
   FileWriter::FlatbufferMessage last_message;
   time_point stop_time{time_point::max()};
   bool has_finished_processing{false};
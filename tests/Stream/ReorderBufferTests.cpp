@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#include "FlatBufferGenerators.h"
+#include "Stream/ReorderBuffer.h"
+#include <algorithm>
+#include <chrono>
+#include <gtest/gtest.h>
+
+namespace {
+FileWriter::FlatbufferMessage create_message(int64_t timestamp_ms) {
+  auto const [buffer, size] =
+      FlatBuffers::create_f144_message_double("::source::", 0, timestamp_ms);
+  return {buffer.get(), size};
+}
+
+std::vector<int64_t> release_all(Stream::ReorderBuffer &buffer) {
+  std::vector<int64_t> timestamps;
+  while (!buffer.empty()) {
+    timestamps.push_back(buffer.release().getTimestamp());
+  }
+  return timestamps;
+}
+} // namespace
+
+TEST(ReorderBuffer, messages_are_released_in_timestamp_order) {
+  Stream::ReorderBuffer buffer(10, 0ms);
+  for (auto timestamp : {300, 100, 200}) {
+    EXPECT_TRUE(buffer.add(create_message(timestamp)));
+  }
+  EXPECT_FALSE(buffer.canRelease());
+  auto released = release_all(buffer);
+  EXPECT_TRUE(std::is_sorted(released.begin(), released.end()));
+  EXPECT_EQ(3u, released.size());
+}
+
+TEST(ReorderBuffer, earliest_message_is_released_when_window_is_full) {
+  Stream::ReorderBuffer buffer(2, 0ms);
+  buffer.add(create_message(200));
+  buffer.add(create_message(100));
+  EXPECT_FALSE(buffer.canRelease());
+  buffer.add(create_message(300));
+  ASSERT_TRUE(buffer.canRelease());
+  EXPECT_EQ(create_message(100).getTimestamp(),
+            buffer.release().getTimestamp());
+  EXPECT_FALSE(buffer.canRelease());
+}
+
+TEST(ReorderBuffer, message_is_released_after_max_delay) {
+  Stream::ReorderBuffer buffer(0, 100ms);
+  buffer.add(create_message(1000));
+  buffer.add(create_message(1050));
+  EXPECT_FALSE(buffer.canRelease());
+  buffer.add(create_message(1100));
+  ASSERT_TRUE(buffer.canRelease());
+  EXPECT_EQ(create_message(1000).getTimestamp(),
+            buffer.release().getTimestamp());
+  EXPECT_FALSE(buffer.canRelease());
+}
+
+TEST(ReorderBuffer, message_is_released_after_waiting_for_max_delay) {
+  Stream::ReorderBuffer buffer(0, 100ms);
+  auto added_at = system_clock::now();
+  buffer.add(create_message(1000), added_at);
+  buffer.add(create_message(1050), added_at + 60ms);
+  EXPECT_FALSE(buffer.canRelease());
+  EXPECT_FALSE(buffer.canRelease(added_at + 99ms));
+  ASSERT_TRUE(buffer.canRelease(added_at + 100ms));
+  buffer.release();
+  EXPECT_FALSE(buffer.canRelease(added_at + 100ms));
+}
+
+TEST(ReorderBuffer, message_earlier_than_a_released_message_is_late) {
+  Stream::ReorderBuffer buffer(1, 0ms);
+  buffer.add(create_message(100));
+  buffer.add(create_message(200));
+  buffer.release();
+  EXPECT_FALSE(buffer.add(create_message(50)));
+  EXPECT_TRUE(buffer.add(create_message(100)));
+  EXPECT_EQ(2u, buffer.size());
+}
@@ -8,6 +8,7 @@
 // Screaming Udder!                              https://esss.se
 
 #include "FlatBufferGenerators.h"
+#include "Stream/Partition.h"
 #include "Stream/SourceFilter.h"
 #include "WriterModule/f144/f144_Writer.h"
 #include <chrono>
@@ -16,7 +17,8 @@
 class StubMessageWriter : public Stream::MessageWriter {
 public:
   StubMessageWriter()
-      : MessageWriter([]() {}, 1s, std::make_unique<Metrics::Registrar>("")) {}
+      : MessageWriter([](duration) { return true; }, 1s,
+                      std::make_unique<Metrics::Registrar>("")) {}
   void addMessage(Stream::Message const &message,
                   [[maybe_unused]] bool is_buffered_message) override {
     messages_received.emplace_back(message);
@@ -266,3 +268,105 @@ TEST(SourceFilter, messages_written_for_each_module_when_more_than_one_module) {
 
   EXPECT_EQ(4u, writer->messages_received.size());
 }
+
+TEST(SourceFilter, messages_are_passed_on_in_order_with_reorder_window) {
+  auto harness = create_filter_for_tests();
+  harness.filter->set_reorder_stage(
+      std::make_shared<Stream::ReorderStage>(2, 0ms));
+
+  for (auto timestamp : {200, 100, 300, 400, 50}) {
+    harness.filter->filter_message(
+        create_f144_message("::source::", 1, timestamp));
+  }
+  // The window holds the two latest messages, the message at 50 ms is late
+  // and passed on immediately.
+  std::vector<int64_t> timestamps;
+  for (auto const &message : harness.writer->messages_received) {
+    timestamps.push_back(message.FbMsg.getTimestamp() / 1'000'000);
+  }
+  EXPECT_EQ((std::vector<int64_t>{100, 200, 50}), timestamps);
+
+  harness.filter.reset();
+  EXPECT_EQ(5u, harness.writer->messages_received.size());
+}
+
+TEST(SourceFilter, waiting_messages_are_passed_on_without_later_messages) {
+  auto harness = create_filter_for_tests();
+  harness.filter->set_reorder_stage(
+      std::make_shared<Stream::ReorderStage>(0, 100ms));
+
+  harness.filter->filter_message(create_f144_message("::source::", 1, 150));
+  harness.filter->filter_message(create_f144_message("::source::", 2, 100));
+  EXPECT_TRUE(harness.writer->messages_received.empty());
+
+  harness.filter->forward_waiting_messages(system_clock::now() + 1s);
+  ASSERT_EQ(2u, harness.writer->messages_received.size());
+  EXPECT_EQ(100, harness.writer->messages_received[0].FbMsg.getTimestamp() /
+                     1'000'000);
+}
+
+TEST(SourceFilter, messages_of_a_source_on_two_partitions_are_reordered) {
+  StubMessageWriter writer;
+  Metrics::Registrar registrar("");
+  WriterModule::f144::f144_Writer writer_module;
+  auto source_hash = FileWriter::calcSourceHash("f144", "::source::");
+  Stream::SrcToDst map{{source_hash, source_hash, &writer_module, "::source::",
+                        "f144", "f144", false, 2, 0ms, 0, false}};
+  auto reorder_stages = Stream::create_reorder_stages(map);
+  auto partition_0 = Stream::create_filters(
+      map, reorder_stages, time_point::min(), time_point::max(), &writer,
+      &registrar);
+  auto partition_1 = Stream::create_filters(
+      map, reorder_stages, time_point::min(), time_point::max(), &writer,
+      &registrar);
+  ASSERT_EQ(1u, partition_0.size());
+  ASSERT_EQ(1u, partition_1.size());
+
+  // Each partition is in order, the source is not.
+  for (auto [timestamp, partition] :
+       std::vector<std::pair<int64_t, int>>{
+           {200, 0}, {100, 1}, {300, 0}, {250, 1}, {400, 0}, {350, 1}}) {
+    auto &filter = partition == 0 ? partition_0[0] : partition_1[0];
+    EXPECT_TRUE(filter->filter_message(
+        create_f144_message("::source::", 1, timestamp)));
+  }
+  partition_0.clear();
+  partition_1.clear();
+
+  std::vector<int64_t> timestamps;
+  for (auto const &message : writer.messages_received) {
+    timestamps.push_back(message.FbMsg.getTimestamp() / 1'000'000);
+  }
+  EXPECT_EQ((std::vector<int64_t>{100, 200, 250, 300, 350, 400}), timestamps);
+}
+
+TEST(SourceFilter, all_messages_of_the_topic_are_passed_on_if_accepted) {
+  auto harness = create_filter_for_tests();
+  harness.filter->set_accepts_all_messages(true);
+
+  harness.filter->filter_message(create_f144_message("::source::", 1, 100));
+  harness.filter->filter_message(create_f144_message("::other::", 2, 200));
+  std::vector<std::uint8_t> broken{1, 2, 3};
+  FileWriter::MessageMetaData meta_data;
+  meta_data.Timestamp = 300ms;
+  FileWriter::Msg kafka_message(broken.data(), broken.size(), meta_data);
+  EXPECT_TRUE(harness.filter->filter_message(
+      FileWriter::FlatbufferMessage::unparsed(kafka_message)));
+
+  EXPECT_EQ(3u, harness.writer->messages_received.size());
+}
+
+TEST(SourceFilter, duplicate_messages_are_dropped_with_dedup_window) {
+  auto harness = create_filter_for_tests();
+  harness.filter->set_dedup_window(4);
+
+  harness.filter->filter_message(create_f144_message("::source::", 1, 100));
+  harness.filter->filter_message(create_f144_message("::source::", 2, 200));
+  EXPECT_FALSE(harness.filter->filter_message(
+      create_f144_message("::source::", 1, 100)));
+  // Same timestamp, different content
+  harness.filter->filter_message(create_f144_message("::source::", 3, 300));
+
+  EXPECT_EQ(3u, harness.writer->messages_received.size());
+  EXPECT_EQ(1, harness.writer_module->nrOfDuplicateMessages());
+}
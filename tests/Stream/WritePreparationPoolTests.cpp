@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#include "Stream/WritePreparationPool.h"
+#include <chrono>
+#include <future>
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+
+TEST(WritePreparationPool, TasksWithSameKeyAreExecutedInOrder) {
+  std::vector<int> ExecutionOrder;
+  int Key{0};
+  int const NrOfTasks{100};
+  {
+    Stream::WritePreparationPool UnderTest(4);
+    for (int i = 0; i < NrOfTasks; ++i) {
+      UnderTest.submit(&Key, [&ExecutionOrder, i]() {
+        ExecutionOrder.push_back(i);
+      });
+    }
+  }
+  ASSERT_EQ(ExecutionOrder.size(), size_t(NrOfTasks));
+  for (int i = 0; i < NrOfTasks; ++i) {
+    EXPECT_EQ(ExecutionOrder[i], i);
+  }
+}
+
+TEST(WritePreparationPool, TasksWithDifferentKeysAreExecutedConcurrently) {
+  int KeyA{0};
+  int KeyB{0};
+  std::promise<void> TaskBExecuted;
+  auto TaskBExecutedFuture = TaskBExecuted.get_future();
+  std::future_status TaskAWaitResult{std::future_status::deferred};
+  {
+    Stream::WritePreparationPool UnderTest(2);
+    UnderTest.submit(&KeyA, [&TaskBExecutedFuture, &TaskAWaitResult]() {
+      TaskAWaitResult = TaskBExecutedFuture.wait_for(10s);
+    });
+    UnderTest.submit(&KeyB, [&TaskBExecuted]() { TaskBExecuted.set_value(); });
+  }
+  EXPECT_EQ(TaskAWaitResult, std::future_status::ready);
+}
+
+TEST(WritePreparationPool, DestructorExecutesQueuedTasks) {
+  int NrOfExecutedTasks{0};
+  int Key{0};
+  {
+    Stream::WritePreparationPool UnderTest(1);
+    for (int i = 0; i < 10; ++i) {
+      UnderTest.submit(&Key, [&NrOfExecutedTasks]() { ++NrOfExecutedTasks; });
+    }
+  }
+  EXPECT_EQ(NrOfExecutedTasks, 10);
+}
@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#include "AccessMessageMetadata/ad00/ad00_Extractor.h"
+#include "FlatBufferGenerators.h"
+#include "WriterModule/ad00/ad00_FrameProcessing.h"
+#include "WriterModule/ad00/ad00_Writer.h"
+#include "helpers/HDFFileTestHelper.h"
+#include "helpers/SetExtractorModule.h"
+#include <gtest/gtest.h>
+
+using WriterModule::InitResult;
+using namespace WriterModule::ad00;
+
+TEST(ad00FrameProcessing, BinningSumsPixelsAndDropsPartialBins) {
+  // 3 x 5 pixels
+  std::vector<std::int32_t> Frame{1,  2,  3,  4,  5,  //
+                                  6,  7,  8,  9,  10, //
+                                  11, 12, 13, 14, 15};
+  FrameRegion Whole{"value", 0, 0, 3, 5};
+  std::vector<PixelSum<std::int32_t>> RowSums(2);
+  std::vector<std::int32_t> Result(2);
+  binRegion(Frame.data(), 5, Whole, 2, 2, RowSums.data(), Result.data());
+  EXPECT_EQ((std::vector<std::int32_t>{1 + 2 + 6 + 7, 3 + 4 + 8 + 9}), Result);
+}
+
+TEST(ad00FrameProcessing, RegionIsCopiedWithoutBinning) {
+  std::vector<std::uint16_t> Frame{1, 2, 3, //
+                                   4, 5, 6, //
+                                   7, 8, 9};
+  FrameRegion Region{"roi", 1, 1, 2, 2};
+  std::vector<std::uint16_t> Result(4);
+  binRegion<std::uint16_t>(Frame.data(), 3, Region, 1, 1, nullptr,
+                           Result.data());
+  EXPECT_EQ((std::vector<std::uint16_t>{5, 6, 8, 9}), Result);
+}
+
+TEST(ad00FrameProcessing, BinnedPixelsAreClampedToTheType) {
+  std::vector<std::uint8_t> Frame{200, 200, 1, 2};
+  FrameRegion Whole{"value", 0, 0, 1, 4};
+  std::vector<PixelSum<std::uint8_t>> RowSums(2);
+  std::vector<std::uint8_t> Result(2);
+  binRegion(Frame.data(), 4, Whole, 1, 2, RowSums.data(), Result.data());
+  EXPECT_EQ((std::vector<std::uint8_t>{255, 3}), Result);
+}
+
+TEST(ad00FrameProcessing, ProjectionsAreTheSumsOfColumnsAndRows) {
+  std::vector<float> Frame{1, 2, 3, //
+                           4, 5, 6};
+  std::vector<double> ColumnSums(3);
+  std::vector<double> RowSums(2);
+  sumProjections(Frame.data(), 2, 3, ColumnSums.data(), RowSums.data());
+  EXPECT_EQ((std::vector<double>{5, 7, 9}), ColumnSums);
+  EXPECT_EQ((std::vector<double>{6, 15}), RowSums);
+  EXPECT_EQ(1u, binInPlace(ColumnSums.data(), ColumnSums.size(), 2));
+  EXPECT_EQ(12, ColumnSums[0]);
+}
+
+TEST(ad00FrameProcessing, RegionIsParsed) {
+  auto Region = parseFrameRegion(
+      nlohmann::json::parse(R"({"offset": [10, 20], "size": [64, 32]})"),
+      "roi_0");
+  EXPECT_EQ("roi_0", Region.Name);
+  EXPECT_EQ(10u, Region.Row);
+  EXPECT_EQ(20u, Region.Column);
+  EXPECT_EQ(64u, Region.Rows);
+  EXPECT_EQ(32u, Region.Columns);
+  EXPECT_TRUE(Region.fits(74, 52));
+  EXPECT_FALSE(Region.fits(73, 52));
+}
+
+TEST(ad00FrameProcessing, InvalidRegionThrows) {
+  EXPECT_THROW(parseFrameRegion(nlohmann::json::parse(R"({"size": [1, 1]})"),
+                                "roi_0"),
+               std::runtime_error);
+  EXPECT_THROW(parseFrameRegion(nlohmann::json::parse(
+                                    R"({"offset": [0, 0], "size": [0, 1]})"),
+                                "roi_0"),
+               std::runtime_error);
+  EXPECT_THROW(parseFrameRegion(nlohmann::json::parse(
+                                    R"({"offset": [0], "size": [1, 1]})"),
+                                "roi_0"),
+               std::runtime_error);
+}
+
+class ad00Writer : public ::testing::Test {
+public:
+  void SetUp() override {
+    File = HDFFileTestHelper::createInMemoryTestFile(TestFileName);
+    RootGroup = File->hdfGroup();
+    UsedGroup = RootGroup.create_group("image");
+    setExtractorModule<AccessMessageMetadata::ad00_Extractor>("ad00");
+  }
+
+  std::string TestFileName{"SomeTestFile.hdf5"};
+  std::unique_ptr<HDFFileTestHelper::DebugHDFFile> File;
+  hdf5::node::Group RootGroup;
+  hdf5::node::Group UsedGroup;
+};
+
+TEST_F(ad00Writer, RegionsBinningAndProjectionsAreWritten) {
+  {
+    ad00_Writer Writer;
+    Writer.parse_config(R"({
+      "array_size": [4, 4],
+      "dtype": "uint16",
+      "rois": [{"name": "spot", "offset": [1, 1], "size": [2, 3]}],
+      "binning": [2, 2],
+      "sum_projection": true
+    })");
+    ASSERT_TRUE(Writer.init_hdf(UsedGroup) == InitResult::OK);
+    ASSERT_TRUE(Writer.reopen(UsedGroup) == InitResult::OK);
+    auto const [Buffer, Size] = FlatBuffers::create_ad00_message_uint16(
+        "::source::",
+        {{1, 2, 3, 4}, {5, 6, 7, 8}, {9, 10, 11, 12}, {13, 14, 15, 16}}, 10);
+    FileWriter::FlatbufferMessage Message(Buffer.get(), Size);
+    EXPECT_NO_THROW(Writer.write(Message, false));
+  }
+  EXPECT_FALSE(UsedGroup.has_dataset("value"));
+
+  auto Spot = UsedGroup.get_dataset("spot");
+  EXPECT_EQ((hdf5::Dimensions{1, 1, 1}),
+            hdf5::dataspace::Simple(Spot.dataspace()).current_dimensions());
+  std::vector<std::uint16_t> SpotPixels(1);
+  Spot.read(SpotPixels);
+  EXPECT_EQ(6 + 7 + 10 + 11, SpotPixels[0]);
+
+  std::vector<std::uint64_t> ProjectionX(2);
+  UsedGroup.get_dataset("projection_x").read(ProjectionX);
+  EXPECT_EQ((std::vector<std::uint64_t>{28 + 32, 36 + 40}), ProjectionX);
+  std::vector<std::uint64_t> ProjectionY(2);
+  UsedGroup.get_dataset("projection_y").read(ProjectionY);
+  EXPECT_EQ((std::vector<std::uint64_t>{10 + 26, 42 + 58}), ProjectionY);
+}
+
+TEST_F(ad00Writer, RegionOutsideOfTheFrameIsNotWritten) {
+  ad00_Writer Writer;
+  Writer.parse_config(R"({
+    "array_size": [2, 2],
+    "dtype": "uint16",
+    "rois": [{"offset": [1, 1], "size": [2, 2]}]
+  })");
+  ASSERT_TRUE(Writer.init_hdf(UsedGroup) == InitResult::OK);
+  ASSERT_TRUE(Writer.reopen(UsedGroup) == InitResult::OK);
+  auto const [Buffer, Size] = FlatBuffers::create_ad00_message_uint16(
+      "::source::", {{1, 2}, {3, 4}}, 10);
+  FileWriter::FlatbufferMessage Message(Buffer.get(), Size);
+  EXPECT_THROW(Writer.write(Message, false), WriterModule::WriterException);
+}
+
+TEST_F(ad00Writer, FrameWithTooLittleDataIsNotWritten) {
+  ad00_Writer Writer;
+  Writer.parse_config(R"({
+    "array_size": [2, 2],
+    "dtype": "uint16"
+  })");
+  ASSERT_TRUE(Writer.init_hdf(UsedGroup) == InitResult::OK);
+  ASSERT_TRUE(Writer.reopen(UsedGroup) == InitResult::OK);
+  // The dimensions are (2, 2) but there are only 3 pixels.
+  auto const [Buffer, Size] = FlatBuffers::create_ad00_message_uint16(
+      "::source::", {{1, 2}, {3}}, 10);
+  FileWriter::FlatbufferMessage Message(Buffer.get(), Size);
+  EXPECT_THROW(Writer.write(Message, false), WriterModule::WriterException);
+}
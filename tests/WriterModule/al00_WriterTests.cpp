@@ -90,6 +90,7 @@ TEST_F(EPICS_AlarmWriter, WriteDataOnce) {
   EXPECT_TRUE(Writer.reopen(UsedGroup) == InitResult::OK);
   FileWriter::FlatbufferMessage TestMsg(Buffer.get(), BufferSize);
   EXPECT_NO_THROW(Writer.write(TestMsg, false));
+  Writer.flushBuffers();
   auto AlarmMsgDataset = UsedGroup.get_dataset("alarm_message");
   auto AlarmSeverityDataset = UsedGroup.get_dataset("alarm_severity");
   auto AlarmTimeDataset = UsedGroup.get_dataset("alarm_time");
@@ -108,3 +109,24 @@ TEST_F(EPICS_AlarmWriter, WriteDataOnce) {
   AlarmMsg[0].erase(AlarmMsg[0].find('\0'));
   EXPECT_EQ(FbPointer->message()->str(), AlarmMsg[0]);
 }
+
+TEST_F(EPICS_AlarmWriter, WriteDictionaryEncodedMessages) {
+  size_t BufferSize{0};
+  auto Buffer = GenerateAlarmFlatbufferData(BufferSize);
+  WriterModule::al00::al00_Writer Writer;
+  Writer.parse_config(R"({"message_encoding": "dictionary"})");
+  EXPECT_TRUE(Writer.init_hdf(UsedGroup) == InitResult::OK);
+  EXPECT_TRUE(Writer.reopen(UsedGroup) == InitResult::OK);
+  FileWriter::FlatbufferMessage TestMsg(Buffer.get(), BufferSize);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_NO_THROW(Writer.write(TestMsg, false));
+  }
+  Writer.flushBuffers();
+  EXPECT_FALSE(UsedGroup.has_dataset("alarm_message"));
+  auto TableDataset = UsedGroup.get_dataset("alarm_message_table");
+  EXPECT_EQ(TableDataset.dataspace().size(), 1);
+  auto IndexDataset = UsedGroup.get_dataset("alarm_message_index");
+  std::vector<std::uint32_t> Indices(IndexDataset.dataspace().size());
+  IndexDataset.read(Indices);
+  EXPECT_EQ(Indices, (std::vector<std::uint32_t>{0, 0, 0}));
+}
@@ -14,6 +14,7 @@
 #include "AccessMessageMetadata/da00/da00_Extractor.h"
 #include "WriterModule/da00/da00_Type.h"
 #include "WriterModule/da00/da00_Variable.h"
+#include "WriterModule/da00/da00_WritePlan.h"
 #include "WriterModule/da00/da00_Writer.h"
 
 static ::testing::AssertionResult NodeTestFailed(std::string_view name,
@@ -838,4 +839,57 @@ TEST_F(da00_WriterTestFixture, da00_WriterFillsInAttributes) {
   EXPECT_TRUE(NodeHasLabel(_group, "y", "Position along y-axis"));
   EXPECT_TRUE(NodeHasShape(_group, "y", y_shape, y_shape));
   EXPECT_TRUE(NodeHasData(_group, "y", y_data));
-}
\ No newline at end of file
+}
+TEST_F(da00_WriterTestFixture, da00_WritePlanOnlyAppendsPlannedShape) {
+  using namespace WriterModule::da00;
+  VariableConfig config;
+  config = make_da00_configuration_complete()["variables"][0].dump();
+  auto dataset = config.insert_variable_dataset(_group, {1024});
+  VariableWritePlan plan(config, *dataset);
+
+  flatbuffers::FlatBufferBuilder builder;
+  auto planned = insert_variable<uint64_t>(
+      builder, "signal", "counts", "", {1, 2, 3, 4, 5, 6, 7, 8, 9}, {3, 3},
+      {"x", "y"});
+  auto other_shape = insert_variable<uint64_t>(
+      builder, "signal", "counts", "", {1, 2, 3, 4}, {2, 2}, {"x", "y"});
+  auto other_type = insert_variable<float>(
+      builder, "signal", "counts", "", {1, 2, 3, 4, 5, 6, 7, 8, 9}, {3, 3},
+      {"x", "y"});
+  auto source_name = builder.CreateString("test_source_name");
+  auto data_array = Createda00_DataArray(
+      builder, source_name, 19820909,
+      builder.CreateVector(std::vector<flatbuffers::Offset<da00_Variable>>{
+          planned, other_shape, other_type}));
+  builder.Finish(data_array, da00_DataArrayIdentifier());
+  auto variables = Getda00_DataArray(builder.GetBufferPointer())->data();
+
+  EXPECT_TRUE(plan.append(variables->Get(0)));
+  EXPECT_FALSE(plan.append(variables->Get(1)));
+  EXPECT_FALSE(plan.append(variables->Get(2)));
+  plan.appendMissing();
+  const std::vector<hsize_t> shape{2, 3, 3};
+  const std::vector<hsize_t> max_shape{H5S_UNLIMITED, 3, 3};
+  EXPECT_TRUE(NodeHasShape(_group, "signal", shape, max_shape));
+}
+
+TEST_F(da00_WriterTestFixture, da00_WritePlanWithoutPlanAppendsNothing) {
+  using namespace WriterModule::da00;
+  VariableWritePlan plan("signal");
+  EXPECT_FALSE(plan.isPlanned());
+
+  flatbuffers::FlatBufferBuilder builder;
+  auto variable = insert_variable<uint64_t>(
+      builder, "signal", "counts", "", {1, 2, 3, 4}, {2, 2}, {"x", "y"});
+  auto source_name = builder.CreateString("test_source_name");
+  auto data_array = Createda00_DataArray(
+      builder, source_name, 19820909,
+      builder.CreateVector(
+          std::vector<flatbuffers::Offset<da00_Variable>>{variable}));
+  builder.Finish(data_array, da00_DataArrayIdentifier());
+  auto variables = Getda00_DataArray(builder.GetBufferPointer())->data();
+
+  // the writer appends the data the generic way instead
+  EXPECT_FALSE(plan.append(variables->Get(0)));
+  EXPECT_NO_THROW(plan.refresh());
+}
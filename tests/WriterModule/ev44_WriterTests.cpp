@@ -13,9 +13,12 @@
 #include <ev44_events_generated.h>
 #include <gmock/gmock.h>
 
+#include <chrono>
+#include <numeric>
 #include <utility>
 
 #include "AccessMessageMetadata/ev44/ev44_Extractor.h"
+#include "WriterModule/ev44/ev44_MergeWriter.h"
 #include "WriterModule/ev44/ev44_Writer.h"
 #include "helpers/HDFFileTestHelper.h"
 #include "helpers/SetExtractorModule.h"
@@ -127,6 +130,34 @@ TEST_F(Event44WriterTests, WriterCreatesUnitsAttributesForTimeDatasets) {
       << fmt::format("Expect time units to be {}", expected_time_units);
 }
 
+TEST_F(Event44WriterTests, WriterCreatesDatasetsWithFlatbufferTypes) {
+  {
+    WriterModule::ev44::ev44_Writer Writer;
+    Writer.parse_config("{}");
+    EXPECT_TRUE(Writer.init_hdf(TestGroup) == InitResult::OK);
+  }
+  auto Int32 = hdf5::datatype::create<std::int32_t>();
+  auto Int64 = hdf5::datatype::create<std::int64_t>();
+  EXPECT_EQ(TestGroup.get_dataset("event_time_offset").datatype(), Int32);
+  EXPECT_EQ(TestGroup.get_dataset("event_id").datatype(), Int32);
+  EXPECT_EQ(TestGroup.get_dataset("event_time_zero").datatype(), Int64);
+  EXPECT_EQ(TestGroup.get_dataset("event_index").datatype(), Int64);
+}
+
+TEST_F(Event44WriterTests, WriterCreatesDatasetsWithLegacyTypes) {
+  {
+    WriterModule::ev44::ev44_Writer Writer;
+    Writer.parse_config(R"({"legacy_types": true})");
+    EXPECT_TRUE(Writer.init_hdf(TestGroup) == InitResult::OK);
+  }
+  auto UInt32 = hdf5::datatype::create<std::uint32_t>();
+  auto UInt64 = hdf5::datatype::create<std::uint64_t>();
+  EXPECT_EQ(TestGroup.get_dataset("event_time_offset").datatype(), UInt32);
+  EXPECT_EQ(TestGroup.get_dataset("event_id").datatype(), UInt32);
+  EXPECT_EQ(TestGroup.get_dataset("event_time_zero").datatype(), UInt64);
+  EXPECT_EQ(TestGroup.get_dataset("event_index").datatype(), UInt32);
+}
+
 TEST_F(Event44WriterTests, WriterFailsToReopenGroupWhichWasNeverInitialised) {
   WriterModule::ev44::ev44_Writer Writer;
   EXPECT_FALSE(Writer.reopen(TestGroup) == InitResult::OK);
@@ -630,3 +661,336 @@ TEST_F(Event44WriterTests, buffered_data_not_written) {
   EXPECT_EQ(0, EventTimeOffsetDataset.dataspace().size());
   EXPECT_EQ(0, EventTimeZeroDataset.dataspace().size());
 }
+
+TEST_F(Event44WriterTests, HistogramIsWrittenWithEvents) {
+  auto MessageBuffer = generateFlatbufferData(
+      "TestSource", 0, {101, 102, 201, 350}, {101, 102, 201, 100});
+  FileWriter::FlatbufferMessage TestMessage(MessageBuffer.data(),
+                                            MessageBuffer.size());
+  auto Config = R"({"histogram": "with_events",
+                    "tof_bin_edges": [0, 100, 200, 300],
+                    "pixel_range": [100, 203], "pixel_group_size": 2,
+                    "histogram_interval_ms": 0})";
+  {
+    WriterModule::ev44::ev44_Writer Writer;
+    Writer.parse_config(Config);
+    EXPECT_TRUE(Writer.init_hdf(TestGroup) == InitResult::OK);
+    EXPECT_TRUE(Writer.reopen(TestGroup) == InitResult::OK);
+    EXPECT_NO_THROW(Writer.write(TestMessage, false));
+    Writer.flushBuffers();
+    ASSERT_NE(Writer.histogram(), nullptr);
+    EXPECT_EQ(Writer.histogram()->nrOfPixelGroups(), 52u);
+    EXPECT_FALSE(Writer.histogram()->hasChanged());
+  }
+  EXPECT_EQ(TestGroup.get_dataset("event_time_offset").dataspace().size(), 4);
+  ASSERT_TRUE(TestGroup.has_group("histogram"));
+  auto Counts = TestGroup.get_dataset("histogram/counts");
+  std::vector<std::uint64_t> WrittenCounts(Counts.dataspace().size());
+  Counts.read(WrittenCounts);
+  ASSERT_EQ(WrittenCounts.size(), 52u * 3u);
+  std::vector<std::uint64_t> ExpectedCounts(WrittenCounts.size(), 0);
+  ExpectedCounts[0 * 3 + 1] = 1; // Pixel 101 (group 0), bin 1.
+  ExpectedCounts[1 * 3 + 1] = 1; // Pixel 102 (group 1), bin 1.
+  ExpectedCounts[50 * 3 + 2] = 1; // Pixel 201 (group 50), bin 2.
+  EXPECT_EQ(WrittenCounts, ExpectedCounts);
+  std::uint64_t EventsOutside{0};
+  Counts.attributes["events_outside"].read(EventsOutside);
+  EXPECT_EQ(EventsOutside, 1u);
+}
+
+TEST_F(Event44WriterTests, OnlyHistogramIsWritten) {
+  auto MessageBuffer = generateFlatbufferData(
+      "TestSource", 0, {101, 102, 201, 350}, {101, 102, 201, 100});
+  FileWriter::FlatbufferMessage TestMessage(MessageBuffer.data(),
+                                            MessageBuffer.size());
+  // Bin edges that are not uniform.
+  auto Config = R"({"histogram": "only", "tof_bin_edges": [0, 150, 160, 400],
+                    "pixel_range": [0, 299], "pixel_group_size": 100})";
+  {
+    WriterModule::ev44::ev44_Writer Writer;
+    Writer.parse_config(Config);
+    EXPECT_TRUE(Writer.init_hdf(TestGroup) == InitResult::OK);
+    EXPECT_TRUE(Writer.reopen(TestGroup) == InitResult::OK);
+    EXPECT_NO_THROW(Writer.write(TestMessage, false));
+  } // The histogram is written on destruction.
+  EXPECT_EQ(TestGroup.get_dataset("event_time_offset").dataspace().size(), 0);
+  EXPECT_EQ(TestGroup.get_dataset("event_time_zero").dataspace().size(), 0);
+  auto Counts = TestGroup.get_dataset("histogram/counts");
+  std::vector<std::uint64_t> WrittenCounts(Counts.dataspace().size());
+  Counts.read(WrittenCounts);
+  EXPECT_EQ(WrittenCounts,
+            (std::vector<std::uint64_t>{0, 0, 0, 2, 0, 1, 0, 0, 1}));
+}
+
+TEST_F(Event44WriterTests, InvalidHistogramConfigurationOnlyWritesEvents) {
+  WriterModule::ev44::ev44_Writer Writer;
+  Writer.parse_config(R"({"histogram": "with_events",
+                          "tof_bin_edges": [0, 100]})");
+  EXPECT_EQ(Writer.histogram(), nullptr);
+  EXPECT_TRUE(Writer.init_hdf(TestGroup) == InitResult::OK);
+  EXPECT_FALSE(TestGroup.has_group("histogram"));
+}
+
+TEST_F(Event44WriterTests, DroppedEventCountsAreCreatedBeforeWriting) {
+  WriterModule::ev44::ev44_Writer Writer;
+  Writer.parse_config(R"({"tof_window": [0, 300]})");
+  EXPECT_TRUE(Writer.init_hdf(TestGroup) == InitResult::OK);
+  for (auto const &Name : {"dropped_events_tof", "dropped_events_unmapped",
+                           "dropped_events_masked"}) {
+    std::uint64_t Dropped{1};
+    TestGroup.attributes[Name].read(Dropped);
+    EXPECT_EQ(Dropped, 0u) << Name;
+  }
+}
+
+TEST_F(Event44WriterTests, EventsAreRemappedAndFiltered) {
+  auto MessageBuffer = generateFlatbufferData(
+      "TestSource", 0, {101, 102, 201, 350, 150, 160},
+      {100, 101, 102, 100, 103, 102}, {1000, 2000}, {0, 3});
+  FileWriter::FlatbufferMessage TestMessage(MessageBuffer.data(),
+                                            MessageBuffer.size());
+  // Raw id 101 is not mapped, pixel 13 (raw id 103) is masked and the time of
+  // flight 350 is outside of the window.
+  auto Config = R"({"pixel_lookup_table": [10, -1, 12, 13],
+                    "pixel_lookup_offset": 100, "masked_pixels": [13],
+                    "tof_window": [0, 300]})";
+  {
+    WriterModule::ev44::ev44_Writer Writer;
+    Writer.parse_config(Config);
+    EXPECT_TRUE(Writer.init_hdf(TestGroup) == InitResult::OK);
+    EXPECT_TRUE(Writer.reopen(TestGroup) == InitResult::OK);
+    EXPECT_NO_THROW(Writer.write(TestMessage, false));
+    Writer.flushBuffers();
+  }
+  auto readAll = [this](std::string const &Name, auto &Data) {
+    auto Dataset = TestGroup.get_dataset(Name);
+    Data.resize(Dataset.dataspace().size());
+    Dataset.read(Data);
+  };
+  std::vector<std::int32_t> EventTimeOffset;
+  std::vector<std::int32_t> EventId;
+  std::vector<std::int64_t> EventIndex;
+  readAll("event_time_offset", EventTimeOffset);
+  readAll("event_id", EventId);
+  readAll("event_index", EventIndex);
+  EXPECT_EQ(EventTimeOffset, (std::vector<std::int32_t>{101, 201, 160}));
+  EXPECT_EQ(EventId, (std::vector<std::int32_t>{10, 12, 12}));
+  // The second pulse starts at the fourth raw event, the third kept event.
+  EXPECT_EQ(EventIndex, (std::vector<std::int64_t>{0, 2}));
+  for (auto const &Name : {"dropped_events_tof", "dropped_events_unmapped",
+                           "dropped_events_masked"}) {
+    std::uint64_t Dropped{0};
+    TestGroup.attributes[Name].read(Dropped);
+    EXPECT_EQ(Dropped, 1u) << Name;
+  }
+}
+
+TEST_F(Event44WriterTests, PulsesOfFilteredOutEventsAreWritten) {
+  auto Buffer1 = generateFlatbufferData("TestSource", 0, {101, 102}, {1, 2},
+                                        {1000}, {0});
+  auto Buffer2 = generateFlatbufferData("TestSource", 1, {501, 502}, {3, 4},
+                                        {2000, 3000}, {0, 1});
+  auto Buffer3 = generateFlatbufferData("TestSource", 2, {103}, {5}, {4000},
+                                        {0});
+  FileWriter::FlatbufferMessage Message1(Buffer1.data(), Buffer1.size());
+  FileWriter::FlatbufferMessage Message2(Buffer2.data(), Buffer2.size());
+  FileWriter::FlatbufferMessage Message3(Buffer3.data(), Buffer3.size());
+  {
+    WriterModule::ev44::ev44_Writer Writer;
+    Writer.parse_config(R"({"tof_window": [0, 300]})");
+    EXPECT_TRUE(Writer.init_hdf(TestGroup) == InitResult::OK);
+    EXPECT_TRUE(Writer.reopen(TestGroup) == InitResult::OK);
+    EXPECT_NO_THROW(Writer.write(Message1, false));
+    // All events of the second message are outside of the window.
+    EXPECT_NO_THROW(Writer.write(Message2, false));
+    EXPECT_NO_THROW(Writer.write(Message3, false));
+    Writer.flushBuffers();
+  }
+  auto readAll = [this](std::string const &Name, auto &Data) {
+    auto Dataset = TestGroup.get_dataset(Name);
+    Data.resize(Dataset.dataspace().size());
+    Dataset.read(Data);
+  };
+  std::vector<std::int32_t> EventTimeOffset;
+  std::vector<std::int64_t> EventTimeZero;
+  std::vector<std::int64_t> EventIndex;
+  readAll("event_time_offset", EventTimeOffset);
+  readAll("event_time_zero", EventTimeZero);
+  readAll("event_index", EventIndex);
+  EXPECT_EQ(EventTimeOffset, (std::vector<std::int32_t>{101, 102, 103}));
+  EXPECT_EQ(EventTimeZero,
+            (std::vector<std::int64_t>{1000, 2000, 3000, 4000}));
+  EXPECT_EQ(EventIndex, (std::vector<std::int64_t>{0, 2, 2, 2}));
+}
+
+TEST_F(Event44WriterTests, EventsAreOnlyHistogrammedWhileOverloaded) {
+  auto Buffer1 = generateFlatbufferData("TestSource", 0, {101, 102, 201},
+                                        {1, 2, 3}, {1000, 2000}, {0, 2});
+  auto Buffer2 = generateFlatbufferData("TestSource", 1, {301, 302}, {4, 5},
+                                        {3000}, {0});
+  FileWriter::FlatbufferMessage Message1(Buffer1.data(), Buffer1.size());
+  FileWriter::FlatbufferMessage Message2(Buffer2.data(), Buffer2.size());
+  auto Config = R"({"histogram": "on_overload", "tof_bin_edges": [0, 1000],
+                    "pixel_range": [0, 9], "overload_queued_messages": 2})";
+  {
+    WriterModule::ev44::ev44_Writer Writer;
+    Writer.parse_config(Config);
+    EXPECT_TRUE(Writer.init_hdf(TestGroup) == InitResult::OK);
+    EXPECT_TRUE(Writer.reopen(TestGroup) == InitResult::OK);
+    // Four messages in the write queue.
+    for (int i = 0; i < 4; ++i) {
+      Writer.nextQueueSequenceNumber();
+    }
+    EXPECT_NO_THROW(Writer.write(Message1, false));
+    // One message left, which is below half of the threshold.
+    for (int i = 0; i < 3; ++i) {
+      Writer.countDequeuedMessage(std::chrono::milliseconds(0));
+    }
+    EXPECT_NO_THROW(Writer.write(Message2, false));
+    Writer.flushBuffers();
+    ASSERT_NE(Writer.histogram(), nullptr);
+    auto const &Counts = Writer.histogram()->counts();
+    EXPECT_EQ(std::accumulate(Counts.begin(), Counts.end(), std::uint64_t(0)),
+              3u);
+  }
+  auto readAll = [](hdf5::node::Group const &Group, std::string const &Name,
+                    auto &Data) {
+    auto Dataset = Group.get_dataset(Name);
+    Data.resize(Dataset.dataspace().size());
+    Dataset.read(Data);
+  };
+  std::vector<std::int32_t> EventTimeOffset;
+  std::vector<std::int64_t> EventTimeZero;
+  readAll(TestGroup, "event_time_offset", EventTimeOffset);
+  readAll(TestGroup, "event_time_zero", EventTimeZero);
+  EXPECT_EQ(EventTimeOffset, (std::vector<std::int32_t>{301, 302}));
+  EXPECT_EQ(EventTimeZero, (std::vector<std::int64_t>{3000}));
+  auto ModeGroup = hdf5::node::get_group(TestGroup, "write_mode");
+  std::vector<std::int64_t> ModeTime;
+  std::vector<std::uint8_t> ModeValue;
+  readAll(ModeGroup, "time", ModeTime);
+  readAll(ModeGroup, "value", ModeValue);
+  EXPECT_EQ(ModeTime, (std::vector<std::int64_t>{1000, 3000}));
+  EXPECT_EQ(ModeValue, (std::vector<std::uint8_t>{1, 0}));
+}
+
+TEST_F(Event44WriterTests, EventsOfSeveralSourcesAreMergedByReferenceTime) {
+  auto BufferA = generateFlatbufferData("BankA", 0, {1, 2, 3}, {1, 2, 3},
+                                        {1000, 2000}, {0, 2});
+  auto BufferB = generateFlatbufferData("BankB", 0, {10, 11}, {10, 11},
+                                        {1000, 3000}, {0, 1});
+  FileWriter::FlatbufferMessage MessageA(BufferA.data(), BufferA.size());
+  FileWriter::FlatbufferMessage MessageB(BufferB.data(), BufferB.size());
+  {
+    WriterModule::ev44::ev44_MergeWriter Writer;
+    Writer.parse_config(
+        R"({"source": "BankA", "sources": ["BankB"], "reorder_window": 2})");
+    EXPECT_EQ(Writer.additionalSources(), std::vector<std::string>{"BankB"});
+    EXPECT_TRUE(Writer.init_hdf(TestGroup) == InitResult::OK);
+    EXPECT_TRUE(Writer.reopen(TestGroup) == InitResult::OK);
+    EXPECT_NO_THROW(Writer.write(MessageA, false));
+    EXPECT_NO_THROW(Writer.write(MessageB, false));
+    // The pulse at 3000 waits for the next pulse of BankA until the file is
+    // closed.
+  }
+  auto readAll = [this](std::string const &Name, auto &Data) {
+    auto Dataset = TestGroup.get_dataset(Name);
+    Data.resize(Dataset.dataspace().size());
+    Dataset.read(Data);
+  };
+  std::vector<std::int32_t> EventTimeOffset;
+  std::vector<std::int32_t> EventId;
+  std::vector<std::int64_t> EventTimeZero;
+  std::vector<std::int64_t> EventIndex;
+  readAll("event_time_offset", EventTimeOffset);
+  readAll("event_id", EventId);
+  readAll("event_time_zero", EventTimeZero);
+  readAll("event_index", EventIndex);
+  EXPECT_EQ(EventTimeOffset, (std::vector<std::int32_t>{1, 2, 10, 3, 11}));
+  EXPECT_EQ(EventId, (std::vector<std::int32_t>{1, 2, 10, 3, 11}));
+  EXPECT_EQ(EventTimeZero, (std::vector<std::int64_t>{1000, 2000, 3000}));
+  EXPECT_EQ(EventIndex, (std::vector<std::int64_t>{0, 3, 4}));
+}
+
+TEST_F(Event44WriterTests, MergeCountsAreCreatedBeforeWriting) {
+  WriterModule::ev44::ev44_MergeWriter Writer;
+  Writer.parse_config(R"({"source": "BankA", "sources": ["BankB"]})");
+  EXPECT_TRUE(Writer.init_hdf(TestGroup) == InitResult::OK);
+  for (auto const &Name : {"late_pulses", "rejected_messages"}) {
+    std::uint64_t Count{1};
+    TestGroup.attributes[Name].read(Count);
+    EXPECT_EQ(Count, 0u) << Name;
+  }
+}
+
+TEST_F(Event44WriterTests, MergedMessagesWithoutPixelIdsAreRejected) {
+  auto BufferA = generateFlatbufferData("BankA", 0, {1, 2, 3}, {1, 2, 3},
+                                        {1000, 2000}, {0, 2});
+  auto BufferB =
+      generateFlatbufferData("BankB", 0, {10, 11}, {}, {1000, 3000}, {0, 1});
+  FileWriter::FlatbufferMessage MessageA(BufferA.data(), BufferA.size());
+  FileWriter::FlatbufferMessage MessageB(BufferB.data(), BufferB.size());
+  {
+    WriterModule::ev44::ev44_MergeWriter Writer;
+    Writer.parse_config(R"({"source": "BankA", "sources": ["BankB"]})");
+    EXPECT_TRUE(Writer.init_hdf(TestGroup) == InitResult::OK);
+    EXPECT_TRUE(Writer.reopen(TestGroup) == InitResult::OK);
+    EXPECT_NO_THROW(Writer.write(MessageA, false));
+    EXPECT_NO_THROW(Writer.write(MessageB, false));
+  }
+  auto readAll = [this](std::string const &Name, auto &Data) {
+    auto Dataset = TestGroup.get_dataset(Name);
+    Data.resize(Dataset.dataspace().size());
+    Dataset.read(Data);
+  };
+  std::vector<std::int32_t> EventTimeOffset;
+  std::vector<std::int32_t> EventId;
+  readAll("event_time_offset", EventTimeOffset);
+  readAll("event_id", EventId);
+  EXPECT_EQ(EventTimeOffset, (std::vector<std::int32_t>{1, 2, 3}));
+  EXPECT_EQ(EventId, (std::vector<std::int32_t>{1, 2, 3}));
+  std::uint64_t Rejected{0};
+  TestGroup.attributes["rejected_messages"].read(Rejected);
+  EXPECT_EQ(Rejected, 1u);
+}
+
+TEST_F(Event44WriterTests, MergedMessageFromUnknownSourceThrows) {
+  auto Buffer = generateFlatbufferData("BankC");
+  FileWriter::FlatbufferMessage Message(Buffer.data(), Buffer.size());
+  WriterModule::ev44::ev44_MergeWriter Writer;
+  Writer.parse_config(R"({"source": "BankA", "sources": ["BankB"]})");
+  EXPECT_TRUE(Writer.init_hdf(TestGroup) == InitResult::OK);
+  EXPECT_TRUE(Writer.reopen(TestGroup) == InitResult::OK);
+  EXPECT_THROW(Writer.write(Message, false), WriterModule::WriterException);
+}
+
+TEST(EventMergerTests, PulsesAreReorderedWithinTheWindow) {
+  WriterModule::ev44::EventMerger Merger(2, 4);
+  auto Events = std::make_shared<WriterModule::ev44::MessageEvents>();
+  Events->TimeOfFlight = {1, 2, 3};
+  std::vector<std::int64_t> Late{3000, 1000, 2000};
+  std::vector<std::int32_t> Index{0, 1, 2};
+  Merger.add(0, Events, Late.data(), Index.data(), Late.size());
+  WriterModule::ev44::MergedEvents Merged;
+  Merger.merge(Merged);
+  EXPECT_TRUE(Merged.ReferenceTime.empty());
+  Merger.merge(Merged, true);
+  EXPECT_EQ(Merged.ReferenceTime,
+            (std::vector<std::int64_t>{1000, 2000, 3000}));
+  EXPECT_EQ(Merged.TimeOfFlight, (std::vector<std::int32_t>{2, 3, 1}));
+  EXPECT_TRUE(Merged.PixelId.empty());
+
+  // A pulse of a full window is merged, a pulse that arrives later with an
+  // earlier reference time is late.
+  std::vector<std::int64_t> Next{4000, 5000, 6000, 7000, 8000};
+  std::vector<std::int32_t> NextIndex{0, 1, 2, 3, 3};
+  Merged.clear();
+  Merger.add(1, Events, Next.data(), NextIndex.data(), Next.size());
+  Merger.merge(Merged);
+  EXPECT_EQ(Merged.ReferenceTime, (std::vector<std::int64_t>{4000}));
+  std::vector<std::int64_t> Earlier{3500};
+  Merger.add(0, Events, Earlier.data(), Index.data(), Earlier.size());
+  Merger.merge(Merged, true);
+  EXPECT_EQ(Merger.latePulses(), 1u);
+  EXPECT_EQ(Merger.nrOfWaitingPulses(), 0u);
+}
@@ -38,10 +38,13 @@ public:
 class f144_WriterStandIn : public f144_Writer {
 public:
   using f144_Writer::ArraySize;
+  using f144_Writer::ArrayValues;
   using f144_Writer::ChunkSize;
   using f144_Writer::CueIndex;
   using f144_Writer::CueTimestampZero;
   using f144_Writer::ElementType;
+  using f144_Writer::MetaDataMax;
+  using f144_Writer::MetaDataMin;
   using f144_Writer::Timestamp;
   using f144_Writer::ValueIndexInterval;
   using f144_Writer::Values;
@@ -236,7 +239,7 @@ generateFlatbufferMessage(double Value, std::int64_t Timestamp) {
 std::pair<std::unique_ptr<uint8_t[]>, size_t>
 generateFlatbufferArrayMessage(std::vector<double> Value, int64_t Timestamp) {
   auto ValueFunc = [Value](auto &Builder) {
-    return Builder.CreateVector(Value).Union();
+    return CreateArrayDouble(Builder, Builder.CreateVector(Value)).Union();
   };
   return generateFlatbufferMessageBase(ValueFunc, Value::ArrayDouble,
                                        Timestamp);
@@ -380,3 +383,150 @@ TEST_F(f144Init, write_multiple_elements) {
   EXPECT_EQ(WrittenTimes[2], timestamps[2]);
   EXPECT_EQ(WrittenTimes[3], timestamps[3]);
 }
+
+TEST_F(f144Init, scalar_values_and_timestamps_are_written_together) {
+  f144_WriterStandIn TestWriter;
+  TestWriter.parse_config(R"({"chunk_size": 4})");
+  TestWriter.init_hdf(RootGroup);
+  TestWriter.reopen(RootGroup);
+  for (int i = 0; i < 6; ++i) {
+    auto [buffer, size] = f144_schema::generateFlatbufferMessage(i, 10 + i);
+    TestWriter.write(FileWriter::FlatbufferMessage(buffer.get(), size), false);
+    EXPECT_EQ(TestWriter.Values.nrOfBufferedElements(),
+              TestWriter.Timestamp.nrOfBufferedElements());
+  }
+  // One chunk has been written, two rows are still buffered.
+  EXPECT_EQ(TestWriter.Values.nrOfBufferedElements(), 2u);
+  TestWriter.flushBuffers();
+  EXPECT_EQ(TestWriter.Values.nrOfBufferedElements(), 0u);
+  EXPECT_EQ(TestWriter.Timestamp.nrOfBufferedElements(), 0u);
+  std::vector<double> WrittenValues(6);
+  TestWriter.Values.read(WrittenValues);
+  EXPECT_EQ(WrittenValues, (std::vector<double>{0, 1, 2, 3, 4, 5}));
+}
+
+TEST_F(f144Init, write_array_values) {
+  f144_WriterStandIn TestWriter;
+  TestWriter.parse_config(R"({"array_size": 3, "chunk_size": 6})");
+  TestWriter.init_hdf(RootGroup);
+  TestWriter.reopen(RootGroup);
+  ASSERT_NE(TestWriter.ArrayValues, nullptr);
+  EXPECT_EQ(TestWriter.ArrayValues->chunk_info(),
+            (std::vector<hsize_t>{2, 3}));
+  std::vector<std::vector<double>> Arrays{{1, 2, 3}, {4, 5, 6}, {7, 8, 9}};
+  for (size_t i = 0; i < Arrays.size(); ++i) {
+    auto [buffer, size] =
+        f144_schema::generateFlatbufferArrayMessage(Arrays[i], 20 + i);
+    TestWriter.write(FileWriter::FlatbufferMessage(buffer.get(), size), false);
+  }
+  // Two arrays (one chunk) are written together, the last one is collected.
+  EXPECT_EQ(TestWriter.ArrayValues->nrOfStagedFrames(), 1u);
+  EXPECT_EQ(TestWriter.ArrayValues->dimensions(),
+            (std::vector<hsize_t>{3, 3}));
+  TestWriter.flushBuffers();
+  std::vector<double> WrittenValues(9);
+  TestWriter.ArrayValues->read(WrittenValues);
+  EXPECT_EQ(WrittenValues,
+            (std::vector<double>{1, 2, 3, 4, 5, 6, 7, 8, 9}));
+  std::vector<std::int64_t> WrittenTimes(3);
+  TestWriter.Timestamp.read_data(WrittenTimes);
+  EXPECT_EQ(WrittenTimes, (std::vector<std::int64_t>{20, 21, 22}));
+}
+
+TEST_F(f144Init, array_value_without_array_size_throws) {
+  f144_WriterStandIn TestWriter;
+  TestWriter.init_hdf(RootGroup);
+  TestWriter.reopen(RootGroup);
+  auto [buffer, size] =
+      f144_schema::generateFlatbufferArrayMessage({1, 2, 3}, 20);
+  EXPECT_THROW(
+      TestWriter.write(FileWriter::FlatbufferMessage(buffer.get(), size),
+                       false),
+      WriterModule::WriterException);
+  EXPECT_EQ(TestWriter.Timestamp.current_size(), 0);
+}
+
+namespace {
+void writeScalars(f144_WriterStandIn &Writer, std::vector<double> const &Values,
+                  std::vector<std::int64_t> const &Times) {
+  for (size_t i = 0; i < Values.size(); ++i) {
+    auto [buffer, size] =
+        f144_schema::generateFlatbufferMessage(Values[i], Times[i]);
+    Writer.write(FileWriter::FlatbufferMessage(buffer.get(), size), false);
+  }
+  Writer.flushBuffers();
+}
+
+std::uint64_t readCount(f144_WriterStandIn &Writer, std::string const &Name) {
+  std::uint64_t Count{0};
+  Writer.Values.attribute(Name, Count);
+  return Count;
+}
+} // namespace
+
+TEST_F(f144Init, update_counts_are_created_before_writing) {
+  f144_WriterStandIn TestWriter;
+  TestWriter.init_hdf(RootGroup);
+  TestWriter.reopen(RootGroup);
+  EXPECT_EQ(readCount(TestWriter, "raw_updates"), 0u);
+  EXPECT_EQ(readCount(TestWriter, "written_updates"), 0u);
+}
+
+TEST_F(f144Init, updates_within_deadband_are_not_written) {
+  f144_WriterStandIn TestWriter;
+  TestWriter.parse_config(R"({"deadband": 0.1})");
+  TestWriter.init_hdf(RootGroup);
+  TestWriter.reopen(RootGroup);
+  writeScalars(TestWriter, {1.0, 1.05, 1.2, 1.25, 0.5}, {1, 2, 3, 4, 5});
+  std::vector<double> WrittenValues(TestWriter.Values.size());
+  TestWriter.Values.read(WrittenValues);
+  EXPECT_EQ(WrittenValues, (std::vector<double>{1.0, 1.2, 0.5}));
+  EXPECT_EQ(TestWriter.Timestamp.current_size(), 3);
+  EXPECT_EQ(readCount(TestWriter, "raw_updates"), 5u);
+  EXPECT_EQ(readCount(TestWriter, "written_updates"), 3u);
+  // The statistics cover the updates that were not written.
+  EXPECT_EQ(TestWriter.MetaDataMax.getValue(), 1.25);
+  EXPECT_EQ(TestWriter.MetaDataMin.getValue(), 0.5);
+}
+
+TEST_F(f144Init, updates_within_relative_deadband_are_not_written) {
+  f144_WriterStandIn TestWriter;
+  TestWriter.parse_config(R"({"relative_deadband": 0.1})");
+  TestWriter.init_hdf(RootGroup);
+  TestWriter.reopen(RootGroup);
+  writeScalars(TestWriter, {100, 109, 111, 121, 122}, {1, 2, 3, 4, 5});
+  std::vector<double> WrittenValues(TestWriter.Values.size());
+  TestWriter.Values.read(WrittenValues);
+  EXPECT_EQ(WrittenValues, (std::vector<double>{100, 111}));
+}
+
+TEST_F(f144Init, updates_within_minimum_interval_are_not_written) {
+  f144_WriterStandIn TestWriter;
+  TestWriter.parse_config(R"({"minimum_interval_ns": 10})");
+  TestWriter.init_hdf(RootGroup);
+  TestWriter.reopen(RootGroup);
+  writeScalars(TestWriter, {1, 2, 3, 4, 5}, {100, 105, 110, 119, 125});
+  std::vector<std::int64_t> WrittenTimes(TestWriter.Timestamp.current_size());
+  TestWriter.Timestamp.read_data(WrittenTimes);
+  EXPECT_EQ(WrittenTimes, (std::vector<std::int64_t>{100, 110, 125}));
+  EXPECT_EQ(readCount(TestWriter, "raw_updates"), 5u);
+  EXPECT_EQ(readCount(TestWriter, "written_updates"), 3u);
+}
+
+TEST_F(f144Init, decimation_keeps_minimum_and_maximum) {
+  f144_WriterStandIn TestWriter;
+  TestWriter.parse_config(R"({"decimation": 4})");
+  TestWriter.init_hdf(RootGroup);
+  TestWriter.reopen(RootGroup);
+  // Two full windows and one partial window (written by flushBuffers()).
+  writeScalars(TestWriter, {5, 9, 1, 6, 3, 3, 3, 3, 7, 2},
+               {1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+  std::vector<double> WrittenValues(TestWriter.Values.size());
+  TestWriter.Values.read(WrittenValues);
+  EXPECT_EQ(WrittenValues, (std::vector<double>{9, 1, 3, 7, 2}));
+  std::vector<std::int64_t> WrittenTimes(TestWriter.Timestamp.current_size());
+  TestWriter.Timestamp.read_data(WrittenTimes);
+  EXPECT_EQ(WrittenTimes, (std::vector<std::int64_t>{2, 3, 5, 9, 10}));
+  EXPECT_EQ(readCount(TestWriter, "raw_updates"), 10u);
+  EXPECT_EQ(readCount(TestWriter, "written_updates"), 5u);
+}
@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// This code has been produced by the European Spallation Source
+// and its partner institutes under the BSD 2 Clause License.
+//
+// See LICENSE.md at the top level for license information.
+//
+// Screaming Udder!                              https://esss.se
+
+#include "AccessMessageMetadata/f144/f144_Extractor.h"
+#include "FlatBufferGenerators.h"
+#include "WriterModule/raw/raw_Writer.h"
+#include "helpers/HDFFileTestHelper.h"
+#include "helpers/SetExtractorModule.h"
+#include <gtest/gtest.h>
+
+using WriterModule::InitResult;
+
+class rawWriter : public ::testing::Test {
+public:
+  void SetUp() override {
+    File = HDFFileTestHelper::createInMemoryTestFile(TestFileName);
+    RootGroup = File->hdfGroup();
+    UsedGroup = RootGroup.create_group("archive");
+    setExtractorModule<AccessMessageMetadata::f144_Extractor>("f144");
+  }
+
+  static FileWriter::FlatbufferMessage createMessage(double Value,
+                                                     int64_t TimestampMs) {
+    auto const [Buffer, Size] = FlatBuffers::create_f144_message_double(
+        "::source::", Value, TimestampMs);
+    return {Buffer.get(), Size};
+  }
+
+  std::string TestFileName{"SomeTestFile.hdf5"};
+  std::unique_ptr<HDFFileTestHelper::DebugHDFFile> File;
+  hdf5::node::Group RootGroup;
+  hdf5::node::Group UsedGroup;
+};
+
+TEST_F(rawWriter, MessagesOfTheConfiguredSchemaAreArchived) {
+  WriterModule::raw::raw_Writer Writer;
+  Writer.parse_config(R"({"schema": "f144"})");
+  EXPECT_EQ(std::optional<std::string>("f144"), Writer.messageFlatbufferID());
+  EXPECT_FALSE(Writer.writesAllMessagesOfTopic());
+}
+
+TEST_F(rawWriter, AllMessagesOfTheTopicAreArchivedWithoutSchema) {
+  WriterModule::raw::raw_Writer Writer;
+  Writer.parse_config(R"({})");
+  EXPECT_FALSE(Writer.messageFlatbufferID().has_value());
+  EXPECT_TRUE(Writer.writesAllMessagesOfTopic());
+}
+
+TEST_F(rawWriter, InvalidSchemaIsNotUsed) {
+  WriterModule::raw::raw_Writer Writer;
+  Writer.parse_config(R"({"schema": "f14"})");
+  EXPECT_FALSE(Writer.messageFlatbufferID().has_value());
+}
+
+TEST_F(rawWriter, ArchivedMessagesAreReadBackVerbatim) {
+  std::vector<FileWriter::FlatbufferMessage> Messages;
+  for (int i = 0; i < 5; ++i) {
+    Messages.push_back(createMessage(i, 1000 + i));
+  }
+  {
+    WriterModule::raw::raw_Writer Writer;
+    Writer.parse_config(R"({"schema": "f144", "batch_size": 100})");
+    EXPECT_TRUE(Writer.init_hdf(UsedGroup) == InitResult::OK);
+    EXPECT_TRUE(Writer.reopen(UsedGroup) == InitResult::OK);
+    for (auto const &Message : Messages) {
+      EXPECT_NO_THROW(Writer.write(Message, false));
+    }
+  }
+  WriterModule::raw::ArchiveReader Reader(UsedGroup);
+  ASSERT_EQ(Messages.size(), Reader.size());
+  WriterModule::raw::ArchivedMessage Archived;
+  for (size_t i = 0; i < Messages.size(); ++i) {
+    Reader.read(i, Archived);
+    EXPECT_EQ(std::vector<std::uint8_t>(Messages[i].data(),
+                                        Messages[i].data() +
+                                            Messages[i].size()),
+              Archived.Payload);
+    EXPECT_EQ(Messages[i].getTimestamp(), Archived.Timestamp);
+    // Not consumed from Kafka
+    EXPECT_EQ(-1, Archived.Origin.Offset);
+  }
+  EXPECT_THROW(Reader.read(Messages.size()), std::runtime_error);
+}
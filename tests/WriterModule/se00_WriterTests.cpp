@@ -52,6 +52,24 @@ GenerateFlatbufferData(size_t &DataSize, size_t NrOfElements = 6,
   std::memcpy(RawBuffer.get(), builder.GetBufferPointer(), DataSize);
   return RawBuffer;
 }
+
+flatbuffers::DetachedBuffer
+GenerateFlatbufferData(std::vector<std::int64_t> const &Timestamps) {
+  flatbuffers::FlatBufferBuilder builder;
+  std::vector<std::uint16_t> TestValues(Timestamps.size(), 1);
+  auto ValueObjectOffset =
+      CreateUInt16Array(builder, builder.CreateVector(TestValues));
+  auto FBTimestampOffset = builder.CreateVector(Timestamps);
+  auto FBNameStringOffset = builder.CreateString("SomeTestString");
+  se00_SampleEnvironmentDataBuilder MessageBuilder(builder);
+  MessageBuilder.add_name(FBNameStringOffset);
+  MessageBuilder.add_values(ValueObjectOffset.Union());
+  MessageBuilder.add_values_type(ValueUnion::UInt16Array);
+  MessageBuilder.add_timestamps(FBTimestampOffset);
+  builder.Finish(MessageBuilder.Finish(),
+                 se00_SampleEnvironmentDataIdentifier());
+  return builder.Release();
+}
 } // namespace se00_tests
 
 class se00Writer : public ::testing::Test {
@@ -110,6 +128,7 @@ TEST_F(se00Writer, WriteDataOnce) {
   EXPECT_TRUE(Writer.reopen(UsedGroup) == InitResult::OK);
   FileWriter::FlatbufferMessage TestMsg(Buffer.get(), BufferSize);
   EXPECT_NO_THROW(Writer.write(TestMsg, false));
+  Writer.flushBuffers();
   auto RawValuesDataset = UsedGroup.get_dataset("value");
   auto TimestampDataset = UsedGroup.get_dataset("time");
   auto CueIndexDataset = UsedGroup.get_dataset("cue_index");
@@ -153,6 +172,7 @@ TEST_F(se00Writer, WriteDataTwice) {
   FileWriter::FlatbufferMessage TestMsg(Buffer.get(), BufferSize);
   EXPECT_NO_THROW(Writer.write(TestMsg, false));
   EXPECT_NO_THROW(Writer.write(TestMsg, false));
+  Writer.flushBuffers();
   auto RawValuesDataset = UsedGroup.get_dataset("value");
   auto TimestampDataset = UsedGroup.get_dataset("time");
   auto CueIndexDataset = UsedGroup.get_dataset("cue_index");
@@ -191,6 +211,7 @@ TEST_F(se00Writer, WriteNoElements) {
   EXPECT_TRUE(Writer.reopen(UsedGroup) == InitResult::OK);
   FileWriter::FlatbufferMessage TestMsg(Buffer.get(), BufferSize);
   EXPECT_NO_THROW(Writer.write(TestMsg, false));
+  Writer.flushBuffers();
   auto RawValuesDataset = UsedGroup.get_dataset("value");
   auto TimestampDataset = UsedGroup.get_dataset("time");
   auto CueIndexDataset = UsedGroup.get_dataset("cue_index");
@@ -210,6 +231,7 @@ TEST_F(se00Writer, WriteDataWithNoTimestampsInFB) {
   EXPECT_TRUE(Writer.reopen(UsedGroup) == InitResult::OK);
   FileWriter::FlatbufferMessage TestMsg(Buffer.get(), BufferSize);
   EXPECT_NO_THROW(Writer.write(TestMsg, false));
+  Writer.flushBuffers();
   auto RawValuesDataset = UsedGroup.get_dataset("value");
   auto TimestampDataset = UsedGroup.get_dataset("time");
   auto CueIndexDataset = UsedGroup.get_dataset("cue_index");
@@ -240,3 +262,111 @@ TEST_F(se00Writer, WriteDataWithNoTimestampsInFB) {
   EXPECT_NO_THROW(CueTimestampZeroDataset.read(CueTimestamp));
   EXPECT_EQ(CueTimestamp.at(0), FbPointer->packet_timestamp());
 }
+
+TEST_F(se00Writer, ValuesAreBatchedUntilFlushed) {
+  size_t BufferSize;
+  auto Buffer = se00_tests::GenerateFlatbufferData(BufferSize, 16, false);
+  WriterModule::se00::se00_Writer Writer;
+  Writer.parse_config(R"({"batch_size": 100})");
+  EXPECT_TRUE(Writer.init_hdf(UsedGroup) == InitResult::OK);
+  EXPECT_TRUE(Writer.reopen(UsedGroup) == InitResult::OK);
+  FileWriter::FlatbufferMessage TestMsg(Buffer.get(), BufferSize);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_NO_THROW(Writer.write(TestMsg, false));
+  }
+  auto RawValuesDataset = UsedGroup.get_dataset("value");
+  auto TimestampDataset = UsedGroup.get_dataset("time");
+  EXPECT_EQ(RawValuesDataset.dataspace().size(), 0);
+  Writer.flushBuffers();
+  auto FbPointer = Getse00_SampleEnvironmentData(TestMsg.data());
+  auto ValuesSize = FbPointer->values_as_UInt16Array()->value()->size();
+  EXPECT_EQ(RawValuesDataset.dataspace().size(), 3 * ValuesSize);
+  std::vector<std::uint64_t> Timestamps(TimestampDataset.dataspace().size());
+  ASSERT_EQ(Timestamps.size(), 3 * ValuesSize);
+  TimestampDataset.read(Timestamps);
+  auto Expected = WriterModule::se00::GenerateTimeStamps(
+      FbPointer->packet_timestamp(), FbPointer->time_delta(), ValuesSize);
+  for (size_t i = 0; i < Timestamps.size(); i++) {
+    EXPECT_EQ(Timestamps[i], Expected[i % ValuesSize]);
+  }
+}
+
+TEST_F(se00Writer, ImplicitTimestampsOnlyStoreOriginAndDelta) {
+  size_t BufferSize;
+  auto Buffer = se00_tests::GenerateFlatbufferData(BufferSize, 16, false);
+  {
+    WriterModule::se00::se00_Writer Writer;
+    Writer.parse_config(R"({"implicit_timestamps": true})");
+    EXPECT_TRUE(Writer.init_hdf(UsedGroup) == InitResult::OK);
+    EXPECT_TRUE(Writer.reopen(UsedGroup) == InitResult::OK);
+    FileWriter::FlatbufferMessage TestMsg(Buffer.get(), BufferSize);
+    EXPECT_NO_THROW(Writer.write(TestMsg, false));
+    EXPECT_NO_THROW(Writer.write(TestMsg, false));
+  }
+  EXPECT_EQ(UsedGroup.get_dataset("time").dataspace().size(), 0);
+  auto FbPointer = Getse00_SampleEnvironmentData(Buffer.get());
+  std::vector<double> TimeDelta(2);
+  UsedGroup.get_dataset("time_delta").read(TimeDelta);
+  EXPECT_EQ(TimeDelta, std::vector<double>(2, FbPointer->time_delta()));
+  std::vector<std::uint64_t> CueTimestamp(2);
+  UsedGroup.get_dataset("cue_timestamp_zero").read(CueTimestamp);
+  EXPECT_EQ(CueTimestamp[1], FbPointer->packet_timestamp());
+}
+
+TEST_F(se00Writer, ImplicitTimestampsTolerateJitter) {
+  auto Buffer = se00_tests::GenerateFlatbufferData({1000, 1011, 1019, 1030});
+  FileWriter::FlatbufferMessage Msg(Buffer.data(), Buffer.size());
+  {
+    WriterModule::se00::se00_Writer Writer;
+    Writer.parse_config(R"({"implicit_timestamps": true,
+                            "implicit_timestamps_tolerance": 0.2})");
+    EXPECT_TRUE(Writer.init_hdf(UsedGroup) == InitResult::OK);
+    EXPECT_TRUE(Writer.reopen(UsedGroup) == InitResult::OK);
+    EXPECT_NO_THROW(Writer.write(Msg, false));
+  }
+  EXPECT_EQ(UsedGroup.get_dataset("value").dataspace().size(), 4);
+  EXPECT_EQ(UsedGroup.get_dataset("time").dataspace().size(), 0);
+  std::vector<double> TimeDelta(1);
+  UsedGroup.get_dataset("time_delta").read(TimeDelta);
+  EXPECT_EQ(TimeDelta[0], 10.0);
+}
+
+TEST_F(se00Writer, UnevenTimestampsAreWrittenExplicitly) {
+  auto EvenBuffer = se00_tests::GenerateFlatbufferData({1000, 1010, 1020});
+  auto UnevenBuffer = se00_tests::GenerateFlatbufferData({2000, 2010, 2030});
+  auto LaterBuffer = se00_tests::GenerateFlatbufferData({3000, 3010});
+  FileWriter::FlatbufferMessage EvenMsg(EvenBuffer.data(), EvenBuffer.size());
+  FileWriter::FlatbufferMessage UnevenMsg(UnevenBuffer.data(),
+                                          UnevenBuffer.size());
+  FileWriter::FlatbufferMessage LaterMsg(LaterBuffer.data(),
+                                         LaterBuffer.size());
+  {
+    WriterModule::se00::se00_Writer Writer;
+    Writer.parse_config(R"({"implicit_timestamps": true})");
+    EXPECT_TRUE(Writer.init_hdf(UsedGroup) == InitResult::OK);
+    EXPECT_TRUE(Writer.reopen(UsedGroup) == InitResult::OK);
+    EXPECT_NO_THROW(Writer.write(EvenMsg, false));
+    EXPECT_NO_THROW(Writer.write(UnevenMsg, false));
+    EXPECT_NO_THROW(Writer.write(LaterMsg, false));
+    Writer.flushBuffers();
+  }
+  EXPECT_EQ(UsedGroup.get_dataset("value").dataspace().size(), 8);
+  // Only the first message is written implicitly.
+  std::vector<double> TimeDelta(1);
+  auto TimeDeltaDataset = UsedGroup.get_dataset("time_delta");
+  EXPECT_EQ(TimeDeltaDataset.dataspace().size(), 1);
+  TimeDeltaDataset.read(TimeDelta);
+  EXPECT_EQ(TimeDelta[0], 10.0);
+  // All time stamps, including those of the first message.
+  std::vector<std::uint64_t> Timestamps(8);
+  UsedGroup.get_dataset("time").read(Timestamps);
+  EXPECT_EQ(Timestamps, (std::vector<std::uint64_t>{1000, 1010, 1020, 2000,
+                                                    2010, 2030, 3000, 3010}));
+}
+
+TEST(se00TimeStamps, GeneratedTimeStampsAreRounded) {
+  std::vector<std::uint64_t> Result(4);
+  WriterModule::se00::GenerateTimeStamps(1000, 0.5, Result.size(),
+                                         Result.data());
+  EXPECT_EQ(Result, (std::vector<std::uint64_t>{1000, 1001, 1001, 1002}));
+}